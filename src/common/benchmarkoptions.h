@@ -24,10 +24,35 @@ struct ApplicationOptions
 
     string dataDir;
     int dataGroup;
+
+    // FIR filter specific
+    string firMode;
+    int firBlock;
+    string firMethod;
+    string firVariants;
+    string firChannels;
+    float firStep;
+
+    // Needleman-Wunsch specific
+    string nwBatch;
+    int nwPairs;
+    string nwMode;
+    int gapOpen;
+    int gapExtend;
+    string nwOutput;
+    bool nwTraceback;
+    int nwBand;
+    string nwFasta;
     
     // RANSAC specific
     string ifile;
     string model;
+    string ransacDataDir;
+    float ransacConfidence;
+    int ransacBatch;
+    int ransacBlock;
+    int ransacFrames;
+    string ransacFrameDir;
 };
 
 // A struct representing Benchmark suite options specified.
@@ -0,0 +1,49 @@
+/** @file mappedfile.cpp
+*/
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <iostream>
+
+#include "mappedfile.h"
+
+using namespace std;
+
+bool mapFile(string fileName, void *&mapping, size_t &size)
+{
+    int fd = open(fileName.c_str(), O_RDONLY);
+
+    if (fd < 0)
+    {
+        cout << "Failed opening: " << fileName << " for reading" << endl;
+        return false;
+    }
+
+    struct stat fileStat;
+    if (fstat(fd, &fileStat) != 0 || fileStat.st_size == 0)
+    {
+        cout << "Failed reading the file: " << fileName << endl;
+        close(fd);
+        return false;
+    }
+
+    mapping = mmap(NULL, fileStat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+
+    if (mapping == MAP_FAILED)
+    {
+        cout << "Failed mapping the file: " << fileName << endl;
+        mapping = NULL;
+        return false;
+    }
+
+    size = fileStat.st_size;
+    madvise(mapping, size, MADV_SEQUENTIAL);
+    return true;
+}
+
+void unmapFile(void *mapping, size_t size)
+{
+    munmap(mapping, size);
+}
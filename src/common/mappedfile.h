@@ -0,0 +1,23 @@
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+#include <stddef.h>
+#include <string>
+
+/****************************************************************************
+* @file mappedfile.h
+*
+* <b>Purpose:</b> Read only memory mappings of whole data files, which the
+* benchmarks parse or use in place instead of reading them line by line.
+*
+****************************************************************************/
+
+// Maps the whole file read only for a sequential read. Returns false and
+// prints the error to stdout if the file cannot be opened, is empty or
+// cannot be mapped.
+bool mapFile(std::string fileName, void *&mapping, size_t &size);
+
+// Releases a mapping of mapFile().
+void unmapFile(void *mapping, size_t size);
+
+#endif
@@ -31,6 +31,7 @@
 #include <string>
 #include <vector>
 #include <map>
+#include <stdlib.h>
 #include "optionparser.h"
 #include <sstream>
 #include <fstream>
@@ -114,6 +115,19 @@ bool OptionParser::parse(const vector<string> &args) {
       else if (temp[0] == '-' && temp[1] == '-') //Long Name argument
       {
          string longName = temp.substr(2);
+         size_t equals = longName.find('=');
+         if (equals != string::npos) {
+            //Value given as --name=value
+            string value = longName.substr(equals+1);
+            longName = longName.substr(0, equals);
+            if (optionMap.find(longName) == optionMap.end()) {
+               cout << "Option not recognized: " << temp << endl;
+               cout << "Ignoring remaining options" << endl;
+               return false;
+            }
+            optionMap[longName].value = value;
+            continue;
+         }
          if (optionMap.find(longName) == optionMap.end()) {
             cout << "Option not recognized: " << temp << endl;
             cout << "Ignoring remaining options" << endl;
@@ -198,6 +212,39 @@ void OptionParser::print() const {
 
 }
 
+long long OptionParser::getOptionInt(const string &name) const {
+
+    OptionMap::const_iterator iter = optionMap.find( name );
+   if (iter == optionMap.end()) {
+     cout << "getOptionInt: option name \"" << name << "\" not recognized.\n";
+     return -9999;
+   }
+
+   return atoll(iter->second.value.c_str());
+}
+
+float OptionParser::getOptionFloat(const string &name) const {
+
+    OptionMap::const_iterator iter = optionMap.find( name );
+   if (iter == optionMap.end()) {
+     cout << "getOptionFloat: option name \"" << name << "\" not recognized.\n";
+     return -9999;
+   }
+
+   return atof(iter->second.value.c_str());
+}
+
+string OptionParser::getOptionString(const string &name) const {
+
+    OptionMap::const_iterator iter = optionMap.find( name );
+   if (iter == optionMap.end()) {
+     cout << "getOptionString: option name \"" << name << "\" not recognized.\n";
+     return "";
+   }
+
+   return iter->second.value;
+}
+
 bool OptionParser::getOptionBool(const string &name) const {
 
    int retVal;
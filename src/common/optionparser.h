@@ -98,7 +98,10 @@ class OptionParser
     bool parse(const vector<string> &args);
 
     //Accessors for options
+    long long   getOptionInt(const string &name) const;
+    float       getOptionFloat(const string &name) const;
     bool        getOptionBool(const string &name) const;
+    string      getOptionString(const string &name) const;
 
     vector<long long>     getOptionVecInt(const string &name) const;
     vector<float>         getOptionVecFloat(const string &name) const;
@@ -31,6 +31,8 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 /** @file utility.cpp
 */
 #include <stdexcept>
+#include <algorithm>
+#include <math.h>
 
 #include "utility.h"
 
@@ -59,27 +61,58 @@ const string
     firFilterKernelOption   = "firfilterkernel",
     firFilterDataDir        = "inputdir",
     firFilterDataGroup      = "group",
+    firFilterModeOption     = "fir-mode",
+    firFilterBlockOption    = "fir-block",
+    firFilterMethodOption   = "fir-method",
+    firFilterVariantsOption = "fir-variants",
+    firFilterChannelsOption = "fir-channels",
+    firFilterStepOption     = "fir-step",
     nwKernelOption          = "nwkernel",
+    nwBatchOption           = "nw-batch",
+    nwPairsOption           = "nw-pairs",
+    nwModeOption            = "nw-mode",
+    nwGapOpenOption         = "gap-open",
+    nwGapExtendOption       = "gap-extend",
+    nwOutputOption          = "nw-output",
+    nwTracebackOption       = "nw-traceback",
+    nwBandOption            = "nw-band",
+    nwFastaOption           = "nw-fasta",
     mmKernelOption          = "mmkernel",
     ransacKernelOption      = "ransackernel",
     mergesortKernelOption   = "mergesortkernel",
     ransacIfileOption       = "ifile",
     ransacModelOption       = "model",
+    ransacDataDirOption     = "ransac-datadir",
+    ransacConfidenceOption  = "ransac-confidence",
+    ransacBatchOption       = "ransac-batch",
+    ransacBlockOption       = "ransac-block",
+    ransacFramesOption      = "ransac-frames",
+    ransacFrameDirOption    = "ransac-framedir",
     sizeOption              = "size",
     passesOption            = "passes",
     iterationsOption        = "iterations",
     intOption               = "specify int option",
+    floatOption             = "specify float option",
     stringOption            = "specify string option",
     vectorStringOption      = "specify vector string option",
     booleanOption           = "specify boolean option",   
     md5DefaultKernel        = "md5.aocx",
     scanDefaultKernel       = "scan.aocx",
     firFilterDefaultKernel  = "firfilter.aocx",
+    firFilterDefaultMode    = "block",
+    firFilterDefaultBlock   = "65536",
+    firFilterDefaultMethod  = "direct",
+    firFilterDefaultChannels = "64,256,1024",
     nwDefaultKernel         = "nw.aocx",
+    nwDefaultPairs          = "8192",
+    nwDefaultMode           = "global",
+    nwDefaultGapCost        = "10",
+    nwDefaultOutput         = "strip",
     mmDefaultKernel         = "mm.aocx",
     ransacDefaultKernel     = "ransac.aocx",
     ransacDefaultIfile      = "flowvector.csv",
     ransacDefaultModel      = "fv",
+    ransacDefaultDataDir    = "../../src/ransac/data/",
     mergesortDefaultKernel  = "mergesort.aocx";
 
 /****************************************************************************
@@ -379,10 +412,33 @@ BenchmarkOptionsParser bopts;
 
     bopts.addOption(firFilterDataDir, OPT_STRING, "data/", stringOption);
     bopts.addOption(firFilterDataGroup, OPT_INT, "1", stringOption);
+    bopts.addOption(firFilterModeOption, OPT_STRING, firFilterDefaultMode, stringOption);
+    bopts.addOption(firFilterBlockOption, OPT_INT, firFilterDefaultBlock, intOption);
+    bopts.addOption(firFilterMethodOption, OPT_STRING, firFilterDefaultMethod, stringOption);
+    bopts.addOption(firFilterVariantsOption, OPT_STRING, "", stringOption);
+    bopts.addOption(firFilterChannelsOption, OPT_STRING, firFilterDefaultChannels, stringOption);
+    bopts.addOption(firFilterStepOption, OPT_FLOAT, "0", floatOption);
+
+    // Needleman-Wunsch specific options
+    bopts.addOption(nwBatchOption, OPT_STRING, "", stringOption);
+    bopts.addOption(nwPairsOption, OPT_INT, nwDefaultPairs, intOption);
+    bopts.addOption(nwModeOption, OPT_STRING, nwDefaultMode, stringOption);
+    bopts.addOption(nwGapOpenOption, OPT_INT, nwDefaultGapCost, intOption);
+    bopts.addOption(nwGapExtendOption, OPT_INT, nwDefaultGapCost, intOption);
+    bopts.addOption(nwOutputOption, OPT_STRING, nwDefaultOutput, stringOption);
+    bopts.addOption(nwTracebackOption, OPT_BOOL, "false", booleanOption);
+    bopts.addOption(nwBandOption, OPT_INT, "0", intOption);
+    bopts.addOption(nwFastaOption, OPT_STRING, "", stringOption);
 
     // RANSAC specific options
     bopts.addOption(ransacIfileOption, OPT_STRING, ransacDefaultIfile, stringOption);
     bopts.addOption(ransacModelOption, OPT_STRING, ransacDefaultModel, stringOption);
+    bopts.addOption(ransacDataDirOption, OPT_STRING, ransacDefaultDataDir, stringOption);
+    bopts.addOption(ransacConfidenceOption, OPT_FLOAT, "0", floatOption);
+    bopts.addOption(ransacBatchOption, OPT_INT, "32", intOption);
+    bopts.addOption(ransacBlockOption, OPT_INT, "128", intOption);
+    bopts.addOption(ransacFramesOption, OPT_INT, "0", intOption);
+    bopts.addOption(ransacFrameDirOption, OPT_STRING, "", stringOption);
 
     return bopts;
 }
@@ -519,8 +575,29 @@ void addApplications(BenchmarkOptionsParser &parser,
                     getKernelNameOption(appName, rootCall)),
                 .dataDir = parser.getOptionString(appNameInConfig, firFilterDataDir),
 		.dataGroup = parser.getOptionInt(appNameInConfig, firFilterDataGroup),
+                .firMode = parser.getOptionString(appNameInConfig, firFilterModeOption),
+                .firBlock = parser.getOptionInt(appNameInConfig, firFilterBlockOption),
+                .firMethod = parser.getOptionString(appNameInConfig, firFilterMethodOption),
+                .firVariants = parser.getOptionString(appNameInConfig, firFilterVariantsOption),
+                .firChannels = parser.getOptionString(appNameInConfig, firFilterChannelsOption),
+                .firStep = parser.getOptionFloat(appNameInConfig, firFilterStepOption),
+                .nwBatch = parser.getOptionString(appNameInConfig, nwBatchOption),
+                .nwPairs = parser.getOptionInt(appNameInConfig, nwPairsOption),
+                .nwMode = parser.getOptionString(appNameInConfig, nwModeOption),
+                .gapOpen = parser.getOptionInt(appNameInConfig, nwGapOpenOption),
+                .gapExtend = parser.getOptionInt(appNameInConfig, nwGapExtendOption),
+                .nwOutput = parser.getOptionString(appNameInConfig, nwOutputOption),
+                .nwTraceback = parser.getOptionBool(appNameInConfig, nwTracebackOption),
+                .nwBand = parser.getOptionInt(appNameInConfig, nwBandOption),
+                .nwFasta = parser.getOptionString(appNameInConfig, nwFastaOption),
 		.ifile = parser.getOptionString(appNameInConfig, ransacIfileOption), // ransac specific
-                .model = parser.getOptionString(appNameInConfig, ransacModelOption)  // ransac specific
+                .model = parser.getOptionString(appNameInConfig, ransacModelOption), // ransac specific
+                .ransacDataDir = parser.getOptionString(appNameInConfig, ransacDataDirOption), // ransac specific
+                .ransacConfidence = parser.getOptionFloat(appNameInConfig, ransacConfidenceOption), // ransac specific
+                .ransacBatch = parser.getOptionInt(appNameInConfig, ransacBatchOption), // ransac specific
+                .ransacBlock = parser.getOptionInt(appNameInConfig, ransacBlockOption), // ransac specific
+                .ransacFrames = parser.getOptionInt(appNameInConfig, ransacFramesOption), // ransac specific
+                .ransacFrameDir = parser.getOptionString(appNameInConfig, ransacFrameDirOption) // ransac specific
             };
 
             benchOptions.appsToRun[appType] = appOptions;
@@ -584,3 +661,26 @@ BenchmarkDatabase createResultDatabase(BenchmarkOptions options)
     benchDb.AddBenchmark(mergesortOption, options);
     return benchDb;
 }
+
+/****************************************************************************
+* <b>Function:</b> getPercentile()
+*
+* <b>Purpose:</b> Returns the p-th percentile of the values by nearest rank, 
+* e.g. for reporting latency distributions.
+*
+* @param values the measured values (e.g. latencies).
+* @param p the percentile, from 0 to 100.
+*
+* @returns The percentile value or 0 if there are no values.
+****************************************************************************/
+double getPercentile(std::vector<double> values, double p)
+{
+    if (values.empty()) return 0;
+
+    std::sort(values.begin(), values.end());
+
+    size_t rank = (size_t)ceil(p / 100.0 * values.size());
+    if (rank > 0) rank--;
+    
+    return values[std::min(rank, values.size()-1)];
+}
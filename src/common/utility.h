@@ -2,6 +2,7 @@
 #define UTILITY_H
 
 #include <CL/opencl.h>
+#include <vector>
 
 #include "support.h"
 #include "benchmarkoptions.h"
@@ -38,4 +39,7 @@ BenchmarkOptions parseBenchmarkOptions(int argc, char *argv[]);
 // settings.
 BenchmarkDatabase createResultDatabase(BenchmarkOptions options);
 
+// Returns the p-th (0-100) percentile of the values, by nearest rank.
+double getPercentile(std::vector<double> values, double p);
+
 #endif
@@ -0,0 +1,142 @@
+/** @file firfilter_fft.cl */
+
+#define FFT_SIZE (1 << FFT_LOG2)
+#define FFT_HALF (FFT_SIZE/2)
+
+typedef float FLOATING_POINT;
+typedef unsigned int uint;
+
+uint bit_reverse(uint index)
+{
+    uint reversed = 0;
+    #pragma unroll
+    for (uint b=0; b<FFT_LOG2; b++)
+        reversed |= ((index >> b) & 1) << (FFT_LOG2-1-b);
+    return reversed;
+}
+
+/****************************************************************************
+* <b>Function:</b> fft_in_place()
+* <b>Purpose:</b> Radix-2 decimation in time fft of a bit reversed input,
+* the output is in natural order.
+****************************************************************************/
+void fft_in_place(FLOATING_POINT re[FFT_SIZE], FLOATING_POINT im[FFT_SIZE],
+                FLOATING_POINT w_re[FFT_HALF], FLOATING_POINT w_im[FFT_HALF])
+{
+    for (uint stage=0; stage<FFT_LOG2; stage++)
+    {
+        uint half = 1 << stage;
+
+        #pragma ivdep
+        for (uint k=0; k<FFT_HALF; k++)
+        {
+            uint pos = k & (half-1);
+            uint i = ((k >> stage) << (stage+1)) + pos;
+            uint j = i + half;
+            uint w = pos << (FFT_LOG2-1-stage);
+
+            FLOATING_POINT tr = w_re[w]*re[j] - w_im[w]*im[j];
+            FLOATING_POINT ti = w_re[w]*im[j] + w_im[w]*re[j];
+
+            re[j] = re[i] - tr;
+            im[j] = im[i] - ti;
+            re[i] = re[i] + tr;
+            im[i] = im[i] + ti;
+        }
+    }
+}
+
+/****************************************************************************
+* <b>Function:</b> convolve_fft()
+* <b>Purpose:</b> Within the FPGA, convolve the input samples with the filter
+* coefficients by overlap-add fast convolution. Each fft carries two
+* consecutive segments of FFT_SIZE-numCoefficients+1 samples, one as the real
+* and one as the imaginary part.
+* @param samples the input samples to convolve.
+* @param spectrum the fft of the zero padded coefficients scaled by
+* 1/FFT_SIZE, FFT_SIZE real parts followed by FFT_SIZE imaginary parts.
+* @param twiddles exp(-2*pi*i*k/FFT_SIZE) for k < FFT_SIZE/2, real parts
+* followed by imaginary parts.
+* @param result output -the resulted convolved samples.
+* @param numSamples the number of input samples.
+* @param numCoefficients the number of filter coefficients, at most
+* FFT_SIZE/2.
+* @returns Void
+****************************************************************************/
+__attribute__((uses_global_work_offset(0)))
+__attribute__((max_global_work_dim(0)))
+__kernel void
+convolve_fft(global FLOATING_POINT * restrict samples,
+                global FLOATING_POINT * restrict spectrum,
+                global FLOATING_POINT * restrict twiddles,
+                global FLOATING_POINT * restrict results,
+                uint numSamples,
+                uint numCoefficients)
+{
+    FLOATING_POINT h_re[FFT_SIZE], h_im[FFT_SIZE];
+    for (uint i=0; i<FFT_SIZE; i++)
+    {
+        h_re[i] = spectrum[i];
+        h_im[i] = spectrum[FFT_SIZE+i];
+    }
+
+    FLOATING_POINT w_re[FFT_HALF], w_im[FFT_HALF];
+    for (uint i=0; i<FFT_HALF; i++)
+    {
+        w_re[i] = twiddles[i];
+        w_im[i] = twiddles[FFT_HALF+i];
+    }
+
+    uint segment = FFT_SIZE - numCoefficients + 1;
+    uint tail = numCoefficients - 1;
+
+    // Tail of the previous segment pair to add to the next one.
+    FLOATING_POINT overlap[FFT_HALF];
+    for (uint i=0; i<FFT_HALF; i++)
+        overlap[i] = 0;
+
+    for (uint base=0; base<numSamples; base+=2*segment)
+    {
+        FLOATING_POINT re[FFT_SIZE], im[FFT_SIZE];
+
+        for (uint i=0; i<FFT_SIZE; i++)
+        {
+            uint r = bit_reverse(i);
+            re[r] = (i < segment && base+i < numSamples) ?
+                        samples[base+i] : 0;
+            im[r] = (i < segment && base+segment+i < numSamples) ?
+                        samples[base+segment+i] : 0;
+        }
+
+        fft_in_place(re, im, w_re, w_im);
+
+        // Multiply by the spectrum and conjugate, so that the forward fft
+        // below gives the conjugate of the inverse fft.
+        FLOATING_POINT y_re[FFT_SIZE], y_im[FFT_SIZE];
+        for (uint i=0; i<FFT_SIZE; i++)
+        {
+            uint r = bit_reverse(i);
+            y_re[r] = re[i]*h_re[i] - im[i]*h_im[i];
+            y_im[r] = -(re[i]*h_im[i] + im[i]*h_re[i]);
+        }
+
+        fft_in_place(y_re, y_im, w_re, w_im);
+
+        // The real part is the first segment's convolution, the negated
+        // imaginary part the second's, starting segment samples later.
+        for (uint i=0; i<segment; i++)
+        {
+            FLOATING_POINT value = y_re[i] + (i < tail ? overlap[i] : 0);
+            if (base+i < numSamples) results[base+i] = value;
+        }
+
+        for (uint i=0; i<segment; i++)
+        {
+            FLOATING_POINT value = -y_im[i] + (i < tail ? y_re[segment+i] : 0);
+            if (base+segment+i < numSamples) results[base+segment+i] = value;
+        }
+
+        for (uint i=0; i<FFT_HALF; i++)
+            overlap[i] = i < tail ? -y_im[segment+i] : 0;
+    }
+}
@@ -0,0 +1,158 @@
+/** @file firfilter_fixed.cl */
+
+typedef unsigned int uint;
+
+// Q15 samples and coefficients are accumulated in 48 bits (the width of the
+// DSP block accumulators), Q7 ones in 32 bits. Neither accumulator overflows
+// for TAP_SIZE up to 2^17, the saturation only guards larger filters.
+#define ACC48_MAX ((1L << 47) - 1)
+#define ACC48_MIN (-(1L << 47))
+
+#define Q15_MAX 32767
+#define Q15_MIN (-32768)
+#define Q7_MAX 127
+#define Q7_MIN (-128)
+
+// Shift register of a block: TAP_SIZE-1 history samples and BLOCK_SIZE new.
+#define WINDOW_SIZE (TAP_SIZE-1+BLOCK_SIZE)
+
+/****************************************************************************
+* <b>Function:</b> requantize_q15()
+* <b>Purpose:</b> Saturates the accumulator to 48 bits, shifts it right by
+* shift bits with rounding to nearest and saturates it to Q15.
+* @param acc the accumulated products.
+* @param shift the result shift.
+* @returns The Q15 result.
+****************************************************************************/
+short
+requantize_q15(long acc, uint shift)
+{
+    acc = clamp(acc, ACC48_MIN, ACC48_MAX);
+    long rounded = shift > 0 ? (acc + (1L << (shift-1))) >> shift : acc;
+    return (short)clamp(rounded, (long)Q15_MIN, (long)Q15_MAX);
+}
+
+/****************************************************************************
+* <b>Function:</b> requantize_q7()
+* <b>Purpose:</b> Shifts the 32 bit accumulator right by shift bits with
+* rounding to nearest and saturates it to Q7.
+* @param acc the accumulated products.
+* @param shift the result shift.
+* @returns The Q7 result.
+****************************************************************************/
+char
+requantize_q7(int acc, uint shift)
+{
+    long rounded = shift > 0 ? ((long)acc + (1L << (shift-1))) >> shift : acc;
+    return (char)clamp(rounded, (long)Q7_MIN, (long)Q7_MAX);
+}
+
+/****************************************************************************
+* <b>Function:</b> convolve_q15()
+* <b>Purpose:</b> Within the FPGA, filter the Q15 input samples by the Q15
+* coefficients, BLOCK_SIZE outputs at a time. The products are accumulated
+* exactly and each result is requantized to Q15 by requantize_q15().
+* @param samples the Q15 input samples.
+* @param coefficients the TAP_SIZE Q15 filter coefficients.
+* @param result output -the Q15 filtered samples.
+* @param numSamples the number of input samples.
+* @param shift the right shift of the accumulators to the results.
+* @returns Void
+****************************************************************************/
+__attribute__((uses_global_work_offset(0)))
+__attribute__((max_global_work_dim(0)))
+__kernel void
+convolve_q15(global short * restrict samples,
+                global short * restrict coefficients,
+                global short * restrict results,
+                uint numSamples,
+                uint shift)
+{
+    short pr_coeffs[TAP_SIZE];
+    #pragma unroll MEM_BLOCK_SIZE
+    for (uint i=0,j=TAP_SIZE-1; i<TAP_SIZE; i++,j--)
+        pr_coeffs[i] = coefficients[j];
+
+    short pr_samples[WINDOW_SIZE];
+    #pragma unroll
+    for (uint j=0; j<WINDOW_SIZE; j++)
+        pr_samples[j] = 0;
+
+    for (uint i=0; i<numSamples; i+=BLOCK_SIZE)
+    {
+        #pragma unroll
+        for (uint j=0; j<TAP_SIZE-1; j++)
+            pr_samples[j] = pr_samples[j+BLOCK_SIZE];
+
+        #pragma unroll
+        for (uint j=0; j<BLOCK_SIZE; j++)
+            pr_samples[TAP_SIZE-1+j] = i+j < numSamples ? samples[i+j] : 0;
+
+        #pragma unroll
+        for (uint j=0; j<BLOCK_SIZE; j++)
+        {
+            long acc = 0;
+
+            #pragma unroll
+            for (uint t=0; t<TAP_SIZE; t++)
+                acc += (int)pr_samples[j+t] * (int)pr_coeffs[t];
+
+            if (i+j < numSamples) results[i+j] = requantize_q15(acc, shift);
+        }
+    }
+}
+
+/****************************************************************************
+* <b>Function:</b> convolve_q7()
+* <b>Purpose:</b> Within the FPGA, filter the Q7 input samples by the Q7
+* coefficients, BLOCK_SIZE outputs at a time. The products are accumulated
+* exactly and each result is requantized to Q7 by requantize_q7().
+* @param samples the Q7 input samples.
+* @param coefficients the TAP_SIZE Q7 filter coefficients.
+* @param result output -the Q7 filtered samples.
+* @param numSamples the number of input samples.
+* @param shift the right shift of the accumulators to the results.
+* @returns Void
+****************************************************************************/
+__attribute__((uses_global_work_offset(0)))
+__attribute__((max_global_work_dim(0)))
+__kernel void
+convolve_q7(global char * restrict samples,
+                global char * restrict coefficients,
+                global char * restrict results,
+                uint numSamples,
+                uint shift)
+{
+    char pr_coeffs[TAP_SIZE];
+    #pragma unroll MEM_BLOCK_SIZE
+    for (uint i=0,j=TAP_SIZE-1; i<TAP_SIZE; i++,j--)
+        pr_coeffs[i] = coefficients[j];
+
+    char pr_samples[WINDOW_SIZE];
+    #pragma unroll
+    for (uint j=0; j<WINDOW_SIZE; j++)
+        pr_samples[j] = 0;
+
+    for (uint i=0; i<numSamples; i+=BLOCK_SIZE)
+    {
+        #pragma unroll
+        for (uint j=0; j<TAP_SIZE-1; j++)
+            pr_samples[j] = pr_samples[j+BLOCK_SIZE];
+
+        #pragma unroll
+        for (uint j=0; j<BLOCK_SIZE; j++)
+            pr_samples[TAP_SIZE-1+j] = i+j < numSamples ? samples[i+j] : 0;
+
+        #pragma unroll
+        for (uint j=0; j<BLOCK_SIZE; j++)
+        {
+            int acc = 0;
+
+            #pragma unroll
+            for (uint t=0; t<TAP_SIZE; t++)
+                acc += (short)pr_samples[j+t] * (short)pr_coeffs[t];
+
+            if (i+j < numSamples) results[i+j] = requantize_q7(acc, shift);
+        }
+    }
+}
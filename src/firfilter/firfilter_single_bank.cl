@@ -0,0 +1,75 @@
+/** @file firfilter_single_bank.cl */
+
+typedef float FLOATING_POINT;
+typedef unsigned int uint;
+
+/****************************************************************************
+* <b>Function:</b> convolve_bank()
+* <b>Purpose:</b> Within the FPGA, filter many independent channels, each
+* with its own coefficients, in one launch. The data is channel interleaved
+* (sample n of channel c at n*numChannels+c), so BLOCK_SIZE neighbouring
+* channels are filtered side by side with one shift register each, reading
+* and writing BLOCK_SIZE consecutive values per sample.
+* @param samples the numSamples x numChannels interleaved input samples.
+* @param coefficients the TAP_SIZE x numChannels interleaved coefficients.
+* @param result output -the numSamples x numChannels interleaved results.
+* @param numSamples the number of input samples per channel.
+* @param numChannels the number of channels, a multiple of BLOCK_SIZE.
+* @returns Void
+****************************************************************************/
+__attribute__((uses_global_work_offset(0)))
+__attribute__((max_global_work_dim(0)))
+__kernel void
+convolve_bank(global FLOATING_POINT * restrict samples,
+                global FLOATING_POINT * restrict coefficients,
+                global FLOATING_POINT * restrict results,
+                uint numSamples,
+                uint numChannels)
+{
+    for (uint g=0; g<numChannels; g+=BLOCK_SIZE)
+    {
+        FLOATING_POINT pr_coeffs[TAP_SIZE][BLOCK_SIZE];
+        for (uint i=0,j=TAP_SIZE-1; i<TAP_SIZE; i++,j--)
+        {
+            #pragma unroll
+            for (uint c=0; c<BLOCK_SIZE; c++)
+                pr_coeffs[i][c] = coefficients[j*numChannels+g+c];
+        }
+
+        FLOATING_POINT pr_samples[TAP_SIZE][BLOCK_SIZE];
+        #pragma unroll
+        for (uint i=0; i<TAP_SIZE; i++)
+        {
+            #pragma unroll
+            for (uint c=0; c<BLOCK_SIZE; c++)
+                pr_samples[i][c] = 0;
+        }
+
+        for (uint n=0; n<numSamples; n++)
+        {
+            #pragma unroll
+            for (uint i=0; i<TAP_SIZE-1; i++)
+            {
+                #pragma unroll
+                for (uint c=0; c<BLOCK_SIZE; c++)
+                    pr_samples[i][c] = pr_samples[i+1][c];
+            }
+
+            #pragma unroll
+            for (uint c=0; c<BLOCK_SIZE; c++)
+                pr_samples[TAP_SIZE-1][c] = samples[n*numChannels+g+c];
+
+            #pragma unroll
+            for (uint c=0; c<BLOCK_SIZE; c++)
+            {
+                FLOATING_POINT sum = 0;
+
+                #pragma unroll
+                for (uint i=0; i<TAP_SIZE; i++)
+                    sum += pr_samples[i][c] * pr_coeffs[i][c];
+
+                results[n*numChannels+g+c] = sum;
+            }
+        }
+    }
+}
@@ -0,0 +1,127 @@
+/** @file firfilter_single_man_mac_lms.cl */
+
+#define MANUAL_MAC_L1_LEN 8
+#define MANUAL_MAC_L2_LEN 32
+#define MANUAL_MAC_L2_REPS 4
+#define MANUAL_MACS_L2_SIZE (MANUAL_MAC_L2_LEN*MANUAL_MAC_L2_REPS)
+
+// Regularization of the NLMS step, keeps it finite for silent input.
+#define LMS_DELTA 1e-6f
+
+typedef float FLOATING_POINT;
+typedef unsigned int uint;
+
+FLOATING_POINT
+mac_8x(uint sampleIndex, uint coeffIndex,
+    FLOATING_POINT samples[], FLOATING_POINT coeffs[])
+{
+    return  samples[sampleIndex+0]*coeffs[coeffIndex+0] +
+            samples[sampleIndex+1]*coeffs[coeffIndex+1] +
+            samples[sampleIndex+2]*coeffs[coeffIndex+2] +
+            samples[sampleIndex+3]*coeffs[coeffIndex+3] +
+            samples[sampleIndex+4]*coeffs[coeffIndex+4] +
+            samples[sampleIndex+5]*coeffs[coeffIndex+5] +
+            samples[sampleIndex+6]*coeffs[coeffIndex+6] +
+            samples[sampleIndex+7]*coeffs[coeffIndex+7] ;
+}
+
+FLOATING_POINT
+mac_32x(uint blockIndex, uint sampleIndex,
+    FLOATING_POINT samples[], FLOATING_POINT coeffs[])
+{
+    return
+        mac_8x(sampleIndex+0*MANUAL_MAC_L1_LEN,
+            (sampleIndex-blockIndex)+0*MANUAL_MAC_L1_LEN, samples, coeffs)+
+        mac_8x(sampleIndex+1*MANUAL_MAC_L1_LEN,
+            (sampleIndex-blockIndex)+1*MANUAL_MAC_L1_LEN, samples, coeffs)+
+        mac_8x(sampleIndex+2*MANUAL_MAC_L1_LEN,
+            (sampleIndex-blockIndex)+2*MANUAL_MAC_L1_LEN, samples, coeffs)+
+        mac_8x(sampleIndex+3*MANUAL_MAC_L1_LEN,
+            (sampleIndex-blockIndex)+3*MANUAL_MAC_L1_LEN, samples, coeffs);
+}
+
+FLOATING_POINT
+mac_manual(uint blockIndex, uint sampleIndex,
+    FLOATING_POINT samples[], FLOATING_POINT coeffs[])
+{
+    return
+        mac_32x(blockIndex, sampleIndex+0*MANUAL_MAC_L2_LEN, samples, coeffs)+
+        mac_32x(blockIndex, sampleIndex+1*MANUAL_MAC_L2_LEN, samples, coeffs)+
+        mac_32x(blockIndex, sampleIndex+2*MANUAL_MAC_L2_LEN, samples, coeffs)+
+        mac_32x(blockIndex, sampleIndex+3*MANUAL_MAC_L2_LEN, samples, coeffs);
+}
+
+/****************************************************************************
+* <b>Function:</b> convolve_lms()
+* <b>Purpose:</b> Within the FPGA, adapt a TAP_SIZE fir filter, starting from
+* zero, so that it maps the input samples to the desired samples, by the LMS
+* or NLMS rule: after each output y the weights are updated by
+* step*(desired-y)*samples, the NLMS step is divided by the energy of the
+* samples in the filter. The next output needs the updated weights, so the
+* main loop is bound by the latency of the MAC tree and the update (its
+* initiation interval), not by the number of multipliers.
+* @param samples the input samples.
+* @param desired the desired output samples.
+* @param weights output -the TAP_SIZE adapted filter coefficients.
+* @param errors output -the error desired-y of each sample.
+* @param numSamples the number of input samples.
+* @param step the step size (LMS) or normalized step size (NLMS).
+* @param normalized 1 for NLMS, 0 for LMS.
+* @returns Void
+****************************************************************************/
+__attribute__((uses_global_work_offset(0)))
+__attribute__((max_global_work_dim(0)))
+__kernel void
+convolve_lms(global FLOATING_POINT * restrict samples,
+                global FLOATING_POINT * restrict desired,
+                global FLOATING_POINT * restrict weights,
+                global FLOATING_POINT * restrict errors,
+                uint numSamples,
+                FLOATING_POINT step,
+                uint normalized)
+{
+    // Weight i multiplies sample i of the shift register, the newest sample
+    // is the last one.
+    FLOATING_POINT pr_weights[TAP_SIZE];
+    FLOATING_POINT pr_samples[TAP_SIZE];
+
+    #pragma unroll
+    for (uint i=0; i<TAP_SIZE; i++)
+    {
+        pr_weights[i] = 0;
+        pr_samples[i] = 0;
+    }
+
+    for (uint n=0; n<numSamples; n++)
+    {
+        #pragma unroll
+        for (uint i=0; i<TAP_SIZE-1; i++)
+            pr_samples[i] = pr_samples[i+1];
+
+        pr_samples[TAP_SIZE-1] = samples[n];
+
+        FLOATING_POINT y = 0;
+        FLOATING_POINT energy = 0;
+
+        #pragma unroll
+        for (uint j=0; j<TAP_SIZE; j+=MANUAL_MACS_L2_SIZE)
+        {
+            y += mac_manual(0, j, pr_samples, pr_weights);
+            energy += mac_manual(0, j, pr_samples, pr_samples);
+        }
+
+        FLOATING_POINT e = desired[n] - y;
+        FLOATING_POINT mu = normalized ? step / (LMS_DELTA + energy) : step;
+        FLOATING_POINT update = mu * e;
+
+        #pragma unroll
+        for (uint i=0; i<TAP_SIZE; i++)
+            pr_weights[i] += update * pr_samples[i];
+
+        errors[n] = e;
+    }
+
+    #pragma unroll MEM_BLOCK_SIZE
+    for (uint i=0; i<TAP_SIZE; i++)
+        weights[i] = pr_weights[TAP_SIZE-1-i];
+}
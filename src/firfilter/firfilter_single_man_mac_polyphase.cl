@@ -0,0 +1,189 @@
+/** @file firfilter_single_man_mac_polyphase.cl */
+
+#define MEM_BLOCK_SIZE_EFFECT BLOCK_SIZE % MEM_BLOCK_SIZE == 0 ? MEM_BLOCK_SIZE : BLOCK_SIZE
+
+#define MANUAL_MAC_L1_LEN 8
+#define MANUAL_MAC_L2_LEN 32
+#define MANUAL_MAC_L2_REPS 4
+#define MANUAL_MACS_L2_SIZE (MANUAL_MAC_L2_LEN*MANUAL_MAC_L2_REPS)
+
+// Input samples consumed per block of BLOCK_SIZE decimated outputs.
+#define DECIMATE_SPAN (RATE_FACTOR*BLOCK_SIZE)
+// Taps of each interpolation phase.
+#define PHASE_TAPS (TAP_SIZE/RATE_FACTOR)
+
+typedef float FLOATING_POINT;
+typedef unsigned int uint;
+
+FLOATING_POINT
+mac_8x(uint sampleIndex, uint coeffIndex,
+    FLOATING_POINT samples[], FLOATING_POINT coeffs[])
+{
+    return  samples[sampleIndex+0]*coeffs[coeffIndex+0] +
+            samples[sampleIndex+1]*coeffs[coeffIndex+1] +
+            samples[sampleIndex+2]*coeffs[coeffIndex+2] +
+            samples[sampleIndex+3]*coeffs[coeffIndex+3] +
+            samples[sampleIndex+4]*coeffs[coeffIndex+4] +
+            samples[sampleIndex+5]*coeffs[coeffIndex+5] +
+            samples[sampleIndex+6]*coeffs[coeffIndex+6] +
+            samples[sampleIndex+7]*coeffs[coeffIndex+7] ;
+}
+
+FLOATING_POINT
+mac_32x(uint blockIndex, uint sampleIndex,
+    FLOATING_POINT samples[], FLOATING_POINT coeffs[])
+{
+    return
+        mac_8x(sampleIndex+0*MANUAL_MAC_L1_LEN,
+            (sampleIndex-blockIndex)+0*MANUAL_MAC_L1_LEN, samples, coeffs)+
+        mac_8x(sampleIndex+1*MANUAL_MAC_L1_LEN,
+            (sampleIndex-blockIndex)+1*MANUAL_MAC_L1_LEN, samples, coeffs)+
+        mac_8x(sampleIndex+2*MANUAL_MAC_L1_LEN,
+            (sampleIndex-blockIndex)+2*MANUAL_MAC_L1_LEN, samples, coeffs)+
+        mac_8x(sampleIndex+3*MANUAL_MAC_L1_LEN,
+            (sampleIndex-blockIndex)+3*MANUAL_MAC_L1_LEN, samples, coeffs);
+}
+
+FLOATING_POINT
+mac_manual(uint blockIndex, uint sampleIndex,
+    FLOATING_POINT samples[], FLOATING_POINT coeffs[])
+{
+    return
+        mac_32x(blockIndex, sampleIndex+0*MANUAL_MAC_L2_LEN, samples, coeffs)+
+        mac_32x(blockIndex, sampleIndex+1*MANUAL_MAC_L2_LEN, samples, coeffs)+
+        mac_32x(blockIndex, sampleIndex+2*MANUAL_MAC_L2_LEN, samples, coeffs)+
+        mac_32x(blockIndex, sampleIndex+3*MANUAL_MAC_L2_LEN, samples, coeffs);
+}
+
+/****************************************************************************
+* <b>Function:</b> convolve_decimate()
+* <b>Purpose:</b> Within the FPGA, filter the input samples and decimate them
+* by RATE_FACTOR, i.e. only every RATE_FACTOR-th output of the full rate
+* filter is computed. A block of BLOCK_SIZE outputs takes DECIMATE_SPAN new
+* samples into the shift register, output j of the block starts its window
+* j*RATE_FACTOR samples further in.
+* @param samples the input samples to filter.
+* @param coefficients the TAP_SIZE filter coefficients.
+* @param result output -the (numSamples+RATE_FACTOR-1)/RATE_FACTOR decimated
+* samples.
+* @param numSamples the number of input samples.
+* @returns Void
+****************************************************************************/
+__attribute__((uses_global_work_offset(0)))
+__attribute__((max_global_work_dim(0)))
+__kernel void
+convolve_decimate(global FLOATING_POINT * restrict samples,
+                global FLOATING_POINT * restrict coefficients,
+                global FLOATING_POINT * restrict results,
+                uint numSamples)
+{
+    FLOATING_POINT pr_coeffs[TAP_SIZE];
+    #pragma unroll MEM_BLOCK_SIZE
+    for (uint i=0,j=TAP_SIZE-1; i<TAP_SIZE; i++,j--)
+        pr_coeffs[i] = coefficients[j];
+
+    FLOATING_POINT pr_samples[TAP_SIZE+DECIMATE_SPAN];
+    #pragma unroll TAP_SIZE+DECIMATE_SPAN
+    for (uint j=0; j<TAP_SIZE+DECIMATE_SPAN; j++)
+            pr_samples[j] = 0;
+
+    uint numOutputs = (numSamples + RATE_FACTOR - 1) / RATE_FACTOR;
+
+    for (uint i=0, o=0; i<numSamples; i+=DECIMATE_SPAN, o+=BLOCK_SIZE)
+    {
+        #pragma unroll TAP_SIZE
+        for (uint j=0; j<TAP_SIZE; j++)
+            pr_samples[j] = pr_samples[j+DECIMATE_SPAN];
+
+        #pragma unroll MEM_BLOCK_SIZE_EFFECT
+        for (uint j=0; j<DECIMATE_SPAN; j++)
+            pr_samples[TAP_SIZE-1+j] = i+j < numSamples ? samples[i+j] : 0;
+
+        FLOATING_POINT pr_results[BLOCK_SIZE];
+        #pragma unroll BLOCK_SIZE
+        for (uint j=0; j<BLOCK_SIZE; j++)
+            pr_results[j] = 0.0;
+
+        #pragma unroll ((BLOCK_SIZE*TAP_SIZE)/MANUAL_MACS_L2_SIZE)
+        for (uint j=0; j<BLOCK_SIZE*TAP_SIZE; j+=MANUAL_MACS_L2_SIZE)
+        {
+            uint blockIndex = j/TAP_SIZE;
+            uint windowIndex = blockIndex*RATE_FACTOR;
+            pr_results[blockIndex] +=
+                mac_manual(windowIndex, windowIndex+(j%TAP_SIZE), pr_samples, pr_coeffs);
+        }
+
+        #pragma unroll MEM_BLOCK_SIZE_EFFECT
+        for (uint j=0; j<BLOCK_SIZE; j++)
+            if (o+j < numOutputs) results[o+j] = pr_results[j];
+    }
+}
+
+/****************************************************************************
+* <b>Function:</b> convolve_interpolate()
+* <b>Purpose:</b> Within the FPGA, interpolate the input samples by
+* RATE_FACTOR: the output is the filtered input with RATE_FACTOR-1 zeros after
+* each sample. Output j*RATE_FACTOR+p is computed by the PHASE_TAPS
+* coefficients p, p+RATE_FACTOR, ... of phase p, so no products with the
+* stuffed zeros are made.
+* @param samples the input samples to filter.
+* @param coefficients the TAP_SIZE filter coefficients.
+* @param result output -the numSamples*RATE_FACTOR interpolated samples.
+* @param numSamples the number of input samples.
+* @returns Void
+****************************************************************************/
+__attribute__((uses_global_work_offset(0)))
+__attribute__((max_global_work_dim(0)))
+__kernel void
+convolve_interpolate(global FLOATING_POINT * restrict samples,
+                global FLOATING_POINT * restrict coefficients,
+                global FLOATING_POINT * restrict results,
+                uint numSamples)
+{
+    // The phases one after the other, each with reversed coefficients.
+    FLOATING_POINT pr_coeffs[TAP_SIZE];
+    #pragma unroll MEM_BLOCK_SIZE
+    for (uint i=0; i<TAP_SIZE; i++)
+    {
+        uint phase = i / PHASE_TAPS;
+        uint tap = PHASE_TAPS-1 - i % PHASE_TAPS;
+        pr_coeffs[i] = coefficients[phase + tap*RATE_FACTOR];
+    }
+
+    FLOATING_POINT pr_samples[PHASE_TAPS+BLOCK_SIZE];
+    #pragma unroll PHASE_TAPS+BLOCK_SIZE
+    for (uint j=0; j<PHASE_TAPS+BLOCK_SIZE; j++)
+            pr_samples[j] = 0;
+
+    for (uint i=0; i<numSamples; i+=BLOCK_SIZE)
+    {
+        #pragma unroll PHASE_TAPS
+        for (uint j=0; j<PHASE_TAPS; j++)
+            pr_samples[j] = pr_samples[j+BLOCK_SIZE];
+
+        #pragma unroll MEM_BLOCK_SIZE_EFFECT
+        for (uint j=0; j<BLOCK_SIZE; j++)
+            pr_samples[PHASE_TAPS-1+j] = i+j < numSamples ? samples[i+j] : 0;
+
+        FLOATING_POINT pr_results[BLOCK_SIZE*RATE_FACTOR];
+        #pragma unroll BLOCK_SIZE*RATE_FACTOR
+        for (uint j=0; j<BLOCK_SIZE*RATE_FACTOR; j++)
+            pr_results[j] = 0.0;
+
+        #pragma unroll ((BLOCK_SIZE*TAP_SIZE)/MANUAL_MAC_L1_LEN)
+        for (uint j=0; j<BLOCK_SIZE*TAP_SIZE; j+=MANUAL_MAC_L1_LEN)
+        {
+            uint output = j/PHASE_TAPS;
+            uint blockIndex = output/RATE_FACTOR;
+            uint phase = output%RATE_FACTOR;
+            uint tap = j%PHASE_TAPS;
+            pr_results[output] +=
+                mac_8x(blockIndex+tap, phase*PHASE_TAPS+tap, pr_samples, pr_coeffs);
+        }
+
+        #pragma unroll MEM_BLOCK_SIZE_EFFECT
+        for (uint j=0; j<BLOCK_SIZE*RATE_FACTOR; j++)
+            if (i*RATE_FACTOR+j < numSamples*RATE_FACTOR)
+                results[i*RATE_FACTOR+j] = pr_results[j];
+    }
+}
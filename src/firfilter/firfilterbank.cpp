@@ -0,0 +1,159 @@
+#include <stdlib.h>
+#include <math.h>
+#include <iostream>
+#include <thread>
+#include <algorithm>
+
+#include "firfilterbank.h"
+
+using namespace std;
+
+/****************************************************************************
+* Function: parseChannelCounts()
+*
+* Purpose: Parses the comma separated, positive channel counts of the filter
+*          bank mode.
+*
+* @param list the channel counts, e.g. "64,256,1024".
+* @param channelCounts output -the parsed counts.
+* @returns false if a count is not a positive number.
+*
+*****************************************************************************/
+bool parseChannelCounts(string list, vector<int> &channelCounts)
+{
+    channelCounts.clear();
+
+    size_t begin = 0;
+    while (begin <= list.size())
+    {
+        size_t end = list.find(',', begin);
+        if (end == string::npos) end = list.size();
+
+        string count = list.substr(begin, end - begin);
+        begin = end + 1;
+
+        if (count.empty()) continue;
+
+        char* rest;
+        long channels = strtol(count.c_str(), &rest, 10);
+
+        if (*rest != '\0' || channels < 1 || channels > (1 << 20))
+        {
+            cout << "Invalid fir filter channel count: " << count << endl;
+            return false;
+        }
+
+        channelCounts.push_back(channels);
+    }
+
+    return !channelCounts.empty();
+}
+
+/****************************************************************************
+* Function: makeFilterBank()
+*
+* Purpose: Builds a cosine modulated filter bank from the data files: channel
+*          c filters the input samples, started c*997 samples in, by the file
+*          coefficients shifted to the band of the channel.
+*
+* @param bank output -the interleaved filter bank data.
+* @param benchmarkData the input benchmark data.
+* @param numChannels the number of channels.
+* @param numSamples the number of samples per channel.
+* @returns Void
+*
+*****************************************************************************/
+void makeFilterBank(FilterBank &bank, BenchmarkData &benchmarkData, int numChannels,
+                    int numSamples)
+{
+    FLOATING_POINT* samples = benchmarkData.samples.elements;
+    FLOATING_POINT* coefficients = benchmarkData.coefficients.elements;
+    int fileSamples = benchmarkData.samples.size;
+    int numCoefficients = benchmarkData.coefficients.size;
+
+    bank.numChannels = numChannels;
+    bank.numSamples = numSamples;
+    bank.numCoefficients = numCoefficients;
+    bank.samples.resize(long(numSamples) * numChannels);
+    bank.coefficients.resize(long(numCoefficients) * numChannels);
+
+    for (int n=0; n<numSamples; n++)
+    {
+        for (int c=0; c<numChannels; c++)
+            bank.samples[long(n)*numChannels + c] = samples[(n + c*997L) % fileSamples];
+    }
+
+    for (int k=0; k<numCoefficients; k++)
+    {
+        for (int c=0; c<numChannels; c++)
+        {
+            bank.coefficients[long(k)*numChannels + c] = coefficients[k] *
+                2 * cos(M_PI * (c + 0.5) * (k - (numCoefficients-1) / 2.0) / numChannels);
+        }
+    }
+}
+
+// Filters the channels [first, last) of the bank, the inner loop runs over
+// neighbouring channels and is vectorized.
+static void filterBankChannels(const FilterBank &bank, FLOATING_POINT* results,
+                    int first, int last)
+{
+    int numChannels = bank.numChannels;
+    int numCoefficients = bank.numCoefficients;
+    int width = last - first;
+
+    for (int n=0; n<bank.numSamples; n++)
+    {
+        FLOATING_POINT sums[FIR_BANK_CHANNEL_CHUNK] = {0};
+        int taps = min(numCoefficients, n+1);
+
+        for (int k=0; k<taps; k++)
+        {
+            const FLOATING_POINT* sampleRow = &bank.samples[long(n-k)*numChannels + first];
+            const FLOATING_POINT* coeffRow = &bank.coefficients[long(k)*numChannels + first];
+
+            for (int c=0; c<width; c++)
+                sums[c] += coeffRow[c] * sampleRow[c];
+        }
+
+        for (int c=0; c<width; c++)
+            results[long(n)*numChannels + first + c] = sums[c];
+    }
+}
+
+/****************************************************************************
+* Function: filterBankCPU()
+*
+* Purpose: Filters every channel of the bank on the host, chunks of
+*          FIR_BANK_CHANNEL_CHUNK channels are spread over the threads.
+*
+* @param bank the interleaved filter bank data.
+* @param results output -the interleaved results.
+* @param numThreads the number of threads, 0 for all cores.
+* @returns Void
+*
+*****************************************************************************/
+void filterBankCPU(const FilterBank &bank, FLOATING_POINT* results, int numThreads)
+{
+    int numChunks = (bank.numChannels + FIR_BANK_CHANNEL_CHUNK - 1) / FIR_BANK_CHANNEL_CHUNK;
+
+    if (numThreads <= 0) numThreads = max(1u, thread::hardware_concurrency());
+    numThreads = min(numThreads, numChunks);
+
+    vector<thread> threads;
+
+    for (int t=0; t<numThreads; t++)
+    {
+        threads.push_back(thread([&bank, results, numChunks, numThreads, t]()
+        {
+            for (int chunk=t; chunk<numChunks; chunk+=numThreads)
+            {
+                int first = chunk * FIR_BANK_CHANNEL_CHUNK;
+                int last = min(bank.numChannels, first + FIR_BANK_CHANNEL_CHUNK);
+                filterBankChannels(bank, results, first, last);
+            }
+        }));
+    }
+
+    for (thread &t : threads) t.join();
+}
@@ -0,0 +1,33 @@
+#ifndef FIR_BANK_H
+#define FIR_BANK_H
+
+#include <string>
+#include <vector>
+
+#include "firfilterutility.h"
+
+#define FIR_MODE_BANK "bank"
+
+// Channels filtered together by a host thread, the working set of their
+// samples and coefficients stays in the cache.
+#define FIR_BANK_CHANNEL_CHUNK 64
+
+// A filter bank of numChannels independent channels, with the samples,
+// coefficients and results interleaved by channel (element n of channel c
+// at n*numChannels+c).
+typedef struct {
+    int numChannels;
+    int numSamples;         // per channel
+    int numCoefficients;    // per channel
+    std::vector<FLOATING_POINT> samples;
+    std::vector<FLOATING_POINT> coefficients;
+} FilterBank;
+
+bool parseChannelCounts(std::string list, std::vector<int> &channelCounts);
+
+void makeFilterBank(FilterBank &bank, BenchmarkData &benchmarkData, int numChannels,
+                    int numSamples);
+
+void filterBankCPU(const FilterBank &bank, FLOATING_POINT* results, int numThreads);
+
+#endif
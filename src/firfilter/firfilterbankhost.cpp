@@ -0,0 +1,143 @@
+/** @file firfilterbankhost.cpp */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <string.h>
+
+#include "../common/utility.h"
+#include "../common/benchmarkoptions.h"
+
+#include "firfilterutility.h"
+#include "firfilterbank.h"
+#include "firfilterhost.h"
+
+using namespace std;
+
+/****************************************************************************
+* Function: filterBankFPGA()
+*
+* Purpose: On the FPGA, filter every channel of the filter bank by its own
+*          coefficients in one launch of the convolve_bank kernel.
+*
+* @param ctx the opencl context to use for the benchmark
+* @param queue the opencl command queue to issue commands to
+* @param prog the opencl program containing the kernel
+* @param bank the interleaved filter bank data.
+* @param result output -the interleaved results.
+* @returns The kernel runtime in seconds.
+*
+*****************************************************************************/
+double filterBankFPGA(cl_device_id dev,
+                             cl_context ctx,
+                             cl_command_queue queue,
+                             cl_program prog,
+                             FilterBank &bank,
+                             FLOATING_POINT* results)
+{
+    int numSamples = bank.numSamples;
+    int numChannels = bank.numChannels;
+    size_t samplesSize = sizeof(FLOATING_POINT) * bank.samples.size();
+    size_t coefficientsSize = sizeof(FLOATING_POINT) * bank.coefficients.size();
+
+    int err;
+
+    //
+    // find the kernel
+    //
+    cl_kernel filterkernel = clCreateKernel(prog, "convolve_bank", &err);
+    CL_CHECK_ERROR(err);
+
+    //
+    // allocate device memory for input and output buffers.
+    //
+    cl_mem d_samples = clCreateBuffer(ctx, CL_MEM_READ_ONLY,
+                                          samplesSize, NULL, &err);
+    CL_CHECK_ERROR(err);
+
+    cl_mem d_coefficients = clCreateBuffer(ctx, CL_MEM_READ_ONLY,
+                                          coefficientsSize, NULL, &err);
+    CL_CHECK_ERROR(err);
+
+    cl_mem d_results = clCreateBuffer(ctx, CL_MEM_WRITE_ONLY,
+                                          samplesSize, NULL, &err);
+    CL_CHECK_ERROR(err);
+
+    //
+    // write input buffers to the device memory.
+    //
+    err = clEnqueueWriteBuffer(queue, d_samples, true, 0,
+                               samplesSize, bank.samples.data(),
+                               0, NULL, NULL);
+    CL_CHECK_ERROR(err);
+
+    err = clEnqueueWriteBuffer(queue, d_coefficients, true, 0,
+                               coefficientsSize, bank.coefficients.data(),
+                               0, NULL, NULL);
+    CL_CHECK_ERROR(err);
+
+    err = clFinish(queue);
+    CL_CHECK_ERROR(err);
+
+    //
+    // set arguments for the kernel
+    //
+    err = clSetKernelArg(filterkernel, 0, sizeof(cl_mem), (void*)&d_samples);
+    CL_CHECK_ERROR(err);
+    err = clSetKernelArg(filterkernel, 1, sizeof(cl_mem), (void*)&d_coefficients);
+    CL_CHECK_ERROR(err);
+    err = clSetKernelArg(filterkernel, 2, sizeof(cl_mem), (void*)&d_results);
+    CL_CHECK_ERROR(err);
+    err = clSetKernelArg(filterkernel, 3, sizeof(int), (void*)&numSamples);
+    CL_CHECK_ERROR(err);
+    err = clSetKernelArg(filterkernel, 4, sizeof(int), (void*)&numChannels);
+    CL_CHECK_ERROR(err);
+
+    //
+    // run the kernel
+    //
+    cl_event event = NULL;
+    err = clEnqueueTask(queue, filterkernel, 0, NULL, &event);
+    CL_CHECK_ERROR(err);
+
+    err = clFinish(queue);
+    CL_CHECK_ERROR (err);
+
+    //
+    // get the timing/rate info
+    //
+    cl_ulong submitTime;
+    cl_ulong endTime;
+
+    err = clGetEventProfilingInfo(event, CL_PROFILING_COMMAND_SUBMIT,
+                                    sizeof(cl_ulong), &submitTime, NULL);
+    CL_CHECK_ERROR(err);
+
+    err = clGetEventProfilingInfo(event, CL_PROFILING_COMMAND_END,
+                                    sizeof(cl_ulong), &endTime, NULL);
+    CL_CHECK_ERROR(err);
+
+    double nanosec = endTime - submitTime;
+
+    //
+    // read the filtered channels
+    //
+    err = clEnqueueReadBuffer(queue, d_results, true, 0,
+                              samplesSize, results,
+                              0, NULL, NULL);
+    CL_CHECK_ERROR(err);
+
+    //
+    // free device memory
+    //
+    clReleaseEvent(event);
+    clReleaseMemObject(d_samples);
+    clReleaseMemObject(d_coefficients);
+    clReleaseMemObject(d_results);
+    clReleaseKernel(filterkernel);
+
+    //
+    // return the runtime in seconds
+    //
+    return nanosec / 1.e9;
+}
@@ -0,0 +1,364 @@
+#include <stdlib.h>
+#include <math.h>
+#include <string.h>
+#include <chrono>
+#include <limits>
+#include <algorithm>
+
+#ifdef __AVX__
+#include <immintrin.h>
+#endif
+
+#include "firfilterfft.h"
+
+using namespace std;
+
+int nextPowerOfTwo(int n)
+{
+    int power = 1;
+    while (power < n) power <<= 1;
+    return power;
+}
+
+void initFftPlan(FftPlan &plan, int size)
+{
+    plan.size = size;
+    plan.twiddles.clear();
+
+    for (int len=size; len>=4; len/=4)
+    {
+        int m = len/4;
+        size_t offset = plan.twiddles.size();
+        plan.twiddles.resize(offset + 6*m);
+
+        FLOATING_POINT* w = &plan.twiddles[offset];
+        for (int k=1; k<=3; k++)
+        {
+            for (int p=0; p<m; p++)
+            {
+                double angle = -2.0 * M_PI * k * p / len;
+                w[(2*k-2)*m + p] = cos(angle);
+                w[(2*k-1)*m + p] = sin(angle);
+            }
+        }
+    }
+
+    plan.workRe.resize(size);
+    plan.workIm.resize(size);
+}
+
+#ifdef __AVX__
+static inline __m256 complexMulRe(__m256 ar, __m256 ai, __m256 br, __m256 bi)
+{
+#ifdef __FMA__
+    return _mm256_fmsub_ps(ar, br, _mm256_mul_ps(ai, bi));
+#else
+    return _mm256_sub_ps(_mm256_mul_ps(ar, br), _mm256_mul_ps(ai, bi));
+#endif
+}
+
+static inline __m256 complexMulIm(__m256 ar, __m256 ai, __m256 br, __m256 bi)
+{
+#ifdef __FMA__
+    return _mm256_fmadd_ps(ar, bi, _mm256_mul_ps(ai, br));
+#else
+    return _mm256_add_ps(_mm256_mul_ps(ar, bi), _mm256_mul_ps(ai, br));
+#endif
+}
+#endif
+
+// One radix-4 Stockham stage of length len and stride s, the q (stride)
+// loop is contiguous in memory and vectorized once s is wide enough.
+static void radix4Stage(int len, int s, const FLOATING_POINT* w,
+                        const FLOATING_POINT* xr, const FLOATING_POINT* xi,
+                        FLOATING_POINT* yr, FLOATING_POINT* yi)
+{
+    int m = len/4;
+
+    for (int p=0; p<m; p++)
+    {
+        FLOATING_POINT w1r = w[p],     w1i = w[m+p];
+        FLOATING_POINT w2r = w[2*m+p], w2i = w[3*m+p];
+        FLOATING_POINT w3r = w[4*m+p], w3i = w[5*m+p];
+
+        const FLOATING_POINT *ar = xr + s*p,       *ai = xi + s*p;
+        const FLOATING_POINT *br = xr + s*(p+m),   *bi = xi + s*(p+m);
+        const FLOATING_POINT *cr = xr + s*(p+2*m), *ci = xi + s*(p+2*m);
+        const FLOATING_POINT *dr = xr + s*(p+3*m), *di = xi + s*(p+3*m);
+
+        FLOATING_POINT *y0r = yr + s*(4*p),   *y0i = yi + s*(4*p);
+        FLOATING_POINT *y1r = yr + s*(4*p+1), *y1i = yi + s*(4*p+1);
+        FLOATING_POINT *y2r = yr + s*(4*p+2), *y2i = yi + s*(4*p+2);
+        FLOATING_POINT *y3r = yr + s*(4*p+3), *y3i = yi + s*(4*p+3);
+
+        int q = 0;
+
+#ifdef __AVX__
+        __m256 vw1r = _mm256_set1_ps(w1r), vw1i = _mm256_set1_ps(w1i);
+        __m256 vw2r = _mm256_set1_ps(w2r), vw2i = _mm256_set1_ps(w2i);
+        __m256 vw3r = _mm256_set1_ps(w3r), vw3i = _mm256_set1_ps(w3i);
+
+        for (; q+8<=s; q+=8)
+        {
+            __m256 var = _mm256_loadu_ps(ar+q), vai = _mm256_loadu_ps(ai+q);
+            __m256 vbr = _mm256_loadu_ps(br+q), vbi = _mm256_loadu_ps(bi+q);
+            __m256 vcr = _mm256_loadu_ps(cr+q), vci = _mm256_loadu_ps(ci+q);
+            __m256 vdr = _mm256_loadu_ps(dr+q), vdi = _mm256_loadu_ps(di+q);
+
+            __m256 apcr = _mm256_add_ps(var, vcr), apci = _mm256_add_ps(vai, vci);
+            __m256 amcr = _mm256_sub_ps(var, vcr), amci = _mm256_sub_ps(vai, vci);
+            __m256 bpdr = _mm256_add_ps(vbr, vdr), bpdi = _mm256_add_ps(vbi, vdi);
+            __m256 bmdr = _mm256_sub_ps(vbr, vdr), bmdi = _mm256_sub_ps(vbi, vdi);
+
+            __m256 t1r = _mm256_add_ps(amcr, bmdi), t1i = _mm256_sub_ps(amci, bmdr);
+            __m256 t2r = _mm256_sub_ps(apcr, bpdr), t2i = _mm256_sub_ps(apci, bpdi);
+            __m256 t3r = _mm256_sub_ps(amcr, bmdi), t3i = _mm256_add_ps(amci, bmdr);
+
+            _mm256_storeu_ps(y0r+q, _mm256_add_ps(apcr, bpdr));
+            _mm256_storeu_ps(y0i+q, _mm256_add_ps(apci, bpdi));
+            _mm256_storeu_ps(y1r+q, complexMulRe(vw1r, vw1i, t1r, t1i));
+            _mm256_storeu_ps(y1i+q, complexMulIm(vw1r, vw1i, t1r, t1i));
+            _mm256_storeu_ps(y2r+q, complexMulRe(vw2r, vw2i, t2r, t2i));
+            _mm256_storeu_ps(y2i+q, complexMulIm(vw2r, vw2i, t2r, t2i));
+            _mm256_storeu_ps(y3r+q, complexMulRe(vw3r, vw3i, t3r, t3i));
+            _mm256_storeu_ps(y3i+q, complexMulIm(vw3r, vw3i, t3r, t3i));
+        }
+#endif
+
+        for (; q<s; q++)
+        {
+            FLOATING_POINT apcr = ar[q] + cr[q], apci = ai[q] + ci[q];
+            FLOATING_POINT amcr = ar[q] - cr[q], amci = ai[q] - ci[q];
+            FLOATING_POINT bpdr = br[q] + dr[q], bpdi = bi[q] + di[q];
+            FLOATING_POINT bmdr = br[q] - dr[q], bmdi = bi[q] - di[q];
+
+            // (a-c) -/+ j(b-d)
+            FLOATING_POINT t1r = amcr + bmdi, t1i = amci - bmdr;
+            FLOATING_POINT t2r = apcr - bpdr, t2i = apci - bpdi;
+            FLOATING_POINT t3r = amcr - bmdi, t3i = amci + bmdr;
+
+            y0r[q] = apcr + bpdr;
+            y0i[q] = apci + bpdi;
+            y1r[q] = w1r*t1r - w1i*t1i;
+            y1i[q] = w1r*t1i + w1i*t1r;
+            y2r[q] = w2r*t2r - w2i*t2i;
+            y2i[q] = w2r*t2i + w2i*t2r;
+            y3r[q] = w3r*t3r - w3i*t3i;
+            y3i[q] = w3r*t3i + w3i*t3r;
+        }
+    }
+}
+
+// The last (twiddle free) radix-2 stage for odd powers of two.
+static void radix2Stage(int s, const FLOATING_POINT* xr, const FLOATING_POINT* xi,
+                        FLOATING_POINT* yr, FLOATING_POINT* yi)
+{
+    for (int q=0; q<s; q++)
+    {
+        FLOATING_POINT ar = xr[q], ai = xi[q];
+        FLOATING_POINT br = xr[q+s], bi = xi[q+s];
+
+        yr[q] = ar + br;
+        yi[q] = ai + bi;
+        yr[q+s] = ar - br;
+        yi[q+s] = ai - bi;
+    }
+}
+
+// In-place forward fft, the output is in natural order.
+void fft(FftPlan &plan, FLOATING_POINT* re, FLOATING_POINT* im)
+{
+    FLOATING_POINT *xr = re, *xi = im;
+    FLOATING_POINT *yr = plan.workRe.data(), *yi = plan.workIm.data();
+    const FLOATING_POINT* w = plan.twiddles.data();
+
+    int s = 1;
+    for (int len=plan.size; len>=4; len/=4)
+    {
+        radix4Stage(len, s, w, xr, xi, yr, yi);
+        w += 6*(len/4);
+        s *= 4;
+        swap(xr, yr);
+        swap(xi, yi);
+    }
+
+    if (s < plan.size)
+    {
+        radix2Stage(s, xr, xi, yr, yi);
+        swap(xr, yr);
+        swap(xi, yi);
+    }
+
+    if (xr != re)
+    {
+        memcpy(re, xr, plan.size*sizeof(FLOATING_POINT));
+        memcpy(im, xi, plan.size*sizeof(FLOATING_POINT));
+    }
+}
+
+void initFftFilter(FftFilter &filter, const FLOATING_POINT* coefficients,
+                    int numCoefficients, int fftSize)
+{
+    initFftPlan(filter.plan, fftSize);
+    filter.numCoefficients = numCoefficients;
+    filter.segmentSize = fftSize - numCoefficients + 1;
+
+    filter.spectrumRe.assign(fftSize, 0);
+    filter.spectrumIm.assign(fftSize, 0);
+    for (int i=0; i<numCoefficients; i++)
+        filter.spectrumRe[i] = coefficients[i] / fftSize;
+
+    fft(filter.plan, filter.spectrumRe.data(), filter.spectrumIm.data());
+
+    filter.re.resize(fftSize);
+    filter.im.resize(fftSize);
+}
+
+/****************************************************************************
+* Function: filterSamplesFFT()
+*
+* Purpose: Applies the FIR filter by overlap-add fast convolution. Each fft
+*          carries two consecutive segments of segmentSize samples, one as
+*          the real and one as the imaginary part, since the filter is real
+*          both convolutions come out separated the same way.
+*
+* @param filter the fft filter made by initFftFilter().
+* @param samples the input samples to convolve.
+* @param numSamples the number of input samples.
+* @param results output -the resulted convolved samples.
+* @returns Void
+*
+*****************************************************************************/
+void filterSamplesFFT(FftFilter &filter, const FLOATING_POINT* samples,
+                    int numSamples, FLOATING_POINT* results)
+{
+    int size = filter.plan.size;
+    int segment = filter.segmentSize;
+    FLOATING_POINT* re = filter.re.data();
+    FLOATING_POINT* im = filter.im.data();
+    const FLOATING_POINT* hr = filter.spectrumRe.data();
+    const FLOATING_POINT* hi = filter.spectrumIm.data();
+
+    memset(results, 0, numSamples*sizeof(FLOATING_POINT));
+
+    for (int base=0; base<numSamples; base+=2*segment)
+    {
+        int countA = min(segment, numSamples-base);
+        int countB = max(0, min(segment, numSamples-base-segment));
+
+        memset(re, 0, size*sizeof(FLOATING_POINT));
+        memset(im, 0, size*sizeof(FLOATING_POINT));
+        memcpy(re, samples+base, countA*sizeof(FLOATING_POINT));
+        memcpy(im, samples+base+segment, countB*sizeof(FLOATING_POINT));
+
+        fft(filter.plan, re, im);
+
+        // Multiply by the spectrum and conjugate, so that the forward fft
+        // below gives the conjugate of the inverse fft.
+        for (int k=0; k<size; k++)
+        {
+            FLOATING_POINT r = re[k]*hr[k] - im[k]*hi[k];
+            FLOATING_POINT i = re[k]*hi[k] + im[k]*hr[k];
+            re[k] = r;
+            im[k] = -i;
+        }
+
+        fft(filter.plan, re, im);
+
+        int outA = min(size, numSamples-base);
+        for (int i=0; i<outA; i++)
+            results[base+i] += re[i];
+
+        int outB = countB > 0 ? min(size, numSamples-base-segment) : 0;
+        for (int i=0; i<outB; i++)
+            results[base+segment+i] -= im[i];
+    }
+}
+
+// Average seconds of one call of run, repeated for at least a millisecond.
+template<class F>
+static double measureSeconds(F run)
+{
+    typedef chrono::steady_clock Clock;
+
+    int calls = 0;
+    Clock::time_point start = Clock::now();
+    double seconds;
+    do
+    {
+        run();
+        calls++;
+        seconds = chrono::duration<double>(Clock::now() - start).count();
+    }
+    while (seconds < 1.e-3);
+
+    return seconds / calls;
+}
+
+/****************************************************************************
+* Function: measureFirMethod()
+*
+* Purpose: Chooses between the direct and the fft filter by timing both on
+*          this host. The direct cost per sample is measured on a slice of the
+*          samples, the fft cost of every power of two size from 2x the tap
+*          count up to the block is measured per pair of segments and scaled
+*          to the pairs the whole block needs.
+*
+* @param samples the input samples (used for the timing runs).
+* @param numSamples the number of samples filtered at a time.
+* @param coefficients the filter coefficients.
+* @param numCoefficients the number of filter coefficients.
+* @returns The cheaper method, its fft size and the measured costs.
+*
+*****************************************************************************/
+FirMethodChoice measureFirMethod(const FLOATING_POINT* samples, int numSamples,
+                    const FLOATING_POINT* coefficients, int numCoefficients)
+{
+    FirMethodChoice choice;
+
+    int directSamples = min(numSamples, 4096);
+    vector<FLOATING_POINT> history(numCoefficients-1);
+    vector<FLOATING_POINT> results(max(directSamples, 1));
+
+    choice.directCost = measureSeconds([&]()
+    {
+        fill(history.begin(), history.end(), 0);
+        filterSamplesCPU(samples, directSamples, coefficients, numCoefficients,
+                        history.data(), results.data());
+    }) / max(directSamples, 1);
+
+    choice.fftSize = 0;
+    choice.fftCost = numeric_limits<double>::infinity();
+
+    int smallest = nextPowerOfTwo(2*numCoefficients);
+    int largest = max(smallest,
+        min(FIR_MAX_FFT_SIZE, nextPowerOfTwo(numSamples+numCoefficients-1)));
+
+    for (int size=smallest; size<=largest; size*=2)
+    {
+        FftFilter filter;
+        initFftFilter(filter, coefficients, numCoefficients, size);
+
+        int pairSamples = min(numSamples, 2*filter.segmentSize);
+        results.resize(max(pairSamples, 1));
+
+        double pairSeconds = measureSeconds([&]()
+        {
+            filterSamplesFFT(filter, samples, pairSamples, results.data());
+        });
+
+        long pairs = (long(numSamples) + 2*filter.segmentSize - 1)
+                        / (2*filter.segmentSize);
+        double cost = pairSeconds * pairs / max(numSamples, 1);
+
+        if (cost < choice.fftCost)
+        {
+            choice.fftCost = cost;
+            choice.fftSize = size;
+        }
+    }
+
+    choice.useFft = choice.fftCost < choice.directCost;
+
+    return choice;
+}
@@ -0,0 +1,60 @@
+#ifndef FIR_FFT_H
+#define FIR_FFT_H
+
+#include <vector>
+
+#include "firfilterutility.h"
+
+// Log2 of the fft size the convolve_fft kernel is compiled with (set by CMake).
+#ifndef FIR_FFT_LOG2
+#define FIR_FFT_LOG2 10
+#endif
+
+#define FIR_METHOD_DIRECT "direct"
+#define FIR_METHOD_FFT "fft"
+#define FIR_METHOD_AUTO "auto"
+
+// Largest fft size considered by the cost model.
+#define FIR_MAX_FFT_SIZE (1 << 20)
+
+// Split (real/imaginary) complex fft of a power of two size, computed by
+// radix-4 Stockham stages (plus a final radix-2 stage for odd powers).
+typedef struct {
+    int size;
+    // Per radix-4 stage: w^p, w^2p, w^3p as (re, im) arrays of size/4^(stage+1).
+    std::vector<FLOATING_POINT> twiddles;
+    std::vector<FLOATING_POINT> workRe, workIm;
+} FftPlan;
+
+// Overlap-add fast convolution, two real input segments are filtered by a
+// single complex fft as the real and imaginary part.
+typedef struct {
+    FftPlan plan;
+    int numCoefficients;
+    int segmentSize;
+    // Spectrum of the coefficients, scaled by 1/size for the inverse fft.
+    std::vector<FLOATING_POINT> spectrumRe, spectrumIm;
+    std::vector<FLOATING_POINT> re, im;
+} FftFilter;
+
+typedef struct {
+    bool useFft;
+    int fftSize;
+    double directCost;  // seconds per output sample
+    double fftCost;     // seconds per output sample with fftSize
+} FirMethodChoice;
+
+int nextPowerOfTwo(int n);
+
+void initFftPlan(FftPlan &plan, int size);
+void fft(FftPlan &plan, FLOATING_POINT* re, FLOATING_POINT* im);
+
+void initFftFilter(FftFilter &filter, const FLOATING_POINT* coefficients,
+                    int numCoefficients, int fftSize);
+void filterSamplesFFT(FftFilter &filter, const FLOATING_POINT* samples,
+                    int numSamples, FLOATING_POINT* results);
+
+FirMethodChoice measureFirMethod(const FLOATING_POINT* samples, int numSamples,
+                    const FLOATING_POINT* coefficients, int numCoefficients);
+
+#endif
@@ -0,0 +1,174 @@
+/** @file firfilterffthost.cpp */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <string.h>
+
+#include "../common/utility.h"
+#include "../common/benchmarkoptions.h"
+
+#include "firfilterutility.h"
+#include "firfilterfft.h"
+#include "firfilterhost.h"
+
+using namespace std;
+
+/****************************************************************************
+* Function: filterSamplesFPGAFft()
+*
+* Purpose: On the FPGA, apply the FIR filter in coefficients to the input
+*          samples by overlap-add fft convolution (convolve_fft kernel). The
+*          spectrum of the coefficients and the twiddles are computed on the
+*          host.
+*
+* @param ctx the opencl context to use for the benchmark
+* @param queue the opencl command queue to issue commands to
+* @param prog the opencl program containing the kernel
+* @param benchmarkData the input benchmark data to convolve.
+* @param result output -the resulted convolved samples.
+* @returns The kernel runtime in seconds.
+*
+*****************************************************************************/
+double filterSamplesFPGAFft(cl_device_id dev,
+                             cl_context ctx,
+                             cl_command_queue queue,
+                             cl_program prog,
+                             BenchmarkData &benchmarkData,
+                             FLOATING_POINT* results)
+{
+    FLOATING_POINT* samples = benchmarkData.samples.elements;
+    int numSamples = benchmarkData.samples.size;
+    int numCoefficients = benchmarkData.coefficients.size;
+    int fftSize = 1 << FIR_FFT_LOG2;
+
+    int err;
+
+    //
+    // prepare the spectrum and twiddles, real parts followed by
+    // imaginary parts.
+    //
+    FftFilter filter;
+    initFftFilter(filter, benchmarkData.coefficients.elements, numCoefficients, fftSize);
+
+    vector<FLOATING_POINT> spectrum(filter.spectrumRe);
+    spectrum.insert(spectrum.end(), filter.spectrumIm.begin(), filter.spectrumIm.end());
+
+    vector<FLOATING_POINT> twiddles(fftSize);
+    for (int k=0; k<fftSize/2; k++)
+    {
+        twiddles[k] = cos(-2.0 * M_PI * k / fftSize);
+        twiddles[fftSize/2+k] = sin(-2.0 * M_PI * k / fftSize);
+    }
+
+    //
+    // find the kernel
+    //
+    cl_kernel filterkernel = clCreateKernel(prog, "convolve_fft", &err);
+    CL_CHECK_ERROR(err);
+
+    //
+    // allocate device memory for input and output buffers.
+    //
+    cl_mem d_samples = clCreateBuffer(ctx, CL_MEM_READ_ONLY,
+                                          sizeof(FLOATING_POINT)*numSamples, NULL, &err);
+    CL_CHECK_ERROR(err);
+
+    cl_mem d_spectrum = clCreateBuffer(ctx, CL_MEM_READ_ONLY,
+                                          sizeof(FLOATING_POINT)*2*fftSize, NULL, &err);
+    CL_CHECK_ERROR(err);
+
+    cl_mem d_twiddles = clCreateBuffer(ctx, CL_MEM_READ_ONLY,
+                                          sizeof(FLOATING_POINT)*fftSize, NULL, &err);
+    CL_CHECK_ERROR(err);
+
+    cl_mem d_results = clCreateBuffer(ctx, CL_MEM_WRITE_ONLY,
+                                          sizeof(FLOATING_POINT)*numSamples, NULL, &err);
+    CL_CHECK_ERROR(err);
+
+    //
+    // write input buffers to the device memory.
+    //
+    err = clEnqueueWriteBuffer(queue, d_samples, true, 0,
+                               sizeof(FLOATING_POINT)*numSamples, samples,
+                               0, NULL, NULL);
+    CL_CHECK_ERROR(err);
+
+    err = clEnqueueWriteBuffer(queue, d_spectrum, true, 0,
+                               sizeof(FLOATING_POINT)*2*fftSize, spectrum.data(),
+                               0, NULL, NULL);
+    CL_CHECK_ERROR(err);
+
+    err = clEnqueueWriteBuffer(queue, d_twiddles, true, 0,
+                               sizeof(FLOATING_POINT)*fftSize, twiddles.data(),
+                               0, NULL, NULL);
+    CL_CHECK_ERROR(err);
+
+    err = clFinish(queue);
+    CL_CHECK_ERROR(err);
+
+    //
+    // set arguments for the kernel
+    //
+    err = clSetKernelArg(filterkernel, 0, sizeof(cl_mem), (void*)&d_samples);
+    CL_CHECK_ERROR(err);
+    err = clSetKernelArg(filterkernel, 1, sizeof(cl_mem), (void*)&d_spectrum);
+    CL_CHECK_ERROR(err);
+    err = clSetKernelArg(filterkernel, 2, sizeof(cl_mem), (void*)&d_twiddles);
+    CL_CHECK_ERROR(err);
+    err = clSetKernelArg(filterkernel, 3, sizeof(cl_mem), (void*)&d_results);
+    CL_CHECK_ERROR(err);
+    err = clSetKernelArg(filterkernel, 4, sizeof(int), (void*)&numSamples);
+    CL_CHECK_ERROR(err);
+    err = clSetKernelArg(filterkernel, 5, sizeof(int), (void*)&numCoefficients);
+    CL_CHECK_ERROR(err);
+
+    //
+    // run the kernel
+    //
+    cl_event event = NULL;
+    err = clEnqueueTask(queue, filterkernel, 0, NULL, &event);
+    CL_CHECK_ERROR(err);
+
+    err = clFinish(queue);
+    CL_CHECK_ERROR (err);
+
+    //
+    // get the timing/rate info
+    //
+    cl_ulong submitTime;
+    cl_ulong endTime;
+
+    err = clGetEventProfilingInfo(event, CL_PROFILING_COMMAND_SUBMIT,
+                                    sizeof(cl_ulong), &submitTime, NULL);
+    CL_CHECK_ERROR(err);
+
+    err = clGetEventProfilingInfo(event, CL_PROFILING_COMMAND_END,
+                                    sizeof(cl_ulong), &endTime, NULL);
+    CL_CHECK_ERROR(err);
+
+    double nanosec = endTime - submitTime;
+
+    //
+    // read the samples response result
+    //
+    err = clEnqueueReadBuffer(queue, d_results, true, 0,
+                              sizeof(FLOATING_POINT)*(numSamples), results,
+                              0, NULL, NULL);
+    CL_CHECK_ERROR(err);
+
+    //
+    // free device memory
+    //
+    clReleaseEvent(event);
+    clReleaseMemObject(d_samples);
+    clReleaseMemObject(d_spectrum);
+    clReleaseMemObject(d_twiddles);
+    clReleaseMemObject(d_results);
+    clReleaseKernel(filterkernel);
+
+    //
+    // return the runtime in seconds
+    //
+    return nanosec / 1.e9;
+}
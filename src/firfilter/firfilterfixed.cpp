@@ -0,0 +1,303 @@
+#include <stdlib.h>
+#include <math.h>
+#include <iostream>
+#include <algorithm>
+
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+#include "firfilterfixed.h"
+#include "firfilterfft.h"
+
+using namespace std;
+
+// Tap counts are padded to whole vectors of this many 16 bit values.
+#define FIXED_VECTOR 16
+
+static int roundUp(int n, int multiple)
+{
+    return ((n + multiple - 1) / multiple) * multiple;
+}
+
+// Quantizes the values to fracBits fractional bits after scaling them by the
+// power of two exponent, the smallest one above the largest magnitude. The
+// range is kept symmetric, so no product is (-2^fracBits)^2.
+template <typename T>
+static void quantizeFixedPoint(const FLOATING_POINT* values, int size, T* quantized,
+                    int &exponent)
+{
+    const int fracBits = FixedPointTraits<T>::fracBits;
+    const long limit = (1L << fracBits) - 1;
+
+    double maxAbs = 0;
+    for (int i=0; i<size; i++) maxAbs = max(maxAbs, (double)fabs(values[i]));
+
+    exponent = 0;
+    if (maxAbs > 0) frexp(maxAbs, &exponent);
+
+    double scale = ldexp(1.0, fracBits - exponent);
+    for (int i=0; i<size; i++)
+        quantized[i] = (T)max(-limit, min(limit, lround(values[i] * scale)));
+}
+
+/****************************************************************************
+* Function: initFixedPointFilter()
+*
+* Purpose: Quantizes the samples and coefficients of the benchmark data, each
+*          with its own power of two scale, and picks the smallest result
+*          shift with which no result saturates.
+*
+* @param filter output -the quantized filter and samples.
+* @param benchmarkData the input benchmark data.
+* @returns Void
+*
+*****************************************************************************/
+template <typename T>
+void initFixedPointFilter(FixedPointFilter<T> &filter, BenchmarkData &benchmarkData)
+{
+    filter.numSamples = benchmarkData.samples.size;
+    filter.numCoefficients = benchmarkData.coefficients.size;
+    filter.samples.resize(filter.numSamples);
+    filter.coefficients.resize(filter.numCoefficients);
+
+    quantizeFixedPoint(benchmarkData.samples.elements, filter.numSamples,
+                        filter.samples.data(), filter.sampleExponent);
+    quantizeFixedPoint(benchmarkData.coefficients.elements, filter.numCoefficients,
+                        filter.coefficients.data(), filter.coeffExponent);
+
+    // A result is at most 2^fracBits times the coefficient magnitudes.
+    double sumAbs = 0;
+    for (T h : filter.coefficients) sumAbs += abs((int)h);
+
+    filter.shift = 0;
+    while (ldexp(1.0, filter.shift) < sumAbs) filter.shift++;
+}
+
+template <typename T>
+double getFixedPointScale(const FixedPointFilter<T> &filter)
+{
+    return ldexp(1.0, filter.shift + filter.sampleExponent + filter.coeffExponent
+                        - 2*FixedPointTraits<T>::fracBits);
+}
+
+/****************************************************************************
+* Function: getFixedPointErrorBound()
+*
+* Purpose: Bounds the difference of a dequantized result to the floating
+*          point filter: the sample and coefficient quantization errors of
+*          one LSB (at the saturated ends) times the magnitudes of the other
+*          operand, their product, the result rounding, and the floating
+*          point error of the reference.
+*
+* @param filter the quantized filter.
+* @param benchmarkData the floating point benchmark data.
+* @returns The bound.
+*
+*****************************************************************************/
+template <typename T>
+double getFixedPointErrorBound(const FixedPointFilter<T> &filter,
+                    BenchmarkData &benchmarkData)
+{
+    const int fracBits = FixedPointTraits<T>::fracBits;
+
+    double maxSample = 0, sumCoefficients = 0;
+    for (int i=0; i<benchmarkData.samples.size; i++)
+        maxSample = max(maxSample, (double)fabs(benchmarkData.samples.elements[i]));
+    for (int k=0; k<benchmarkData.coefficients.size; k++)
+        sumCoefficients += fabs(benchmarkData.coefficients.elements[k]);
+
+    double sampleLsb = ldexp(1.0, filter.sampleExponent - fracBits);
+    double coeffLsb = ldexp(1.0, filter.coeffExponent - fracBits);
+    int numCoefficients = filter.numCoefficients;
+
+    return sampleLsb * sumCoefficients
+            + coeffLsb * numCoefficients * maxSample
+            + numCoefficients * sampleLsb * coeffLsb
+            + getFixedPointScale(filter)
+            + 1.e-5 * sumCoefficients * maxSample;
+}
+
+// Requantizes an accumulator like the kernels: saturated to the accumulator
+// width, shifted with rounding to nearest and saturated to T.
+template <typename T>
+static T requantize(int64_t acc, int shift)
+{
+    const int accBits = FixedPointTraits<T>::accBits;
+    const int fracBits = FixedPointTraits<T>::fracBits;
+
+    acc = max(-(int64_t(1) << (accBits-1)), min((int64_t(1) << (accBits-1)) - 1, acc));
+    int64_t rounded = shift > 0 ? (acc + (int64_t(1) << (shift-1))) >> shift : acc;
+
+    return (T)max(-(int64_t(1) << fracBits), min((int64_t(1) << fracBits) - 1, rounded));
+}
+
+// Four dot products of numTaps (a multiple of 16) taps with the windows
+// starting at window, window+1, window+2 and window+3. The pairwise products
+// of vpmaddwd are widened to 64 bits for Wide accumulators, else summed in
+// 32 bits.
+template <bool Wide>
+static void dot4Fixed(const int16_t* window, const int16_t* taps, int numTaps,
+                    int64_t sums[4])
+{
+#ifdef __AVX2__
+    __m256i acc[4];
+    for (int d=0; d<4; d++) acc[d] = _mm256_setzero_si256();
+
+    for (int q=0; q<numTaps; q+=FIXED_VECTOR)
+    {
+        __m256i h = _mm256_loadu_si256((const __m256i*)(taps+q));
+
+        for (int d=0; d<4; d++)
+        {
+            __m256i x = _mm256_loadu_si256((const __m256i*)(window+d+q));
+            __m256i pairs = _mm256_madd_epi16(x, h);
+
+            if (Wide)
+            {
+                acc[d] = _mm256_add_epi64(acc[d],
+                            _mm256_cvtepi32_epi64(_mm256_castsi256_si128(pairs)));
+                acc[d] = _mm256_add_epi64(acc[d],
+                            _mm256_cvtepi32_epi64(_mm256_extracti128_si256(pairs, 1)));
+            }
+            else
+            {
+                acc[d] = _mm256_add_epi32(acc[d], pairs);
+            }
+        }
+    }
+
+    for (int d=0; d<4; d++)
+    {
+        if (Wide)
+        {
+            int64_t lanes[4];
+            _mm256_storeu_si256((__m256i*)lanes, acc[d]);
+            sums[d] = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+        }
+        else
+        {
+            int32_t lanes[8];
+            _mm256_storeu_si256((__m256i*)lanes, acc[d]);
+            sums[d] = 0;
+            for (int l=0; l<8; l++) sums[d] += lanes[l];
+        }
+    }
+#else
+    for (int d=0; d<4; d++)
+    {
+        int64_t sum = 0;
+        for (int q=0; q<numTaps; q++)
+            sum += int32_t(window[d+q]) * int32_t(taps[q]);
+        sums[d] = sum;
+    }
+#endif
+}
+
+/****************************************************************************
+* Function: filterSamplesFixedCPU()
+*
+* Purpose: Filters the quantized samples on the host, bit exact to the fixed
+*          point kernels. Both precisions are widened to 16 bits and
+*          multiplied by vpmaddwd, 16 taps of four outputs at a time.
+*
+* @param filter the quantized filter and samples.
+* @param results output -the numSamples quantized results.
+* @returns Void
+*
+*****************************************************************************/
+template <typename T>
+void filterSamplesFixedCPU(const FixedPointFilter<T> &filter, T* results)
+{
+    const bool wide = sizeof(typename FixedPointTraits<T>::Accumulator) > 4;
+
+    int numSamples = filter.numSamples;
+    int numCoefficients = filter.numCoefficients;
+    int numTaps = roundUp(numCoefficients, FIXED_VECTOR);
+
+    // The reversed coefficients, zero padded at the end.
+    vector<int16_t> taps(numTaps, 0);
+    for (int t=0; t<numCoefficients; t++)
+        taps[t] = filter.coefficients[numCoefficients-1-t];
+
+    // numCoefficients-1 zero samples ahead, so output n is the dot product
+    // of the taps with the window starting at n.
+    vector<int16_t> windows(numCoefficients-1 + numSamples + numTaps + 3, 0);
+    for (int n=0; n<numSamples; n++)
+        windows[numCoefficients-1 + n] = filter.samples[n];
+
+    int64_t sums[4];
+
+    for (int n=0; n<numSamples; n+=4)
+    {
+        dot4Fixed<wide>(&windows[n], taps.data(), numTaps, sums);
+
+        for (int d=0; d<4 && n+d<numSamples; d++)
+            results[n+d] = requantize<T>(sums[d], filter.shift);
+    }
+}
+
+/****************************************************************************
+* Function: verifyFixedPoint()
+*
+* Purpose: Checks the dequantized results against the floating point filter
+*          of the benchmark data, within getFixedPointErrorBound().
+*
+* @param filter the quantized filter.
+* @param benchmarkData the floating point benchmark data.
+* @param results the quantized results.
+* @param maxError output -the largest difference to the reference.
+* @returns false if a result is off by more than the bound.
+*
+*****************************************************************************/
+template <typename T>
+bool verifyFixedPoint(const FixedPointFilter<T> &filter, BenchmarkData &benchmarkData,
+                    const T* results, double &maxError)
+{
+    int numSamples = benchmarkData.samples.size;
+    int numCoefficients = benchmarkData.coefficients.size;
+    double bound = getFixedPointErrorBound(filter, benchmarkData);
+    double scale = getFixedPointScale(filter);
+
+    // The floating point reference, by fft convolution.
+    FftFilter fftFilter;
+    initFftFilter(fftFilter, benchmarkData.coefficients.elements, numCoefficients,
+                nextPowerOfTwo(8*numCoefficients));
+
+    vector<FLOATING_POINT> expected(numSamples);
+    filterSamplesFFT(fftFilter, benchmarkData.samples.elements, numSamples,
+                    expected.data());
+
+    maxError = 0;
+
+    for (int n=0; n<numSamples; n++)
+    {
+        double error = fabs(results[n] * scale - expected[n]);
+        maxError = max(maxError, error);
+
+        if (error > bound)
+        {
+            cout << "Result mismatch at index: " << n << endl;
+            cout << "The " << FixedPointTraits<T>::name() << " value: "
+                 << results[n] * scale << ", the floating point value: "
+                 << expected[n] << endl;
+            cout << "Error bound: " << bound << endl;
+            return false;
+        }
+    }
+
+    return true;
+}
+
+template void initFixedPointFilter(FixedPointFilter<int16_t>&, BenchmarkData&);
+template void initFixedPointFilter(FixedPointFilter<int8_t>&, BenchmarkData&);
+template double getFixedPointScale(const FixedPointFilter<int16_t>&);
+template double getFixedPointScale(const FixedPointFilter<int8_t>&);
+template double getFixedPointErrorBound(const FixedPointFilter<int16_t>&, BenchmarkData&);
+template double getFixedPointErrorBound(const FixedPointFilter<int8_t>&, BenchmarkData&);
+template void filterSamplesFixedCPU(const FixedPointFilter<int16_t>&, int16_t*);
+template void filterSamplesFixedCPU(const FixedPointFilter<int8_t>&, int8_t*);
+template bool verifyFixedPoint(const FixedPointFilter<int16_t>&, BenchmarkData&,
+                    const int16_t*, double&);
+template bool verifyFixedPoint(const FixedPointFilter<int8_t>&, BenchmarkData&,
+                    const int8_t*, double&);
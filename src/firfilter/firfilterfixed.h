@@ -0,0 +1,66 @@
+#ifndef FIR_FIXED_H
+#define FIR_FIXED_H
+
+#include <stdint.h>
+#include <vector>
+
+#include "firfilterutility.h"
+
+#define FIR_MODE_FIXED "fixed"
+
+// The fixed point precisions, by their sample type.
+template <typename T> struct FixedPointTraits;
+
+template <> struct FixedPointTraits<int16_t>
+{
+    typedef int64_t Accumulator;
+    static const int fracBits = 15;
+    static const int accBits = 48;
+    static const char* name() { return "q15"; }
+    static const char* kernelName() { return "convolve_q15"; }
+};
+
+template <> struct FixedPointTraits<int8_t>
+{
+    typedef int32_t Accumulator;
+    static const int fracBits = 7;
+    static const int accBits = 32;
+    static const char* name() { return "q7"; }
+    static const char* kernelName() { return "convolve_q7"; }
+};
+
+// A fir filter and its input samples quantized to the fixed point type T.
+// A quantized sample x stands for x*2^(sampleExponent-fracBits), a
+// coefficient h for h*2^(coeffExponent-fracBits), and a result y, the sum
+// of the products shifted right by shift bits, for
+// y*2^(shift+sampleExponent+coeffExponent-2*fracBits).
+template <typename T>
+struct FixedPointFilter
+{
+    int numSamples;
+    int numCoefficients;
+    int sampleExponent;
+    int coeffExponent;
+    int shift;
+    std::vector<T> samples;
+    std::vector<T> coefficients;
+};
+
+template <typename T>
+void initFixedPointFilter(FixedPointFilter<T> &filter, BenchmarkData &benchmarkData);
+
+template <typename T>
+double getFixedPointScale(const FixedPointFilter<T> &filter);
+
+template <typename T>
+double getFixedPointErrorBound(const FixedPointFilter<T> &filter,
+                    BenchmarkData &benchmarkData);
+
+template <typename T>
+void filterSamplesFixedCPU(const FixedPointFilter<T> &filter, T* results);
+
+template <typename T>
+bool verifyFixedPoint(const FixedPointFilter<T> &filter, BenchmarkData &benchmarkData,
+                    const T* results, double &maxError);
+
+#endif
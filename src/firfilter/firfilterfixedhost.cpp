@@ -0,0 +1,149 @@
+/** @file firfilterfixedhost.cpp */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <string.h>
+
+#include "../common/utility.h"
+#include "../common/benchmarkoptions.h"
+
+#include "firfilterutility.h"
+#include "firfilterfixed.h"
+#include "firfilterhost.h"
+
+using namespace std;
+
+/****************************************************************************
+* Function: filterSamplesFPGAFixed()
+*
+* Purpose: On the FPGA, filter the quantized samples by the quantized
+*          coefficients with the fixed point kernel of the sample type T
+*          (convolve_q15 or convolve_q7).
+*
+* @param ctx the opencl context to use for the benchmark
+* @param queue the opencl command queue to issue commands to
+* @param prog the opencl program containing the kernel
+* @param filter the quantized filter and samples.
+* @param result output -the quantized results.
+* @returns The kernel runtime in seconds.
+*
+*****************************************************************************/
+template <typename T>
+double filterSamplesFPGAFixed(cl_device_id dev,
+                             cl_context ctx,
+                             cl_command_queue queue,
+                             cl_program prog,
+                             const FixedPointFilter<T> &filter,
+                             T* results)
+{
+    int numSamples = filter.numSamples;
+    int numCoefficients = filter.numCoefficients;
+    int shift = filter.shift;
+
+    int err;
+
+    //
+    // find the kernel
+    //
+    cl_kernel filterkernel = clCreateKernel(prog, FixedPointTraits<T>::kernelName(), &err);
+    CL_CHECK_ERROR(err);
+
+    //
+    // allocate device memory for input and output buffers.
+    //
+    cl_mem d_samples = clCreateBuffer(ctx, CL_MEM_READ_ONLY,
+                                          sizeof(T)*numSamples, NULL, &err);
+    CL_CHECK_ERROR(err);
+
+    cl_mem d_coefficients = clCreateBuffer(ctx, CL_MEM_READ_ONLY,
+                                          sizeof(T)*numCoefficients, NULL, &err);
+    CL_CHECK_ERROR(err);
+
+    cl_mem d_results = clCreateBuffer(ctx, CL_MEM_WRITE_ONLY,
+                                          sizeof(T)*numSamples, NULL, &err);
+    CL_CHECK_ERROR(err);
+
+    //
+    // write input buffers to the device memory.
+    //
+    err = clEnqueueWriteBuffer(queue, d_samples, true, 0,
+                               sizeof(T)*numSamples, filter.samples.data(),
+                               0, NULL, NULL);
+    CL_CHECK_ERROR(err);
+
+    err = clEnqueueWriteBuffer(queue, d_coefficients, true, 0,
+                               sizeof(T)*numCoefficients, filter.coefficients.data(),
+                               0, NULL, NULL);
+    CL_CHECK_ERROR(err);
+
+    err = clFinish(queue);
+    CL_CHECK_ERROR(err);
+
+    //
+    // set arguments for the kernel
+    //
+    err = clSetKernelArg(filterkernel, 0, sizeof(cl_mem), (void*)&d_samples);
+    CL_CHECK_ERROR(err);
+    err = clSetKernelArg(filterkernel, 1, sizeof(cl_mem), (void*)&d_coefficients);
+    CL_CHECK_ERROR(err);
+    err = clSetKernelArg(filterkernel, 2, sizeof(cl_mem), (void*)&d_results);
+    CL_CHECK_ERROR(err);
+    err = clSetKernelArg(filterkernel, 3, sizeof(int), (void*)&numSamples);
+    CL_CHECK_ERROR(err);
+    err = clSetKernelArg(filterkernel, 4, sizeof(int), (void*)&shift);
+    CL_CHECK_ERROR(err);
+
+    //
+    // run the kernel
+    //
+    cl_event event = NULL;
+    err = clEnqueueTask(queue, filterkernel, 0, NULL, &event);
+    CL_CHECK_ERROR(err);
+
+    err = clFinish(queue);
+    CL_CHECK_ERROR (err);
+
+    //
+    // get the timing/rate info
+    //
+    cl_ulong submitTime;
+    cl_ulong endTime;
+
+    err = clGetEventProfilingInfo(event, CL_PROFILING_COMMAND_SUBMIT,
+                                    sizeof(cl_ulong), &submitTime, NULL);
+    CL_CHECK_ERROR(err);
+
+    err = clGetEventProfilingInfo(event, CL_PROFILING_COMMAND_END,
+                                    sizeof(cl_ulong), &endTime, NULL);
+    CL_CHECK_ERROR(err);
+
+    double nanosec = endTime - submitTime;
+
+    //
+    // read the filtered result
+    //
+    err = clEnqueueReadBuffer(queue, d_results, true, 0,
+                              sizeof(T)*numSamples, results,
+                              0, NULL, NULL);
+    CL_CHECK_ERROR(err);
+
+    //
+    // free device memory
+    //
+    clReleaseEvent(event);
+    clReleaseMemObject(d_samples);
+    clReleaseMemObject(d_coefficients);
+    clReleaseMemObject(d_results);
+    clReleaseKernel(filterkernel);
+
+    //
+    // return the runtime in seconds
+    //
+    return nanosec / 1.e9;
+}
+
+template double filterSamplesFPGAFixed(cl_device_id, cl_context, cl_command_queue,
+                    cl_program, const FixedPointFilter<int16_t>&, int16_t*);
+template double filterSamplesFPGAFixed(cl_device_id, cl_context, cl_command_queue,
+                    cl_program, const FixedPointFilter<int8_t>&, int8_t*);
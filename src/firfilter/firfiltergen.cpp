@@ -0,0 +1,180 @@
+/** @file firfiltergen.cpp
+*
+* Generates fir filter data sets: windowed-sinc low pass coefficients,
+* random input samples and the reference results, computed in double
+* precision on all host threads. The files are written in the text or
+* the binary (mmap-able) format read by readFiles().
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <iostream>
+#include <random>
+#include <thread>
+#include <vector>
+#include <algorithm>
+
+#include "../common/optionparser.h"
+
+#include "firfilterutility.h"
+
+using namespace std;
+
+// Samples generated per random engine seed, so that the data does not
+// depend on the number of threads.
+#define GEN_CHUNK_SIZE (1 << 16)
+
+// Runs work(begin, end) on numThreads threads over [0, count).
+template<class F>
+static void parallelFor(long count, int numThreads, F work)
+{
+    vector<thread> threads;
+    long chunk = (count + numThreads - 1) / numThreads;
+
+    for (int t=0; t<numThreads; t++)
+    {
+        long begin = min(count, t * chunk);
+        long end = min(count, begin + chunk);
+        threads.push_back(thread(work, begin, end));
+    }
+
+    for (thread &t : threads) t.join();
+}
+
+// Hamming windowed sinc low pass with unit gain at DC.
+static vector<FLOATING_POINT> makeCoefficients(int numCoefficients, double cutoff)
+{
+    vector<double> taps(numCoefficients);
+    double center = (numCoefficients - 1) / 2.0;
+    double sum = 0;
+
+    for (int i=0; i<numCoefficients; i++)
+    {
+        double x = i - center;
+        double sinc = x == 0 ? 2 * cutoff : sin(2 * M_PI * cutoff * x) / (M_PI * x);
+        double window = numCoefficients > 1 ?
+            0.54 - 0.46 * cos(2 * M_PI * i / (numCoefficients - 1)) : 1;
+        taps[i] = sinc * window;
+        sum += taps[i];
+    }
+
+    vector<FLOATING_POINT> coefficients(numCoefficients);
+    for (int i=0; i<numCoefficients; i++)
+        coefficients[i] = taps[i] / sum;
+
+    return coefficients;
+}
+
+int main(int argc, char *argv[])
+{
+    OptionParser parser;
+    parser.addOption("outdir", OPT_STRING, "data/", "output directory of the data files");
+    parser.addOption("group", OPT_INT, "1", "group number of the data files", 'g');
+    parser.addOption("samples", OPT_INT, "1048576", "number of input samples", 's');
+    parser.addOption("taps", OPT_INT, "256", "number of filter coefficients", 't');
+    parser.addOption("cutoff", OPT_FLOAT, "0.1", "low pass cutoff, fraction of the sample rate");
+    parser.addOption("seed", OPT_INT, "1", "random seed of the input samples");
+    parser.addOption("format", OPT_STRING, "bin", "file format, bin or text", 'f');
+    parser.addOption("threads", OPT_INT, "0", "number of threads, 0 for all cores");
+
+    if (!parser.parse(argc, argv) || parser.HelpRequested())
+    {
+        parser.usage();
+        return parser.HelpRequested() ? 0 : 1;
+    }
+
+    string outDir = parser.getOptionString("outdir");
+    int group = parser.getOptionInt("group");
+    long numSamples = parser.getOptionInt("samples");
+    int numCoefficients = parser.getOptionInt("taps");
+    double cutoff = parser.getOptionFloat("cutoff");
+    unsigned seed = parser.getOptionInt("seed");
+    string format = parser.getOptionString("format");
+    int numThreads = parser.getOptionInt("threads");
+
+    if (numThreads <= 0) numThreads = max(1u, thread::hardware_concurrency());
+
+    if (numSamples < 1 || numSamples > INT32_MAX || numCoefficients < 1)
+    {
+        cerr << "ERROR: the number of samples and coefficients must be positive"
+             << " and fit the file format." << endl;
+        return 1;
+    }
+
+    if (format != "bin" && format != "text")
+    {
+        cerr << "ERROR: unknown format: " << format << endl;
+        return 1;
+    }
+
+    vector<FLOATING_POINT> coefficients = makeCoefficients(numCoefficients, cutoff);
+    vector<FLOATING_POINT> samples(numSamples);
+    vector<FLOATING_POINT> results(numSamples);
+
+    long numChunks = (numSamples + GEN_CHUNK_SIZE - 1) / GEN_CHUNK_SIZE;
+
+    parallelFor(numChunks, numThreads, [&](long begin, long end)
+    {
+        uniform_real_distribution<double> distribution(-1.0, 1.0);
+
+        for (long c=begin; c<end; c++)
+        {
+            mt19937 engine(seed * 1000003u + c);
+            long last = min(numSamples, (c+1) * GEN_CHUNK_SIZE);
+
+            for (long i=c * GEN_CHUNK_SIZE; i<last; i++)
+                samples[i] = distribution(engine);
+        }
+    });
+
+    // Reference results accumulated in double precision.
+    vector<double> reversed(coefficients.rbegin(), coefficients.rend());
+
+    parallelFor(numSamples, numThreads, [&](long begin, long end)
+    {
+        for (long i=begin; i<end; i++)
+        {
+            long first = max(0L, i - numCoefficients + 1);
+            const double* taps = &reversed[first - (i - numCoefficients + 1)];
+            const FLOATING_POINT* window = &samples[first];
+            long length = i - first + 1;
+
+            double sum0 = 0, sum1 = 0, sum2 = 0, sum3 = 0;
+            long j = 0;
+            for (; j+4<=length; j+=4)
+            {
+                sum0 += taps[j+0] * window[j+0];
+                sum1 += taps[j+1] * window[j+1];
+                sum2 += taps[j+2] * window[j+2];
+                sum3 += taps[j+3] * window[j+3];
+            }
+            for (; j<length; j++)
+                sum0 += taps[j] * window[j];
+
+            results[i] = (sum0 + sum1) + (sum2 + sum3);
+        }
+    });
+
+    bool binary = format == "bin";
+    string prefix = outDir + to_string(group);
+
+    bool written = binary ?
+        writeBinaryFile(prefix + INPUTS_BINARY_FILE, group, samples.data(), numSamples) &&
+        writeBinaryFile(prefix + COEFFS_BINARY_FILE, group, coefficients.data(), numCoefficients) &&
+        writeBinaryFile(prefix + RESULTS_BINARY_FILE, group, results.data(), numSamples) :
+        writeFile(prefix + INPUTS_FILE, group, samples.data(), numSamples) &&
+        writeFile(prefix + COEFFS_FILE, group, coefficients.data(), numCoefficients) &&
+        writeFile(prefix + RESULTS_FILE, group, results.data(), numSamples);
+
+    if (!written)
+    {
+        cerr << "ERROR: could not write the data files to " << outDir << endl;
+        return 1;
+    }
+
+    cout << "Written group " << group << ": " << numSamples << " samples, "
+         << numCoefficients << " coefficients (" << format << ") to " << outDir << endl;
+
+    return 0;
+}
@@ -4,11 +4,17 @@
 #include <stdlib.h>
 #include <math.h>
 #include <string.h>
+#include <chrono>
+#include <algorithm>
+#include <unistd.h>
 
 #include "../common/utility.h"
 #include "../common/benchmarkoptions.h"
 
 #include "firfilterutility.h"
+#include "firfilterfft.h"
+#include "firfilterpolyphase.h"
+#include "firfilterhost.h"
 
 using namespace std;
 
@@ -151,9 +157,6 @@ double filterSamplesFPGAChanneled(cl_device_id dev,
     CL_CHECK_ERROR(err);
 
     nanosec = endTime - submitTime;
-    
-    double rate = double(numSamples) / double(nanosec);
-    // cout << "rate = " << rate << " GSamples/sec" << endl;
 
     //
     // read the samples response result
@@ -169,8 +172,16 @@ double filterSamplesFPGAChanneled(cl_device_id dev,
     //
     // free device memory
     //
+    clReleaseEvent(event1);
+    clReleaseEvent(event2);
+    clReleaseEvent(event3);
+    clReleaseMemObject(d_samples);
+    clReleaseMemObject(d_coefficients);
     err = clReleaseMemObject(d_results);
     CL_CHECK_ERROR(err);
+    clReleaseKernel(readKernel);
+    clReleaseKernel(performKernel);
+    clReleaseKernel(writeKernel);
 
     clReleaseCommandQueue(queue1);
     clReleaseCommandQueue(queue2);
@@ -182,18 +193,18 @@ double filterSamplesFPGAChanneled(cl_device_id dev,
     return nanosec / 1.e9;
 }
 
-double filterSamplesFPGANonChanneled(cl_device_id dev,
-                             cl_context ctx,
+// Runs the convolve kernel on samples of the element type T (float or 
+// double, as the kernel variant is compiled for).
+template<typename T>
+static double filterSamplesFPGADirect(cl_context ctx,
                              cl_command_queue queue,
                              cl_program prog,
-                             BenchmarkData &benchmarkData,
-                             FLOATING_POINT* results)
+                             const T* samples,
+                             int numSamples,
+                             const T* coefficients,
+                             int numCoefficients,
+                             T* results)
 {
-    FLOATING_POINT* samples = benchmarkData.samples.elements;
-    FLOATING_POINT* coefficients = benchmarkData.coefficients.elements;
-    int numSamples = benchmarkData.samples.size;
-    int numCoefficients = benchmarkData.coefficients.size;
-    
     int err;
 
     //
@@ -206,30 +217,30 @@ double filterSamplesFPGANonChanneled(cl_device_id dev,
     // allocate device memory for input buffers.
     // 
     cl_mem d_samples = clCreateBuffer(ctx, CL_MEM_READ_ONLY,
-                                          sizeof(FLOATING_POINT)*numSamples, NULL, &err);
+                                          sizeof(T)*numSamples, NULL, &err);
     CL_CHECK_ERROR(err);
 
     cl_mem d_coefficients = clCreateBuffer(ctx, CL_MEM_READ_ONLY,
-                                          sizeof(FLOATING_POINT)*numCoefficients, NULL, &err);
+                                          sizeof(T)*numCoefficients, NULL, &err);
     CL_CHECK_ERROR(err);
 
     //
     // allocate device memory for output buffer.
     // 
     cl_mem d_results = clCreateBuffer(ctx, CL_MEM_WRITE_ONLY,
-                                          sizeof(FLOATING_POINT)*numSamples, NULL, &err);
+                                          sizeof(T)*numSamples, NULL, &err);
     CL_CHECK_ERROR(err);
 
     //
     // write input buffers to the device memory.
     //
     err = clEnqueueWriteBuffer(queue, d_samples, true, 0,
-                               sizeof(FLOATING_POINT)*numSamples, samples,
+                               sizeof(T)*numSamples, samples,
                                0, NULL, NULL);
     CL_CHECK_ERROR(err);
 
     err = clEnqueueWriteBuffer(queue, d_coefficients, true, 0,
-                            sizeof(FLOATING_POINT)*numCoefficients, coefficients,
+                            sizeof(T)*numCoefficients, coefficients,
                             0, NULL, NULL);
     CL_CHECK_ERROR(err);
 
@@ -276,15 +287,12 @@ double filterSamplesFPGANonChanneled(cl_device_id dev,
     CL_CHECK_ERROR(err);
 
     nanosec = endTime - submitTime;
-    
-    double rate = double(numSamples) / double(nanosec);
-    // cout << "rate = " << rate << " GSamples/sec" << endl;
 
     //
     // read the samples response result
     //
     err = clEnqueueReadBuffer(queue, d_results, true, 0,
-                              sizeof(FLOATING_POINT)*(numSamples), results,
+                              sizeof(T)*(numSamples), results,
                               0, NULL, NULL);
     CL_CHECK_ERROR(err);
 
@@ -294,8 +302,12 @@ double filterSamplesFPGANonChanneled(cl_device_id dev,
     //
     // free device memory
     //
+    clReleaseEvent(event);
+    clReleaseMemObject(d_samples);
+    clReleaseMemObject(d_coefficients);
     err = clReleaseMemObject(d_results);
     CL_CHECK_ERROR(err);
+    clReleaseKernel(filterkernel);
 
     //
     // return the runtime in seconds
@@ -303,18 +315,54 @@ double filterSamplesFPGANonChanneled(cl_device_id dev,
     return nanosec / 1.e9;
 }
 
+double filterSamplesFPGANonChanneled(cl_device_id dev,
+                             cl_context ctx,
+                             cl_command_queue queue,
+                             cl_program prog,
+                             BenchmarkData &benchmarkData,
+                             bool doublePrecision,
+                             FLOATING_POINT* results)
+{
+    FLOATING_POINT* samples = benchmarkData.samples.elements;
+    FLOATING_POINT* coefficients = benchmarkData.coefficients.elements;
+    int numSamples = benchmarkData.samples.size;
+    int numCoefficients = benchmarkData.coefficients.size;
+
+    if (!doublePrecision)
+    {
+        return filterSamplesFPGADirect(ctx, queue, prog, samples, numSamples,
+                                    coefficients, numCoefficients, results);
+    }
+
+    // The double precision variants get the samples converted.
+    vector<double> d_samples(samples, samples + numSamples);
+    vector<double> d_coefficients(coefficients, coefficients + numCoefficients);
+    vector<double> d_results(numSamples);
+
+    double seconds = filterSamplesFPGADirect(ctx, queue, prog, d_samples.data(), 
+                                    numSamples, d_coefficients.data(), 
+                                    numCoefficients, d_results.data());
+
+    copy(d_results.begin(), d_results.end(), results);
+
+    return seconds;
+}
+
 /****************************************************************************
 * Function: filterSamplesFPGA()
 *
 * Purpose: On the FPGA, apply the FIR filter in coefficients to the input samples 
-*          and populate the results by convolution.
+*          and populate the results by convolution, with the kernel(s) of the
+*          given variant.
 *
 * @param ctx the opencl context to use for the benchmark
 * @param queue the opencl command queue to issue commands to
 * @param prog the opencl program containing the kernel
+* @param variant the kernel variant of the program.
 * @param benchmarkData the input benchmark data to convolve.
 * @param result output -the resulted convolved samples.
-* @returns Void
+* @returns The kernel runtime in seconds, or a negative value if the variant
+*          is no block mode variant.
 *
 * @author Abdul Rehman Tareen
 * @date May 14, 2020
@@ -324,20 +372,940 @@ double filterSamplesFPGA(cl_device_id dev,
                              cl_context ctx,
                              cl_command_queue queue,
                              cl_program prog,
-                             BenchmarkData benchmarkData,
+                             const FirVariant &variant,
+                             BenchmarkData &benchmarkData,
                              FLOATING_POINT* results)
 {
-#if defined(CHANNELED) && defined(NON_CHANNELED) 
-    printf("Please specifiy non conflicting channel version to be used\n");
-    exit(1);
-#elif defined(CHANNELED)
-    return filterSamplesFPGAChanneled(dev, ctx, queue, prog, benchmarkData, results);
-#elif defined(NON_CHANNELED) 
-    return filterSamplesFPGANonChanneled(dev, ctx, queue, prog, benchmarkData, results);
-#else
-    printf("Please specifiy if the channeled version kernel be used or not");
-    exit(1);
-#endif
+    switch (variant.type)
+    {
+        case FIR_KERNEL_DIRECT:
+            return filterSamplesFPGANonChanneled(dev, ctx, queue, prog, benchmarkData,
+                                    variant.doublePrecision, results);
+        case FIR_KERNEL_CHANNELED:
+            return filterSamplesFPGAChanneled(dev, ctx, queue, prog, benchmarkData, 
+                                    results);
+        case FIR_KERNEL_FFT:
+            return filterSamplesFPGAFft(dev, ctx, queue, prog, benchmarkData, results);
+        default:
+            cout << "ERROR: " << variant.name << " has no block mode fir filter kernel." 
+                 << endl;
+            return -1;
+    }
+}
+
+// Whether the program (bitstream) contains a kernel of the given name.
+static bool hasKernel(cl_program prog, const char* name)
+{
+    cl_int err;
+    cl_kernel kernel = clCreateKernel(prog, name, &err);
+    
+    if (err != CL_SUCCESS) return false;
+    
+    clReleaseKernel(kernel);
+    return true;
+}
+
+/****************************************************************************
+* Function: detectFirVariant()
+*
+* Purpose: Tells the kernel variant of a loaded program by its kernel names,
+*          and its precision by the bitstream name (see getFirVariant()).
+*
+* @param prog the opencl program.
+* @param bitstreamFile the file the program was created from.
+* @returns The variant, of type FIR_KERNEL_NONE if no fir filter kernel is 
+*          found.
+*
+*****************************************************************************/
+FirVariant detectFirVariant(cl_program prog, string bitstreamFile)
+{
+    FirKernelType type;
+
+    if (hasKernel(prog, "convolve_read") && hasKernel(prog, "convolve_perform") 
+        && hasKernel(prog, "convolve_write"))
+        type = FIR_KERNEL_CHANNELED;
+    else if (hasKernel(prog, "convolve"))
+        type = FIR_KERNEL_DIRECT;
+    else if (hasKernel(prog, "convolve_fft"))
+        type = FIR_KERNEL_FFT;
+    else if (hasKernel(prog, "convolve_stream"))
+        type = FIR_KERNEL_STREAM;
+    else if (hasKernel(prog, "convolve_decimate") && hasKernel(prog, "convolve_interpolate"))
+        type = FIR_KERNEL_POLYPHASE;
+    else if (hasKernel(prog, "convolve_bank"))
+        type = FIR_KERNEL_BANK;
+    else if (hasKernel(prog, "convolve_q15") && hasKernel(prog, "convolve_q7"))
+        type = FIR_KERNEL_FIXED;
+    else if (hasKernel(prog, "convolve_lms"))
+        type = FIR_KERNEL_LMS;
+    else
+        type = FIR_KERNEL_NONE;
+
+    return getFirVariant(bitstreamFile, type);
+}
+
+/****************************************************************************
+* Function: filterSamplesHost()
+*
+* Purpose: On the host, apply the FIR filter in coefficients to the input 
+*          samples, by the fft filter if one is given or else directly.
+*
+* @param benchmarkData the input benchmark data to convolve.
+* @param fftFilter the fft filter to use or NULL for the direct filter.
+* @param result output -the resulted convolved samples.
+* @returns The runtime in seconds.
+*
+*****************************************************************************/
+static double filterSamplesHost(BenchmarkData &benchmarkData,
+                             FftFilter *fftFilter,
+                             FLOATING_POINT* results)
+{
+    int numCoefficients = benchmarkData.coefficients.size;
+    vector<FLOATING_POINT> history(numCoefficients-1, 0);
+
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+
+    if (fftFilter != NULL)
+    {
+        filterSamplesFFT(*fftFilter, benchmarkData.samples.elements, 
+                        benchmarkData.samples.size, results);
+    }
+    else
+    {
+        filterSamplesCPU(benchmarkData.samples.elements, benchmarkData.samples.size,
+                        benchmarkData.coefficients.elements, numCoefficients,
+                        history.data(), results);
+    }
+
+    return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+/****************************************************************************
+* Function: benchmarkFirFilterStream()
+*
+* Purpose: Executes the passes of the streaming mode, each pass filters 
+*          iterations blocks of firBlock samples as one continuous stream.
+*
+* @param program the opencl program containing the convolve_stream kernel
+* @param benchmarkData the input benchmark data to stream.
+* @param resultDB results from the benchmark are stored in this db
+* @param options the benchmark suite options
+* @param appOptions the fir filter options
+*
+* @returns Nothing
+*
+****************************************************************************/
+void benchmarkFirFilterStream(cl_device_id dev,
+                    cl_context ctx,
+                    cl_command_queue queue,
+                    cl_program program,
+                    BenchmarkData &benchmarkData,
+                    BenchmarkDatabase &resultDB,
+                    BenchmarkOptions &options,
+                    ApplicationOptions &appOptions)
+{
+    if (benchmarkData.coefficients.size != FIR_TAP_SIZE)
+    {
+        cout << "ERROR: the streaming kernel is compiled for " << FIR_TAP_SIZE 
+             << " coefficients, the input has " << benchmarkData.coefficients.size 
+             << "." << endl;
+        return;
+    }
+
+    // The kernel filters BLOCK_SIZE samples at a time.
+    int blockSize = ((max(appOptions.firBlock, 1) + FIR_BLOCK_SIZE - 1) 
+                        / FIR_BLOCK_SIZE) * FIR_BLOCK_SIZE;
+    int numBlocks = appOptions.iterations;
+
+    if (options.verbose)
+        cout << "Streaming " << numBlocks << " blocks of " << blockSize << " samples." << endl;
+
+    for (int pass = 0 ; pass < appOptions.passes; ++pass) 
+    {
+        if (!options.quiet) cout << "Pass: " << pass << endl;
+
+        StreamResult streamResult = streamSamplesFPGA(dev, ctx, queue, program,
+                                        benchmarkData, blockSize, numBlocks);
+
+        double rate = (double(blockSize) * numBlocks / streamResult.seconds) / 1.e6;
+        double p50 = getPercentile(streamResult.latencies, 50) * 1.e6;
+        double p90 = getPercentile(streamResult.latencies, 90) * 1.e6;
+        double p99 = getPercentile(streamResult.latencies, 99) * 1.e6;
+
+        if (options.verbose)
+        {
+            cout << "time = " << streamResult.seconds << " sec, rate = " << rate 
+                 << " MSamples/sec\n";
+            cout << "block latency p50 = " << p50 << " us, p90 = " << p90 
+                 << " us, p99 = " << p99 << " us\n";
+        }
+
+        if (!streamResult.verified)
+        {
+            cout << "Could not verify the streamed result." << endl;
+        } 
+        else if (!options.quiet)
+        {
+           cout << "Successfully verified the streamed results." << endl;
+        }
+
+        char atts[1024];
+        sprintf(atts, "%d,%d,%d", blockSize, numBlocks,
+                benchmarkData.coefficients.size);
+
+        resultDB.AddResult("firfilter", "firfilter-stream", atts, "MSample/s", rate);
+        resultDB.AddResult("firfilter", "firfilter-stream-latency-p50", atts, "us", p50);
+        resultDB.AddResult("firfilter", "firfilter-stream-latency-p90", atts, "us", p90);
+        resultDB.AddResult("firfilter", "firfilter-stream-latency-p99", atts, "us", p99);
+    }
+}
+
+/****************************************************************************
+* Function: benchmarkFirFilterPolyphase()
+*
+* Purpose: Executes the passes of the decimation or interpolation mode, the
+*          samples are resampled by FIR_RATE_FACTOR on the device and by the
+*          host engine. Besides the output rate, the multiply-accumulates 
+*          made per second and the ones a full rate filter would have to make
+*          for the same output (effective) are reported.
+*
+* @param program the opencl program containing the polyphase kernels
+* @param benchmarkData the input benchmark data to resample.
+* @param resultDB results from the benchmark are stored in this db
+* @param options the benchmark suite options
+* @param appOptions the fir filter options
+*
+* @returns Nothing
+*
+****************************************************************************/
+void benchmarkFirFilterPolyphase(cl_device_id dev,
+                    cl_context ctx,
+                    cl_command_queue queue,
+                    cl_program program,
+                    BenchmarkData &benchmarkData,
+                    BenchmarkDatabase &resultDB,
+                    BenchmarkOptions &options,
+                    ApplicationOptions &appOptions)
+{
+    int numSamples = benchmarkData.samples.size;
+    int numCoefficients = benchmarkData.coefficients.size;
+    int factor = FIR_RATE_FACTOR;
+
+    if (numCoefficients != FIR_TAP_SIZE)
+    {
+        cout << "ERROR: the polyphase kernels are compiled for " << FIR_TAP_SIZE 
+             << " coefficients, the input has " << numCoefficients << "." << endl;
+        return;
+    }
+
+    bool interpolate = appOptions.firMode.compare(FIR_MODE_INTERPOLATE) == 0;
+    string test = interpolate ? "interpolate" : "decimate";
+
+    long numOutputs = interpolate ? long(numSamples) * factor :
+                                    getDecimatedSize(numSamples, factor);
+
+    // Interpolation skips the products with the stuffed zeros, decimation 
+    // the outputs that are dropped.
+    double macs = interpolate ? double(numSamples) * numCoefficients :
+                                double(numOutputs) * numCoefficients;
+    double fullRateMacs = interpolate ? double(numOutputs) * numCoefficients :
+                                double(numSamples) * numCoefficients;
+
+    PolyphaseFilter filter;
+    initPolyphaseFilter(filter, benchmarkData.coefficients.elements, numCoefficients, 
+                        factor);
+
+    FLOATING_POINT *results = new FLOATING_POINT[numOutputs];
+
+    char atts[1024];
+    sprintf(atts, "%d,%d,%d", numSamples, numCoefficients, factor);
+
+    for (int pass = 0 ; pass < appOptions.passes; ++pass) 
+    {
+        if (!options.quiet) cout << "Pass: " << pass << endl;
+
+        for (int host = 0; host < 2; host++)
+        {
+            double t;
+
+            if (host)
+            {
+                chrono::steady_clock::time_point start = chrono::steady_clock::now();
+
+                if (interpolate)
+                    interpolateSamplesCPU(filter, benchmarkData.samples.elements, 
+                                        numSamples, results);
+                else
+                    decimateSamplesCPU(filter, benchmarkData.samples.elements, 
+                                        numSamples, results);
+
+                t = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+            }
+            else
+            {
+                t = resampleSamplesFPGA(dev, ctx, queue, program, benchmarkData, 
+                                        interpolate, results);
+            }
+
+            double rate = (double(numOutputs) / t) / 1.e9;
+            double macRate = (macs / t) / 1.e9;
+            double effectiveMacRate = (fullRateMacs / t) / 1.e9;
+
+            if (options.verbose)
+            {
+                cout << (host ? "host " : "") << "time = " << t << " sec, rate = " << rate 
+                     << " GSamples/sec, " << macRate << " GMAC/sec (effective " 
+                     << effectiveMacRate << " GMAC/sec)\n";
+            }
+
+            bool verified = interpolate ?
+                verifyInterpolated(benchmarkData, factor, results) :
+                verifyDecimated(benchmarkData, factor, results);
+
+            if (!verified)
+            {
+                cout << "Could not verify the " << (host ? "host " : "") 
+                     << "resampled result." << endl;
+            } 
+            else if (!options.quiet)
+            {
+               cout << "Successfully verified the " << (host ? "host " : "") 
+                    << "resampled results." << endl;
+            }
+
+            string prefix = string(host ? "firfilter-host-" : "firfilter-") + test;
+
+            resultDB.AddResult("firfilter", prefix, atts, "GSample/s", rate);
+            resultDB.AddResult("firfilter", prefix + "-mac", atts, "GMAC/s", macRate);
+            resultDB.AddResult("firfilter", prefix + "-effective-mac", atts, "GMAC/s", 
+                                effectiveMacRate);
+        }
+    }
+
+    delete[] results;
+}
+
+/****************************************************************************
+* Function: benchmarkFirFilterBank()
+*
+* Purpose: Executes the passes of the filter bank mode for each channel 
+*          count, all channels are filtered by one launch on the device and
+*          by the multithreaded host engine, which is also the reference. The
+*          samples per channel are the file samples divided by the channel 
+*          count, so the aggregate rates compare across channel counts.
+*
+* @param program the opencl program containing the convolve_bank kernel
+* @param benchmarkData the input benchmark data.
+* @param resultDB results from the benchmark are stored in this db
+* @param options the benchmark suite options
+* @param appOptions the fir filter options
+*
+* @returns Nothing
+*
+****************************************************************************/
+void benchmarkFirFilterBank(cl_device_id dev,
+                    cl_context ctx,
+                    cl_command_queue queue,
+                    cl_program program,
+                    BenchmarkData &benchmarkData,
+                    BenchmarkDatabase &resultDB,
+                    BenchmarkOptions &options,
+                    ApplicationOptions &appOptions)
+{
+    int numCoefficients = benchmarkData.coefficients.size;
+    vector<int> channelCounts;
+
+    if (!parseChannelCounts(appOptions.firChannels, channelCounts)) return;
+
+    if (numCoefficients != FIR_TAP_SIZE)
+    {
+        cout << "ERROR: the filter bank kernel is compiled for " << FIR_TAP_SIZE 
+             << " coefficients, the input has " << numCoefficients << "." << endl;
+        return;
+    }
+
+    // Best device and host rate per channel count, for the summary.
+    vector<double> deviceRates, hostRates;
+    vector<bool> verified;
+
+    for (int numChannels : channelCounts)
+    {
+        deviceRates.push_back(0);
+        hostRates.push_back(0);
+        verified.push_back(false);
+
+        if (numChannels % FIR_BLOCK_SIZE != 0)
+        {
+            cout << "ERROR: the filter bank kernel filters " << FIR_BLOCK_SIZE 
+                 << " channels at a time, " << numChannels << " channels are not " 
+                 << "a multiple of it." << endl;
+            continue;
+        }
+
+        int samplesPerChannel = max(benchmarkData.samples.size / numChannels, 
+                                    numCoefficients);
+        double totalSamples = double(samplesPerChannel) * numChannels;
+
+        if (!options.quiet)
+        {
+            cout << "Channels: " << numChannels << ", samples per channel: " 
+                 << samplesPerChannel << endl;
+        }
+
+        FilterBank bank;
+        makeFilterBank(bank, benchmarkData, numChannels, samplesPerChannel);
+
+        vector<FLOATING_POINT> reference(bank.samples.size());
+        vector<FLOATING_POINT> results(bank.samples.size());
+
+        double tolerance = getDeviceEspsilon(numCoefficients);
+
+        char atts[1024];
+        sprintf(atts, "%d,%d,%d", numChannels, samplesPerChannel, numCoefficients);
+
+        verified.back() = true;
+
+        for (int pass = 0 ; pass < appOptions.passes; ++pass) 
+        {
+            if (!options.quiet) cout << "Pass: " << pass << endl;
+
+            chrono::steady_clock::time_point start = chrono::steady_clock::now();
+            filterBankCPU(bank, reference.data(), 0);
+            double hostTime = 
+                chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+            double t = filterBankFPGA(dev, ctx, queue, program, bank, results.data());
+
+            double rate = (totalSamples / t) / 1.e9;
+            double hostRate = (totalSamples / hostTime) / 1.e9;
+
+            if (options.verbose)
+            {
+                cout << "time = " << t << " sec, rate = " << rate << " GSamples/sec, "
+                     << "host time = " << hostTime << " sec, rate = " << hostRate 
+                     << " GSamples/sec\n";
+            }
+
+            for (size_t i=0; i<results.size(); i++)
+            {
+                if (!floatingPointEquals(reference[i], results[i], tolerance))
+                {
+                    cout << "Result mismatch at channel " << i % numChannels 
+                         << ", sample " << i / numChannels << ": " << results[i]
+                         << ", the host value: " << reference[i] << endl;
+                    verified.back() = false;
+                    break;
+                }
+            }
+
+            deviceRates.back() = max(deviceRates.back(), rate);
+            hostRates.back() = max(hostRates.back(), hostRate);
+
+            resultDB.AddResult("firfilter", "firfilter-bank", atts, "GSample/s", rate);
+            resultDB.AddResult("firfilter", "firfilter-host-bank", atts, "GSample/s", 
+                                hostRate);
+        }
+
+        if (!verified.back())
+        {
+            cout << "Could not verify the filter bank result." << endl;
+        }
+        else if (!options.quiet)
+        {
+            cout << "Successfully verified the filter bank results." << endl;
+        }
+    }
+
+    printf("\n%10s %14s %14s  %s\n", "Channels", "Device GS/s", "Host GS/s", "Verified");
+
+    for (size_t i=0; i<channelCounts.size(); i++)
+    {
+        printf("%10d %14.4f %14.4f  %s\n", channelCounts[i], deviceRates[i], hostRates[i],
+                verified[i] ? "yes" : "NO");
+    }
+
+    printf("\n");
+}
+
+// Outcome of one fixed point precision.
+typedef struct {
+    double deviceRate;      // best of the passes
+    double hostRate;
+    double maxError;        // of the dequantized results to the float filter
+    double errorBound;
+    bool verified;
+} FixedPointResult;
+
+/****************************************************************************
+* Function: benchmarkFixedPrecision()
+*
+* Purpose: Executes the passes of the fixed mode for the sample type T. The
+*          device results must be bit exact to the host engine, whose results
+*          are checked against the floating point filter within the error 
+*          bound of the quantization.
+*
+* @param program the opencl program containing the fixed point kernels
+* @param benchmarkData the input benchmark data.
+* @param resultDB results from the benchmark are stored in this db
+* @param options the benchmark suite options
+* @param appOptions the fir filter options
+*
+* @returns The rates, error and verification outcome.
+*
+****************************************************************************/
+template <typename T>
+static FixedPointResult benchmarkFixedPrecision(cl_device_id dev,
+                    cl_context ctx,
+                    cl_command_queue queue,
+                    cl_program program,
+                    BenchmarkData &benchmarkData,
+                    BenchmarkDatabase &resultDB,
+                    BenchmarkOptions &options,
+                    ApplicationOptions &appOptions)
+{
+    const char* name = FixedPointTraits<T>::name();
+    int numSamples = benchmarkData.samples.size;
+
+    FixedPointResult result = {0, 0, 0, 0, true};
+
+    FixedPointFilter<T> filter;
+    initFixedPointFilter(filter, benchmarkData);
+
+    if (options.verbose)
+    {
+        cout << name << ": sample exponent " << filter.sampleExponent 
+             << ", coefficient exponent " << filter.coeffExponent 
+             << ", result shift " << filter.shift << endl;
+    }
+
+    vector<T> hostResults(numSamples), results(numSamples);
+
+    char atts[1024];
+    sprintf(atts, "%d,%d,%d", numSamples, filter.numCoefficients, filter.shift);
+
+    string test = string("firfilter-") + name;
+    string hostTest = string("firfilter-host-") + name;
+
+    for (int pass = 0 ; pass < appOptions.passes; ++pass) 
+    {
+        if (!options.quiet) cout << "Pass: " << pass << " (" << name << ")" << endl;
+
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        filterSamplesFixedCPU(filter, hostResults.data());
+        double hostTime = 
+            chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+        double t = filterSamplesFPGAFixed(dev, ctx, queue, program, filter, 
+                                            results.data());
+
+        double rate = (double(numSamples) / t) / 1.e9;
+        double hostRate = (double(numSamples) / hostTime) / 1.e9;
+
+        if (options.verbose)
+        {
+            cout << "time = " << t << " sec, rate = " << rate << " GSamples/sec, "
+                 << "host time = " << hostTime << " sec, rate = " << hostRate 
+                 << " GSamples/sec\n";
+        }
+
+        for (int n=0; n<numSamples; n++)
+        {
+            if (results[n] != hostResults[n])
+            {
+                cout << "Result mismatch at index: " << n << endl;
+                cout << "The " << name << " value: " << int(results[n]) 
+                     << ", the host value: " << int(hostResults[n]) << endl;
+                result.verified = false;
+                break;
+            }
+        }
+
+        result.deviceRate = max(result.deviceRate, rate);
+        result.hostRate = max(result.hostRate, hostRate);
+
+        resultDB.AddResult("firfilter", test, atts, "GSample/s", rate);
+        resultDB.AddResult("firfilter", hostTest, atts, "GSample/s", hostRate);
+    }
+
+    // The host results are the same in every pass.
+    result.errorBound = getFixedPointErrorBound(filter, benchmarkData);
+    result.verified &= verifyFixedPoint(filter, benchmarkData, hostResults.data(), 
+                                        result.maxError);
+
+    if (!result.verified)
+    {
+        cout << "Could not verify the " << name << " results." << endl;
+    }
+    else if (!options.quiet)
+    {
+        cout << "Successfully verified the " << name << " results, max error " 
+             << result.maxError << " (bound " << result.errorBound << ")." << endl;
+    }
+
+    return result;
+}
+
+/****************************************************************************
+* Function: benchmarkFirFilterFixed()
+*
+* Purpose: Executes the fixed mode, the data is filtered in Q15 and in Q7 on
+*          the device and by the host engine, and the rates per precision 
+*          are compared to the floating point host engine.
+*
+* @param program the opencl program containing the fixed point kernels
+* @param benchmarkData the input benchmark data.
+* @param resultDB results from the benchmark are stored in this db
+* @param options the benchmark suite options
+* @param appOptions the fir filter options
+*
+* @returns Nothing
+*
+****************************************************************************/
+void benchmarkFirFilterFixed(cl_device_id dev,
+                    cl_context ctx,
+                    cl_command_queue queue,
+                    cl_program program,
+                    BenchmarkData &benchmarkData,
+                    BenchmarkDatabase &resultDB,
+                    BenchmarkOptions &options,
+                    ApplicationOptions &appOptions)
+{
+    int numSamples = benchmarkData.samples.size;
+
+    if (benchmarkData.coefficients.size != FIR_TAP_SIZE)
+    {
+        cout << "ERROR: the fixed point kernels are compiled for " << FIR_TAP_SIZE 
+             << " coefficients, the input has " << benchmarkData.coefficients.size 
+             << "." << endl;
+        return;
+    }
+
+    FixedPointResult q15 = benchmarkFixedPrecision<int16_t>(dev, ctx, queue, program,
+                                benchmarkData, resultDB, options, appOptions);
+    FixedPointResult q7 = benchmarkFixedPrecision<int8_t>(dev, ctx, queue, program,
+                                benchmarkData, resultDB, options, appOptions);
+
+    // The floating point host engine, for comparison.
+    vector<FLOATING_POINT> results(numSamples);
+    double floatRate = 0;
+
+    for (int pass = 0 ; pass < appOptions.passes; ++pass) 
+    {
+        double hostTime = filterSamplesHost(benchmarkData, NULL, results.data());
+        floatRate = max(floatRate, (double(numSamples) / hostTime) / 1.e9);
+    }
+
+    printf("\n%10s %14s %14s %14s %14s  %s\n", "Precision", "Device GS/s", "Host GS/s",
+            "Max error", "Error bound", "Verified");
+    printf("%10s %14.4f %14.4f %14.3e %14.3e  %s\n", "q15", q15.deviceRate, 
+            q15.hostRate, q15.maxError, q15.errorBound, q15.verified ? "yes" : "NO");
+    printf("%10s %14.4f %14.4f %14.3e %14.3e  %s\n", "q7", q7.deviceRate, 
+            q7.hostRate, q7.maxError, q7.errorBound, q7.verified ? "yes" : "NO");
+    printf("%10s %14s %14.4f %14s %14s\n\n", "float", "-", floatRate, "-", "-");
+}
+
+// A power ratio in dB, exact zeros (a perfectly learnt filter) at -300 dB.
+static double toDecibels(double ratio)
+{
+    return 10 * log10(max(ratio, 1.e-30));
+}
+
+/****************************************************************************
+* Function: benchmarkFirFilterLms()
+*
+* Purpose: Executes the passes of the lms and nlms modes: a TAP_SIZE filter
+*          is adapted, sample by sample, to map the input samples to the 
+*          file results on the device and by the host engine. Both runs must
+*          converge, i.e. their mean square error fall well below the power
+*          of the file results.
+*
+* @param program the opencl program containing the convolve_lms kernel
+* @param benchmarkData the input benchmark data.
+* @param resultDB results from the benchmark are stored in this db
+* @param options the benchmark suite options
+* @param appOptions the fir filter options
+*
+* @returns Nothing
+*
+****************************************************************************/
+void benchmarkFirFilterLms(cl_device_id dev,
+                    cl_context ctx,
+                    cl_command_queue queue,
+                    cl_program program,
+                    BenchmarkData &benchmarkData,
+                    BenchmarkDatabase &resultDB,
+                    BenchmarkOptions &options,
+                    ApplicationOptions &appOptions)
+{
+    bool normalized = appOptions.firMode.compare(FIR_MODE_NLMS) == 0;
+    int numSamples = benchmarkData.samples.size;
+    int numTaps = FIR_TAP_SIZE;
+
+    if (benchmarkData.coefficients.size > numTaps)
+    {
+        cout << "ERROR: the adaptive filter kernel has " << numTaps << " taps, "
+             << "fewer than the " << benchmarkData.coefficients.size 
+             << " coefficients of the input." << endl;
+        return;
+    }
+
+    FLOATING_POINT step = getLmsStep(benchmarkData, numTaps, normalized, 
+                                    appOptions.firStep);
+
+    if (options.verbose) 
+        cout << appOptions.firMode << " step size: " << step << endl;
+
+    vector<FLOATING_POINT> weights(numTaps), errors(numSamples);
+    vector<FLOATING_POINT> hostWeights(numTaps), hostErrors(numSamples);
+
+    char atts[1024];
+    sprintf(atts, "%d,%d,%g", numSamples, numTaps, step);
+
+    string test = string("firfilter-") + appOptions.firMode;
+    string hostTest = string("firfilter-host-") + appOptions.firMode;
+
+    LmsConvergence convergence, hostConvergence;
+    double deviceRate = 0, hostRate = 0;
+
+    for (int pass = 0 ; pass < appOptions.passes; ++pass) 
+    {
+        if (!options.quiet) cout << "Pass: " << pass << endl;
+
+        double t = adaptSamplesFPGA(dev, ctx, queue, program, benchmarkData, step, 
+                                    normalized, weights.data(), errors.data());
+
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        adaptSamplesCPU(benchmarkData.samples.elements, benchmarkData.results.elements,
+                        numSamples, numTaps, step, normalized, 
+                        hostWeights.data(), hostErrors.data());
+        double hostTime = 
+            chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+        double rate = (double(numSamples) / t) / 1.e6;
+        double hostPassRate = (double(numSamples) / hostTime) / 1.e6;
+
+        if (options.verbose)
+        {
+            cout << "time = " << t << " sec, rate = " << rate << " MSamples/sec, "
+                 << "host time = " << hostTime << " sec, rate = " << hostPassRate 
+                 << " MSamples/sec\n";
+        }
+
+        convergence = getLmsConvergence(benchmarkData, errors.data(), 
+                                        weights.data(), numTaps);
+        hostConvergence = getLmsConvergence(benchmarkData, hostErrors.data(), 
+                                        hostWeights.data(), numTaps);
+
+        deviceRate = max(deviceRate, rate);
+        hostRate = max(hostRate, hostPassRate);
+
+        resultDB.AddResult("firfilter", test, atts, "MSample/s", rate);
+        resultDB.AddResult("firfilter", hostTest, atts, "MSample/s", hostPassRate);
+        resultDB.AddResult("firfilter", test + "-mse", atts, "dB", 
+                    toDecibels(convergence.finalMse / convergence.desiredPower));
+    }
+
+    if (appOptions.passes < 1) return;
+
+    if (!hostConvergence.converged)
+    {
+        cout << "The host " << appOptions.firMode << " filter did not converge, "
+             << "try a smaller --fir-step." << endl;
+    }
+
+    if (!convergence.converged)
+    {
+        cout << "Could not verify the " << appOptions.firMode << " result, the "
+             << "filter did not converge." << endl;
+    }
+    else if (!options.quiet)
+    {
+        cout << "Successfully verified the " << appOptions.firMode 
+             << " convergence." << endl;
+    }
+
+    // Mean square errors relative to the desired power, in dB.
+    printf("\n%8s %14s %12s %12s %14s  %s\n", "", "Rate MS/s", "Initial dB", 
+            "Final dB", "Misalign. dB", "Converged");
+
+    const LmsConvergence* runs[2] = {&convergence, &hostConvergence};
+    const double rates[2] = {deviceRate, hostRate};
+
+    for (int r=0; r<2; r++)
+    {
+        printf("%8s %14.4f %12.2f %12.2f %14.2f  %s\n", r == 0 ? "Device" : "Host", 
+                rates[r], toDecibels(runs[r]->initialMse / runs[r]->desiredPower),
+                toDecibels(runs[r]->finalMse / runs[r]->desiredPower),
+                toDecibels(runs[r]->misalignment), runs[r]->converged ? "yes" : "NO");
+    }
+
+    printf("\n");
+}
+
+// Outcome of one kernel variant in the comparison.
+typedef struct {
+    FirVariant variant;
+    string status;          // empty if the variant ran
+    double bestRate;        // GSample/s
+    double meanRate;        // GSample/s
+    bool verified;
+} FirVariantResult;
+
+/****************************************************************************
+* Function: benchmarkFirFilterVariants()
+*
+* Purpose: Runs each of the selected kernel variants whose bitstream is found
+*          in the kernel directory on the same data, and prints a table 
+*          comparing their rates.
+*
+* @param benchmarkData the input benchmark data to convolve.
+* @param resultDB results from the benchmark are stored in this db
+* @param options the benchmark suite options
+* @param appOptions the fir filter options
+*
+* @returns Nothing
+*
+****************************************************************************/
+void benchmarkFirFilterVariants(cl_device_id dev,
+                    cl_context ctx,
+                    cl_command_queue queue,
+                    BenchmarkData &benchmarkData,
+                    BenchmarkDatabase &resultDB,
+                    BenchmarkOptions &options,
+                    ApplicationOptions &appOptions)
+{
+    vector<FirVariant> variants;
+
+    if (!selectFirVariants(appOptions.firVariants, variants)) return;
+
+    string kernelDir = appOptions.kernelDir;
+    if (!kernelDir.empty() && kernelDir[kernelDir.size()-1] != '/') kernelDir += "/";
+
+    int numSamples = benchmarkData.samples.size;
+    int numCoefficients = benchmarkData.coefficients.size;
+
+    FLOATING_POINT *results = new FLOATING_POINT[numSamples];
+    vector<FirVariantResult> variantResults;
+
+    for (FirVariant &variant : variants)
+    {
+        FirVariantResult variantResult = {variant, "", 0, 0, true};
+        string bitstreamFile = kernelDir + variant.name + ".aocx";
+
+        if (access(bitstreamFile.c_str(), R_OK) != 0)
+        {
+            variantResult.status = "not built";
+            variantResults.push_back(variantResult);
+            continue;
+        }
+
+        if (!options.quiet) cout << "Variant: " << variant.name << endl;
+
+        cl_program program = createProgramFromBitstream(ctx, bitstreamFile, dev);
+
+        // The kernels in the bitstream rule over the table.
+        variantResult.variant = detectFirVariant(program, bitstreamFile);
+
+        if (variantResult.variant.type == FIR_KERNEL_FFT 
+            && numCoefficients > (1 << FIR_FFT_LOG2) / 2)
+        {
+            variantResult.status = "too many coefficients";
+        }
+
+        for (int pass = 0; pass < appOptions.passes && variantResult.status.empty(); ++pass)
+        {
+            double t = filterSamplesFPGA(dev, ctx, queue, program, 
+                                    variantResult.variant, benchmarkData, results);
+
+            if (t < 0)
+            {
+                variantResult.status = "no block kernel";
+                break;
+            }
+
+            double rate = (double(numSamples) / t) / 1.e9;
+
+            variantResult.bestRate = max(variantResult.bestRate, rate);
+            variantResult.meanRate += rate / appOptions.passes;
+            variantResult.verified &= verifyResults(benchmarkData, results);
+
+            if (options.verbose)
+                cout << "time = " << t << " sec, rate = " << rate << " GSamples/sec\n";
+
+            char atts[1024];
+            sprintf(atts, "%s,%d,%d", variant.name.c_str(), numSamples, numCoefficients);
+
+            resultDB.AddResult("firfilter", "firfilter-variant", atts, "GSample/s", rate);
+        }
+
+        clReleaseProgram(program);
+        variantResults.push_back(variantResult);
+    }
+
+    delete[] results;
+
+    // Fastest first, the variants that did not run last.
+    stable_sort(variantResults.begin(), variantResults.end(), 
+        [](const FirVariantResult &a, const FirVariantResult &b) 
+        { 
+            return a.status.empty() != b.status.empty() ? 
+                a.status.empty() : a.bestRate > b.bestRate; 
+        });
+
+    printf("\n%-44s %-10s %-9s %10s %10s  %s\n", "Variant", "Kernel", "Precision",
+            "Best GS/s", "Mean GS/s", "Verified");
+
+    for (FirVariantResult &variantResult : variantResults)
+    {
+        printf("%-44s %-10s %-9s ", variantResult.variant.name.c_str(),
+                getFirKernelTypeName(variantResult.variant.type),
+                variantResult.variant.doublePrecision ? "double" : "single");
+
+        if (variantResult.status.empty())
+        {
+            printf("%10.4f %10.4f  %s\n", variantResult.bestRate, variantResult.meanRate,
+                    variantResult.verified ? "yes" : "NO");
+        }
+        else
+        {
+            printf("%10s %10s  (%s)\n", "-", "-", variantResult.status.c_str());
+        }
+    }
+
+    printf("\n");
+}
+
+// A mode of its own kernel: the kernel type the bitstream must carry and the
+// benchmark run on it.
+typedef struct {
+    const char *mode;
+    FirKernelType type;
+    const char *kernels;    // named in the error of a bitstream without them
+    void (*run)(cl_device_id, cl_context, cl_command_queue, cl_program,
+                BenchmarkData &, BenchmarkDatabase &, BenchmarkOptions &,
+                ApplicationOptions &);
+} FirModeHandler;
+
+static const FirModeHandler firModeHandlers[] = {
+    { FIR_MODE_STREAM, FIR_KERNEL_STREAM, "convolve_stream kernel", benchmarkFirFilterStream },
+    { FIR_MODE_DECIMATE, FIR_KERNEL_POLYPHASE, "polyphase kernels", benchmarkFirFilterPolyphase },
+    { FIR_MODE_INTERPOLATE, FIR_KERNEL_POLYPHASE, "polyphase kernels", benchmarkFirFilterPolyphase },
+    { FIR_MODE_BANK, FIR_KERNEL_BANK, "convolve_bank kernel", benchmarkFirFilterBank },
+    { FIR_MODE_FIXED, FIR_KERNEL_FIXED, "convolve_q15 and convolve_q7 kernels", benchmarkFirFilterFixed },
+    { FIR_MODE_LMS, FIR_KERNEL_LMS, "convolve_lms kernel", benchmarkFirFilterLms },
+    { FIR_MODE_NLMS, FIR_KERNEL_LMS, "convolve_lms kernel", benchmarkFirFilterLms },
+};
+
+// The handler of the mode, NULL for the block mode of the direct and fft 
+// kernels or an unknown mode.
+static const FirModeHandler *findFirModeHandler(const string &mode)
+{
+    for (const FirModeHandler &handler : firModeHandlers)
+    {
+        if (mode.compare(handler.mode) == 0) return &handler;
+    }
+
+    return NULL;
 }
 
 /****************************************************************************
@@ -374,13 +1342,22 @@ void benchmarkFirFilter(cl_device_id dev,
     ApplicationOptions appOptions = iter->second;
 
     // TODO: Input settings to the benchmark check
+    if (findFirModeHandler(appOptions.firMode) == NULL
+        && appOptions.firMode.compare("block") != 0)
+    {
+        cerr << "ERROR: Unknown fir filter mode: " << appOptions.firMode << endl;
+        return;
+    }
 
-    if (options.verbose)
-        cout << "Creating program from the fir filter bitstream." << endl;
+    bool directMethod = appOptions.firMethod.compare(FIR_METHOD_DIRECT) == 0;
+    bool fftMethod = appOptions.firMethod.compare(FIR_METHOD_FFT) == 0;
+    bool autoMethod = appOptions.firMethod.compare(FIR_METHOD_AUTO) == 0;
 
-    cl_program program = createProgramFromBitstream(ctx,
-                                                    appOptions.bitstreamFile, 
-                                                    dev);
+    if (!directMethod && !fftMethod && !autoMethod)
+    {
+        cerr << "ERROR: Unknown fir filter method: " << appOptions.firMethod << endl;
+        return;
+    }
 
     BenchmarkData benchmarkData;
 
@@ -390,7 +1367,11 @@ void benchmarkFirFilter(cl_device_id dev,
     
     if (options.verbose) cout << "Verifying files' data.";
     
-    if (!verifyFilesData(benchmarkData)) return;   
+    if (!verifyFilesData(benchmarkData)) 
+    {
+        releaseFiles(benchmarkData);
+        return;
+    }
     
     if (!options.quiet) cout << "Input data verified." << endl;
 
@@ -400,14 +1381,130 @@ void benchmarkFirFilter(cl_device_id dev,
         cout << "Number of coefficients: " << benchmarkData.coefficients.size << endl;
     }
 
+    if (!appOptions.firVariants.empty())
+    {
+        benchmarkFirFilterVariants(dev, ctx, queue, benchmarkData, 
+                                    resultDB, options, appOptions);
+
+        releaseFiles(benchmarkData);
+        return;
+    }
+
+    if (options.verbose)
+        cout << "Creating program from the fir filter bitstream." << endl;
+
+    cl_program program = createProgramFromBitstream(ctx,
+                                                    appOptions.bitstreamFile, 
+                                                    dev);
+
+    FirVariant variant = detectFirVariant(program, appOptions.bitstreamFile);
+
+    if (options.verbose)
+    {
+        cout << "Kernel variant: " << variant.name << " (" 
+             << getFirKernelTypeName(variant.type) << ", " 
+             << (variant.doublePrecision ? "double" : "single") << ")" << endl;
+    }
+
+    const FirModeHandler *handler = findFirModeHandler(appOptions.firMode);
+
+    if (handler != NULL)
+    {
+        if (variant.type != handler->type)
+        {
+            cout << "ERROR: the " << appOptions.firMode << " mode needs the " 
+                 << handler->kernels << ", which " << appOptions.bitstreamFile 
+                 << " does not have." << endl;
+        }
+        else
+        {
+            handler->run(dev, ctx, queue, program, benchmarkData, 
+                            resultDB, options, appOptions);
+        }
+
+        clReleaseProgram(program);
+        releaseFiles(benchmarkData);
+        return;
+    }
+
+    // A bitstream carries either the direct (or channeled) or the fft kernel,
+    // the fft method needs the fft one and the auto method takes either.
+    bool deviceFft = variant.type == FIR_KERNEL_FFT;
+    string error;
+
+    if (variant.type == FIR_KERNEL_NONE || variant.type == FIR_KERNEL_STREAM 
+        || variant.type == FIR_KERNEL_POLYPHASE || variant.type == FIR_KERNEL_BANK
+        || variant.type == FIR_KERNEL_FIXED || variant.type == FIR_KERNEL_LMS)
+    {
+        error = appOptions.bitstreamFile + " has no block mode fir filter kernel";
+    }
+    else if (fftMethod != deviceFft && !autoMethod)
+    {
+        error = "the " + appOptions.firMethod + " method does not match the " 
+                + getFirKernelTypeName(variant.type) + " kernel of " 
+                + appOptions.bitstreamFile;
+    }
+    else if (deviceFft && benchmarkData.coefficients.size > (1 << FIR_FFT_LOG2) / 2)
+    {
+        error = "the fft kernel supports up to " + to_string((1 << FIR_FFT_LOG2) / 2)
+                + " coefficients, the input has " 
+                + to_string(benchmarkData.coefficients.size);
+    }
+
+    if (!error.empty())
+    {
+        cout << "ERROR: " << error << "." << endl;
+        clReleaseProgram(program);
+        releaseFiles(benchmarkData);
+        return;
+    }
+
+    // The host engine picks the method and fft size by the measured costs.
+    FirMethodChoice choice = {false, 0, 0, 0};
+    FftFilter hostFilter;
+
+    if (!directMethod)
+    {
+        choice = measureFirMethod(benchmarkData.samples.elements, 
+                        benchmarkData.samples.size, benchmarkData.coefficients.elements, 
+                        benchmarkData.coefficients.size);
+        choice.useFft = fftMethod || choice.useFft;
+
+        if (options.verbose)
+        {
+            cout << "Host cost model: direct " << choice.directCost * 1.e9 
+                 << " ns/sample, fft " << choice.fftCost * 1.e9 << " ns/sample (size "
+                 << choice.fftSize << ")" << endl;
+        }
+
+        if (choice.useFft)
+        {
+            initFftFilter(hostFilter, benchmarkData.coefficients.elements,
+                        benchmarkData.coefficients.size, choice.fftSize);
+        }
+    }
+
+    if (options.verbose)
+    {
+        cout << "Device method: " << (deviceFft ? FIR_METHOD_FFT : FIR_METHOD_DIRECT) 
+             << ", host method: " << (choice.useFft ? FIR_METHOD_FFT : FIR_METHOD_DIRECT)
+             << endl;
+    }
+
     FLOATING_POINT *results = new FLOATING_POINT[benchmarkData.samples.size];
 
+    // the fft and auto methods compare the device to the host engine of
+    // the chosen method, the direct method runs the device only
+    FLOATING_POINT *hostResults = directMethod ? NULL 
+                                    : new FLOATING_POINT[benchmarkData.samples.size];
+
     for (int pass = 0 ; pass < appOptions.passes; ++pass) 
     {
         if (!options.quiet) cout << "Pass: " << pass << endl;
 
         // in seconds.
-        double t = filterSamplesFPGA(dev, ctx, queue, program, benchmarkData, results);
+        double t = filterSamplesFPGA(dev, ctx, queue, program, variant, 
+                                        benchmarkData, results);
         
         // Calculate the rate and add it to the results.
         double rate = (double(benchmarkData.samples.size) / double(t)) / 1.e9;
@@ -436,13 +1533,36 @@ void benchmarkFirFilter(cl_device_id dev,
                 benchmarkData.coefficients.size);
 
         // Add the calculated performance to the results.
-        resultDB.AddResult("firfilter", "firfilter", atts, "GSample/s", rate);
+        resultDB.AddResult("firfilter", deviceFft ? "firfilter-fft" : "firfilter",
+                            atts, "GSample/s", rate);
+
+        if (directMethod) continue;
+
+        // The same filter by the host engine.
+        double hostTime = filterSamplesHost(benchmarkData, 
+                                choice.useFft ? &hostFilter : NULL, hostResults);
+        double hostRate = (double(benchmarkData.samples.size) / hostTime) / 1.e9;
+
+        if (options.verbose)
+            cout << "host time = " << hostTime << " sec, rate = " << hostRate << " GSamples/sec\n";
+
+        if (!verifyResults(benchmarkData, hostResults))
+        {
+            cout << "Could not verify the host computed result." << endl;
+        }
+
+        sprintf(atts, "%d,%d,%d", benchmarkData.samples.size,
+                benchmarkData.coefficients.size, choice.useFft ? choice.fftSize : 0);
+
+        resultDB.AddResult("firfilter", 
+                            choice.useFft ? "firfilter-host-fft" : "firfilter-host-direct",
+                            atts, "GSample/s", hostRate);
     }
 
-    delete results;
-    delete benchmarkData.samples.elements;
-    delete benchmarkData.coefficients.elements;
-    delete benchmarkData.results.elements;
+    delete[] results;
+    delete[] hostResults;
+    clReleaseProgram(program);
+    releaseFiles(benchmarkData);
 
     return;
 }
@@ -0,0 +1,86 @@
+/** @file firfilterhost.h */
+
+#ifndef FIR_HOST_H
+#define FIR_HOST_H
+
+#include <vector>
+
+#include "../common/utility.h"
+
+#include "firfilterutility.h"
+#include "firfilterbank.h"
+#include "firfilterfixed.h"
+#include "firfilterlms.h"
+
+#define FIR_MODE_STREAM "stream"
+
+// Number of pinned host slots between the sample producer and the device.
+#define FIR_STREAM_RING_SLOTS 4
+// Number of leading stream blocks verified against the CPU.
+#define FIR_STREAM_VERIFY_BLOCKS 8
+
+typedef struct {
+    bool verified;
+    double seconds;                 // wall time of the whole stream
+    std::vector<double> latencies;  // per block, producer ready to result read
+} StreamResult;
+
+FirVariant detectFirVariant(cl_program prog, std::string bitstreamFile);
+
+double filterSamplesFPGA(cl_device_id dev, 
+                             cl_context ctx,
+                             cl_command_queue queue,
+                             cl_program prog,
+                             const FirVariant &variant,
+                             BenchmarkData &benchmarkData,
+                             FLOATING_POINT* results);
+
+double filterSamplesFPGAFft(cl_device_id dev,
+                             cl_context ctx,
+                             cl_command_queue queue,
+                             cl_program prog,
+                             BenchmarkData &benchmarkData,
+                             FLOATING_POINT* results);
+
+double resampleSamplesFPGA(cl_device_id dev,
+                             cl_context ctx,
+                             cl_command_queue queue,
+                             cl_program prog,
+                             BenchmarkData &benchmarkData,
+                             bool interpolate,
+                             FLOATING_POINT* results);
+
+double filterBankFPGA(cl_device_id dev,
+                             cl_context ctx,
+                             cl_command_queue queue,
+                             cl_program prog,
+                             FilterBank &bank,
+                             FLOATING_POINT* results);
+
+template <typename T>
+double filterSamplesFPGAFixed(cl_device_id dev,
+                             cl_context ctx,
+                             cl_command_queue queue,
+                             cl_program prog,
+                             const FixedPointFilter<T> &filter,
+                             T* results);
+
+double adaptSamplesFPGA(cl_device_id dev,
+                             cl_context ctx,
+                             cl_command_queue queue,
+                             cl_program prog,
+                             BenchmarkData &benchmarkData,
+                             FLOATING_POINT step,
+                             bool normalized,
+                             FLOATING_POINT* weights,
+                             FLOATING_POINT* errors);
+
+StreamResult streamSamplesFPGA(cl_device_id dev,
+                             cl_context ctx,
+                             cl_command_queue queue,
+                             cl_program prog,
+                             BenchmarkData &benchmarkData,
+                             int blockSize,
+                             int numBlocks);
+
+#endif
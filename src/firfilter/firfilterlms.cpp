@@ -0,0 +1,190 @@
+#include <stdlib.h>
+#include <math.h>
+#include <algorithm>
+
+#if defined(__AVX2__) && defined(__FMA__)
+#include <immintrin.h>
+#endif
+
+#include "firfilterlms.h"
+
+using namespace std;
+
+#define LMS_VECTOR 8
+
+static double getMeanSquare(const FLOATING_POINT* values, long count)
+{
+    double sum = 0;
+    for (long i=0; i<count; i++) sum += double(values[i]) * values[i];
+    return count > 0 ? sum / count : 0;
+}
+
+/****************************************************************************
+* Function: getLmsStep()
+*
+* Purpose: Picks the step size of the adaptive filter, the given one if it
+*          is positive, or else the default of the rule. The LMS default is
+*          scaled by the tap count and the power of the input samples.
+*
+* @param benchmarkData the input benchmark data.
+* @param numTaps the number of adaptive filter taps.
+* @param normalized whether the rule is NLMS or LMS.
+* @param step the step size option, 0 for the default.
+* @returns The step size.
+*
+*****************************************************************************/
+double getLmsStep(BenchmarkData &benchmarkData, int numTaps, bool normalized,
+                    double step)
+{
+    if (step > 0) return step;
+    if (normalized) return FIR_NLMS_DEFAULT_STEP;
+
+    double power = getMeanSquare(benchmarkData.samples.elements,
+                                benchmarkData.samples.size);
+
+    return FIR_LMS_DEFAULT_STEP / (numTaps * max(power, FIR_LMS_DELTA));
+}
+
+// The output of the weights for the window and the weight update by
+// update*window, both over numTaps weights.
+static FLOATING_POINT dotWindow(const FLOATING_POINT* weights,
+                    const FLOATING_POINT* window, int numTaps)
+{
+    int q = 0;
+    FLOATING_POINT sum = 0;
+
+#if defined(__AVX2__) && defined(__FMA__)
+    __m256 acc0 = _mm256_setzero_ps(), acc1 = _mm256_setzero_ps();
+
+    for (; q+2*LMS_VECTOR<=numTaps; q+=2*LMS_VECTOR)
+    {
+        acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(weights+q),
+                                _mm256_loadu_ps(window+q), acc0);
+        acc1 = _mm256_fmadd_ps(_mm256_loadu_ps(weights+q+LMS_VECTOR),
+                                _mm256_loadu_ps(window+q+LMS_VECTOR), acc1);
+    }
+
+    __m256 acc = _mm256_add_ps(acc0, acc1);
+    __m128 r = _mm_add_ps(_mm256_castps256_ps128(acc), _mm256_extractf128_ps(acc, 1));
+    r = _mm_hadd_ps(r, r);
+    r = _mm_hadd_ps(r, r);
+    sum = _mm_cvtss_f32(r);
+#endif
+
+    for (; q<numTaps; q++) sum += weights[q] * window[q];
+    return sum;
+}
+
+static void updateWeights(FLOATING_POINT* weights, const FLOATING_POINT* window,
+                    FLOATING_POINT update, int numTaps)
+{
+    int q = 0;
+
+#if defined(__AVX2__) && defined(__FMA__)
+    __m256 u = _mm256_set1_ps(update);
+
+    for (; q+LMS_VECTOR<=numTaps; q+=LMS_VECTOR)
+    {
+        _mm256_storeu_ps(weights+q, _mm256_fmadd_ps(u, _mm256_loadu_ps(window+q),
+                                                    _mm256_loadu_ps(weights+q)));
+    }
+#endif
+
+    for (; q<numTaps; q++) weights[q] += update * window[q];
+}
+
+/****************************************************************************
+* Function: adaptSamplesCPU()
+*
+* Purpose: Adapts a fir filter of numTaps weights, starting from zero, so
+*          that it maps the samples to the desired samples by the LMS or
+*          NLMS rule, updating the weights after every output like the
+*          convolve_lms kernel.
+*
+* @param samples the input samples.
+* @param desired the desired output samples.
+* @param numSamples the number of samples.
+* @param numTaps the number of weights.
+* @param step the step size (LMS) or normalized step size (NLMS).
+* @param normalized whether the rule is NLMS or LMS.
+* @param weights output -the numTaps adapted weights (coefficients).
+* @param errors output -the error desired-y of each sample.
+* @returns Void
+*
+*****************************************************************************/
+void adaptSamplesCPU(const FLOATING_POINT* samples, const FLOATING_POINT* desired,
+                    int numSamples, int numTaps, FLOATING_POINT step, bool normalized,
+                    FLOATING_POINT* weights, FLOATING_POINT* errors)
+{
+    // numTaps-1 zero samples ahead, the window of sample n starts at n and
+    // ends with the sample. Weight q multiplies window sample q, i.e. it is
+    // coefficient numTaps-1-q.
+    vector<FLOATING_POINT> windows(numTaps-1 + numSamples, 0);
+    copy(samples, samples + numSamples, windows.begin() + numTaps-1);
+
+    vector<FLOATING_POINT> reversed(numTaps, 0);
+    double energy = 0;
+
+    for (int n=0; n<numSamples; n++)
+    {
+        const FLOATING_POINT* window = &windows[n];
+
+        // The window gained the sample and lost the one before its start.
+        energy += double(samples[n]) * samples[n];
+        if (n > 0) energy -= double(windows[n-1]) * windows[n-1];
+
+        FLOATING_POINT e = desired[n] - dotWindow(reversed.data(), window, numTaps);
+        FLOATING_POINT mu = normalized ? step / (FIR_LMS_DELTA + max(energy, 0.0)) : step;
+
+        updateWeights(reversed.data(), window, mu * e, numTaps);
+        errors[n] = e;
+    }
+
+    for (int k=0; k<numTaps; k++)
+        weights[k] = reversed[numTaps-1-k];
+}
+
+/****************************************************************************
+* Function: getLmsConvergence()
+*
+* Purpose: Measures the convergence of an adaptive filter run on the
+*          benchmark data, whose desired samples are the file results, by
+*          the mean square errors of the first and last window and by the
+*          misalignment of the weights to the file coefficients.
+*
+* @param benchmarkData the input benchmark data.
+* @param errors the errors of the run.
+* @param weights the adapted weights.
+* @param numTaps the number of weights.
+* @returns The convergence measures.
+*
+*****************************************************************************/
+LmsConvergence getLmsConvergence(BenchmarkData &benchmarkData,
+                    const FLOATING_POINT* errors, const FLOATING_POINT* weights,
+                    int numTaps)
+{
+    int numSamples = benchmarkData.samples.size;
+    int window = min(FIR_LMS_MSE_WINDOW, max(1, numSamples / 4));
+
+    LmsConvergence convergence;
+    convergence.desiredPower = getMeanSquare(benchmarkData.results.elements, numSamples);
+    convergence.initialMse = getMeanSquare(errors, window);
+    convergence.finalMse = getMeanSquare(errors + numSamples - window, window);
+
+    // The file coefficients, zero padded to the taps.
+    double distance = 0, norm = 0;
+    for (int k=0; k<max(numTaps, benchmarkData.coefficients.size); k++)
+    {
+        double h = k < benchmarkData.coefficients.size ?
+                    benchmarkData.coefficients.elements[k] : 0;
+        double w = k < numTaps ? weights[k] : 0;
+        distance += (w - h) * (w - h);
+        norm += h * h;
+    }
+
+    convergence.misalignment = norm > 0 ? distance / norm : distance;
+    convergence.converged = convergence.finalMse <= convergence.desiredPower
+                            * pow(10.0, -FIR_LMS_MIN_ATTENUATION_DB / 10.0);
+
+    return convergence;
+}
@@ -0,0 +1,45 @@
+#ifndef FIR_LMS_H
+#define FIR_LMS_H
+
+#include <vector>
+
+#include "firfilterutility.h"
+
+#define FIR_MODE_LMS "lms"
+#define FIR_MODE_NLMS "nlms"
+
+// Default step sizes: normalized for NLMS, and for LMS divided by the tap
+// count times the input power, well inside the stable range of both.
+#define FIR_NLMS_DEFAULT_STEP 0.5
+#define FIR_LMS_DEFAULT_STEP 0.2
+
+// Regularization of the NLMS step (as in the kernel).
+#define FIR_LMS_DELTA 1e-6
+
+// The mean square errors are taken over windows of this many samples (or a
+// quarter of the samples if fewer), the filter has converged if the last
+// window is this many dB below the power of the desired signal.
+#define FIR_LMS_MSE_WINDOW 4096
+#define FIR_LMS_MIN_ATTENUATION_DB 20
+
+// How well the adaptive filter learnt the desired signal.
+typedef struct {
+    double desiredPower;    // mean square of the desired samples
+    double initialMse;      // mean square error of the first window
+    double finalMse;        // mean square error of the last window
+    double misalignment;    // |w-h|^2/|h|^2 of the weights to the file coefficients
+    bool converged;
+} LmsConvergence;
+
+double getLmsStep(BenchmarkData &benchmarkData, int numTaps, bool normalized, 
+                    double step);
+
+void adaptSamplesCPU(const FLOATING_POINT* samples, const FLOATING_POINT* desired,
+                    int numSamples, int numTaps, FLOATING_POINT step, bool normalized,
+                    FLOATING_POINT* weights, FLOATING_POINT* errors);
+
+LmsConvergence getLmsConvergence(BenchmarkData &benchmarkData, 
+                    const FLOATING_POINT* errors, const FLOATING_POINT* weights, 
+                    int numTaps);
+
+#endif
@@ -0,0 +1,165 @@
+/** @file firfilterlmshost.cpp */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <string.h>
+
+#include "../common/utility.h"
+#include "../common/benchmarkoptions.h"
+
+#include "firfilterutility.h"
+#include "firfilterlms.h"
+#include "firfilterhost.h"
+
+using namespace std;
+
+/****************************************************************************
+* Function: adaptSamplesFPGA()
+*
+* Purpose: On the FPGA, adapt a TAP_SIZE fir filter to map the input samples
+*          to the desired samples (the file results) by the convolve_lms 
+*          kernel, with the LMS or NLMS rule.
+*
+* @param ctx the opencl context to use for the benchmark
+* @param queue the opencl command queue to issue commands to
+* @param prog the opencl program containing the kernel
+* @param benchmarkData the input benchmark data.
+* @param step the step size (LMS) or normalized step size (NLMS).
+* @param normalized whether the rule is NLMS or LMS.
+* @param weights output -the TAP_SIZE adapted weights.
+* @param errors output -the error of each sample.
+* @returns The kernel runtime in seconds.
+*
+*****************************************************************************/
+double adaptSamplesFPGA(cl_device_id dev,
+                             cl_context ctx,
+                             cl_command_queue queue,
+                             cl_program prog,
+                             BenchmarkData &benchmarkData,
+                             FLOATING_POINT step,
+                             bool normalized,
+                             FLOATING_POINT* weights,
+                             FLOATING_POINT* errors)
+{
+    FLOATING_POINT* samples = benchmarkData.samples.elements;
+    FLOATING_POINT* desired = benchmarkData.results.elements;
+    int numSamples = benchmarkData.samples.size;
+    int numTaps = FIR_TAP_SIZE;
+    int normalizedArg = normalized ? 1 : 0;
+
+    int err;
+
+    //
+    // find the kernel
+    //
+    cl_kernel filterkernel = clCreateKernel(prog, "convolve_lms", &err);
+    CL_CHECK_ERROR(err);
+
+    //
+    // allocate device memory for input and output buffers.
+    //
+    cl_mem d_samples = clCreateBuffer(ctx, CL_MEM_READ_ONLY,
+                                          sizeof(FLOATING_POINT)*numSamples, NULL, &err);
+    CL_CHECK_ERROR(err);
+
+    cl_mem d_desired = clCreateBuffer(ctx, CL_MEM_READ_ONLY,
+                                          sizeof(FLOATING_POINT)*numSamples, NULL, &err);
+    CL_CHECK_ERROR(err);
+
+    cl_mem d_weights = clCreateBuffer(ctx, CL_MEM_WRITE_ONLY,
+                                          sizeof(FLOATING_POINT)*numTaps, NULL, &err);
+    CL_CHECK_ERROR(err);
+
+    cl_mem d_errors = clCreateBuffer(ctx, CL_MEM_WRITE_ONLY,
+                                          sizeof(FLOATING_POINT)*numSamples, NULL, &err);
+    CL_CHECK_ERROR(err);
+
+    //
+    // write input buffers to the device memory.
+    //
+    err = clEnqueueWriteBuffer(queue, d_samples, true, 0,
+                               sizeof(FLOATING_POINT)*numSamples, samples,
+                               0, NULL, NULL);
+    CL_CHECK_ERROR(err);
+
+    err = clEnqueueWriteBuffer(queue, d_desired, true, 0,
+                               sizeof(FLOATING_POINT)*numSamples, desired,
+                               0, NULL, NULL);
+    CL_CHECK_ERROR(err);
+
+    err = clFinish(queue);
+    CL_CHECK_ERROR(err);
+
+    //
+    // set arguments for the kernel
+    //
+    err = clSetKernelArg(filterkernel, 0, sizeof(cl_mem), (void*)&d_samples);
+    CL_CHECK_ERROR(err);
+    err = clSetKernelArg(filterkernel, 1, sizeof(cl_mem), (void*)&d_desired);
+    CL_CHECK_ERROR(err);
+    err = clSetKernelArg(filterkernel, 2, sizeof(cl_mem), (void*)&d_weights);
+    CL_CHECK_ERROR(err);
+    err = clSetKernelArg(filterkernel, 3, sizeof(cl_mem), (void*)&d_errors);
+    CL_CHECK_ERROR(err);
+    err = clSetKernelArg(filterkernel, 4, sizeof(int), (void*)&numSamples);
+    CL_CHECK_ERROR(err);
+    err = clSetKernelArg(filterkernel, 5, sizeof(FLOATING_POINT), (void*)&step);
+    CL_CHECK_ERROR(err);
+    err = clSetKernelArg(filterkernel, 6, sizeof(int), (void*)&normalizedArg);
+    CL_CHECK_ERROR(err);
+
+    //
+    // run the kernel
+    //
+    cl_event event = NULL;
+    err = clEnqueueTask(queue, filterkernel, 0, NULL, &event);
+    CL_CHECK_ERROR(err);
+
+    err = clFinish(queue);
+    CL_CHECK_ERROR (err);
+
+    //
+    // get the timing/rate info
+    //
+    cl_ulong submitTime;
+    cl_ulong endTime;
+
+    err = clGetEventProfilingInfo(event, CL_PROFILING_COMMAND_SUBMIT,
+                                    sizeof(cl_ulong), &submitTime, NULL);
+    CL_CHECK_ERROR(err);
+
+    err = clGetEventProfilingInfo(event, CL_PROFILING_COMMAND_END,
+                                    sizeof(cl_ulong), &endTime, NULL);
+    CL_CHECK_ERROR(err);
+
+    double nanosec = endTime - submitTime;
+
+    //
+    // read the adapted weights and the errors
+    //
+    err = clEnqueueReadBuffer(queue, d_weights, true, 0,
+                              sizeof(FLOATING_POINT)*numTaps, weights,
+                              0, NULL, NULL);
+    CL_CHECK_ERROR(err);
+
+    err = clEnqueueReadBuffer(queue, d_errors, true, 0,
+                              sizeof(FLOATING_POINT)*numSamples, errors,
+                              0, NULL, NULL);
+    CL_CHECK_ERROR(err);
+
+    //
+    // free device memory
+    //
+    clReleaseEvent(event);
+    clReleaseMemObject(d_samples);
+    clReleaseMemObject(d_desired);
+    clReleaseMemObject(d_weights);
+    clReleaseMemObject(d_errors);
+    clReleaseKernel(filterkernel);
+
+    //
+    // return the runtime in seconds
+    //
+    return nanosec / 1.e9;
+}
@@ -0,0 +1,249 @@
+#include <stdlib.h>
+#include <math.h>
+#include <iostream>
+#include <algorithm>
+
+#if defined(__AVX2__) && defined(__FMA__)
+#include <immintrin.h>
+#endif
+
+#include "firfilterpolyphase.h"
+#include "firfilterfft.h"
+
+using namespace std;
+
+// Tap counts are padded to whole vectors of this many samples.
+#define POLYPHASE_VECTOR 8
+
+static int roundUp(int n, int multiple)
+{
+    return ((n + multiple - 1) / multiple) * multiple;
+}
+
+void initPolyphaseFilter(PolyphaseFilter &filter, const FLOATING_POINT* coefficients,
+                    int numCoefficients, int factor)
+{
+    filter.factor = factor;
+    filter.numCoefficients = numCoefficients;
+
+    int numTaps = roundUp(numCoefficients, POLYPHASE_VECTOR);
+    filter.taps.assign(numTaps, 0);
+    for (int q=0; q<numTaps; q++)
+    {
+        int k = numTaps-1-q;
+        if (k < numCoefficients) filter.taps[q] = coefficients[k];
+    }
+
+    filter.phaseTaps = roundUp((numCoefficients + factor - 1) / factor, POLYPHASE_VECTOR);
+    filter.phases.assign(factor * filter.phaseTaps, 0);
+    for (int p=0; p<factor; p++)
+    {
+        for (int q=0; q<filter.phaseTaps; q++)
+        {
+            int k = p + (filter.phaseTaps-1-q) * factor;
+            if (k < numCoefficients) filter.phases[p*filter.phaseTaps + q] = coefficients[k];
+        }
+    }
+}
+
+int getDecimatedSize(int numSamples, int factor)
+{
+    return (numSamples + factor - 1) / factor;
+}
+
+// Dot product of the taps with the samples [start, start+numTaps), where
+// the samples before the first one are zero.
+static FLOATING_POINT dotClipped(const FLOATING_POINT* samples, long start,
+                    const FLOATING_POINT* taps, int numTaps)
+{
+    FLOATING_POINT sum = 0;
+    for (int q=max(0L, -start); q<numTaps; q++)
+        sum += taps[q] * samples[start+q];
+    return sum;
+}
+
+// Four dot products of numTaps (a multiple of 8) taps with sample windows,
+// the loads of a window or taps shared between them stay in L1.
+static void dot4(const FLOATING_POINT* const windows[4],
+                    const FLOATING_POINT* const taps[4], int numTaps,
+                    FLOATING_POINT sums[4])
+{
+#if defined(__AVX2__) && defined(__FMA__)
+    __m256 acc0 = _mm256_setzero_ps(), acc1 = _mm256_setzero_ps();
+    __m256 acc2 = _mm256_setzero_ps(), acc3 = _mm256_setzero_ps();
+
+    for (int q=0; q<numTaps; q+=POLYPHASE_VECTOR)
+    {
+        acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(taps[0]+q), _mm256_loadu_ps(windows[0]+q), acc0);
+        acc1 = _mm256_fmadd_ps(_mm256_loadu_ps(taps[1]+q), _mm256_loadu_ps(windows[1]+q), acc1);
+        acc2 = _mm256_fmadd_ps(_mm256_loadu_ps(taps[2]+q), _mm256_loadu_ps(windows[2]+q), acc2);
+        acc3 = _mm256_fmadd_ps(_mm256_loadu_ps(taps[3]+q), _mm256_loadu_ps(windows[3]+q), acc3);
+    }
+
+    // Transpose-add the four accumulators into one vector of four sums.
+    __m256 s01 = _mm256_hadd_ps(acc0, acc1);
+    __m256 s23 = _mm256_hadd_ps(acc2, acc3);
+    __m256 s = _mm256_hadd_ps(s01, s23);
+    __m128 r = _mm_add_ps(_mm256_castps256_ps128(s), _mm256_extractf128_ps(s, 1));
+    _mm_storeu_ps(sums, r);
+#else
+    for (int d=0; d<4; d++)
+    {
+        FLOATING_POINT sum = 0;
+        for (int q=0; q<numTaps; q++)
+            sum += taps[d][q] * windows[d][q];
+        sums[d] = sum;
+    }
+#endif
+}
+
+/****************************************************************************
+* Function: decimateSamplesCPU()
+*
+* Purpose: Filters and decimates the samples by the filter factor, i.e.
+*          computes only the outputs 0, factor, 2*factor, ... of the full
+*          rate filter.
+*
+* @param filter the polyphase filter.
+* @param samples the input samples.
+* @param numSamples the number of input samples.
+* @param results output -getDecimatedSize(numSamples, factor) samples.
+* @returns Void
+*
+*****************************************************************************/
+void decimateSamplesCPU(const PolyphaseFilter &filter, const FLOATING_POINT* samples,
+                    int numSamples, FLOATING_POINT* results)
+{
+    int factor = filter.factor;
+    int numTaps = filter.taps.size();
+    int numOutputs = getDecimatedSize(numSamples, factor);
+    const FLOATING_POINT* taps = filter.taps.data();
+
+    // The windows of the first outputs reach before the first sample.
+    int first = min(numOutputs, (numTaps - 1 + factor - 1) / factor);
+    int m = 0;
+
+    for (; m<first; m++)
+        results[m] = dotClipped(samples, long(m)*factor - numTaps + 1, taps, numTaps);
+
+    const FLOATING_POINT* const allTaps[4] = {taps, taps, taps, taps};
+
+    for (; m+4<=numOutputs; m+=4)
+    {
+        const FLOATING_POINT* base = samples + long(m)*factor - numTaps + 1;
+        const FLOATING_POINT* const windows[4] =
+            {base, base + factor, base + 2*factor, base + 3*factor};
+        dot4(windows, allTaps, numTaps, results + m);
+    }
+
+    for (; m<numOutputs; m++)
+        results[m] = dotClipped(samples, long(m)*factor - numTaps + 1, taps, numTaps);
+}
+
+/****************************************************************************
+* Function: interpolateSamplesCPU()
+*
+* Purpose: Interpolates the samples by the filter factor, the output is the
+*          filtered input with factor-1 zeros after each sample. Output
+*          j*factor+p is computed by phase p of the filter from the input
+*          samples up to j.
+*
+* @param filter the polyphase filter.
+* @param samples the input samples.
+* @param numSamples the number of input samples.
+* @param results output -numSamples*factor samples.
+* @returns Void
+*
+*****************************************************************************/
+void interpolateSamplesCPU(const PolyphaseFilter &filter, const FLOATING_POINT* samples,
+                    int numSamples, FLOATING_POINT* results)
+{
+    int factor = filter.factor;
+    int phaseTaps = filter.phaseTaps;
+    const FLOATING_POINT* phases = filter.phases.data();
+
+    int first = min(numSamples, phaseTaps - 1);
+    int j = 0;
+
+    for (; j<first; j++)
+    {
+        for (int p=0; p<factor; p++)
+        {
+            results[long(j)*factor + p] = dotClipped(samples, long(j) - phaseTaps + 1,
+                                            phases + p*phaseTaps, phaseTaps);
+        }
+    }
+
+    for (; j<numSamples; j++)
+    {
+        const FLOATING_POINT* window = samples + j - phaseTaps + 1;
+        const FLOATING_POINT* const windows[4] = {window, window, window, window};
+        FLOATING_POINT* out = results + long(j)*factor;
+        int p = 0;
+
+        for (; p+4<=factor; p+=4)
+        {
+            const FLOATING_POINT* const taps[4] = {phases + p*phaseTaps,
+                phases + (p+1)*phaseTaps, phases + (p+2)*phaseTaps, phases + (p+3)*phaseTaps};
+            dot4(windows, taps, phaseTaps, out + p);
+        }
+
+        for (; p<factor; p++)
+            out[p] = dotClipped(window, 0, phases + p*phaseTaps, phaseTaps);
+    }
+}
+
+// Decimated outputs are every factor-th full rate result of the data files.
+bool verifyDecimated(BenchmarkData &benchmarkData, int factor, FLOATING_POINT* results)
+{
+    double tolerance = getDeviceEspsilon(benchmarkData.coefficients.size);
+    int numOutputs = getDecimatedSize(benchmarkData.results.size, factor);
+
+    for (int m=0; m<numOutputs; m++)
+    {
+        FLOATING_POINT expected = benchmarkData.results.elements[long(m)*factor];
+
+        if (!floatingPointEquals(expected, results[m], tolerance))
+        {
+            cout << "Result mismatch at index: " << m << endl;
+            cout << "The cacluated value: " << results[m]
+                 << ", the precalculated value: " << expected << endl;
+            cout << "Comparision tolerance :" << tolerance << endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+// Interpolated outputs are checked by fft filtering the zero stuffed input.
+bool verifyInterpolated(BenchmarkData &benchmarkData, int factor, FLOATING_POINT* results)
+{
+    int numSamples = benchmarkData.samples.size;
+    int numCoefficients = benchmarkData.coefficients.size;
+    long numOutputs = long(numSamples) * factor;
+    double tolerance = getDeviceEspsilon(numCoefficients);
+
+    vector<FLOATING_POINT> stuffed(numOutputs, 0);
+    for (int j=0; j<numSamples; j++)
+        stuffed[long(j)*factor] = benchmarkData.samples.elements[j];
+
+    FftFilter filter;
+    initFftFilter(filter, benchmarkData.coefficients.elements, numCoefficients,
+                nextPowerOfTwo(8*numCoefficients));
+
+    vector<FLOATING_POINT> expected(numOutputs);
+    filterSamplesFFT(filter, stuffed.data(), numOutputs, expected.data());
+
+    for (long n=0; n<numOutputs; n++)
+    {
+        if (!floatingPointEquals(expected[n], results[n], tolerance))
+        {
+            cout << "Result mismatch at index: " << n << endl;
+            cout << "The cacluated value: " << results[n]
+                 << ", the expected value: " << expected[n] << endl;
+            cout << "Comparision tolerance :" << tolerance << endl;
+            return false;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,44 @@
+#ifndef FIR_POLYPHASE_H
+#define FIR_POLYPHASE_H
+
+#include <vector>
+
+#include "firfilterutility.h"
+
+// Rate change factor the polyphase kernels are compiled with (set by CMake).
+#ifndef FIR_RATE_FACTOR
+#define FIR_RATE_FACTOR 4
+#endif
+
+#define FIR_MODE_DECIMATE "decimate"
+#define FIR_MODE_INTERPOLATE "interpolate"
+
+// Polyphase form of a fir filter for resampling by factor. Decimation
+// filters only every factor-th output, interpolation filters the input
+// (with factor-1 zeros stuffed after each sample) by factor sub-filters of
+// phaseTaps taps, one per output phase, skipping the zero products.
+typedef struct {
+    int factor;
+    int numCoefficients;
+    int phaseTaps;
+    // The reversed coefficients, zero padded to a multiple of 8.
+    std::vector<FLOATING_POINT> taps;
+    // factor phases of phaseTaps reversed coefficients, phase p holds the
+    // coefficients p, p+factor, p+2*factor, ...
+    std::vector<FLOATING_POINT> phases;
+} PolyphaseFilter;
+
+void initPolyphaseFilter(PolyphaseFilter &filter, const FLOATING_POINT* coefficients,
+                    int numCoefficients, int factor);
+
+int getDecimatedSize(int numSamples, int factor);
+
+void decimateSamplesCPU(const PolyphaseFilter &filter, const FLOATING_POINT* samples,
+                    int numSamples, FLOATING_POINT* results);
+void interpolateSamplesCPU(const PolyphaseFilter &filter, const FLOATING_POINT* samples,
+                    int numSamples, FLOATING_POINT* results);
+
+bool verifyDecimated(BenchmarkData &benchmarkData, int factor, FLOATING_POINT* results);
+bool verifyInterpolated(BenchmarkData &benchmarkData, int factor, FLOATING_POINT* results);
+
+#endif
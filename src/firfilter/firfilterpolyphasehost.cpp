@@ -0,0 +1,147 @@
+/** @file firfilterpolyphasehost.cpp */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <string.h>
+
+#include "../common/utility.h"
+#include "../common/benchmarkoptions.h"
+
+#include "firfilterutility.h"
+#include "firfilterpolyphase.h"
+#include "firfilterhost.h"
+
+using namespace std;
+
+/****************************************************************************
+* Function: resampleSamplesFPGA()
+*
+* Purpose: On the FPGA, decimate or interpolate the input samples by
+*          FIR_RATE_FACTOR with the FIR filter in coefficients, by the
+*          convolve_decimate or convolve_interpolate polyphase kernel.
+*
+* @param ctx the opencl context to use for the benchmark
+* @param queue the opencl command queue to issue commands to
+* @param prog the opencl program containing the kernel
+* @param benchmarkData the input benchmark data to resample.
+* @param interpolate whether to interpolate or decimate.
+* @param result output -the resampled samples.
+* @returns The kernel runtime in seconds.
+*
+*****************************************************************************/
+double resampleSamplesFPGA(cl_device_id dev,
+                             cl_context ctx,
+                             cl_command_queue queue,
+                             cl_program prog,
+                             BenchmarkData &benchmarkData,
+                             bool interpolate,
+                             FLOATING_POINT* results)
+{
+    FLOATING_POINT* samples = benchmarkData.samples.elements;
+    FLOATING_POINT* coefficients = benchmarkData.coefficients.elements;
+    int numSamples = benchmarkData.samples.size;
+    int numCoefficients = benchmarkData.coefficients.size;
+    long numResults = interpolate ? long(numSamples) * FIR_RATE_FACTOR :
+                                    getDecimatedSize(numSamples, FIR_RATE_FACTOR);
+
+    int err;
+
+    //
+    // find the kernel
+    //
+    cl_kernel filterkernel = clCreateKernel(prog,
+                    interpolate ? "convolve_interpolate" : "convolve_decimate", &err);
+    CL_CHECK_ERROR(err);
+
+    //
+    // allocate device memory for input and output buffers.
+    //
+    cl_mem d_samples = clCreateBuffer(ctx, CL_MEM_READ_ONLY,
+                                          sizeof(FLOATING_POINT)*numSamples, NULL, &err);
+    CL_CHECK_ERROR(err);
+
+    cl_mem d_coefficients = clCreateBuffer(ctx, CL_MEM_READ_ONLY,
+                                          sizeof(FLOATING_POINT)*numCoefficients, NULL, &err);
+    CL_CHECK_ERROR(err);
+
+    cl_mem d_results = clCreateBuffer(ctx, CL_MEM_WRITE_ONLY,
+                                          sizeof(FLOATING_POINT)*numResults, NULL, &err);
+    CL_CHECK_ERROR(err);
+
+    //
+    // write input buffers to the device memory.
+    //
+    err = clEnqueueWriteBuffer(queue, d_samples, true, 0,
+                               sizeof(FLOATING_POINT)*numSamples, samples,
+                               0, NULL, NULL);
+    CL_CHECK_ERROR(err);
+
+    err = clEnqueueWriteBuffer(queue, d_coefficients, true, 0,
+                               sizeof(FLOATING_POINT)*numCoefficients, coefficients,
+                               0, NULL, NULL);
+    CL_CHECK_ERROR(err);
+
+    err = clFinish(queue);
+    CL_CHECK_ERROR(err);
+
+    //
+    // set arguments for the kernel
+    //
+    err = clSetKernelArg(filterkernel, 0, sizeof(cl_mem), (void*)&d_samples);
+    CL_CHECK_ERROR(err);
+    err = clSetKernelArg(filterkernel, 1, sizeof(cl_mem), (void*)&d_coefficients);
+    CL_CHECK_ERROR(err);
+    err = clSetKernelArg(filterkernel, 2, sizeof(cl_mem), (void*)&d_results);
+    CL_CHECK_ERROR(err);
+    err = clSetKernelArg(filterkernel, 3, sizeof(int), (void*)&numSamples);
+    CL_CHECK_ERROR(err);
+
+    //
+    // run the kernel
+    //
+    cl_event event = NULL;
+    err = clEnqueueTask(queue, filterkernel, 0, NULL, &event);
+    CL_CHECK_ERROR(err);
+
+    err = clFinish(queue);
+    CL_CHECK_ERROR (err);
+
+    //
+    // get the timing/rate info
+    //
+    cl_ulong submitTime;
+    cl_ulong endTime;
+
+    err = clGetEventProfilingInfo(event, CL_PROFILING_COMMAND_SUBMIT,
+                                    sizeof(cl_ulong), &submitTime, NULL);
+    CL_CHECK_ERROR(err);
+
+    err = clGetEventProfilingInfo(event, CL_PROFILING_COMMAND_END,
+                                    sizeof(cl_ulong), &endTime, NULL);
+    CL_CHECK_ERROR(err);
+
+    double nanosec = endTime - submitTime;
+
+    //
+    // read the resampled result
+    //
+    err = clEnqueueReadBuffer(queue, d_results, true, 0,
+                              sizeof(FLOATING_POINT)*numResults, results,
+                              0, NULL, NULL);
+    CL_CHECK_ERROR(err);
+
+    //
+    // free device memory
+    //
+    clReleaseEvent(event);
+    clReleaseMemObject(d_samples);
+    clReleaseMemObject(d_coefficients);
+    clReleaseMemObject(d_results);
+    clReleaseKernel(filterkernel);
+
+    //
+    // return the runtime in seconds
+    //
+    return nanosec / 1.e9;
+}
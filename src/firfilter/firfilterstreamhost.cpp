@@ -0,0 +1,318 @@
+/** @file firfilterstreamhost.cpp */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+
+#include "../common/utility.h"
+#include "../common/benchmarkoptions.h"
+
+#include "firfilterutility.h"
+#include "firfilterhost.h"
+
+using namespace std;
+
+typedef chrono::steady_clock StreamClock;
+
+// Pinned host slots filled by the producer thread and drained by the
+// device feeding loop, in stream order.
+typedef struct {
+    FLOATING_POINT* slots;
+    int blockSize;
+
+    mutex lock;
+    condition_variable changed;
+    deque<int> filled;
+    int freeSlots;
+    vector<StreamClock::time_point> readyTimes;
+} SampleRing;
+
+static void produceSamples(SampleRing *ring, FileData *samples, int numBlocks)
+{
+    for (int block=0; block<numBlocks; block++)
+    {
+        {
+            unique_lock<mutex> guard(ring->lock);
+            ring->changed.wait(guard, [ring] { return ring->freeSlots > 0; });
+            ring->freeSlots--;
+        }
+
+        int slot = block % FIR_STREAM_RING_SLOTS;
+        fillStreamBlock(*samples, long(block) * ring->blockSize,
+                        ring->slots + slot * ring->blockSize, ring->blockSize);
+
+        {
+            lock_guard<mutex> guard(ring->lock);
+            ring->readyTimes[block] = StreamClock::now();
+            ring->filled.push_back(slot);
+        }
+        ring->changed.notify_all();
+    }
+}
+
+/****************************************************************************
+* Function: streamSamplesFPGA()
+*
+* Purpose: On the FPGA, filter a continuous stream of numBlocks blocks of
+*          blockSize samples. A producer thread repeats the input samples into
+*          a pinned ring buffer, while this thread uploads each block on a
+*          separate queue, so that the upload of a block overlaps the
+*          filtering of the previous one. The coefficients are uploaded once
+*          and the last TAP_SIZE-1 samples stay on the device between blocks
+*          (overlap-save), so the blocks form one seamless output stream.
+*
+* @param ctx the opencl context to use for the benchmark
+* @param queue the opencl command queue to issue commands to
+* @param prog the opencl program containing the convolve_stream kernel
+* @param benchmarkData the input benchmark data to stream.
+* @param blockSize the samples per block, a multiple of FIR_BLOCK_SIZE.
+* @param numBlocks the number of blocks to stream.
+* @returns The wall time of the stream, the per block latencies and whether
+*          the first FIR_STREAM_VERIFY_BLOCKS blocks match the CPU.
+*
+*****************************************************************************/
+StreamResult streamSamplesFPGA(cl_device_id dev,
+                             cl_context ctx,
+                             cl_command_queue queue,
+                             cl_program prog,
+                             BenchmarkData &benchmarkData,
+                             int blockSize,
+                             int numBlocks)
+{
+    FLOATING_POINT* coefficients = benchmarkData.coefficients.elements;
+    int numCoefficients = benchmarkData.coefficients.size;
+    int historySize = numCoefficients-1;
+    size_t blockBytes = sizeof(FLOATING_POINT) * blockSize;
+
+    StreamResult streamResult;
+    streamResult.latencies.resize(numBlocks);
+
+    int err;
+
+    cl_command_queue uploadQueue = clCreateCommandQueue(ctx, dev, 0, &err);
+    CL_CHECK_ERROR(err);
+
+    cl_command_queue readQueue = clCreateCommandQueue(ctx, dev, 0, &err);
+    CL_CHECK_ERROR(err);
+
+    //
+    // find the kernel
+    //
+    cl_kernel streamKernel = clCreateKernel(prog, "convolve_stream", &err);
+    CL_CHECK_ERROR(err);
+
+    //
+    // allocate device memory, two sample and result buffers to alternate
+    // between consecutive blocks.
+    //
+    cl_mem d_samples[2], d_results[2];
+    for (int i=0; i<2; i++)
+    {
+        d_samples[i] = clCreateBuffer(ctx, CL_MEM_READ_ONLY, blockBytes, NULL, &err);
+        CL_CHECK_ERROR(err);
+
+        d_results[i] = clCreateBuffer(ctx, CL_MEM_WRITE_ONLY, blockBytes, NULL, &err);
+        CL_CHECK_ERROR(err);
+    }
+
+    cl_mem d_coefficients = clCreateBuffer(ctx, CL_MEM_READ_ONLY,
+                                    sizeof(FLOATING_POINT)*numCoefficients, NULL, &err);
+    CL_CHECK_ERROR(err);
+
+    cl_mem d_history = clCreateBuffer(ctx, CL_MEM_READ_WRITE,
+                                    sizeof(FLOATING_POINT)*historySize, NULL, &err);
+    CL_CHECK_ERROR(err);
+
+    //
+    // allocate the pinned host ring and result slots.
+    //
+    cl_mem h_ring = clCreateBuffer(ctx, CL_MEM_READ_WRITE | CL_MEM_ALLOC_HOST_PTR,
+                                    blockBytes*FIR_STREAM_RING_SLOTS, NULL, &err);
+    CL_CHECK_ERROR(err);
+
+    cl_mem h_results = clCreateBuffer(ctx, CL_MEM_READ_WRITE | CL_MEM_ALLOC_HOST_PTR,
+                                    blockBytes*2, NULL, &err);
+    CL_CHECK_ERROR(err);
+
+    SampleRing ring;
+    ring.blockSize = blockSize;
+    ring.freeSlots = FIR_STREAM_RING_SLOTS;
+    ring.readyTimes.resize(numBlocks);
+    ring.slots = (FLOATING_POINT*)clEnqueueMapBuffer(queue, h_ring, CL_TRUE,
+                    CL_MAP_READ | CL_MAP_WRITE, 0, blockBytes*FIR_STREAM_RING_SLOTS,
+                    0, NULL, NULL, &err);
+    CL_CHECK_ERROR(err);
+
+    FLOATING_POINT* results = (FLOATING_POINT*)clEnqueueMapBuffer(queue, h_results,
+                    CL_TRUE, CL_MAP_READ | CL_MAP_WRITE, 0, blockBytes*2,
+                    0, NULL, NULL, &err);
+    CL_CHECK_ERROR(err);
+
+    //
+    // write the coefficients and the (silent) initial history once.
+    //
+    vector<FLOATING_POINT> history(historySize, 0);
+
+    err = clEnqueueWriteBuffer(queue, d_coefficients, true, 0,
+                            sizeof(FLOATING_POINT)*numCoefficients, coefficients,
+                            0, NULL, NULL);
+    CL_CHECK_ERROR(err);
+
+    err = clEnqueueWriteBuffer(queue, d_history, true, 0,
+                            sizeof(FLOATING_POINT)*historySize, history.data(),
+                            0, NULL, NULL);
+    CL_CHECK_ERROR(err);
+
+    err = clSetKernelArg(streamKernel, 1, sizeof(cl_mem), (void*)&d_coefficients);
+    CL_CHECK_ERROR(err);
+    err = clSetKernelArg(streamKernel, 3, sizeof(cl_mem), (void*)&d_history);
+    CL_CHECK_ERROR(err);
+    err = clSetKernelArg(streamKernel, 4, sizeof(int), (void*)&blockSize);
+    CL_CHECK_ERROR(err);
+
+    int verifyBlocks = min(numBlocks, FIR_STREAM_VERIFY_BLOCKS);
+    vector<FLOATING_POINT> streamed(size_t(verifyBlocks)*blockSize);
+
+    cl_event readEvents[2] = {NULL, NULL};
+
+    // Waits for the read back of a block, then hands its ring slot back to
+    // the producer.
+    auto retireBlock = [&](int block)
+    {
+        int d = block % 2;
+
+        err = clWaitForEvents(1, &readEvents[d]);
+        CL_CHECK_ERROR(err);
+        clReleaseEvent(readEvents[d]);
+
+        StreamClock::time_point now = StreamClock::now();
+        {
+            lock_guard<mutex> guard(ring.lock);
+            streamResult.latencies[block] =
+                chrono::duration<double>(now - ring.readyTimes[block]).count();
+            ring.freeSlots++;
+        }
+        ring.changed.notify_all();
+
+        if (block < verifyBlocks)
+            memcpy(&streamed[size_t(block)*blockSize], results + d*blockSize, blockBytes);
+    };
+
+    //
+    // run the stream
+    //
+    StreamClock::time_point start = StreamClock::now();
+    thread producer(produceSamples, &ring, &benchmarkData.samples, numBlocks);
+
+    for (int block=0; block<numBlocks; block++)
+    {
+        int slot;
+        {
+            unique_lock<mutex> guard(ring.lock);
+            ring.changed.wait(guard, [&ring] { return !ring.filled.empty(); });
+            slot = ring.filled.front();
+            ring.filled.pop_front();
+        }
+
+        // The device buffers of this block were last used by block-2, which
+        // has been retired in the previous iteration.
+        int d = block % 2;
+
+        cl_event writeEvent, kernelEvent;
+        err = clEnqueueWriteBuffer(uploadQueue, d_samples[d], false, 0, blockBytes,
+                                ring.slots + slot*blockSize, 0, NULL, &writeEvent);
+        CL_CHECK_ERROR(err);
+        err = clFlush(uploadQueue);
+        CL_CHECK_ERROR(err);
+
+        err = clSetKernelArg(streamKernel, 0, sizeof(cl_mem), (void*)&d_samples[d]);
+        CL_CHECK_ERROR(err);
+        err = clSetKernelArg(streamKernel, 2, sizeof(cl_mem), (void*)&d_results[d]);
+        CL_CHECK_ERROR(err);
+
+        err = clEnqueueTask(queue, streamKernel, 1, &writeEvent, &kernelEvent);
+        CL_CHECK_ERROR(err);
+        err = clFlush(queue);
+        CL_CHECK_ERROR(err);
+
+        err = clEnqueueReadBuffer(readQueue, d_results[d], false, 0, blockBytes,
+                                results + d*blockSize, 1, &kernelEvent, &readEvents[d]);
+        CL_CHECK_ERROR(err);
+        err = clFlush(readQueue);
+        CL_CHECK_ERROR(err);
+
+        clReleaseEvent(writeEvent);
+        clReleaseEvent(kernelEvent);
+
+        if (block > 0) retireBlock(block-1);
+    }
+
+    if (numBlocks > 0) retireBlock(numBlocks-1);
+
+    streamResult.seconds =
+        chrono::duration<double>(StreamClock::now() - start).count();
+
+    producer.join();
+
+    //
+    // verify the leading blocks, including their boundaries.
+    //
+    streamResult.verified = true;
+
+    double tolerance = getDeviceEspsilon(numCoefficients);
+    vector<FLOATING_POINT> block(blockSize), expected(blockSize);
+
+    for (int b=0; b<verifyBlocks && streamResult.verified; b++)
+    {
+        fillStreamBlock(benchmarkData.samples, long(b)*blockSize, block.data(), blockSize);
+        filterSamplesCPU(block.data(), blockSize, coefficients, numCoefficients,
+                            history.data(), expected.data());
+
+        for (int i=0; i<blockSize; i++)
+        {
+            FLOATING_POINT computed = streamed[size_t(b)*blockSize+i];
+
+            if (!floatingPointEquals(expected[i], computed, tolerance))
+            {
+                cout << "Stream result mismatch at block: " << b
+                     << ", index: " << i << endl;
+                cout << "The cacluated value: " << computed
+                     << ", the expected value: " << expected[i] << endl;
+                cout << "Comparision tolerance :" << tolerance << endl;
+                streamResult.verified = false;
+                break;
+            }
+        }
+    }
+
+    //
+    // free host and device memory
+    //
+    err = clEnqueueUnmapMemObject(queue, h_ring, ring.slots, 0, NULL, NULL);
+    CL_CHECK_ERROR(err);
+    err = clEnqueueUnmapMemObject(queue, h_results, results, 0, NULL, NULL);
+    CL_CHECK_ERROR(err);
+    err = clFinish(queue);
+    CL_CHECK_ERROR(err);
+
+    for (int i=0; i<2; i++)
+    {
+        clReleaseMemObject(d_samples[i]);
+        clReleaseMemObject(d_results[i]);
+    }
+    clReleaseMemObject(d_coefficients);
+    clReleaseMemObject(d_history);
+    clReleaseMemObject(h_ring);
+    clReleaseMemObject(h_results);
+
+    clReleaseKernel(streamKernel);
+    clReleaseCommandQueue(uploadQueue);
+    clReleaseCommandQueue(readQueue);
+
+    return streamResult;
+}
@@ -4,8 +4,16 @@
 #include <string.h>
 #include <iostream>
 #include <fstream>
+#include <algorithm>
+#include <vector>
+#include <unistd.h>
 
+#include "../common/mappedfile.h"
 #include "firfilterutility.h"
+#include "firfilterfft.h"
+
+static_assert(sizeof(FirDataHeader) == FIR_DATA_ALIGNMENT, 
+                "binary data header must fill one alignment block");
 
 using namespace std;
 
@@ -44,6 +52,9 @@ bool readFloatingPoint(FLOATING_POINT &number, char* buffer, int buffSize, FILE*
 bool readFile(string fileName, FileData &fileData)
 {
     fileData.valid = false;
+    fileData.elements = NULL;
+    fileData.mapping = NULL;
+    fileData.mappingSize = 0;
     
     FILE *file;
     file = fopen(fileName.c_str(), "rb");
@@ -89,20 +100,173 @@ bool readFile(string fileName, FileData &fileData)
     return true;
 }
 
+// Maps a binary data file, the elements are used in place without parsing.
+bool readBinaryFile(string fileName, FileData &fileData)
+{
+    fileData.valid = false;
+    fileData.elements = NULL;
+    fileData.mapping = NULL;
+    fileData.mappingSize = 0;
+
+    if (!mapFile(fileName, fileData.mapping, fileData.mappingSize))
+        return false;
+
+    if (fileData.mappingSize < sizeof(FirDataHeader))
+    {
+        cout << "Failed reading the header of the file: " << fileName << endl;
+        releaseFile(fileData);
+        return false;
+    }
+
+    void* mapping = fileData.mapping;
+    const FirDataHeader* header = (const FirDataHeader*)mapping;
+    uint32_t type = sizeof(FLOATING_POINT) == sizeof(float) ? 
+                        FIR_DATA_FLOAT32 : FIR_DATA_FLOAT64;
+
+    if (memcmp(header->magic, FIR_DATA_MAGIC, sizeof(header->magic)) != 0 ||
+        header->version != FIR_DATA_VERSION)
+    {
+        cout << "Not a fir filter data file (version " << FIR_DATA_VERSION 
+             << "): " << fileName << endl;
+        releaseFile(fileData);
+        return false;
+    }
+
+    if (header->type != type || header->elementSize != sizeof(FLOATING_POINT))
+    {
+        cout << "The element type of the file does not match the host precision: " 
+             << fileName << endl;
+        releaseFile(fileData);
+        return false;
+    }
+
+    // the elements lie behind the header and within the file, the offset
+    // checked on its own first so that no sum of a corrupt one wraps around
+    if (header->count < 0 || header->count > INT32_MAX ||
+        header->dataOffset % FIR_DATA_ALIGNMENT != 0 ||
+        header->dataOffset < sizeof(FirDataHeader) ||
+        header->dataOffset > fileData.mappingSize ||
+        header->count * header->elementSize > fileData.mappingSize - header->dataOffset)
+    {
+        cout << "Failed reading the element(s) in the file: " << fileName << endl;
+        releaseFile(fileData);
+        return false;
+    }
+
+    fileData.group = header->group;
+    fileData.size = header->count;
+    fileData.elements = (FLOATING_POINT*)((char*)mapping + header->dataOffset);
+    fileData.valid = true;
+    return true;
+}
+
+// Reads the binary file of the name if it exists, or else the text file.
+static bool readDataFile(string dirName, int group, string textFile, 
+                        string binaryFile, FileData &fileData)
+{
+    string binaryName = dirName+to_string(group)+binaryFile;
+
+    if (access(binaryName.c_str(), F_OK) == 0)
+        return readBinaryFile(binaryName, fileData);
+
+    return readFile(dirName+to_string(group)+textFile, fileData);
+}
+
 bool readFiles(std::string dirName, int group, BenchmarkData &benchmarkData)
 {    
-    if (!readFile(dirName+to_string(group)+INPUTS_FILE, benchmarkData.samples)) 
+    if (!readDataFile(dirName, group, INPUTS_FILE, INPUTS_BINARY_FILE, 
+                        benchmarkData.samples)) 
         return false;
 
-    if (!readFile(dirName+to_string(group)+COEFFS_FILE, benchmarkData.coefficients)) 
+    if (!readDataFile(dirName, group, COEFFS_FILE, COEFFS_BINARY_FILE, 
+                        benchmarkData.coefficients)) 
+    {
+        releaseFile(benchmarkData.samples);
         return false;
+    }
 
-    if (!readFile(dirName+to_string(group)+RESULTS_FILE, benchmarkData.results)) 
+    if (!readDataFile(dirName, group, RESULTS_FILE, RESULTS_BINARY_FILE, 
+                        benchmarkData.results)) 
+    {
+        releaseFile(benchmarkData.samples);
+        releaseFile(benchmarkData.coefficients);
         return false;
+    }
 
     return true;
 }
 
+void releaseFile(FileData &fileData)
+{
+    if (fileData.mapping != NULL)
+        unmapFile(fileData.mapping, fileData.mappingSize);
+    else
+        free(fileData.elements);
+
+    fileData.valid = false;
+    fileData.elements = NULL;
+    fileData.mapping = NULL;
+    fileData.mappingSize = 0;
+}
+
+void releaseFiles(BenchmarkData &benchmarkData)
+{
+    releaseFile(benchmarkData.samples);
+    releaseFile(benchmarkData.coefficients);
+    releaseFile(benchmarkData.results);
+}
+
+// Writes a text data file as read by readFile().
+bool writeFile(string fileName, int group, const FLOATING_POINT* elements, int size)
+{
+    FILE *file = fopen(fileName.c_str(), "w");
+
+    if (file == NULL) 
+    { 
+        cout << "Failed opening: " << fileName << " for writing" << endl; 
+        return false;
+    }
+
+    fprintf(file, "%d\n%d\n", group, size);
+    for (int i=0; i<size; i++)
+        fprintf(file, "%.15f\n", double(elements[i]));
+
+    bool written = !ferror(file);
+    fclose(file);
+
+    return written;
+}
+
+// Writes a binary data file as read by readBinaryFile().
+bool writeBinaryFile(string fileName, int group, const FLOATING_POINT* elements, int size)
+{
+    FILE *file = fopen(fileName.c_str(), "wb");
+
+    if (file == NULL) 
+    { 
+        cout << "Failed opening: " << fileName << " for writing" << endl; 
+        return false;
+    }
+
+    FirDataHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, FIR_DATA_MAGIC, sizeof(header.magic));
+    header.version = FIR_DATA_VERSION;
+    header.group = group;
+    header.count = size;
+    header.type = sizeof(FLOATING_POINT) == sizeof(float) ? 
+                    FIR_DATA_FLOAT32 : FIR_DATA_FLOAT64;
+    header.elementSize = sizeof(FLOATING_POINT);
+    header.dataOffset = sizeof(FirDataHeader);
+
+    bool written = fwrite(&header, sizeof(header), 1, file) == 1 &&
+        fwrite(elements, sizeof(FLOATING_POINT), size, file) == size_t(size);
+    
+    written = fclose(file) == 0 && written;
+
+    return written;
+}
+
 bool floatingPointEquals(FLOATING_POINT a, FLOATING_POINT b, double tolerance)
 {
     return std::abs(a - b) < tolerance;
@@ -131,15 +295,19 @@ bool verifyFilesData(BenchmarkData &benchmarkData)
 
     double tolerance = getHostEspsilon(benchmarkData.coefficients.size);
 
+    // Filter by fft convolution, so that large data sets are checked fast.
+    FftFilter filter;
+    initFftFilter(filter, benchmarkData.coefficients.elements, 
+                benchmarkData.coefficients.size, 
+                nextPowerOfTwo(8*benchmarkData.coefficients.size));
+
+    vector<FLOATING_POINT> sums(benchmarkData.samples.size);
+    filterSamplesFFT(filter, benchmarkData.samples.elements, 
+                benchmarkData.samples.size, sums.data());
+
     for (int i=0; i<benchmarkData.samples.size; i++)
     {
-        FLOATING_POINT sum = 0.0;
-
-        for (int j=0, k=i; j<benchmarkData.coefficients.size && k >= 0; j++,k--)
-        {
-            sum += benchmarkData.samples.elements[k] 
-                    * benchmarkData.coefficients.elements[j];
-        }
+        FLOATING_POINT sum = sums[i];
 
         // myfile << sum << "\n" ;
 
@@ -191,3 +359,160 @@ bool verifyResults(BenchmarkData& benchmarkData, FLOATING_POINT results[])
     }
     return true;
 }
+
+// Copies the samples [streamOffset, streamOffset+blockSize) of an endless 
+// stream made by repeating the samples of the file into block.
+void fillStreamBlock(FileData &samples, long streamOffset, 
+                        FLOATING_POINT* block, int blockSize)
+{
+    int position = streamOffset % samples.size;
+    
+    for (int i=0; i<blockSize; )
+    {
+        int count = std::min(blockSize-i, samples.size-position);
+        memcpy(block+i, samples.elements+position, count*sizeof(FLOATING_POINT));
+        i += count;
+        position = 0;
+    }
+}
+
+// Filters one block of a stream on the CPU. history holds the last
+// numCoefficients-1 samples of the previous blocks (oldest first) and is 
+// updated with the tail of this block, like the convolve_stream kernel does.
+void filterSamplesCPU(const FLOATING_POINT* samples, int numSamples,
+                        const FLOATING_POINT* coefficients, int numCoefficients,
+                        FLOATING_POINT* history, FLOATING_POINT* results)
+{
+    int historySize = numCoefficients-1;
+
+    for (int i=0; i<numSamples; i++)
+    {
+        FLOATING_POINT sum = 0.0;
+
+        for (int j=0, k=i; j<numCoefficients; j++,k--)
+        {
+            FLOATING_POINT sample = k >= 0 ? samples[k] : history[historySize+k];
+            sum += sample * coefficients[j];
+        }
+
+        results[i] = sum;
+    }
+
+    if (numSamples >= historySize)
+    {
+        memcpy(history, samples+(numSamples-historySize), 
+                historySize*sizeof(FLOATING_POINT));
+    }
+    else
+    {
+        memmove(history, history+numSamples, 
+                (historySize-numSamples)*sizeof(FLOATING_POINT));
+        memcpy(history+(historySize-numSamples), samples, 
+                numSamples*sizeof(FLOATING_POINT));
+    }
+}
+
+// The block mode kernel variants built by the CMake targets.
+static const FirVariant firVariants[] = {
+    {"firfilter_single", FIR_KERNEL_DIRECT, false},
+    {"firfilter_single_unroll_mac", FIR_KERNEL_DIRECT, false},
+    {"firfilter_single_man_mac", FIR_KERNEL_DIRECT, false},
+    {"firfilter_single_man_mac_non_align", FIR_KERNEL_DIRECT, false},
+    {"firfilter_single_channel_man_mac_non_align", FIR_KERNEL_CHANNELED, false},
+    {"firfilter_double", FIR_KERNEL_DIRECT, true},
+    {"firfilter_double_unroll_mac", FIR_KERNEL_DIRECT, true},
+    {"firfilter_fft", FIR_KERNEL_FFT, false}
+};
+
+const char* getFirKernelTypeName(FirKernelType type)
+{
+    switch (type)
+    {
+        case FIR_KERNEL_DIRECT: return "direct";
+        case FIR_KERNEL_CHANNELED: return "channeled";
+        case FIR_KERNEL_FFT: return "fft";
+        case FIR_KERNEL_STREAM: return "stream";
+        case FIR_KERNEL_POLYPHASE: return "polyphase";
+        case FIR_KERNEL_BANK: return "bank";
+        case FIR_KERNEL_FIXED: return "fixed";
+        case FIR_KERNEL_LMS: return "lms";
+        default: return "none";
+    }
+}
+
+/****************************************************************************
+* Function: selectFirVariants()
+*
+* Purpose: Looks up the comma separated kernel variants, by bitstream name 
+*          with or without the firfilter_ prefix, or all of them.
+*
+* @param list the variant names or "all".
+* @param variants output -the selected variants.
+* @returns false if a name is not a known variant.
+*
+*****************************************************************************/
+bool selectFirVariants(string list, vector<FirVariant> &variants)
+{
+    int numVariants = sizeof(firVariants) / sizeof(firVariants[0]);
+    variants.clear();
+
+    if (list.compare(FIR_VARIANTS_ALL) == 0)
+    {
+        variants.assign(firVariants, firVariants + numVariants);
+        return true;
+    }
+
+    size_t begin = 0;
+    while (begin <= list.size())
+    {
+        size_t end = list.find(',', begin);
+        if (end == string::npos) end = list.size();
+
+        string name = list.substr(begin, end - begin);
+        begin = end + 1;
+
+        if (name.empty()) continue;
+
+        int v = 0;
+        while (v < numVariants && firVariants[v].name != name 
+                && firVariants[v].name != "firfilter_" + name)
+            v++;
+
+        if (v == numVariants)
+        {
+            cout << "Unknown fir filter kernel variant: " << name << endl;
+            return false;
+        }
+
+        variants.push_back(firVariants[v]);
+    }
+
+    return !variants.empty();
+}
+
+/****************************************************************************
+* Function: getFirVariant()
+*
+* Purpose: Names the variant of a bitstream of the given kernel interface.
+*          The precision is taken from the bitstream name: the kernels 
+*          declare their samples through the FLOATING_POINT typedef, so the
+*          kernel argument info cannot tell the double kernels apart.
+*
+* @param bitstreamFile the bitstream file, with or without path and .aocx.
+* @param type the kernel interface found in the program.
+* @returns The variant.
+*
+*****************************************************************************/
+FirVariant getFirVariant(string bitstreamFile, FirKernelType type)
+{
+    FirVariant variant;
+
+    size_t slash = bitstreamFile.find_last_of('/');
+    variant.name = bitstreamFile.substr(slash == string::npos ? 0 : slash + 1);
+    variant.name = variant.name.substr(0, variant.name.rfind(".aocx"));
+    variant.type = type;
+    variant.doublePrecision = type == FIR_KERNEL_DIRECT 
+        && variant.name.find("double") != string::npos;
+
+    return variant;
+}
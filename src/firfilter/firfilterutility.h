@@ -4,11 +4,12 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <string>
+#include <stdint.h>
+#include <vector>
 
 using namespace std;
 
 #define FLOATING_POINT float
-#define NON_CHANNELED
 
 #define MAX_LINE_LENGTH 512
 #define DBL_EPSILON_FPGA 0.00001
@@ -19,12 +20,72 @@ using namespace std;
 #define COEFFS_FILE "-coefficients.dat"
 #define RESULTS_FILE "-results.dat"
 
+// Binary data files, preferred over the text files when present.
+#define INPUTS_BINARY_FILE "-inputs.bin"
+#define COEFFS_BINARY_FILE "-coefficients.bin"
+#define RESULTS_BINARY_FILE "-results.bin"
+
+#define FIR_DATA_MAGIC "FBFIRDAT"
+#define FIR_DATA_VERSION 1
+#define FIR_DATA_ALIGNMENT 64
+
+// Element types of the binary data files.
+#define FIR_DATA_FLOAT32 1
+#define FIR_DATA_FLOAT64 2
+
+// Tap and block size the kernels are compiled with (set by CMake).
+#ifndef FIR_TAP_SIZE
+#define FIR_TAP_SIZE 256
+#endif
+#ifndef FIR_BLOCK_SIZE
+#define FIR_BLOCK_SIZE 16
+#endif
+
 typedef struct {
     bool valid;
     int size, group;
     FLOATING_POINT* elements;
+    // The mapped binary file the elements point into, NULL if allocated.
+    void* mapping;
+    size_t mappingSize;
 } FileData;
 
+// Header of the binary data files, the raw elements follow at dataOffset
+// (a multiple of FIR_DATA_ALIGNMENT).
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    int32_t group;
+    int64_t count;
+    uint32_t type;
+    uint32_t elementSize;
+    uint64_t dataOffset;
+    uint8_t reserved[24];
+} FirDataHeader;
+
+// Kernel interfaces of the fir filter bitstreams, told apart by the kernel
+// names in the program.
+typedef enum {
+    FIR_KERNEL_NONE,
+    FIR_KERNEL_DIRECT,      // convolve
+    FIR_KERNEL_CHANNELED,   // convolve_read, convolve_perform, convolve_write
+    FIR_KERNEL_FFT,         // convolve_fft
+    FIR_KERNEL_STREAM,      // convolve_stream
+    FIR_KERNEL_POLYPHASE,   // convolve_decimate, convolve_interpolate
+    FIR_KERNEL_BANK,        // convolve_bank
+    FIR_KERNEL_FIXED,       // convolve_q15, convolve_q7
+    FIR_KERNEL_LMS          // convolve_lms
+} FirKernelType;
+
+// A fir filter kernel variant, i.e. bitstream.
+typedef struct {
+    std::string name;       // the bitstream name without .aocx
+    FirKernelType type;
+    bool doublePrecision;   // the kernel filters double precision samples
+} FirVariant;
+
+#define FIR_VARIANTS_ALL "all"
+
 typedef struct {
     FileData samples;
     FileData coefficients;
@@ -37,11 +98,27 @@ double getHostEspsilon(int fpOps);
 bool readInteger(int &number, char* buffer, int buffSize, FILE* file);
 bool readFloatingPoint(FLOATING_POINT &number, char* buffer, int buffSize, FILE* file);
 bool readFile(std::string fileName, FileData &fileData);
+bool readBinaryFile(std::string fileName, FileData &fileData);
 bool readFiles(std::string dirName, int group, BenchmarkData &benchmarkData);
+void releaseFile(FileData &fileData);
+void releaseFiles(BenchmarkData &benchmarkData);
+
+bool writeFile(std::string fileName, int group, const FLOATING_POINT* elements, int size);
+bool writeBinaryFile(std::string fileName, int group, const FLOATING_POINT* elements, int size);
 
 bool floatingPointEquals(FLOATING_POINT a, FLOATING_POINT b, double tolerance);
 
 bool verifyResults(BenchmarkData& benchmarkData, FLOATING_POINT results[]);
 bool verifyFilesData(BenchmarkData &benchmarkData);
 
+void fillStreamBlock(FileData &samples, long streamOffset, 
+                        FLOATING_POINT* block, int blockSize);
+void filterSamplesCPU(const FLOATING_POINT* samples, int numSamples,
+                        const FLOATING_POINT* coefficients, int numCoefficients,
+                        FLOATING_POINT* history, FLOATING_POINT* results);
+
+const char* getFirKernelTypeName(FirKernelType type);
+bool selectFirVariants(std::string list, std::vector<FirVariant> &variants);
+FirVariant getFirVariant(std::string bitstreamFile, FirKernelType type);
+
 #endif
@@ -19,6 +19,9 @@
  * 
 */
 
+// reference and data hold only the BSIZE rows of the block (strip) starting at
+// row block_offset, row 0 of data being the last row of the previous block.
+// input_v holds the whole first column.
 __attribute__((max_global_work_dim(0)))
 __kernel void nw(__global int* restrict reference, 
                          __global int* restrict data,
@@ -156,7 +159,7 @@ __kernel void nw(__global int* restrict reference,
 			for (int i = 0; i < PAR; i++)
 			{
 				int read_col = comp_col_offset + i;
-				int read_index = read_row * dim + read_col;
+				int read_index = read_block_row * dim + read_col;
 
 				if (read_col < dim - 1 && read_row < dim - 1)
 				{
@@ -173,7 +176,7 @@ __kernel void nw(__global int* restrict reference,
 			int comp_col = comp_col_offset + i;
 
 			int read_col = comp_col_offset + i;
-			int read_index = read_row * dim + read_col;
+			int read_index = read_block_row * dim + read_col;
 
 			if (read_row > 0 && read_col < dim - 1 && read_row < dim - 1) // read_col > 0 is skipped since it has area overhead and removing it is harmless
 			{
@@ -207,7 +210,7 @@ __kernel void nw(__global int* restrict reference,
 			int write_col = write_col_offset + i;
 			int write_block_row = (BSIZE + block_row - (PAR - 1)) & (BSIZE - 1); // write to memory is always PAR - 1 rows behind compute
 			int write_row = block_offset + write_block_row;
-			int write_index = write_row * dim + write_col;
+			int write_index = write_block_row * dim + write_col;
 
 			if (write_block_row > 0 && write_col < dim - 1 && write_row < dim - 1)
 			{
@@ -0,0 +1,96 @@
+/** @file nw_banded.cl */
+
+// The widest band, must match NW_MAX_BAND of nwbanded.h
+#define MAX_BAND 64
+#define BAND_WIDTH (2 * MAX_BAND + 1)
+#define BAND_STRIDE (MAX_BAND + 1)
+
+// below any (doubled) score, far enough from INT_MIN not to wrap
+#define NEG_INF (-(1 << 28))
+
+/****************************************************************************
+* <b>Function:</b> nw_banded()
+* <b>Purpose:</b> Within the FPGA, align two sequences of dim residues
+* globally over the cells (i, j) of the band |i - j| <= band only. The cell
+* (i, j) is on the band diagonal d = j - i + band, one processing element per
+* diagonal. The element of diagonal d computes row i at step t = 2i + d: its
+* left neighbour (d - 1) computed (i, j - 1) and its right neighbour (d + 1)
+* computed (i - 1, j) at the step before, and it computed (i - 1, j - 1) two
+* steps before, so all inputs are registers and every other element works
+* at each step. A score H is kept as 2H + f, the flag f telling whether the
+* best path to the cell touches the edge of the band, a tie choosing the
+* flagged path, so that the band-overflow check is conservative.
+* @param ref_band the band-compressed substitution scores, for each step t
+* the BAND_STRIDE scores of the diagonals d = (t & 1) + 2m of that step.
+* @param result output -the score and the band-overflow flag.
+* @param dim the length of the sequences.
+* @param band the half width of the band, at most MAX_BAND.
+* @param penalty the linear gap penalty.
+* @returns Void
+****************************************************************************/
+__attribute__((max_global_work_dim(0)))
+__kernel void nw_banded(__global const int* restrict ref_band,
+                        __global int* restrict result,
+                                 int           dim,
+                                 int           band,
+                                 int           penalty)
+{
+	int h[BAND_WIDTH];
+	int score = NEG_INF;
+
+	#pragma unroll
+	for (int d = 0; d < BAND_WIDTH; d++)
+	{
+		h[d] = NEG_INF;
+	}
+
+	int steps = 2 * dim + band + 1;
+	int gap = 2 * penalty;
+
+	for (int t = 0; t < steps; t++)
+	{
+		int next[BAND_WIDTH];
+
+		#pragma unroll
+		for (int d = 0; d < BAND_WIDTH; d++)
+		{
+			int two_i = t - d;
+			int i = two_i >> 1;
+			int j = i + d - band;
+
+			int diag = h[d];
+			int left = (d > 0) ? h[d - 1] : NEG_INF;
+			int up   = (d < BAND_WIDTH - 1) ? h[d + 1] : NEG_INF;
+			int s = ref_band[t * BAND_STRIDE + (d >> 1)];
+
+			int out1 = diag + 2 * s;
+			int out2 = left - gap;
+			int out3 = up - gap;
+			int max_temp = (out1 > out2) ? out1 : out2;
+			int max = (out3 > max_temp) ? out3 : max_temp;
+
+			// the first row and column are the gap costs
+			int cell = (i == 0) ? -j * gap : ((j == 0) ? -i * gap : max);
+			cell |= (d == 0 || d == 2 * band) ? 1 : 0;
+
+			bool turn = (two_i & 1) == 0;
+			bool valid = two_i >= 0 && i <= dim && d <= 2 * band && j >= 0 && j <= dim;
+
+			next[d] = !turn ? h[d] : (valid ? cell : NEG_INF);
+
+			if (turn && valid && i == dim && d == band)
+			{
+				score = cell;
+			}
+		}
+
+		#pragma unroll
+		for (int d = 0; d < BAND_WIDTH; d++)
+		{
+			h[d] = next[d];
+		}
+	}
+
+	result[0] = score >> 1;
+	result[1] = score & 1;
+}
@@ -0,0 +1,99 @@
+/** @file nw_batch.cl */
+
+// The longest sequence of a pair, the row kept on chip has one more cell.
+#ifndef MAX_LENGTH
+#define MAX_LENGTH 512
+#endif
+
+#define NUM_RESIDUES 24
+
+/****************************************************************************
+* <b>Function:</b> nw_batch()
+* <b>Purpose:</b> Within the FPGA, compute the global alignment scores of many
+* independent sequence pairs back to back. A pair is given by the offsets and
+* lengths of its two sequences in the residue buffer. The DP matrix of a pair
+* is swept in strips of PAR rows, one column per iteration, with only the row
+* above the strip kept on chip, so a pair needs no external memory but its
+* residues.
+* @param residues the residue codes of all sequences.
+* @param pairs per pair the row sequence offset and length and the column
+* sequence offset and length, the lengths at most MAX_LENGTH.
+* @param substitution the NUM_RESIDUES x NUM_RESIDUES substitution scores.
+* @param scores output -the alignment score of each pair.
+* @param num_pairs the number of pairs.
+* @param penalty the linear gap penalty.
+* @returns Void
+****************************************************************************/
+__attribute__((max_global_work_dim(0)))
+__kernel void nw_batch(__global const char* restrict residues,
+                       __global const int4* restrict pairs,
+                       __global const int* restrict substitution,
+                       __global int* restrict scores,
+                                int           num_pairs,
+                                int           penalty)
+{
+	int table[NUM_RESIDUES * NUM_RESIDUES];
+	int top_row[MAX_LENGTH + 1];
+
+	for (int i = 0; i < NUM_RESIDUES * NUM_RESIDUES; i++)
+	{
+		table[i] = substitution[i];
+	}
+
+	for (int p = 0; p < num_pairs; p++)
+	{
+		int4 pair = pairs[p];
+		int row_offset = pair.x;
+		int rows = pair.y;
+		int col_offset = pair.z;
+		int cols = pair.w;
+
+		for (int j = 0; j <= cols; j++)
+		{
+			top_row[j] = -j * penalty;
+		}
+
+		for (int strip = 0; strip < rows; strip += PAR)
+		{
+			int row_residue[PAR];
+			int left[PAR];
+			int top_left[PAR];
+
+			#pragma unroll
+			for (int r = 0; r < PAR; r++)
+			{
+				int row = strip + r + 1;
+				row_residue[r] = (row <= rows) ? residues[row_offset + row - 1] : 0;
+				left[r] = -row * penalty;
+				top_left[r] = -(row - 1) * penalty;
+			}
+
+			#pragma ivdep array(top_row)
+			for (int j = 1; j <= cols; j++)
+			{
+				int col_residue = residues[col_offset + j - 1];
+				int top = top_row[j];
+
+				// the rows past the end of the pair pass the last row down
+				#pragma unroll
+				for (int r = 0; r < PAR; r++)
+				{
+					int out1 = top_left[r] + table[row_residue[r] * NUM_RESIDUES + col_residue];
+					int out2 = left[r] - penalty;
+					int out3 = top - penalty;
+					int max_temp = (out1 > out2) ? out1 : out2;
+					int max = (out3 > max_temp) ? out3 : max_temp;
+					int out = (strip + r < rows) ? max : top;
+
+					top_left[r] = top;
+					left[r] = out;
+					top = out;
+				}
+
+				top_row[j] = top;
+			}
+		}
+
+		scores[p] = top_row[cols];
+	}
+}
@@ -0,0 +1,255 @@
+/*
+ *
+ * Copyright (c) 2008-2011 University of Virginia
+ * Copyright (c) 2016 RIKEN
+ * Copyright (c) 2016 Tokyo Institute of Technology
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted without royalty fees or other restrictions, provided that the following conditions are met:
+ *
+ *      > Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+ *      > Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+ *      > Neither the name of the University of Virginia, the Dept. of Computer Science, RIKEN, Tokyo Institute of Technology, nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE UNIVERSITY OF VIRGINIA OR THE SOFTWARE AUTHORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The code is based on rodinia_fpga project
+ * - H. R. Zohouri, N. Maruyama, A. Smith, M. Matsuda, and S. Matsuoka. "Evaluating and Optimizing OpenCL Kernels for High Performance Computing with FPGAs," Proceedings of the ACM/IEEE International Conference for High Performance Computing, Networking, Storage and Analysis (SC'16), Nov 2016.
+ *   
+ * 
+*/
+
+// Score-only variant of nw.cl: the scores of the block (strip) are not
+// written to external memory but for its last row and the last column.
+// data holds two rows, the last row of the previous block (row 0) and the
+// last computed row of this block (row 1). last_col gets the scores of the
+// last column, indexed by the row. With check set, the sum of the scores of
+// the block is written to checksums[block_offset / (BSIZE - 1)].
+// reference holds the BSIZE rows of the block starting at row block_offset
+// and input_v the whole first column.
+__attribute__((max_global_work_dim(0)))
+__kernel void nw_score(__global int* restrict reference, 
+                         __global int* restrict data,
+                         __global int* restrict input_v,				// vertical input (first column)
+                                  int           dim,
+                                  int           penalty,
+                                  int           loop_exit,
+                                  int           block_offset,
+                         __global int* restrict last_col,
+                         __global unsigned int* restrict checksums,
+                                  int           check)
+{    
+	int out_SR[PAR - 1][3];										// output shift register; 2 registers per parallel comp_col_offset is required, one for writing, and two for passing data to the following diagonal lines to handle the dependency
+	int last_chunk_col_SR[BSIZE - (PAR - 1) + 2];					// shift register for last comp_col_offset in parallel chunk to pass data to next chunk, (PAR - 1) cells are always out of bound, one extra cell is added for writing and one more for top-left
+	int ref_SR[PAR][PAR];										// shift registers to align reads from the reference buffer
+	int data_h_SR[PAR][PAR];										// shift registers to align reading the first comp_row of data buffer
+	int write_SR[PAR][PAR];										// shift registers to align writes to external memory
+	int input_v_SR[2];											// one for left, one for top-left
+	unsigned int checksum = 0;
+
+	// initialize shift registers
+	#pragma unroll
+	for (int i = 0; i < PAR - 1; i++)
+	{
+		#pragma unroll
+		for (int j = 0; j < 3; j++)
+		{
+			out_SR[i][j] = 0;
+		}
+	}
+	#pragma unroll
+	for (int i = 0; i < BSIZE - PAR + 3; i++)
+	{
+		last_chunk_col_SR[i] = 0;
+	}
+	#pragma unroll
+	for (int i = 0; i < PAR; i++)
+	{
+		#pragma unroll
+		for (int j = 0; j < PAR; j++)
+		{
+			write_SR[i][j] = 0;
+		}
+	}
+	#pragma unroll
+	for (int i = 0; i < PAR; i++)
+	{
+		#pragma unroll
+		for (int j = 0; j < PAR; j++)
+		{
+			ref_SR[i][j] = 0;
+		}
+	}
+	#pragma unroll
+	for (int i = 0; i < PAR; i++)
+	{
+		#pragma unroll
+		for (int j = 0; j < PAR; j++)
+		{
+			data_h_SR[i][j] = 0;
+		}
+	}
+	#pragma unroll
+	for (int i = 0; i < 2; i++)
+	{
+		input_v_SR[i] = 0;
+	}
+
+	// starting points
+	int comp_col_offset = 0;
+	int write_col_offset = -PAR;
+	int block_row = 0;
+	int loop_index = 0;
+
+	#pragma ivdep array(data)
+	while (loop_index != loop_exit)
+	{
+		loop_index++;
+
+		// shift the shift registers
+		#pragma unroll
+		for (int i = 0; i < PAR - 1; i++)
+		{
+			#pragma unroll
+			for (int j = 0; j < 2; j++)
+			{
+				out_SR[i][j] = out_SR[i][j + 1];
+			}
+		}
+		#pragma unroll
+		for (int i = 0; i < BSIZE - PAR + 2; i++)
+		{
+			last_chunk_col_SR[i] = last_chunk_col_SR[i + 1];
+		}
+		#pragma unroll
+		for (int i = 0; i < PAR; i++)
+		{
+			#pragma unroll
+			for (int j = 0; j < PAR - 1; j++)
+			{
+				write_SR[i][j] = write_SR[i][j + 1];
+			}
+		}
+		#pragma unroll
+		for (int i = 0; i < PAR; i++)
+		{
+			#pragma unroll
+			for (int j = 0; j < PAR - 1; j++)
+			{
+				ref_SR[i][j] = ref_SR[i][j + 1];
+			}
+		}
+		#pragma unroll
+		for (int i = 0; i < PAR; i++)
+		{
+			#pragma unroll
+			for (int j = 0; j < PAR - 1; j++)
+			{
+				data_h_SR[i][j] = data_h_SR[i][j + 1];
+			}
+		}
+		#pragma unroll
+		for (int i = 0; i < 1; i++)
+		{
+			input_v_SR[i] = input_v_SR[i + 1];
+		}
+
+		int read_block_row = block_row;
+		int read_row = block_offset + read_block_row;
+
+		if (comp_col_offset == 0 && read_row < dim - 1)
+		{
+			input_v_SR[1] = input_v[read_row];
+		}
+
+		if (block_row == 0)
+		{		
+			#pragma unroll
+			for (int i = 0; i < PAR; i++)
+			{
+				int read_col = comp_col_offset + i;
+				int read_index = read_block_row * dim + read_col;
+
+				if (read_col < dim - 1 && read_row < dim - 1)
+				{
+					data_h_SR[i][i] = data[read_index];
+				}
+			}
+		}
+
+		#pragma unroll
+		for (int i = PAR - 1; i >= 0; i--)
+		{
+			int comp_block_row = (BSIZE + block_row - i) & (BSIZE - 1); // read_col > 0 is skipped since it has area overhead and removing it is harmless
+			int comp_row = block_offset + comp_block_row;
+			int comp_col = comp_col_offset + i;
+
+			int read_col = comp_col_offset + i;
+			int read_index = read_block_row * dim + read_col;
+
+			if (read_row > 0 && read_col < dim - 1 && read_row < dim - 1) // read_col > 0 is skipped since it has area overhead and removing it is harmless
+			{
+				ref_SR[i][i] = reference[read_index];
+			}
+
+			int top      = (i == PAR - 1) ? last_chunk_col_SR[BSIZE - PAR + 1] : out_SR[  i  ][1];
+			int top_left = (comp_col_offset == 0 && i == 0) ? input_v_SR[0] : ((i == 0) ? last_chunk_col_SR[0] : out_SR[i - 1][0]);
+			int left     = (comp_col_offset == 0 && i == 0) ? input_v_SR[1] : ((i == 0) ? last_chunk_col_SR[1] : out_SR[i - 1][1]);
+
+			int out1 = top_left + ref_SR[i][0];
+			int out2 = left - penalty;
+			int out3 = top - penalty;
+			int max_temp = (out1 > out2) ? out1 : out2;
+			int max = (out3 > max_temp) ? out3 : max_temp;
+
+			// directly pass input to output if on the first row in the block which is overlapped with the previous block
+			int out = (comp_block_row == 0) ? data_h_SR[i][0] : max;
+
+			if (i == PAR - 1)									// if on last column in chunk
+			{
+				last_chunk_col_SR[BSIZE - PAR + 2] = out;
+			}
+			else
+			{
+				out_SR[i][2] = out;
+			}
+
+			write_SR[i][PAR - i - 1] = out;
+
+			int write_col = write_col_offset + i;
+			int write_block_row = (BSIZE + block_row - (PAR - 1)) & (BSIZE - 1); // write to memory is always PAR - 1 rows behind compute
+			int write_row = block_offset + write_block_row;
+
+			// the first chunk also writes the (garbage) last row of the chunk before it
+			if (write_block_row > 0 && write_col >= 0 && write_col < dim - 1 && write_row < dim - 1)
+			{
+				if (write_block_row == BSIZE - 1 || write_row == dim - 2)
+				{
+					data[dim + write_col] = write_SR[i][0];
+				}
+
+				if (write_col == dim - 2)
+				{
+					last_col[write_row] = write_SR[i][0];
+				}
+
+				checksum += write_SR[i][0];
+			}
+		}
+
+		block_row = (block_row + 1) & (BSIZE - 1);
+		if (block_row == PAR - 1)
+		{
+			write_col_offset += PAR;
+		}
+		if (block_row == 0)
+		{
+			comp_col_offset += PAR;
+		}
+	}
+
+	if (check)
+	{
+		checksums[block_offset / (BSIZE - 1)] = checksum;
+	}
+}
@@ -0,0 +1,191 @@
+#include <stdlib.h>
+
+#include <vector>
+#include <algorithm>
+
+#include "nwbanded.h"
+
+using namespace std;
+
+// ****************************************************************************
+// Function: makeNWSimilarProblem
+//
+// Purpose:
+//   Generates a pair of similar sequences: the row sequence is random, the
+//   column sequence a copy of it with random substitutions, deletions and
+//   insertions, cut or padded with random residues to dim residues.
+//
+// Arguments:
+//   problem : output - the problem
+//   dim : the number of residues per sequence
+//   penalty : the linear gap penalty
+//   divergence : the fraction of the residues that are edited
+//
+// Returns:  nothing
+//
+// ****************************************************************************
+void makeNWSimilarProblem(NWProblem &problem, int dim, int penalty, double divergence)
+{
+    problem.dim = dim;
+    problem.penalty = penalty;
+    problem.rowSequence.assign(dim + 1, 0);
+    problem.columnSequence.assign(1, 0);
+
+    srand(7);
+
+    for (int i = 1; i <= dim; i++)
+        problem.rowSequence[i] = rand() % NW_RANDOM_RESIDUES + 1;
+
+    for (int i = 1; i <= dim && (int)problem.columnSequence.size() <= dim; i++)
+    {
+        int residue = problem.rowSequence[i];
+
+        if (rand() < divergence * RAND_MAX)
+        {
+            switch (rand() % 3)
+            {
+                case 0:
+                    residue = rand() % NW_RANDOM_RESIDUES + 1;
+                    break;
+                case 1:
+                    continue;
+                default:
+                    problem.columnSequence.push_back(rand() % NW_RANDOM_RESIDUES + 1);
+                    break;
+            }
+        }
+
+        problem.columnSequence.push_back(residue);
+    }
+
+    while ((int)problem.columnSequence.size() <= dim)
+        problem.columnSequence.push_back(rand() % NW_RANDOM_RESIDUES + 1);
+
+    problem.columnSequence.resize(dim + 1);
+}
+
+// ****************************************************************************
+// Function: getNWBandCells
+//
+// Purpose:
+//   The number of cells (i, j) of the band |i - j| <= band of a dim x dim
+//   matrix, 1 <= i, j <= dim.
+//
+// Arguments:
+//   dim : the number of residues per sequence
+//   band : the half width of the band
+//
+// Returns:  the number of cells
+//
+// ****************************************************************************
+long long getNWBandCells(int dim, int band)
+{
+    long long cells = 0;
+
+    for (int d = -min(band, dim - 1); d <= min(band, dim - 1); d++)
+        cells += dim - abs(d);
+
+    return cells;
+}
+
+// ****************************************************************************
+// Function: fillNWBandReference
+//
+// Purpose:
+//   Generates the band-compressed substitution scores of the nw_banded
+//   kernel: for each step t = 2i + d of the wavefront over the band
+//   diagonals d = j - i + band, NW_BAND_STRIDE scores, the one of the
+//   diagonal (t & 1) + 2m at m. The cells outside the matrix are zero.
+//
+// Arguments:
+//   problem : the problem
+//   band : the half width of the band, at most NW_MAX_BAND
+//   reference : output - the scores of the 2 * dim + band + 1 steps
+//
+// Returns:  nothing
+//
+// ****************************************************************************
+void fillNWBandReference(const NWProblem &problem, int band, vector<int> &reference)
+{
+    int dim = problem.dim;
+    int steps = 2 * dim + band + 1;
+
+    reference.assign((size_t)steps * NW_BAND_STRIDE, 0);
+
+    for (int t = 0; t < steps; t++)
+    {
+        for (int d = t & 1; d <= 2 * band && d <= t; d += 2)
+        {
+            int i = (t - d) / 2;
+            int j = i + d - band;
+
+            if (i >= 1 && i <= dim && j >= 1 && j <= dim)
+            {
+                reference[(size_t)t * NW_BAND_STRIDE + d / 2] = 
+                    blosum62[problem.rowSequence[i]][problem.columnSequence[j]];
+            }
+        }
+    }
+}
+
+// ****************************************************************************
+// Function: nwBandedCPU
+//
+// Purpose:
+//   Aligns the sequences of the problem globally over the band |i - j| <=
+//   band only, keeping two rows of the 2 * band + 1 band diagonals. Like the
+//   nw_banded kernel, it flags the scores whose best path touches the edge
+//   of the band (ties preferring the flagged path): the best alignment may
+//   then leave the band, and a wider band may find a better one.
+//
+// Arguments:
+//   problem : the problem
+//   band : the half width of the band
+//   score : output - the best score within the band
+//
+// Returns:  true if the band may overflow
+//
+// ****************************************************************************
+bool nwBandedCPU(const NWProblem &problem, int band, int &score)
+{
+    int dim = problem.dim;
+    int gap = 2 * problem.penalty;
+    int width = 2 * band + 1;
+
+    // doubled scores with the edge flag, two rows of band diagonals
+    vector<int> previous(width + 1, NW_NEG_INF), row(width + 1, NW_NEG_INF);
+
+    for (int i = 0; i <= dim; i++)
+    {
+        previous.swap(row);
+
+        for (int d = 0; d < width; d++)
+        {
+            int j = i + d - band;
+            int cell;
+
+            if (j < 0 || j > dim)
+            {
+                row[d] = NW_NEG_INF;
+                continue;
+            }
+
+            if (i == 0)
+                cell = -j * gap;
+            else if (j == 0)
+                cell = -i * gap;
+            else
+                cell = maximum(previous[d] + 2 * blosum62[problem.rowSequence[i]][problem.columnSequence[j]],
+                               (d > 0 ? row[d - 1] : NW_NEG_INF) - gap,
+                               previous[d + 1] - gap);
+
+            if (d == 0 || d == width - 1)
+                cell |= 1;
+
+            row[d] = cell;
+        }
+    }
+
+    score = row[band] >> 1;
+    return (row[band] & 1) != 0;
+}
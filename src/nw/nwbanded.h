@@ -0,0 +1,27 @@
+#ifndef NW_BANDED_H
+#define NW_BANDED_H
+
+#include <vector>
+
+#include "nwutility.h"
+
+// The widest band, must match MAX_BAND of nw_banded.cl
+#define NW_MAX_BAND 64
+
+// The band-compressed scores per step of the nw_banded kernel
+#define NW_BAND_STRIDE (NW_MAX_BAND + 1)
+
+// The fraction of the residues of the row sequence that are substituted,
+// deleted or followed by an insertion in the column sequence of a similar
+// pair.
+#define NW_SIMILAR_DIVERGENCE 0.02
+
+void makeNWSimilarProblem(NWProblem &problem, int dim, int penalty, double divergence);
+
+long long getNWBandCells(int dim, int band);
+
+void fillNWBandReference(const NWProblem &problem, int band, std::vector<int> &reference);
+
+bool nwBandedCPU(const NWProblem &problem, int band, int &score);
+
+#endif
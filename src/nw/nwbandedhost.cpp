@@ -0,0 +1,113 @@
+/** @file nwbandedhost.cpp */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <vector>
+
+#include "../common/utility.h"
+
+#include "nwhost.h"
+
+using namespace std;
+
+// ****************************************************************************
+// Function: alignBandedFPGA
+//
+// Purpose:
+//   Computes the best global score within the band of the pair of the
+//   problem with one launch of the nw_banded kernel. Only the band-compressed
+//   substitution scores, O(dim * band), are moved to the device.
+//
+// Arguments:
+//   dev: the opencl device id to use for the benchmark
+//   ctx: the opencl context to use for the benchmark
+//   queue: the opencl command queue to issue commands to
+//   prog: the opencl program containing the kernel
+//   reference : the band-compressed scores of fillNWBandReference
+//   dim : the length of the sequences
+//   band : the half width of the band
+//   penalty : the linear gap penalty
+//   score : output - the best score within the band
+//   overflow : output - 1 if the band may overflow
+//
+// Returns:  the kernel runtime in seconds
+//
+// ****************************************************************************
+double alignBandedFPGA(cl_device_id dev,
+                             cl_context ctx,
+                             cl_command_queue queue,
+                             cl_program prog,
+                             const vector<int> &reference,
+                             int dim,
+                             int band,
+                             int penalty,
+                             int &score,
+                             int &overflow)
+{
+    int err;
+
+    // Extract the kernel
+    cl_kernel bandkernel = clCreateKernel(prog, "nw_banded", &err);
+    CL_CHECK_ERROR(err);
+
+    // Allocate device memory
+    cl_mem reference_d = clCreateBuffer(ctx, CL_MEM_READ_ONLY, reference.size() * sizeof(int), NULL, &err);
+    CL_CHECK_ERROR(err);
+
+    cl_mem result_d = clCreateBuffer(ctx, CL_MEM_WRITE_ONLY, 2 * sizeof(int), NULL, &err);
+    CL_CHECK_ERROR(err);
+
+    // write buffers
+    err = clEnqueueWriteBuffer(queue, reference_d, 0, 0, reference.size() * sizeof(int), reference.data(), 0, NULL, NULL);
+    CL_CHECK_ERROR(err);
+
+    err = clFinish(queue);
+    CL_CHECK_ERROR(err);
+
+    // Set the kernel arguments
+    err = clSetKernelArg(bandkernel, 0, sizeof(cl_mem), (void*) &reference_d);
+    CL_CHECK_ERROR(err);
+    err = clSetKernelArg(bandkernel, 1, sizeof(cl_mem), (void*) &result_d);
+    CL_CHECK_ERROR(err);
+    err = clSetKernelArg(bandkernel, 2, sizeof(cl_int), (void*) &dim);
+    CL_CHECK_ERROR(err);
+    err = clSetKernelArg(bandkernel, 3, sizeof(cl_int), (void*) &band);
+    CL_CHECK_ERROR(err);
+    err = clSetKernelArg(bandkernel, 4, sizeof(cl_int), (void*) &penalty);
+    CL_CHECK_ERROR(err);
+
+    cl_event event = NULL;
+    err = clEnqueueTask(queue, bandkernel, 0, NULL, &event);
+    CL_CHECK_ERROR(err);
+
+    err = clFinish(queue);
+    CL_CHECK_ERROR(err);
+
+    cl_ulong startTime;
+    cl_ulong endTime;
+
+    err = clGetEventProfilingInfo(event, CL_PROFILING_COMMAND_START,
+                                    sizeof(cl_ulong), &startTime, NULL);
+    CL_CHECK_ERROR(err);
+
+    err = clGetEventProfilingInfo(event, CL_PROFILING_COMMAND_END,
+                                    sizeof(cl_ulong), &endTime, NULL);
+    CL_CHECK_ERROR(err);
+
+    // read the score and the flag
+    int result[2];
+    err = clEnqueueReadBuffer(queue, result_d, 1, 0, 2 * sizeof(int), result, 0, NULL, NULL);
+    CL_CHECK_ERROR(err);
+
+    score = result[0];
+    overflow = result[1];
+
+    // Clean up device memory
+    clReleaseEvent(event);
+    clReleaseMemObject(reference_d);
+    clReleaseMemObject(result_d);
+    clReleaseKernel(bandkernel);
+
+    return (endTime - startTime) / 1.e9;
+}
@@ -0,0 +1,220 @@
+#include <stdlib.h>
+
+#include <iostream>
+#include <thread>
+#include <algorithm>
+
+#include "nwutility.h"
+#include "nwbatch.h"
+#include "nwsimd.h"
+
+using namespace std;
+
+// Pairs are handed to the threads in chunks of this many.
+#define NW_BATCH_CHUNK 64
+
+// ****************************************************************************
+// Function: parseNWLengthRanges
+//
+// Purpose:
+//   Parses the comma separated sequence lengths of the batched mode, each a
+//   length or a range min-max, e.g. "100,250,100-500".
+//
+// Arguments:
+//   list : the lengths
+//   ranges : output - the parsed ranges
+//
+// Returns:  false if a length is not in 1 to NW_BATCH_MAX_LENGTH
+//
+// ****************************************************************************
+bool parseNWLengthRanges(string list, vector<NWLengthRange> &ranges)
+{
+    ranges.clear();
+
+    size_t begin = 0;
+    while (begin <= list.size())
+    {
+        size_t end = list.find(',', begin);
+        if (end == string::npos) end = list.size();
+
+        string lengths = list.substr(begin, end - begin);
+        begin = end + 1;
+
+        if (lengths.empty()) continue;
+
+        char *rest;
+        NWLengthRange range;
+        range.min = strtol(lengths.c_str(), &rest, 10);
+        range.max = range.min;
+
+        if (*rest == '-')
+        {
+            range.max = strtol(rest + 1, &rest, 10);
+        }
+
+        if (*rest != '\0' || range.min < 1 || range.max < range.min || 
+            range.max > NW_BATCH_MAX_LENGTH)
+        {
+            cout << "Invalid nw sequence lengths: " << lengths << endl;
+            return false;
+        }
+
+        ranges.push_back(range);
+    }
+
+    return !ranges.empty();
+}
+
+string getNWLengthRangeName(const NWLengthRange &range)
+{
+    if (range.min == range.max)
+        return to_string(range.min);
+
+    return to_string(range.min) + "-" + to_string(range.max);
+}
+
+// ****************************************************************************
+// Function: makeNWBatch
+//
+// Purpose:
+//   Generates numPairs random pairs, the length of each sequence drawn from
+//   the range, packed back to back into the residue buffer.
+//
+// Arguments:
+//   batch : output - the batch
+//   numPairs : the number of pairs
+//   range : the sequence lengths
+//   penalty : the linear gap penalty
+//
+// Returns:  nothing
+//
+// ****************************************************************************
+void makeNWBatch(NWBatch &batch, int numPairs, const NWLengthRange &range, 
+                int penalty)
+{
+    batch.penalty = penalty;
+    batch.residues.clear();
+    batch.pairs.resize(numPairs);
+    batch.cells = 0;
+
+    srand(7);
+
+    int span = range.max - range.min + 1;
+
+    for (int p = 0; p < numPairs; p++)
+    {
+        NWPair &pair = batch.pairs[p];
+
+        pair.rowLength = range.min + rand() % span;
+        pair.colLength = range.min + rand() % span;
+        pair.rowOffset = batch.residues.size();
+        pair.colOffset = pair.rowOffset + pair.rowLength;
+
+        for (int i = 0; i < pair.rowLength + pair.colLength; i++)
+            batch.residues.push_back(rand() % NW_RANDOM_RESIDUES + 1);
+
+        batch.cells += (long long)pair.rowLength * pair.colLength;
+    }
+}
+
+// ****************************************************************************
+// Function: nwScorePairCPU
+//
+// Purpose:
+//   Computes the global alignment score of a pair of the batch in linear
+//   space.
+//
+// Arguments:
+//   batch : the batch
+//   pair : the index of the pair
+//   row : scratch space of NW_BATCH_MAX_LENGTH+1 scores
+//
+// Returns:  the alignment score
+//
+// ****************************************************************************
+int nwScorePairCPU(const NWBatch &batch, int pair, int *row)
+{
+    const NWPair &p = batch.pairs[pair];
+    const char *rowSequence = &batch.residues[p.rowOffset];
+    const char *colSequence = &batch.residues[p.colOffset];
+    int penalty = batch.penalty;
+
+    for (int j = 0; j <= p.colLength; j++)
+        row[j] = -j * penalty;
+
+    for (int i = 1; i <= p.rowLength; i++)
+    {
+        const int *scores = blosum62[(int)rowSequence[i - 1]];
+        int topLeft = row[0];
+        row[0] = -i * penalty;
+
+        for (int j = 1; j <= p.colLength; j++)
+        {
+            int top = row[j];
+            row[j] = maximum(topLeft + scores[(int)colSequence[j - 1]],
+                             row[j - 1] - penalty,
+                             top - penalty);
+            topLeft = top;
+        }
+    }
+
+    return row[p.colLength];
+}
+
+// ****************************************************************************
+// Function: nwBatchCPU
+//
+// Purpose:
+//   Computes the scores of all pairs of the batch on the host with the
+//   striped SIMD engine, chunks of NW_BATCH_CHUNK pairs are spread over the
+//   threads.
+//
+// Arguments:
+//   batch : the batch
+//   scores : output - the score of each pair
+//   numThreads : the number of threads, 0 for all cores
+//
+// Returns:  nothing
+//
+// ****************************************************************************
+void nwBatchCPU(const NWBatch &batch, int *scores, int numThreads)
+{
+    int numPairs = batch.pairs.size();
+    int numChunks = (numPairs + NW_BATCH_CHUNK - 1) / NW_BATCH_CHUNK;
+
+    if (numThreads <= 0) numThreads = max(1u, thread::hardware_concurrency());
+    numThreads = max(1, min(numThreads, numChunks));
+
+    vector<thread> threads;
+
+    for (int t = 0; t < numThreads; t++)
+    {
+        threads.push_back(thread([&batch, scores, numPairs, numChunks, numThreads, t]()
+        {
+            vector<int> rowSequence, colSequence;
+
+            for (int chunk = t; chunk < numChunks; chunk += numThreads)
+            {
+                int first = chunk * NW_BATCH_CHUNK;
+                int last = min(numPairs, first + NW_BATCH_CHUNK);
+
+                for (int p = first; p < last; p++)
+                {
+                    const NWPair &pair = batch.pairs[p];
+                    const char *residues = batch.residues.data();
+
+                    rowSequence.assign(residues + pair.rowOffset, 
+                                       residues + pair.rowOffset + pair.rowLength);
+                    colSequence.assign(residues + pair.colOffset, 
+                                       residues + pair.colOffset + pair.colLength);
+
+                    scores[p] = nwScorePairSIMD(rowSequence.data(), pair.rowLength,
+                                                colSequence.data(), pair.colLength,
+                                                batch.penalty, NW_ENGINE_STRIPED);
+                }
+            }
+        }));
+    }
+
+    for (thread &t : threads) t.join();
+}
@@ -0,0 +1,44 @@
+#ifndef NW_BATCH_H
+#define NW_BATCH_H
+
+#include <string>
+#include <vector>
+
+// The longest sequence of a batched pair, must match MAX_LENGTH of nw_batch.cl
+#define NW_BATCH_MAX_LENGTH 512
+
+// The lengths of the sequences of a batch, drawn uniformly from [min, max].
+typedef struct {
+    int min;
+    int max;
+} NWLengthRange;
+
+// A pair of a batch, the offsets and lengths of its sequences in the residue
+// buffer. The layout is the int4 of the nw_batch kernel.
+typedef struct {
+    int rowOffset;
+    int rowLength;
+    int colOffset;
+    int colLength;
+} NWPair;
+
+// Many independent pairs packed into one residue buffer.
+typedef struct {
+    int penalty;
+    std::vector<char> residues;
+    std::vector<NWPair> pairs;
+    long long cells;
+} NWBatch;
+
+bool parseNWLengthRanges(std::string list, std::vector<NWLengthRange> &ranges);
+
+std::string getNWLengthRangeName(const NWLengthRange &range);
+
+void makeNWBatch(NWBatch &batch, int numPairs, const NWLengthRange &range, 
+                int penalty);
+
+int nwScorePairCPU(const NWBatch &batch, int pair, int *row);
+
+void nwBatchCPU(const NWBatch &batch, int *scores, int numThreads);
+
+#endif
@@ -0,0 +1,118 @@
+/** @file nwbatchhost.cpp */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "../common/utility.h"
+
+#include "nwhost.h"
+
+using namespace std;
+
+// ****************************************************************************
+// Function: alignBatchFPGA
+//
+// Purpose:
+//   Computes the scores of all pairs of the batch with one launch of the
+//   nw_batch kernel.
+//
+// Arguments:
+//   dev: the opencl device id to use for the benchmark
+//   ctx: the opencl context to use for the benchmark
+//   queue: the opencl command queue to issue commands to
+//   prog: the opencl program containing the kernel
+//   batch : the batch
+//   scores : output - the score of each pair
+//
+// Returns:  the kernel runtime in seconds
+//
+// ****************************************************************************
+double alignBatchFPGA(cl_device_id dev,
+                             cl_context ctx,
+                             cl_command_queue queue,
+                             cl_program prog,
+                             const NWBatch &batch,
+                             int *scores)
+{
+    int numPairs = batch.pairs.size();
+    int penalty = batch.penalty;
+
+    int err;
+
+    // Extract the kernel
+    cl_kernel batchkernel = clCreateKernel(prog, "nw_batch", &err);
+    CL_CHECK_ERROR(err);
+
+    // Allocate device memory
+    cl_mem residues_d = clCreateBuffer(ctx, CL_MEM_READ_ONLY, batch.residues.size() * sizeof(char), NULL, &err);
+    CL_CHECK_ERROR(err);
+
+    cl_mem pairs_d = clCreateBuffer(ctx, CL_MEM_READ_ONLY, numPairs * sizeof(NWPair), NULL, &err);
+    CL_CHECK_ERROR(err);
+
+    cl_mem substitution_d = clCreateBuffer(ctx, CL_MEM_READ_ONLY, sizeof(blosum62), NULL, &err);
+    CL_CHECK_ERROR(err);
+
+    cl_mem scores_d = clCreateBuffer(ctx, CL_MEM_WRITE_ONLY, numPairs * sizeof(int), NULL, &err);
+    CL_CHECK_ERROR(err);
+
+    // write buffers
+    err = clEnqueueWriteBuffer(queue, residues_d, 0, 0, batch.residues.size() * sizeof(char), batch.residues.data(), 0, NULL, NULL);
+    CL_CHECK_ERROR(err);
+
+    err = clEnqueueWriteBuffer(queue, pairs_d, 0, 0, numPairs * sizeof(NWPair), batch.pairs.data(), 0, NULL, NULL);
+    CL_CHECK_ERROR(err);
+
+    err = clEnqueueWriteBuffer(queue, substitution_d, 0, 0, sizeof(blosum62), blosum62, 0, NULL, NULL);
+    CL_CHECK_ERROR(err);
+
+    err = clFinish(queue);
+    CL_CHECK_ERROR(err);
+
+    // Set the kernel arguments
+    err = clSetKernelArg(batchkernel, 0, sizeof(cl_mem), (void*) &residues_d);
+    CL_CHECK_ERROR(err);
+    err = clSetKernelArg(batchkernel, 1, sizeof(cl_mem), (void*) &pairs_d);
+    CL_CHECK_ERROR(err);
+    err = clSetKernelArg(batchkernel, 2, sizeof(cl_mem), (void*) &substitution_d);
+    CL_CHECK_ERROR(err);
+    err = clSetKernelArg(batchkernel, 3, sizeof(cl_mem), (void*) &scores_d);
+    CL_CHECK_ERROR(err);
+    err = clSetKernelArg(batchkernel, 4, sizeof(cl_int), (void*) &numPairs);
+    CL_CHECK_ERROR(err);
+    err = clSetKernelArg(batchkernel, 5, sizeof(cl_int), (void*) &penalty);
+    CL_CHECK_ERROR(err);
+
+    // all pairs in one launch
+    cl_event event = NULL;
+    err = clEnqueueTask(queue, batchkernel, 0, NULL, &event);
+    CL_CHECK_ERROR(err);
+
+    err = clFinish(queue);
+    CL_CHECK_ERROR(err);
+
+    cl_ulong startTime;
+    cl_ulong endTime;
+
+    err = clGetEventProfilingInfo(event, CL_PROFILING_COMMAND_START,
+                                    sizeof(cl_ulong), &startTime, NULL);
+    CL_CHECK_ERROR(err);
+
+    err = clGetEventProfilingInfo(event, CL_PROFILING_COMMAND_END,
+                                    sizeof(cl_ulong), &endTime, NULL);
+    CL_CHECK_ERROR(err);
+
+    // read the scores
+    err = clEnqueueReadBuffer(queue, scores_d, 1, 0, numPairs * sizeof(int), scores, 0, NULL, NULL);
+    CL_CHECK_ERROR(err);
+
+    // Clean up device memory
+    clReleaseEvent(event);
+    clReleaseMemObject(residues_d);
+    clReleaseMemObject(pairs_d);
+    clReleaseMemObject(substitution_d);
+    clReleaseMemObject(scores_d);
+    clReleaseKernel(batchkernel);
+
+    return (endTime - startTime) / 1.e9;
+}
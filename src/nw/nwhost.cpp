@@ -28,14 +28,26 @@
 #include <iostream>
 #include <fstream>
 #include <vector>
+#include <chrono>
+#include <algorithm>
 
 #include "../common/utility.h"
 #include "timer.h"
+#include "nwhost.h"
+#include "nwsimd.h"
 using namespace std;
 
 #include "CL/cl_ext_intelfpga.h"
 
 #define AOCL_ALIGNMENT 64
+
+// The number of reference strips in flight: the host generates and uploads
+// the strips up to NW_LAUNCH_DEPTH - 1 blocks ahead of the block launched
+#define NW_LAUNCH_DEPTH 4
+
+// Problem Sizes: the sequence lengths of --size 1 to 7, in units of 1024
+static const int probSizes[7] = { 1, 2, 4, 8, 16, 32, 64 };
+
 inline static void* alignedMalloc(size_t size)
 {
 #ifdef _WIN32
@@ -63,54 +75,31 @@ void runTest(const string& testName, cl_device_id dev, cl_context ctx,
         const string& compileFlags);
 
 // ****************************************************************************
-// Function: nwCPU
+// Function: verifyNWRow
 //
 // Purpose:
-//   Simple cpu nw routine to verify device results
+//   Checks a row of the device result against the row of the host engines
 //
 // Arguments:
-//   data : the input data
-//   reference : space for the cpu solution
-//   dev_result : result from the device
-//   size :
-//
-// Returns:  nothing, prints relevant info to stdout
+//   cpu_row : the DP row computed on the host
+//   dev_row : the row from the device, device column c being DP column c+1
+//   cols : the number of device columns to check
 //
-// Programmer: Kyle Spafford
-// Creation: August 13, 2009
-//
-// Modifications:
+// Returns:  true if the row matches, prints relevant info to stdout
 //
 // ****************************************************************************
-inline int maximum(int, int, int);
-
-bool nwCPU(int *reference, int *input_itemsets, int *output_itemsets, int max_rows, int max_cols, int penalty)
+bool verifyNWRow(const int *cpu_row, const int *dev_row, int cols)
 {
     bool passed = true;
 
-	for (int i = 1; i < max_rows - 1; ++i)
-	{
-		for (int j = 1; j < max_cols - 1; ++j)
-		{
-			int index = i * max_cols + j;
-            int ref_offset = i * (max_cols-1) + (j-1);
-			input_itemsets[index] = maximum(input_itemsets[index - 1 - max_rows] + reference[ref_offset],
-									 input_itemsets[index - 1]       - penalty,
-									 input_itemsets[index - max_rows]     - penalty);
- 		}
-	}
+    for (int c = 0; c < cols; c++)
+    {
+        if (dev_row[c] != cpu_row[c + 1])
+        {
+            passed = false;
+        }
+    }
 
-	for (int i=0 ; i < max_rows - 2 ; ++i)
-	{
-		for (int j = 0, jt = 1 ; j < max_cols - 2 && jt < max_cols - 1 ; ++j,++jt)
-		{
-            if (output_itemsets[i * (max_cols - 1) + j] != input_itemsets[i * (max_cols) + jt])
-            {
-                passed = false;
-            }
-		}
-	}
-        
     cout << "Test ";
     if (passed)
         cout << "Passed" << endl;
@@ -119,25 +108,477 @@ bool nwCPU(int *reference, int *input_itemsets, int *output_itemsets, int max_ro
     return passed;
 }
 
-inline int maximum(int a, int b, int c)
+// ****************************************************************************
+// Function: scoreNWRowHost
+//
+// Purpose:
+//   Computes the DP row to verify with the anti-diagonal and the striped
+//   SIMD engines on all cores, checks that they agree and reports their
+//   rates
+//
+// Arguments:
+//   problem : the alignment problem
+//   lastRow : the DP row to compute
+//   cpu_row : output - the dim+1 scores of the row
+//   resultDB : results from the benchmark are stored in this db
+//   options : the benchmark suite options
+//
+// Returns:  false if the engines disagree
+//
+// ****************************************************************************
+bool scoreNWRowHost(const NWProblem &problem, int lastRow, int *cpu_row,
+                    BenchmarkDatabase &resultDB, BenchmarkOptions &options)
+{
+    NWEngine engines[2] = { NW_ENGINE_ANTIDIAGONAL, NW_ENGINE_STRIPED };
+    vector<int> engine_row(problem.dim + 1);
+
+    double cells = double(lastRow) * problem.dim;
+
+    char atts[1024];
+    sprintf(atts, "%lld Elements", (long long)lastRow * problem.dim);
+
+    for (int e = 0; e < 2; e++)
+    {
+        const char *name = getNWEngineName(engines[e]);
+        int *host_row = (e == 0) ? cpu_row : engine_row.data();
+
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        int widened = nwScoreRowSIMD(problem, lastRow, host_row, engines[e], 0);
+        double hostTime = 
+            chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+        if (e > 0 && !equal(engine_row.begin(), engine_row.end(), cpu_row))
+        {
+            cout << "ERROR: the " << name << " host engine disagrees with the "
+                 << getNWEngineName(engines[0]) << " one" << endl;
+            return false;
+        }
+
+        if (!options.quiet)
+        {
+            cout << "Host " << name << " engine: " << cells / hostTime / 1.e9 
+                 << " GCUPS, tiles widened to 32 bits: " << widened << endl;
+        }
+
+        resultDB.AddResult("nw", string("nw-host-") + name, atts, "GCUPS", 
+                            cells / hostTime / 1.e9);
+    }
+
+    return true;
+}
+
+// ****************************************************************************
+// Function: scoreNWAffineRowHost
+//
+// Purpose:
+//   Computes the DP row to verify and the best local score with the affine
+//   gap (Gotoh) recurrence on the host and reports its rate
+//
+// Arguments:
+//   problem : the alignment problem
+//   scoring : the alignment mode and gap costs
+//   lastRow : the DP row to compute
+//   lastCol : the last DP column computed on the device
+//   cpu_row : output - the dim+1 scores of the row
+//   resultDB : results from the benchmark are stored in this db
+//
+// Returns:  the best score of a local alignment, cpu_row[lastCol] for a
+//           global one
+//
+// ****************************************************************************
+int scoreNWAffineRowHost(const NWProblem &problem, const NWScoring &scoring, 
+                    int lastRow, int lastCol, int *cpu_row, BenchmarkDatabase &resultDB)
+{
+    double cells = double(lastRow) * problem.dim;
+
+    char atts[1024];
+    sprintf(atts, "%lld Elements", (long long)lastRow * problem.dim);
+
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    int best = nwAffineRowCPU(problem, scoring, lastRow, lastCol, cpu_row);
+    double hostTime = 
+        chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    resultDB.AddResult("nw", string("nw-host-affine-") + 
+                        (scoring.local ? NW_MODE_LOCAL : NW_MODE_GLOBAL), atts, "GCUPS", 
+                        cells / hostTime / 1.e9);
+
+    return best;
+}
+
+// ****************************************************************************
+// Function: benchmarkNWBatch
+//
+// Purpose:
+//   Executes the passes of the batched mode for each range of sequence
+//   lengths. All pairs of a batch are aligned by one launch of the nw_batch
+//   kernel and by the multithreaded host routine, which is also the
+//   reference.
+//
+// Arguments:
+//   dev: the opencl device id to use for the benchmark
+//   ctx: the opencl context to use for the benchmark
+//   queue: the opencl command queue to issue commands to
+//   resultDB: results from the benchmark are stored in this db
+//   options: the benchmark suite options
+//   appOptions: the nw options
+//
+// Returns:  nothing
+//
+// ****************************************************************************
+void benchmarkNWBatch(cl_device_id dev,
+                    cl_context ctx,
+                    cl_command_queue queue,
+                    BenchmarkDatabase &resultDB,
+                    BenchmarkOptions &options,
+                    ApplicationOptions &appOptions)
 {
-	int k;
-	if(a <= b)
-		k = b;
-	else
-		k = a;
-
-	if(k <= c)
-		return(c);
-	else
-		return(k);
+    vector<NWLengthRange> ranges;
+
+    if (!parseNWLengthRanges(appOptions.nwBatch, ranges)) return;
+
+    int numPairs = appOptions.nwPairs;
+
+    if (numPairs < 1)
+    {
+        cout << "ERROR: invalid number of nw pairs " << numPairs << endl;
+        return;
+    }
+
+    cl_program prog = createProgramFromBitstream(ctx, appOptions.bitstreamFile, dev);
+
+    for (const NWLengthRange &range : ranges)
+    {
+        string lengths = getNWLengthRangeName(range);
+
+        NWBatch batch;
+        makeNWBatch(batch, numPairs, range, NW_DEFAULT_PENALTY);
+
+        if (!options.quiet)
+        {
+            cout << "Pairs: " << numPairs << ", lengths: " << lengths 
+                 << ", cells: " << batch.cells << endl;
+        }
+
+        vector<int> reference(numPairs);
+        vector<int> scores(numPairs);
+
+        char atts[1024];
+        sprintf(atts, "%d pairs, length %s", numPairs, lengths.c_str());
+
+        bool verified = true;
+
+        for (int k = 0; k < appOptions.passes; k++)
+        {
+            chrono::steady_clock::time_point start = chrono::steady_clock::now();
+            nwBatchCPU(batch, reference.data(), 0);
+            double hostTime = 
+                chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+            double t = alignBatchFPGA(dev, ctx, queue, prog, batch, scores.data());
+
+            for (int p = 0; p < numPairs; p++)
+            {
+                if (scores[p] != reference[p])
+                {
+                    cout << "Score mismatch at pair " << p << ": " << scores[p]
+                         << ", the host score: " << reference[p] << endl;
+                    verified = false;
+                    break;
+                }
+            }
+
+            // If answer is incorrect, stop test and do not report performance,
+        // a failed verification leaves the passes for the clean up below
+            if (!verified)
+            {
+                break;
+            }
+
+            if (options.verbose)
+            {
+                cout << "time = " << t << " sec, host time = " << hostTime << " sec" << endl;
+            }
+
+            resultDB.AddResult("nw", "nw-batch", atts, "Alignments/s", numPairs / t);
+            resultDB.AddResult("nw", "nw-batch-gcups", atts, "GCUPS", batch.cells / t / 1.e9);
+            resultDB.AddResult("nw", "nw-host-batch", atts, "Alignments/s", numPairs / hostTime);
+            resultDB.AddResult("nw", "nw-host-batch-gcups", atts, "GCUPS", batch.cells / hostTime / 1.e9);
+        }
+
+        cout << "Test ";
+        if (verified)
+            cout << "Passed" << endl;
+        else
+            cout << "Failed" << endl;
+    }
+
+    int err = clReleaseProgram(prog);
+    CL_CHECK_ERROR(err);
+}
+
+// ****************************************************************************
+// Function: benchmarkNWTraceback
+//
+// Purpose:
+//   Executes the passes of the traceback mode: the pair of the problem size
+//   is aligned in linear space (Hirschberg) with the score rows computed by
+//   the nw kernel, and by the host reference. The alignments must be the
+//   same and score the best score.
+//
+// Arguments:
+//   dev: the opencl device id to use for the benchmark
+//   ctx: the opencl context to use for the benchmark
+//   queue: the opencl command queue to issue commands to
+//   resultDB: results from the benchmark are stored in this db
+//   options: the benchmark suite options
+//   appOptions: the nw options
+//
+// Returns:  nothing
+//
+// ****************************************************************************
+void benchmarkNWTraceback(cl_device_id dev,
+                    cl_context ctx,
+                    cl_command_queue queue,
+                    BenchmarkDatabase &resultDB,
+                    BenchmarkOptions &options,
+                    ApplicationOptions &appOptions)
+{
+    int dim = probSizes[appOptions.size-1] * 1024;
+    int penalty = NW_DEFAULT_PENALTY;
+
+    NWProblem problem;
+    makeNWProblem(problem, dim, penalty);
+
+    vector<int> row(dim + 1);
+    nwScoreRowCPU(problem, dim, row.data());
+    int best = row[dim];
+
+    char atts[1024];
+    sprintf(atts, "%d x %d", dim, dim);
+
+    // the host reference
+    long long hostCells;
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    string reference = nwHirschbergAlign(problem, 
+        [penalty](const int *rowSeq, int rows, const int *colSeq, int cols, int *row)
+        {
+            nwScoreLastRowCPU(rowSeq, rows, colSeq, cols, penalty, row);
+        }, hostCells);
+    double hostTime = 
+        chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    int score;
+    if (!nwScoreCigar(problem, reference, score) || score != best)
+    {
+        cout << "ERROR: the host alignment scores " << score << ", the best score is " << best << endl;
+        return;
+    }
+
+    resultDB.AddResult("nw", "nw-host-traceback", atts, "Alignments/s", 1 / hostTime);
+    resultDB.AddResult("nw", "nw-host-traceback-gcups", atts, "GCUPS", hostCells / hostTime / 1.e9);
+
+	cl_program prog =  createProgramFromBitstream(ctx, appOptions.bitstreamFile, dev);
+
+    NWRowScorerFPGA scorer;
+    initNWRowScorerFPGA(scorer, ctx, queue, prog, dim + 2, penalty);
+
+    for (int k = 0; k < appOptions.passes; k++)
+    {
+        long long cells;
+        scorer.launches = 0;
+
+        int th = Timer::Start();
+
+        string alignment = nwHirschbergAlign(problem, 
+            [&scorer](const int *rowSeq, int rows, const int *colSeq, int cols, int *row)
+            {
+                scoreNWLastRowFPGA(scorer, rowSeq, rows, colSeq, cols, row);
+            }, cells);
+
+        double t = Timer::Stop(th, "total NW traceback time");
+
+        // If answer is incorrect, stop test and do not report performance
+        bool passed = (alignment == reference);
+
+        cout << "Test ";
+        if (passed)
+            cout << "Passed" << endl;
+        else
+            cout << "Failed" << endl;
+
+        if (!passed)
+        {
+            break;
+        }
+
+        if (options.verbose)
+        {
+            cout << "score = " << best << ", CIGAR length = " << alignment.size() 
+                 << ", kernel launches = " << scorer.launches << endl;
+        }
+
+        resultDB.AddResult("nw", "nw-traceback", atts, "Alignments/s", 1 / t);
+        resultDB.AddResult("nw", "nw-traceback-gcups", atts, "GCUPS", cells / t / 1.e9);
+    }
+
+    releaseNWRowScorerFPGA(scorer);
+
+    int err = clReleaseProgram(prog);
+    CL_CHECK_ERROR(err);
+}
+
+// ****************************************************************************
+// Function: benchmarkNWBanded
+//
+// Purpose:
+//   Executes the passes of the banded mode: a pair of similar sequences of
+//   the problem size is aligned over the band |i - j| <= band only by the
+//   nw_banded kernel and by the host reference, which must agree on the
+//   score and the band-overflow flag. The host also aligns the full matrix:
+//   without an overflow, the banded score must be the best score.
+//
+// Arguments:
+//   dev: the opencl device id to use for the benchmark
+//   ctx: the opencl context to use for the benchmark
+//   queue: the opencl command queue to issue commands to
+//   resultDB: results from the benchmark are stored in this db
+//   options: the benchmark suite options
+//   appOptions: the nw options
+//
+// Returns:  nothing
+//
+// ****************************************************************************
+void benchmarkNWBanded(cl_device_id dev,
+                    cl_context ctx,
+                    cl_command_queue queue,
+                    BenchmarkDatabase &resultDB,
+                    BenchmarkOptions &options,
+                    ApplicationOptions &appOptions)
+{
+    int dim = probSizes[appOptions.size-1] * 1024;
+    int penalty = NW_DEFAULT_PENALTY;
+    int band = appOptions.nwBand;
+
+    if (band < 1 || band > NW_MAX_BAND)
+    {
+        cout << "ERROR: invalid nw band " << band << ", the nw_banded kernel supports 1 to " 
+             << NW_MAX_BAND << endl;
+        return;
+    }
+
+    NWProblem problem;
+    makeNWSimilarProblem(problem, dim, penalty, NW_SIMILAR_DIVERGENCE);
+
+    long long cells = getNWBandCells(dim, band);
+    double fullCells = double(dim) * dim;
+
+    char atts[1024];
+    sprintf(atts, "%d x %d, band %d", dim, dim, band);
+
+    // the host reference, full and banded
+    vector<int> row(dim + 1);
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    nwScoreRowCPU(problem, dim, row.data());
+    double fullTime = 
+        chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    int best = row[dim];
+
+    int reference;
+    start = chrono::steady_clock::now();
+    bool overflow = nwBandedCPU(problem, band, reference);
+    double hostTime = 
+        chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    if (!overflow && reference != best)
+    {
+        cout << "ERROR: the host banded score " << reference << " is not the best score " 
+             << best << " without a band overflow" << endl;
+        return;
+    }
+
+    if (overflow)
+    {
+        cout << "Band overflow: the best path touches the edge of the band, the banded score " 
+             << reference << " may be below the best score " << best 
+             << ", try a wider --nw-band" << endl;
+    }
+
+    if (!options.quiet)
+    {
+        cout << "Band cells: " << cells << " of " << (long long)dim * dim 
+             << ", host speedup over the full alignment: " << fullTime / hostTime << endl;
+    }
+
+    resultDB.AddResult("nw", "nw-host-banded", atts, "GCUPS", cells / hostTime / 1.e9);
+    resultDB.AddResult("nw", "nw-host-banded-speedup", atts, "x", fullTime / hostTime);
+
+    vector<int> layout;
+    fillNWBandReference(problem, band, layout);
+
+    cl_program prog = createProgramFromBitstream(ctx, appOptions.bitstreamFile, dev);
+
+    for (int k = 0; k < appOptions.passes; k++)
+    {
+        int score, flag;
+        double t = alignBandedFPGA(dev, ctx, queue, prog, layout, dim, band, penalty, score, flag);
+
+        // If answer is incorrect, stop test and do not report performance
+        bool passed = (score == reference && (flag != 0) == overflow);
+
+        cout << "Test ";
+        if (passed)
+            cout << "Passed" << endl;
+        else
+            cout << "Failed" << endl;
+
+        if (!passed)
+        {
+            cout << "Score mismatch: " << score << " (overflow " << flag << "), the host score: " 
+                 << reference << " (overflow " << overflow << ")" << endl;
+            break;
+        }
+
+        if (options.verbose)
+        {
+            cout << "time = " << t << " sec, score = " << score << endl;
+        }
+
+        resultDB.AddResult("nw", "nw-banded", atts, "GCUPS", cells / t / 1.e9);
+        resultDB.AddResult("nw", "nw-banded-effective", atts, "GCUPS", fullCells / t / 1.e9);
+    }
+
+    int err = clReleaseProgram(prog);
+    CL_CHECK_ERROR(err);
 }
 
 // ****************************************************************************
 // Function: RunBenchmark
 //
 // Purpose:
-//   Executes the nw (Needleman-Wunsch) benchmark
+//   Executes the nw (Needleman-Wunsch) benchmark. The DP matrix is computed
+//   in strips of BSIZE rows overlapping by one row. Only NW_LAUNCH_DEPTH
+//   strips of the reference scores are resident on the host and the device:
+//   while the kernel computes a strip, the next ones are generated from the
+//   sequences and uploaded on a second queue. The last row of a strip is
+//   copied to the first row of the device data strip for the next one.
+//   Each block is launched by its own kernel clone with preset arguments,
+//   back to back into the in-order queue with a single finish per pass, and
+//   the gaps between the kernel END and the next START are reported.
+//   The nw_affine kernel, if the bitstream contains it, computes the affine
+//   gap recurrence of --nw-mode and --gap-open/--gap-extend, its F row being
+//   carried from strip to strip like the last row. The nw kernel only
+//   computes the global alignment with the linear penalty.
+//   With --nw-output=score or checksum, the nw_score kernel writes only the
+//   last row and column of the matrix and, for checksum, the sum of the
+//   scores of each strip to verify all of them.
+//   The nw_packed kernel, if the bitstream contains it, reads the sequences
+//   packed in 2 or 5 bits per residue and looks the scores up itself, so
+//   that no strips are generated or uploaded. --nw-fasta aligns the first
+//   two records of a FASTA file instead of random sequences.
+//   With --nw-band=k, a pair of similar sequences is aligned over the band
+//   |i - j| <= k only by the nw_banded kernel.
 //
 // Arguments:
 //   dev: the opencl device id to use for the benchmark
@@ -154,33 +595,6 @@ inline int maximum(int a, int b, int c)
 // ****************************************************************************
 extern const char *cl_source_nw;
 
-int blosum62[24][24] = {
-{ 4, -1, -2, -2,  0, -1, -1,  0, -2, -1, -1, -1, -1, -2, -1,  1,  0, -3, -2,  0, -2, -1,  0, -4},
-{-1,  5,  0, -2, -3,  1,  0, -2,  0, -3, -2,  2, -1, -3, -2, -1, -1, -3, -2, -3, -1,  0, -1, -4},
-{-2,  0,  6,  1, -3,  0,  0,  0,  1, -3, -3,  0, -2, -3, -2,  1,  0, -4, -2, -3,  3,  0, -1, -4},
-{-2, -2,  1,  6, -3,  0,  2, -1, -1, -3, -4, -1, -3, -3, -1,  0, -1, -4, -3, -3,  4,  1, -1, -4},
-{ 0, -3, -3, -3,  9, -3, -4, -3, -3, -1, -1, -3, -1, -2, -3, -1, -1, -2, -2, -1, -3, -3, -2, -4},
-{-1,  1,  0,  0, -3,  5,  2, -2,  0, -3, -2,  1,  0, -3, -1,  0, -1, -2, -1, -2,  0,  3, -1, -4},
-{-1,  0,  0,  2, -4,  2,  5, -2,  0, -3, -3,  1, -2, -3, -1,  0, -1, -3, -2, -2,  1,  4, -1, -4},
-{ 0, -2,  0, -1, -3, -2, -2,  6, -2, -4, -4, -2, -3, -3, -2,  0, -2, -2, -3, -3, -1, -2, -1, -4},
-{-2,  0,  1, -1, -3,  0,  0, -2,  8, -3, -3, -1, -2, -1, -2, -1, -2, -2,  2, -3,  0,  0, -1, -4},
-{-1, -3, -3, -3, -1, -3, -3, -4, -3,  4,  2, -3,  1,  0, -3, -2, -1, -3, -1,  3, -3, -3, -1, -4},
-{-1, -2, -3, -4, -1, -2, -3, -4, -3,  2,  4, -2,  2,  0, -3, -2, -1, -2, -1,  1, -4, -3, -1, -4},
-{-1,  2,  0, -1, -3,  1,  1, -2, -1, -3, -2,  5, -1, -3, -1,  0, -1, -3, -2, -2,  0,  1, -1, -4},
-{-1, -1, -2, -3, -1,  0, -2, -3, -2,  1,  2, -1,  5,  0, -2, -1, -1, -1, -1,  1, -3, -1, -1, -4},
-{-2, -3, -3, -3, -2, -3, -3, -3, -1,  0,  0, -3,  0,  6, -4, -2, -2,  1,  3, -1, -3, -3, -1, -4},
-{-1, -2, -2, -1, -3, -1, -1, -2, -2, -3, -3, -1, -2, -4,  7, -1, -1, -4, -3, -2, -2, -1, -2, -4},
-{ 1, -1,  1,  0, -1,  0,  0,  0, -1, -2, -2,  0, -1, -2, -1,  4,  1, -3, -2, -2,  0,  0,  0, -4},
-{ 0, -1,  0, -1, -1, -1, -1, -2, -2, -1, -1, -1, -1, -2, -1,  1,  5, -2, -2,  0, -1, -1,  0, -4},
-{-3, -3, -4, -4, -2, -2, -3, -2, -2, -3, -2, -3, -1,  1, -4, -3, -2, 11,  2, -3, -4, -3, -2, -4},
-{-2, -2, -2, -3, -2, -1, -2, -3,  2, -1, -1, -2, -1,  3, -3, -2, -2,  2,  7, -1, -3, -2, -1, -4},
-{ 0, -3, -3, -3, -1, -2, -2, -3, -3,  3,  1, -2,  1, -1, -2, -2,  0, -3, -1,  4, -3, -2, -1, -4},
-{-2, -1,  3,  4, -3,  0,  1, -1,  0, -3, -4,  0, -3, -3, -2,  0, -1, -4, -3, -3,  4,  1, -1, -4},
-{-1,  0,  0,  1, -3,  3,  4, -2,  0, -3, -3,  1, -1, -3, -1,  0, -1, -3, -2, -2,  1,  4, -1, -4},
-{ 0, -1, -1, -1, -2, -1, -1, -1, -1, -1, -1, -1, -1, -1, -2,  0,  0, -2, -1, -1, -1, -1, -1, -4},
-{-4, -4, -4, -4, -4, -4, -4, -4, -4, -4, -4, -4, -4, -4, -4, -4, -4, -4, -4, -4, -4, -4, -4,  1}
-};
-
 void
 benchmarkNW(cl_device_id dev,
                     cl_context ctx,
@@ -199,19 +613,95 @@ benchmarkNW(cl_device_id dev,
 
     ApplicationOptions appOptions = iter->second;
 
+    NWScoring scoring;
+    if (!parseNWScoring(appOptions.nwMode.c_str(), appOptions.gapOpen, appOptions.gapExtend, scoring))
+    {
+        return;
+    }
+
+    NWOutput output;
+    if (!parseNWOutput(appOptions.nwOutput.c_str(), output))
+    {
+        return;
+    }
+
+    bool score_only = (output != NW_OUTPUT_STRIP);
+    int check = (output == NW_OUTPUT_CHECKSUM) ? 1 : 0;
+
+    if (!appOptions.nwBatch.empty())
+    {
+        if (!isNWLinearScoring(scoring, NW_DEFAULT_PENALTY))
+        {
+            cout << "ERROR: the batched mode only computes the global alignment with the linear gap penalty " 
+                 << NW_DEFAULT_PENALTY << endl;
+            return;
+        }
+
+        if (output != NW_OUTPUT_STRIP)
+        {
+            cout << "ERROR: the batched mode only writes the scores of the pairs" << endl;
+            return;
+        }
+
+        benchmarkNWBatch(dev, ctx, queue, resultDB, options, appOptions);
+        return;
+    }
+
+    if (appOptions.nwTraceback)
+    {
+        if (!isNWLinearScoring(scoring, NW_DEFAULT_PENALTY) || output != NW_OUTPUT_STRIP)
+        {
+            cout << "ERROR: the traceback only aligns globally with the linear gap penalty " 
+                 << NW_DEFAULT_PENALTY << " and the nw kernel" << endl;
+            return;
+        }
+
+        benchmarkNWTraceback(dev, ctx, queue, resultDB, options, appOptions);
+        return;
+    }
+
+    if (appOptions.nwBand > 0)
+    {
+        if (!isNWLinearScoring(scoring, NW_DEFAULT_PENALTY) || output != NW_OUTPUT_STRIP)
+        {
+            cout << "ERROR: the banded mode only aligns globally with the linear gap penalty " 
+                 << NW_DEFAULT_PENALTY << " and writes the score" << endl;
+            return;
+        }
+
+        benchmarkNWBanded(dev, ctx, queue, resultDB, options, appOptions);
+        return;
+    }
+
     int err = 0;
 
-    // Problem Sizes
-    int probSizes[7] = { 1, 2, 4, 8, 16, 32, 64 };
     int size = probSizes[appOptions.size-1];
 
     // Convert to MB
     size = size * 1024;
     int dim = size;
+    int penalty = NW_DEFAULT_PENALTY;
+
+    // the first two records of the FASTA file instead of random sequences
+    NWProblem problem;
+    int bits = NW_PROTEIN_BITS;
+
+    if (!appOptions.nwFasta.empty())
+    {
+        if (!makeNWFastaProblem(problem, appOptions.nwFasta.c_str(), penalty, bits))
+        {
+            return;
+        }
+
+        dim = problem.dim;
+    }
+    else
+    {
+        makeNWProblem(problem, dim, penalty);
+    }
 
     int max_rows = dim;
     int max_cols = dim;
-    int penalty = 10;
     
     max_rows = max_rows + 1;
     max_cols = max_cols + 1;
@@ -219,12 +709,103 @@ benchmarkNW(cl_device_id dev,
     int num_rows = max_rows;
     int num_cols = max_cols - 1;
     
-    int data_size = max_cols * max_rows;
-    int ref_size = num_cols * num_rows;
-    
-	int *reference = (int *)alignedMalloc(ref_size * sizeof(int));
-	int *input_itemsets = (int *)alignedMalloc(data_size * sizeof(int));
-	int *output_itemsets = (int *)alignedMalloc(ref_size * sizeof(int));
+    // one strip of BSIZE rows of the reference and data matrices
+    size_t strip_size = (size_t)BSIZE * num_cols;
+
+    // the kernel computes the rows up to dim - 2, the last one is verified
+    int last_row = num_cols - 2;
+
+    cl_program prog =  createProgramFromBitstream(ctx, appOptions.bitstreamFile, dev);
+
+    // Extract the kernel, the score-only one for the score outputs, else the
+    // packed input one for the linear penalty or the affine one if there is
+    // one
+    cl_kernel nwkernel = NULL;
+    bool affine = false;
+    bool packed = false;
+
+    if (score_only)
+    {
+        if (!isNWLinearScoring(scoring, penalty))
+        {
+            cout << "ERROR: the " << getNWOutputName(output) << " output only computes the global alignment with the linear gap penalty " 
+                 << penalty << endl;
+            clReleaseProgram(prog);
+            return;
+        }
+
+        nwkernel = clCreateKernel(prog, "nw_score", &err);
+
+        if (err != CL_SUCCESS)
+        {
+            cout << "ERROR: the " << getNWOutputName(output) << " output needs the nw_score kernel" << endl;
+            clReleaseProgram(prog);
+            return;
+        }
+    }
+    else
+    {
+        if (isNWLinearScoring(scoring, penalty))
+        {
+            nwkernel = clCreateKernel(prog, "nw_packed", &err);
+            packed = (err == CL_SUCCESS);
+        }
+
+        if (!packed)
+        {
+            nwkernel = clCreateKernel(prog, "nw_affine", &err);
+            affine = (err == CL_SUCCESS);
+        }
+    }
+
+    if (!affine && !packed && !score_only)
+    {
+        if (!isNWLinearScoring(scoring, penalty))
+        {
+            cout << "ERROR: the local mode and affine gap costs need the nw_affine kernel" << endl;
+            clReleaseProgram(prog);
+            return;
+        }
+
+        nwkernel = clCreateKernel(prog, "nw", &err);
+        CL_CHECK_ERROR(err);
+    }
+
+    vector<int> cpu_row(dim + 1);
+    int cpu_best = 0;
+
+    if (affine)
+    {
+        cpu_best = scoreNWAffineRowHost(problem, scoring, last_row, num_cols - 1, cpu_row.data(), resultDB);
+    }
+    else if (!scoreNWRowHost(problem, last_row, cpu_row.data(), resultDB, options))
+    {
+        clReleaseKernel(nwkernel);
+        clReleaseProgram(prog);
+        return;
+    }
+
+    // the last column and the checksums of the strips of the score outputs
+    int comp_bsize = BSIZE - 1;
+    int num_strips = (last_row + comp_bsize - 1) / comp_bsize;
+    vector<int> cpu_column(last_row + 1);
+    vector<unsigned int> cpu_checksums(num_strips);
+
+    if (score_only)
+    {
+        nwScoreBoundaryCPU(problem, last_row, num_cols - 1, comp_bsize, cpu_column.data(), cpu_checksums.data());
+    }
+
+    // the packed input kernel needs no strips of reference scores
+    int ref_strips = packed ? 0 : NW_LAUNCH_DEPTH;
+
+    int *reference_strip[NW_LAUNCH_DEPTH];
+    for (int s = 0; s < ref_strips; s++)
+    {
+        reference_strip[s] = (int *)alignedMalloc(strip_size * sizeof(int));
+    }
+    int *output_row = (int *)alignedMalloc(num_cols * sizeof(int));
+    int *output_column = (int *)alignedMalloc(num_cols * sizeof(int));
     
     int *buffer_v = NULL;
     int *buffer_h = NULL;
@@ -232,93 +813,71 @@ benchmarkNW(cl_device_id dev,
     buffer_h = (int *)alignedMalloc(num_cols * sizeof(int));
     buffer_v = (int *)alignedMalloc(num_rows * sizeof(int));
     
-    //initialization
-    srand(7);
-    
-	for (int i = 0; i < max_cols; i++)
-	{
-		for (int j = 0; j < max_rows; j++)
-		{
-			input_itemsets[i * max_rows + j] = 0;
-		}
-	}
-
-	for(int i = 1; i < max_rows; i++)
-	{    //initialize the first column
-		input_itemsets[i * max_cols] = rand() % 10 + 1;
-	}
-	
-	for(int j = 1; j < max_cols; j++)
-	{    //initialize the first row
-		input_itemsets[j] = rand() % 10 + 1;
-	}
-	
-	for (int i = 1; i < max_rows; i++)
-	{
-		for (int j = 1; j < max_cols; j++)
-		{
-            int ref_offset = i * num_cols + (j-1);
-            reference[ref_offset] = blosum62[input_itemsets[i * max_cols]][input_itemsets[j]];
-		}
-	}
-
+    //initialization, the gap costs of the global alignment or 0
     for(int i = 1; i < max_rows; i++)
     {
-        input_itemsets[i * max_cols] = -i * penalty;
-        buffer_v[i] = -i * penalty;
+        buffer_v[i] = scoring.local ? 0 : -getNWGapCost(scoring, i);
     }
     buffer_v[0] = 0;
     
     for(int j = 1; j < max_cols; j++)
     {
-        input_itemsets[j] = -j * penalty;
-        buffer_h[j - 1] = -j * penalty;
+        buffer_h[j - 1] = scoring.local ? 0 : -getNWGapCost(scoring, j);
     }
+
+    // no alignment ends in a vertical gap in row 0
+    vector<int> first_f_row(num_cols, NW_NEG_INF);
     
-    int nworkitems, workgroupsize = 0;
-    nworkitems = BSIZE;
-    
-    if(nworkitems < 1 || workgroupsize < 0)
+    // The strips are uploaded on their own queue, next to the kernels
+    cl_command_queue upload_queue = clCreateCommandQueue(ctx, dev, 0, &err);
+    CL_CHECK_ERROR(err);
+
+    // Allocate device memory for the strips of reference data in flight
+    cl_mem reference_d[NW_LAUNCH_DEPTH];
+    for (int s = 0; s < ref_strips; s++)
     {
-        cout<<"ERROR: invalid or missing <num_work_items>\n";
-        return; 
+        reference_d[s] = clCreateBuffer(ctx, CL_MEM_READ_ONLY | CL_CHANNEL_1_INTELFPGA, strip_size * sizeof(int), NULL, &err);
+        CL_CHECK_ERROR(err);
     }
-    
-    size_t local_work[3] = { (size_t)((workgroupsize>0)?workgroupsize:1), 1, 1 };
-    size_t global_work[3] = { (size_t)nworkitems, 1, 1 };
-    
-	cl_program prog =  createProgramFromBitstream(ctx, appOptions.bitstreamFile, dev);
 
-    // Extract the kernel
-    cl_kernel nwkernel = clCreateKernel(prog, "nw", &err);
+    // Allocate device memory for the packed sequences and the substitution
+    // table of the packed input kernel
+    NWPackedSequence row_packed, column_packed;
+    packNWSequence(problem.rowSequence, bits, row_packed);
+    packNWSequence(problem.columnSequence, bits, column_packed);
+
+    vector<int> table(NW_TABLE_SIDE * NW_TABLE_SIDE);
+    fillNWPackedTable(bits, table.data());
+
+    size_t sequence_size = row_packed.words.size() * sizeof(cl_uint);
+
+    cl_mem row_sequence_d = clCreateBuffer(ctx, CL_MEM_READ_ONLY | CL_CHANNEL_1_INTELFPGA, sequence_size, NULL, &err);
     CL_CHECK_ERROR(err);
 
-    // Allocate host memory for reference data (reference)
-    cl_mem reference_d = clCreateBuffer(ctx, CL_MEM_READ_ONLY | CL_CHANNEL_1_INTELFPGA, ref_size * sizeof(int), NULL, &err);
+    cl_mem column_sequence_d = clCreateBuffer(ctx, CL_MEM_READ_ONLY | CL_CHANNEL_1_INTELFPGA, sequence_size, NULL, &err);
     CL_CHECK_ERROR(err);
-    
-    // Allocate host memory for input data (input_itemsets)
-    int device_buff_size = ref_size;
-    cl_mem input_itemsets_d = clCreateBuffer(ctx, CL_MEM_READ_WRITE | CL_CHANNEL_2_INTELFPGA, device_buff_size * sizeof(int), NULL, &err);
+
+    cl_mem table_d = clCreateBuffer(ctx, CL_MEM_READ_ONLY | CL_CHANNEL_1_INTELFPGA, table.size() * sizeof(int), NULL, &err);
     CL_CHECK_ERROR(err);
     
-    // Allocate
-    cl_mem buffer_v_d = clCreateBuffer(ctx, CL_MEM_READ_ONLY | CL_CHANNEL_1_INTELFPGA, num_rows * sizeof(int), NULL, &err);
+    // Allocate device memory for one strip of output data, two rows for the
+    // score-only kernel
+    int data_rows = score_only ? 2 : BSIZE;
+    cl_mem input_itemsets_d = clCreateBuffer(ctx, CL_MEM_READ_WRITE | CL_CHANNEL_2_INTELFPGA, (size_t)data_rows * num_cols * sizeof(int), NULL, &err);
     CL_CHECK_ERROR(err);
     
-    // write buffers
-    err = clEnqueueWriteBuffer(queue, reference_d, 1, 0, ref_size * sizeof(int), reference, 0, 0, 0);
-    CL_CHECK_ERROR(err);
-
-    err = clFinish(queue);
+    // Allocate the F rows and the best score of the affine kernel
+    cl_mem f_rows_d = clCreateBuffer(ctx, CL_MEM_READ_WRITE | CL_CHANNEL_2_INTELFPGA, 2 * num_cols * sizeof(int), NULL, &err);
     CL_CHECK_ERROR(err);
 
-    err = clEnqueueWriteBuffer(queue, input_itemsets_d, 1, 0, num_cols * sizeof(int), buffer_h, 0, 0, 0);
+    cl_mem best_d = clCreateBuffer(ctx, CL_MEM_READ_WRITE | CL_CHANNEL_2_INTELFPGA, sizeof(int), NULL, &err);
     CL_CHECK_ERROR(err);
 
-    err = clFinish(queue);
+    // Allocate
+    cl_mem buffer_v_d = clCreateBuffer(ctx, CL_MEM_READ_ONLY | CL_CHANNEL_1_INTELFPGA, num_rows * sizeof(int), NULL, &err);
     CL_CHECK_ERROR(err);
-
+    
+    // write buffers
     err = clEnqueueWriteBuffer(queue, buffer_v_d, 1, 0, num_rows * sizeof(int), buffer_v, 0, 0, 0);
     CL_CHECK_ERROR(err);
 
@@ -330,86 +889,405 @@ benchmarkNW(cl_device_id dev,
     cout<< "PAR = " << PAR << endl;
     cout<< "WG size of kernel = " << BSIZE << endl;
     cout<< "worksize = " << worksize << endl;
-    int offset_r = 0, offset_c = 0;
-    int block_width = worksize/BSIZE;
     
     // Set the kernel arguments
     int cols = num_cols - 1 + PAR;
     int exit_col = (cols % PAR == 0) ? cols : cols + PAR - (cols % PAR);
     int loop_exit = exit_col * (BSIZE / PAR);
 
-    err = clSetKernelArg(nwkernel, 0, sizeof(void *), (void*) &reference_d);
-    CL_CHECK_ERROR(err);
-    err = clSetKernelArg(nwkernel, 1, sizeof(void *), (void*) &input_itemsets_d);
-    CL_CHECK_ERROR(err);
-    err = clSetKernelArg(nwkernel, 2, sizeof(void *), (void*) &buffer_v_d);
-    CL_CHECK_ERROR(err);
-    err = clSetKernelArg(nwkernel, 3, sizeof(cl_int), (void*) &num_cols);
-    CL_CHECK_ERROR(err);
-    err = clSetKernelArg(nwkernel, 4, sizeof(cl_int), (void*) &penalty);
+    int num_diags  = max_rows - 1;
+    int last_diag  = (num_diags % comp_bsize == 0) ? num_diags : num_diags + comp_bsize - (num_diags % comp_bsize);
+    int num_blocks = last_diag / comp_bsize;
+
+    // the last row is read back from the block it is computed in
+    int last_block = (last_row - 1) / comp_bsize;
+
+    // the last column and one checksum per block of the score-only kernel
+    cl_mem last_col_d = clCreateBuffer(ctx, CL_MEM_WRITE_ONLY | CL_CHANNEL_2_INTELFPGA, num_cols * sizeof(int), NULL, &err);
     CL_CHECK_ERROR(err);
-    err = clSetKernelArg(nwkernel, 5, sizeof(cl_int), (void*) &loop_exit);
+
+    cl_mem checksums_d = clCreateBuffer(ctx, CL_MEM_WRITE_ONLY | CL_CHANNEL_2_INTELFPGA, num_blocks * sizeof(cl_uint), NULL, &err);
     CL_CHECK_ERROR(err);
-    
+
+    vector<unsigned int> checksums(num_blocks);
+
+    // Every block is launched by its own clone of the kernel with all of its
+    // arguments set here, so a pass only enqueues the launches back to back
+    const char *kernel_name = score_only ? "nw_score" : (packed ? "nw_packed" : (affine ? "nw_affine" : "nw"));
+    int local = scoring.local ? 1 : 0;
+    int block_offset_arg = affine ? 8 : 6;
+
+    vector<cl_kernel> launch_kernels(num_blocks);
+    launch_kernels[0] = nwkernel;
+
+    for (int bx = 0; bx < num_blocks; bx++)
+    {
+        if (bx > 0)
+        {
+            launch_kernels[bx] = clCreateKernel(prog, kernel_name, &err);
+            CL_CHECK_ERROR(err);
+        }
+
+        cl_kernel launch_kernel = launch_kernels[bx];
+        int block_offset = bx * comp_bsize;
+
+        err = clSetKernelArg(launch_kernel, 0, sizeof(void *), (void*) (packed ? &row_sequence_d : &reference_d[bx % NW_LAUNCH_DEPTH]));
+        CL_CHECK_ERROR(err);
+        err = clSetKernelArg(launch_kernel, block_offset_arg, sizeof(cl_int), (void*) &block_offset);
+        CL_CHECK_ERROR(err);
+
+        if (affine)
+        {
+            err = clSetKernelArg(launch_kernel, 1, sizeof(void *), (void*) &input_itemsets_d);
+            CL_CHECK_ERROR(err);
+            err = clSetKernelArg(launch_kernel, 2, sizeof(void *), (void*) &f_rows_d);
+            CL_CHECK_ERROR(err);
+            err = clSetKernelArg(launch_kernel, 3, sizeof(void *), (void*) &buffer_v_d);
+            CL_CHECK_ERROR(err);
+            err = clSetKernelArg(launch_kernel, 4, sizeof(cl_int), (void*) &num_cols);
+            CL_CHECK_ERROR(err);
+            err = clSetKernelArg(launch_kernel, 5, sizeof(cl_int), (void*) &scoring.gapOpen);
+            CL_CHECK_ERROR(err);
+            err = clSetKernelArg(launch_kernel, 6, sizeof(cl_int), (void*) &scoring.gapExtend);
+            CL_CHECK_ERROR(err);
+            err = clSetKernelArg(launch_kernel, 7, sizeof(cl_int), (void*) &loop_exit);
+            CL_CHECK_ERROR(err);
+            err = clSetKernelArg(launch_kernel, 9, sizeof(cl_int), (void*) &local);
+            CL_CHECK_ERROR(err);
+            err = clSetKernelArg(launch_kernel, 10, sizeof(void *), (void*) &best_d);
+            CL_CHECK_ERROR(err);
+        }
+        else
+        {
+            err = clSetKernelArg(launch_kernel, 1, sizeof(void *), (void*) &input_itemsets_d);
+            CL_CHECK_ERROR(err);
+            err = clSetKernelArg(launch_kernel, 2, sizeof(void *), (void*) &buffer_v_d);
+            CL_CHECK_ERROR(err);
+            err = clSetKernelArg(launch_kernel, 3, sizeof(cl_int), (void*) &num_cols);
+            CL_CHECK_ERROR(err);
+            err = clSetKernelArg(launch_kernel, 4, sizeof(cl_int), (void*) &penalty);
+            CL_CHECK_ERROR(err);
+            err = clSetKernelArg(launch_kernel, 5, sizeof(cl_int), (void*) &loop_exit);
+            CL_CHECK_ERROR(err);
+        }
+
+        if (packed)
+        {
+            err = clSetKernelArg(launch_kernel, 7, sizeof(void *), (void*) &column_sequence_d);
+            CL_CHECK_ERROR(err);
+            err = clSetKernelArg(launch_kernel, 8, sizeof(void *), (void*) &table_d);
+            CL_CHECK_ERROR(err);
+            err = clSetKernelArg(launch_kernel, 9, sizeof(cl_int), (void*) &bits);
+            CL_CHECK_ERROR(err);
+        }
+
+        if (score_only)
+        {
+            err = clSetKernelArg(launch_kernel, 7, sizeof(void *), (void*) &last_col_d);
+            CL_CHECK_ERROR(err);
+            err = clSetKernelArg(launch_kernel, 8, sizeof(void *), (void*) &checksums_d);
+            CL_CHECK_ERROR(err);
+            err = clSetKernelArg(launch_kernel, 9, sizeof(cl_int), (void*) &check);
+            CL_CHECK_ERROR(err);
+        }
+    }
+
+    // the row of the block that is the first row of the next one
+    size_t carry_offset = (size_t)(score_only ? 1 : comp_bsize) * num_cols * sizeof(int);
+
+    // the bytes of the scores or sequences uploaded, read back to the host
+    // and written by the kernels and the copies to the device memory per pass
+    double upload_bytes = packed ? 2. * sequence_size + table.size() * sizeof(int) 
+                                 : double(num_blocks) * strip_size * sizeof(int);
+    double readback_bytes = double(num_cols) * sizeof(int);
+    double device_write_bytes = double(num_blocks - 1) * num_cols * sizeof(int);
+
+    if (score_only)
+    {
+        readback_bytes += double(num_cols) * sizeof(int) + (check ? num_blocks * sizeof(cl_uint) : 0);
+        device_write_bytes += double(num_strips) * (num_cols - 1) * sizeof(int) + double(last_row) * sizeof(int);
+    }
+    else
+    {
+        device_write_bytes += double(last_row) * (num_cols - 1) * sizeof(int);
+    }
+
     int passes = appOptions.passes;
 
     for (int k = 0; k < passes; k++)
     {
+        cl_event upload_event[NW_LAUNCH_DEPTH] = { NULL };
+        vector<cl_event> kernel_event(num_blocks, (cl_event)NULL);
 
         int th = Timer::Start();
-        
-        int num_diags  = max_rows - 1;
-        int comp_bsize = BSIZE - 1;
-        int last_diag  = (num_diags % comp_bsize == 0) ? num_diags : num_diags + comp_bsize - (num_diags % comp_bsize);
-        int num_blocks = last_diag / comp_bsize;
+
+        err = clEnqueueWriteBuffer(queue, input_itemsets_d, 0, 0, num_cols * sizeof(int), buffer_h, 0, 0, 0);
+        CL_CHECK_ERROR(err);
+
+        int device_best = 0;
+
+        if (affine)
+        {
+            err = clEnqueueWriteBuffer(queue, f_rows_d, 0, 0, num_cols * sizeof(int), first_f_row.data(), 0, 0, 0);
+            CL_CHECK_ERROR(err);
+            err = clEnqueueWriteBuffer(queue, best_d, 0, 0, sizeof(int), &device_best, 0, 0, 0);
+            CL_CHECK_ERROR(err);
+        }
+
+        if (packed)
+        {
+            err = clEnqueueWriteBuffer(queue, row_sequence_d, 0, 0, sequence_size, row_packed.words.data(), 0, 0, 0);
+            CL_CHECK_ERROR(err);
+            err = clEnqueueWriteBuffer(queue, column_sequence_d, 0, 0, sequence_size, column_packed.words.data(), 0, 0, 0);
+            CL_CHECK_ERROR(err);
+            err = clEnqueueWriteBuffer(queue, table_d, 0, 0, table.size() * sizeof(int), table.data(), 0, 0, 0);
+            CL_CHECK_ERROR(err);
+        }
+
+        // the strips of the first blocks are uploaded ahead
+        for (int bx = 0; bx < ref_strips - 1 && bx < num_blocks; bx++)
+        {
+            fillNWReferenceStrip(problem, bx * comp_bsize, BSIZE, reference_strip[bx]);
+
+            err = clEnqueueWriteBuffer(upload_queue, reference_d[bx], 0, 0, strip_size * sizeof(int), reference_strip[bx], 0, NULL, &upload_event[bx]);
+            CL_CHECK_ERROR(err);
+        }
+
+        err = clFlush(upload_queue);
+        CL_CHECK_ERROR(err);
         
         for (int bx = 0; bx < num_blocks; bx++)
         {
             int block_offset = bx * comp_bsize;
+            int s = bx % NW_LAUNCH_DEPTH;
 
-            err = clSetKernelArg(nwkernel, 6, sizeof(cl_int), (void*) &block_offset);
+            err = clEnqueueTask(queue, launch_kernels[bx], packed ? 0 : 1, packed ? NULL : &upload_event[s], &kernel_event[bx]);
             CL_CHECK_ERROR(err);
-            
-            err = clEnqueueTask(queue, nwkernel, 0, NULL, NULL);
+
+            if (bx == last_block)
+            {
+                size_t row_offset = score_only ? num_cols * sizeof(int) : (size_t)(last_row - block_offset) * num_cols * sizeof(int);
+
+                err = clEnqueueReadBuffer(queue, input_itemsets_d, 0, row_offset, num_cols * sizeof(int), output_row, 0, 0, 0);
+                CL_CHECK_ERROR(err);
+            }
+
+            // the last row of this block is the first row of the next one
+            if (bx + 1 < num_blocks)
+            {
+                err = clEnqueueCopyBuffer(queue, input_itemsets_d, input_itemsets_d, carry_offset, 0, num_cols * sizeof(int), 0, NULL, NULL);
+                CL_CHECK_ERROR(err);
+
+                if (affine)
+                {
+                    err = clEnqueueCopyBuffer(queue, f_rows_d, f_rows_d, num_cols * sizeof(int), 0, num_cols * sizeof(int), 0, NULL, NULL);
+                    CL_CHECK_ERROR(err);
+                }
+            }
+
+            err = clFlush(queue);
             CL_CHECK_ERROR(err);
 
-            err = clFinish(queue);
+            int ahead = bx + NW_LAUNCH_DEPTH - 1;
+
+            if (!packed && ahead < num_blocks)
+            {
+                // the staging strip and device buffer of block bx - 1 are
+                // free for block ahead once bx - 1 is uploaded and computed
+                int n = ahead % NW_LAUNCH_DEPTH;
+                cl_event *computed = (bx > 0) ? &kernel_event[bx - 1] : NULL;
+
+                if (upload_event[n] != NULL)
+                {
+                    err = clWaitForEvents(1, &upload_event[n]);
+                    CL_CHECK_ERROR(err);
+                    clReleaseEvent(upload_event[n]);
+                }
+
+                fillNWReferenceStrip(problem, ahead * comp_bsize, BSIZE, reference_strip[n]);
+
+                err = clEnqueueWriteBuffer(upload_queue, reference_d[n], 0, 0, strip_size * sizeof(int), reference_strip[n], 
+                                           computed != NULL ? 1 : 0, computed, &upload_event[n]);
+                CL_CHECK_ERROR(err);
+
+                err = clFlush(upload_queue);
+                CL_CHECK_ERROR(err);
+            }
+        }
+
+        if (affine)
+        {
+            err = clEnqueueReadBuffer(queue, best_d, 0, 0, sizeof(int), &device_best, 0, 0, 0);
             CL_CHECK_ERROR(err);
         }
-    
-        double totalNWTime = Timer::Stop(th, "total NW time");
 
-        err = clEnqueueReadBuffer(queue, input_itemsets_d, 1, 0, ref_size * sizeof(int), output_itemsets, 0, 0, 0);
-        CL_CHECK_ERROR(err);
+        if (score_only)
+        {
+            err = clEnqueueReadBuffer(queue, last_col_d, 0, 0, num_cols * sizeof(int), output_column, 0, 0, 0);
+            CL_CHECK_ERROR(err);
+        }
+
+        if (check)
+        {
+            err = clEnqueueReadBuffer(queue, checksums_d, 0, 0, num_blocks * sizeof(cl_uint), checksums.data(), 0, 0, 0);
+            CL_CHECK_ERROR(err);
+        }
 
         err = clFinish(queue);
         CL_CHECK_ERROR(err);
     
+        double totalNWTime = Timer::Stop(th, "total NW time");
+
+        // the time from the END of a launch to the START of the next one is
+        // the launch overhead, including the copy of the carried row
+        double kernelTime = 0;
+        double gapTime = 0;
+        double maxGap = 0;
+        cl_ulong previousEnd = 0;
+
+        for (int bx = 0; bx < num_blocks; bx++)
+        {
+            cl_ulong startTime;
+            cl_ulong endTime;
+
+            err = clGetEventProfilingInfo(kernel_event[bx], CL_PROFILING_COMMAND_START,
+                                            sizeof(cl_ulong), &startTime, NULL);
+            CL_CHECK_ERROR(err);
+
+            err = clGetEventProfilingInfo(kernel_event[bx], CL_PROFILING_COMMAND_END,
+                                            sizeof(cl_ulong), &endTime, NULL);
+            CL_CHECK_ERROR(err);
+
+            kernelTime += (endTime - startTime) / 1.e9;
+
+            if (bx > 0)
+            {
+                double gap = (double(startTime) - double(previousEnd)) / 1.e9;
+                gapTime += gap;
+                maxGap = max(maxGap, gap);
+            }
+
+            previousEnd = endTime;
+            clReleaseEvent(kernel_event[bx]);
+        }
+
+        double meanGap = (num_blocks > 1) ? gapTime / (num_blocks - 1) : 0;
+
+        for (int s = 0; s < NW_LAUNCH_DEPTH; s++)
+        {
+            if (upload_event[s] != NULL)
+                clReleaseEvent(upload_event[s]);
+        }
+
+        if (options.verbose)
+        {
+            cout << "launches = " << num_blocks << ", kernel time = " << kernelTime 
+                 << " sec, launch gaps = " << gapTime << " sec (mean " << meanGap * 1.e6 
+                 << " us, max " << maxGap * 1.e6 << " us)" << endl;
+        }
+    
+        if (scoring.local && device_best != cpu_best)
+        {
+            cout << "Best local score mismatch: " << device_best 
+                 << ", the host score: " << cpu_best << endl;
+            cout << "Test Failed" << endl;
+            break;
+        }
+
+        if (score_only && !equal(cpu_column.begin() + 1, cpu_column.end(), output_column + 1))
+        {
+            cout << "Last column mismatch" << endl;
+            cout << "Test Failed" << endl;
+            break;
+        }
+
+        if (check && !equal(cpu_checksums.begin(), cpu_checksums.end(), checksums.begin()))
+        {
+            cout << "Strip checksum mismatch" << endl;
+            cout << "Test Failed" << endl;
+            break;
+        }
+
         // If answer is incorrect, stop test and do not report performance
-        if (! nwCPU(reference, input_itemsets, output_itemsets, max_rows, max_cols , penalty))
+        if (! verifyNWRow(cpu_row.data(), output_row, num_cols - 1))
         {
-            return;
+            break;
         }
         
         char atts[1024];
         sprintf(atts, "%d Elements", (dim-1) * (dim-1));
         double GigaElement = ( (double(dim-1) * double(dim-1)) / ((1000.) * (1000.) * (1000.)) );
         
-        resultDB.AddResult("nw", "Needleman-Wunsch", atts, "GigaElement/s", GigaElement / totalNWTime);
+        string output_name = string("nw-") + getNWOutputName(output);
+
+        if (affine)
+        {
+            resultDB.AddResult("nw", string("nw-affine-") + appOptions.nwMode, atts, "GCUPS", GigaElement / totalNWTime);
+        }
+        else if (score_only)
+        {
+            resultDB.AddResult("nw", output_name, atts, "GCUPS", GigaElement / totalNWTime);
+        }
+        else
+        {
+            resultDB.AddResult("nw", "Needleman-Wunsch", atts, "GigaElement/s", GigaElement / totalNWTime);
+            resultDB.AddResult("nw", "nw-linear-global", atts, "GCUPS", GigaElement / totalNWTime);
+
+            if (packed)
+            {
+                resultDB.AddResult("nw", string("nw-packed-") + (bits == NW_DNA_BITS ? "dna" : "protein"), 
+                                    atts, "GCUPS", GigaElement / totalNWTime);
+            }
+        }
+
+        resultDB.AddResult("nw", output_name + "-time", atts, "s", totalNWTime);
+        resultDB.AddResult("nw", output_name + "-upload", atts, "B", upload_bytes);
+        resultDB.AddResult("nw", output_name + "-readback", atts, "B", readback_bytes);
+        resultDB.AddResult("nw", output_name + "-device-writes", atts, "B", device_write_bytes);
+        resultDB.AddResult("nw", output_name + "-kernel-time", atts, "s", kernelTime);
+        resultDB.AddResult("nw", output_name + "-launch-gap", atts, "us", meanGap * 1.e6);
+        resultDB.AddResult("nw", output_name + "-launch-gap-max", atts, "us", maxGap * 1.e6);
 
     }
     // Clean up device memory
-    err = clReleaseMemObject(reference_d);
+    for (int s = 0; s < ref_strips; s++)
+    {
+        err = clReleaseMemObject(reference_d[s]);
+        CL_CHECK_ERROR(err);
+        free(reference_strip[s]);
+    }
+    err = clReleaseMemObject(row_sequence_d);
+    CL_CHECK_ERROR(err);
+    err = clReleaseMemObject(column_sequence_d);
+    CL_CHECK_ERROR(err);
+    err = clReleaseMemObject(table_d);
     CL_CHECK_ERROR(err);
     err = clReleaseMemObject(input_itemsets_d);
     CL_CHECK_ERROR(err);
+    err = clReleaseMemObject(buffer_v_d);
+    CL_CHECK_ERROR(err);
+    err = clReleaseMemObject(f_rows_d);
+    CL_CHECK_ERROR(err);
+    err = clReleaseMemObject(best_d);
+    CL_CHECK_ERROR(err);
+    err = clReleaseMemObject(last_col_d);
+    CL_CHECK_ERROR(err);
+    err = clReleaseMemObject(checksums_d);
+    CL_CHECK_ERROR(err);
+    err = clReleaseCommandQueue(upload_queue);
+    CL_CHECK_ERROR(err);
 
     // Clean up other host memory
-    delete[] reference;
+    free(output_row);
+    free(output_column);
+    free(buffer_h);
+    free(buffer_v);
 
     err = clReleaseProgram(prog);
     CL_CHECK_ERROR(err);
-    err = clReleaseKernel(nwkernel);
-    CL_CHECK_ERROR(err);
+    for (int bx = 0; bx < num_blocks; bx++)
+    {
+        err = clReleaseKernel(launch_kernels[bx]);
+        CL_CHECK_ERROR(err);
+    }
 }
-
@@ -0,0 +1,59 @@
+/** @file nwhost.h */
+
+#ifndef NW_HOST_H
+#define NW_HOST_H
+
+#include "../common/utility.h"
+
+#include "nwutility.h"
+#include "nwbatch.h"
+#include "nwtraceback.h"
+#include "nwbanded.h"
+#include "nwsequence.h"
+
+// The device memory to compute the score rows of the Hirschberg subproblems
+// with the nw kernel, for subproblems of up to maxDim - 2 rows and maxDim - 1
+// columns.
+typedef struct {
+    cl_command_queue queue;
+    cl_kernel kernel;
+    cl_mem reference_d[2];
+    cl_mem data_d;
+    cl_mem input_v_d;
+    int *strip[2];
+    int maxDim;
+    int penalty;
+    long long launches;
+} NWRowScorerFPGA;
+
+double alignBatchFPGA(cl_device_id dev,
+                             cl_context ctx,
+                             cl_command_queue queue,
+                             cl_program prog,
+                             const NWBatch &batch,
+                             int *scores);
+
+double alignBandedFPGA(cl_device_id dev,
+                             cl_context ctx,
+                             cl_command_queue queue,
+                             cl_program prog,
+                             const std::vector<int> &reference,
+                             int dim,
+                             int band,
+                             int penalty,
+                             int &score,
+                             int &overflow);
+
+void initNWRowScorerFPGA(NWRowScorerFPGA &scorer,
+                             cl_context ctx,
+                             cl_command_queue queue,
+                             cl_program prog,
+                             int maxDim,
+                             int penalty);
+
+void scoreNWLastRowFPGA(NWRowScorerFPGA &scorer, const int *rowSeq, int rows,
+                             const int *colSeq, int cols, int *row);
+
+void releaseNWRowScorerFPGA(NWRowScorerFPGA &scorer);
+
+#endif
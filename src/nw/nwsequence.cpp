@@ -0,0 +1,250 @@
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <algorithm>
+
+#include "../common/mappedfile.h"
+#include "nwsequence.h"
+
+using namespace std;
+
+// ****************************************************************************
+// Function: readNWFasta
+//
+// Purpose:
+//   Reads the sequences of a FASTA file, mapped into memory instead of read
+//   line by line. The header (>) and comment (;) lines are skipped, the
+//   residues are upper case, and the letters that are no residue of blosum62
+//   read as X.
+//
+// Arguments:
+//   file : the path of the FASTA file
+//   sequences : output - the residues of each record
+//
+// Returns:  false if the file cannot be read or has no record, prints the
+//           error to stdout
+//
+// ****************************************************************************
+bool readNWFasta(const char *file, vector<string> &sequences)
+{
+    sequences.clear();
+
+    void *mapping;
+    size_t size;
+    if (!mapFile(file, mapping, size))
+    {
+        cout << "ERROR: cannot read the FASTA file " << file << endl;
+        return false;
+    }
+
+    const char *data = (const char *)mapping;
+
+    for (size_t p = 0; p < size; )
+    {
+        const char *end = (const char *)memchr(data + p, '\n', size - p);
+        size_t next = end ? end - data + 1 : size;
+
+        if (data[p] == '>')
+        {
+            sequences.push_back(string());
+        }
+        else if (data[p] != ';' && !sequences.empty())
+        {
+            string &sequence = sequences.back();
+
+            for (size_t q = p; q < next; q++)
+            {
+                char c = toupper((unsigned char)data[q]);
+
+                if (isalpha((unsigned char)c) || c == '*')
+                    sequence.push_back(strchr(NW_PROTEIN_RESIDUES, c) ? c : 'X');
+            }
+        }
+
+        p = next;
+    }
+
+    unmapFile(mapping, size);
+
+    if (sequences.empty())
+    {
+        cout << "ERROR: the FASTA file " << file << " has no record" << endl;
+        return false;
+    }
+
+    return true;
+}
+
+// ****************************************************************************
+// Function: makeNWFastaProblem
+//
+// Purpose:
+//   Makes the problem of the first two records of a FASTA file, the first
+//   one being the row sequence. Both are cut to the length of the shorter
+//   one. The records of only A, C, G and T are DNA and packed in 2 bits per
+//   nucleotide, the others proteins packed in 5 bits per amino acid.
+//
+// Arguments:
+//   problem : output - the problem
+//   file : the path of the FASTA file
+//   penalty : the linear gap penalty
+//   bits : output - the bits per packed residue
+//
+// Returns:  false if the file has no two records of at least 3 residues,
+//           prints the error to stdout
+//
+// ****************************************************************************
+bool makeNWFastaProblem(NWProblem &problem, const char *file, int penalty, int &bits)
+{
+    vector<string> sequences;
+
+    if (!readNWFasta(file, sequences)) return false;
+
+    if (sequences.size() < 2)
+    {
+        cout << "ERROR: the FASTA file " << file << " needs two records" << endl;
+        return false;
+    }
+
+    int dim = min(sequences[0].size(), sequences[1].size());
+
+    if (dim < 3)
+    {
+        cout << "ERROR: the first two records of " << file << " need at least 3 residues" << endl;
+        return false;
+    }
+
+    if (sequences[0].size() != sequences[1].size())
+    {
+        cout << "The records of " << sequences[0].size() << " and " << sequences[1].size() 
+             << " residues are cut to " << dim << endl;
+    }
+
+    bool dna = true;
+
+    for (int s = 0; s < 2; s++)
+    {
+        for (int p = 0; p < dim && dna; p++)
+        {
+            if (!strchr(NW_DNA_RESIDUES, sequences[s][p])) dna = false;
+        }
+    }
+
+    bits = dna ? NW_DNA_BITS : NW_PROTEIN_BITS;
+
+    problem.dim = dim;
+    problem.penalty = penalty;
+    problem.rowSequence.assign(dim + 1, 0);
+    problem.columnSequence.assign(dim + 1, 0);
+
+    for (int p = 0; p < dim; p++)
+    {
+        problem.rowSequence[p + 1] = strchr(NW_PROTEIN_RESIDUES, sequences[0][p]) - NW_PROTEIN_RESIDUES;
+        problem.columnSequence[p + 1] = strchr(NW_PROTEIN_RESIDUES, sequences[1][p]) - NW_PROTEIN_RESIDUES;
+    }
+
+    return true;
+}
+
+// ****************************************************************************
+// Function: packNWSequence
+//
+// Purpose:
+//   Packs a sequence of the problem as a stream of bits, the blosum62 code of
+//   each residue in 5 bits, or the code of each nucleotide in 2 bits.
+//
+// Arguments:
+//   sequence : the residues, index 0 unused
+//   bits : NW_PROTEIN_BITS or NW_DNA_BITS
+//   packed : output - the packed sequence
+//
+// Returns:  nothing
+//
+// ****************************************************************************
+void packNWSequence(const vector<int> &sequence, int bits, NWPackedSequence &packed)
+{
+    int length = sequence.size();
+
+    packed.bits = bits;
+    packed.length = length;
+    packed.words.assign(((size_t)length * bits + 31) / 32 + 1, 0);
+
+    for (int p = 1; p < length; p++)
+    {
+        unsigned int code = sequence[p];
+
+        if (bits == NW_DNA_BITS)
+            code = strchr(NW_DNA_RESIDUES, NW_PROTEIN_RESIDUES[code]) - NW_DNA_RESIDUES;
+
+        size_t bit = (size_t)p * bits;
+        unsigned long long field = (unsigned long long)code << (bit & 31);
+
+        packed.words[bit >> 5] |= (unsigned int)field;
+        packed.words[(bit >> 5) + 1] |= (unsigned int)(field >> 32);
+    }
+}
+
+// ****************************************************************************
+// Function: unpackNWResidue
+//
+// Purpose:
+//   Reads the code of a residue of a packed sequence like the nw_packed
+//   kernel, from the two words holding it.
+//
+// Arguments:
+//   words : the words of the packed sequence
+//   index : the index of the residue
+//   bits : the bits per residue
+//
+// Returns:  the code of the residue
+//
+// ****************************************************************************
+int unpackNWResidue(const unsigned int *words, int index, int bits)
+{
+    size_t bit = (size_t)index * bits;
+    unsigned long long window = ((unsigned long long)words[(bit >> 5) + 1] << 32) | words[bit >> 5];
+
+    return (int)(window >> (bit & 31)) & ((1 << bits) - 1);
+}
+
+// ****************************************************************************
+// Function: fillNWPackedTable
+//
+// Purpose:
+//   Generates the substitution table of the nw_packed kernel, indexed by the
+//   packed codes: blosum62 for proteins, the blosum62 scores of the letters
+//   A, C, G and T for DNA, so that the host reference scores both with
+//   blosum62.
+//
+// Arguments:
+//   bits : NW_PROTEIN_BITS or NW_DNA_BITS
+//   table : output - NW_TABLE_SIDE * NW_TABLE_SIDE scores
+//
+// Returns:  nothing
+//
+// ****************************************************************************
+void fillNWPackedTable(int bits, int *table)
+{
+    if (bits != NW_DNA_BITS)
+    {
+        memcpy(table, blosum62, NW_TABLE_SIDE * NW_TABLE_SIDE * sizeof(int));
+        return;
+    }
+
+    memset(table, 0, NW_TABLE_SIDE * NW_TABLE_SIDE * sizeof(int));
+
+    for (int a = 0; a < 4; a++)
+    {
+        for (int b = 0; b < 4; b++)
+        {
+            int row = strchr(NW_PROTEIN_RESIDUES, NW_DNA_RESIDUES[a]) - NW_PROTEIN_RESIDUES;
+            int col = strchr(NW_PROTEIN_RESIDUES, NW_DNA_RESIDUES[b]) - NW_PROTEIN_RESIDUES;
+
+            table[a * NW_TABLE_SIDE + b] = blosum62[row][col];
+        }
+    }
+}
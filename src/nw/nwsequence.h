@@ -0,0 +1,44 @@
+#ifndef NW_SEQUENCE_H
+#define NW_SEQUENCE_H
+
+#include <string>
+#include <vector>
+
+#include "nwutility.h"
+
+// The residues in the order of the rows and columns of blosum62, the codes
+// of the residues of NWProblem.
+#define NW_PROTEIN_RESIDUES "ARNDCQEGHILKMFPSTWYVBZX*"
+
+// The nucleotides in the order of their 2 bit codes.
+#define NW_DNA_RESIDUES "ACGT"
+
+// The bits of a packed residue: the blosum62 code of an amino acid, or the
+// code of a nucleotide in NW_DNA_RESIDUES.
+#define NW_PROTEIN_BITS 5
+#define NW_DNA_BITS 2
+
+// The side of the substitution table of the nw_packed kernel, the side of
+// blosum62.
+#define NW_TABLE_SIDE 24
+
+// A sequence packed as a stream of bits: residue p at bit p * bits, residue 0
+// being the unused DP index 0. One word more than needed is kept, so that the
+// two words holding a residue can always be read.
+typedef struct {
+    int bits;
+    int length;
+    std::vector<unsigned int> words;
+} NWPackedSequence;
+
+bool readNWFasta(const char *file, std::vector<std::string> &sequences);
+
+bool makeNWFastaProblem(NWProblem &problem, const char *file, int penalty, int &bits);
+
+void packNWSequence(const std::vector<int> &sequence, int bits, NWPackedSequence &packed);
+
+int unpackNWResidue(const unsigned int *words, int index, int bits);
+
+void fillNWPackedTable(int bits, int *table);
+
+#endif
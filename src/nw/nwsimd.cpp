@@ -0,0 +1,570 @@
+#include <stdint.h>
+#include <limits.h>
+
+#include <limits>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <algorithm>
+
+#if defined(__AVX2__) || defined(__AVX512BW__)
+#include <immintrin.h>
+#endif
+
+#include "nwsimd.h"
+
+using namespace std;
+
+#define NW_NUM_RESIDUES 24
+#define NW_MAX_SUBSTITUTION 11
+
+// The lanes of the SIMD engines, 16 bit lanes saturate, 32 bit lanes are
+// never close to overflow for the relative scores of a tile.
+template <typename T> struct NWVector;
+
+#if defined(__AVX512BW__)
+
+template <> struct NWVector<int16_t>
+{
+    typedef __m512i V;
+    static const int LANES = 32;
+    static V load(const int16_t *p) { return _mm512_loadu_si512(p); }
+    static void store(int16_t *p, V v) { _mm512_storeu_si512(p, v); }
+    static V set1(int16_t x) { return _mm512_set1_epi16(x); }
+    static V add(V a, V b) { return _mm512_adds_epi16(a, b); }
+    static V sub(V a, V b) { return _mm512_subs_epi16(a, b); }
+    static V max(V a, V b) { return _mm512_max_epi16(a, b); }
+    static V min(V a, V b) { return _mm512_min_epi16(a, b); }
+    static bool anyGreater(V a, V b) { return _mm512_cmpgt_epi16_mask(a, b) != 0; }
+    // lane i+1 gets lane i, lane 0 gets first
+    static V shiftIn(V v, int16_t first)
+    {
+        const V index = _mm512_set_epi16(30, 29, 28, 27, 26, 25, 24, 23, 22, 21, 20,
+                                        19, 18, 17, 16, 15, 14, 13, 12, 11, 10, 9, 8,
+                                        7, 6, 5, 4, 3, 2, 1, 0, 0);
+        return _mm512_mask_set1_epi16(_mm512_permutexvar_epi16(index, v), 1, first);
+    }
+};
+
+template <> struct NWVector<int32_t>
+{
+    typedef __m512i V;
+    static const int LANES = 16;
+    static V load(const int32_t *p) { return _mm512_loadu_si512(p); }
+    static void store(int32_t *p, V v) { _mm512_storeu_si512(p, v); }
+    static V set1(int32_t x) { return _mm512_set1_epi32(x); }
+    static V add(V a, V b) { return _mm512_add_epi32(a, b); }
+    static V sub(V a, V b) { return _mm512_sub_epi32(a, b); }
+    static V max(V a, V b) { return _mm512_max_epi32(a, b); }
+    static V min(V a, V b) { return _mm512_min_epi32(a, b); }
+    static bool anyGreater(V a, V b) { return _mm512_cmpgt_epi32_mask(a, b) != 0; }
+    static V shiftIn(V v, int32_t first)
+    {
+        return _mm512_alignr_epi32(v, _mm512_set1_epi32(first), 15);
+    }
+};
+
+#elif defined(__AVX2__)
+
+template <> struct NWVector<int16_t>
+{
+    typedef __m256i V;
+    static const int LANES = 16;
+    static V load(const int16_t *p) { return _mm256_loadu_si256((const __m256i*)p); }
+    static void store(int16_t *p, V v) { _mm256_storeu_si256((__m256i*)p, v); }
+    static V set1(int16_t x) { return _mm256_set1_epi16(x); }
+    static V add(V a, V b) { return _mm256_adds_epi16(a, b); }
+    static V sub(V a, V b) { return _mm256_subs_epi16(a, b); }
+    static V max(V a, V b) { return _mm256_max_epi16(a, b); }
+    static V min(V a, V b) { return _mm256_min_epi16(a, b); }
+    static bool anyGreater(V a, V b)
+    {
+        return _mm256_movemask_epi8(_mm256_cmpgt_epi16(a, b)) != 0;
+    }
+    static V shiftIn(V v, int16_t first)
+    {
+        V shifted = _mm256_alignr_epi8(v, _mm256_permute2x128_si256(v, v, 0x08), 14);
+        return _mm256_insert_epi16(shifted, first, 0);
+    }
+};
+
+template <> struct NWVector<int32_t>
+{
+    typedef __m256i V;
+    static const int LANES = 8;
+    static V load(const int32_t *p) { return _mm256_loadu_si256((const __m256i*)p); }
+    static void store(int32_t *p, V v) { _mm256_storeu_si256((__m256i*)p, v); }
+    static V set1(int32_t x) { return _mm256_set1_epi32(x); }
+    static V add(V a, V b) { return _mm256_add_epi32(a, b); }
+    static V sub(V a, V b) { return _mm256_sub_epi32(a, b); }
+    static V max(V a, V b) { return _mm256_max_epi32(a, b); }
+    static V min(V a, V b) { return _mm256_min_epi32(a, b); }
+    static bool anyGreater(V a, V b)
+    {
+        return _mm256_movemask_epi8(_mm256_cmpgt_epi32(a, b)) != 0;
+    }
+    static V shiftIn(V v, int32_t first)
+    {
+        V shifted = _mm256_alignr_epi8(v, _mm256_permute2x128_si256(v, v, 0x08), 12);
+        return _mm256_insert_epi32(shifted, first, 0);
+    }
+};
+
+#else
+
+// One lane, saturated like the SIMD lanes.
+template <typename T> struct NWScalarVector
+{
+    typedef T V;
+    static const int LANES = 1;
+    static T saturate(int64_t x)
+    {
+        return (T)std::max<int64_t>(numeric_limits<T>::min(),
+                        std::min<int64_t>(numeric_limits<T>::max(), x));
+    }
+    static V load(const T *p) { return *p; }
+    static void store(T *p, V v) { *p = v; }
+    static V set1(T x) { return x; }
+    static V add(V a, V b) { return saturate((int64_t)a + b); }
+    static V sub(V a, V b) { return saturate((int64_t)a - b); }
+    static V max(V a, V b) { return std::max(a, b); }
+    static V min(V a, V b) { return std::min(a, b); }
+    static bool anyGreater(V a, V b) { return a > b; }
+    static V shiftIn(V, T first) { return first; }
+};
+
+template <> struct NWVector<int16_t> : NWScalarVector<int16_t> {};
+template <> struct NWVector<int32_t> : NWScalarVector<int32_t> {};
+
+#endif
+
+// A tile of the DP matrix: rows x cols cells below the top boundary row
+// top[0..cols] and right of the left boundary column left[0..rows], both
+// starting with the corner. The tile computes its bottom row bottom[0..cols]
+// and right column right[0..rows].
+typedef struct {
+    int rows;
+    int cols;
+    const int *rowSequence;
+    const int *colSequence;
+    const int *top;
+    const int *left;
+    int penalty;
+    int *bottom;
+    int *right;
+} NWTile;
+
+// The scores of a tile are computed relative to its corner. They must stay
+// within these bounds, so that no lane saturates.
+template <typename T>
+static bool inNWRange(int x, int penalty)
+{
+    return x >= (int)numeric_limits<T>::min() + penalty + NW_MAX_SUBSTITUTION + 1 &&
+           x <= (int)numeric_limits<T>::max() - NW_MAX_SUBSTITUTION - 1;
+}
+
+template <typename T>
+static bool checkNWBoundaries(const NWTile &tile)
+{
+    int bias = tile.top[0];
+
+    for (int j = 0; j <= tile.cols; j++)
+        if (!inNWRange<T>(tile.top[j] - bias, tile.penalty)) return false;
+
+    for (int i = 0; i <= tile.rows; i++)
+        if (!inNWRange<T>(tile.left[i] - bias, tile.penalty)) return false;
+
+    return true;
+}
+
+template <typename T>
+static bool checkNWExtremes(typename NWVector<T>::V lowest, typename NWVector<T>::V highest,
+                    int penalty)
+{
+    typedef NWVector<T> W;
+    T low[W::LANES], high[W::LANES];
+
+    W::store(low, lowest);
+    W::store(high, highest);
+
+    for (int l = 0; l < W::LANES; l++)
+        if (!inNWRange<T>(low[l], penalty) || !inNWRange<T>(high[l], penalty))
+            return false;
+
+    return true;
+}
+
+// ****************************************************************************
+// Function: nwTileStriped
+//
+// Purpose:
+//   Computes a tile by Farrar's striped method: the columns are split into
+//   LANES segments, vector k holding column k of every segment, so that the
+//   cells of a vector do not depend on each other but through the left
+//   neighbour. That dependency is first ignored and then fixed up by the lazy
+//   loop, which ends as soon as no lane improves. The substitution scores of
+//   a row come from the profile of its residue, built once per tile.
+//
+// Arguments:
+//   tile : the tile
+//
+// Returns:  false if a lane could have saturated
+//
+// ****************************************************************************
+template <typename T>
+static bool nwTileStriped(const NWTile &tile)
+{
+    typedef NWVector<T> W;
+    typedef typename W::V V;
+
+    const int L = W::LANES;
+    // below any score, the 16 bit lanes saturate, the 32 bit ones must not wrap
+    const T NEG = sizeof(T) == 2 ? numeric_limits<T>::min() : numeric_limits<T>::min() / 2;
+
+    if (!checkNWBoundaries<T>(tile)) return false;
+
+    int rows = tile.rows;
+    int cols = tile.cols;
+    int bias = tile.top[0];
+    int S = (cols + L - 1) / L;
+
+    // profile[r][k][l], column l*S+k, zero for the padding beyond cols
+    vector<T> profile(NW_NUM_RESIDUES * S * L, 0);
+    for (int r = 0; r < NW_NUM_RESIDUES; r++)
+        for (int q = 0; q < cols; q++)
+            profile[(r * S + q % S) * L + q / S] = blosum62[r][tile.colSequence[q]];
+
+    vector<T> previous(S * L), current(S * L);
+    for (int q = 0; q < S * L; q++)
+        previous[(q % S) * L + q / S] = tile.top[min(q + 1, cols)] - bias;
+
+    V vPenalty = W::set1(tile.penalty);
+    V lowest = W::set1(0);
+    V highest = W::set1(0);
+
+    for (int i = 1; i <= rows; i++)
+    {
+        const T *rowProfile = &profile[tile.rowSequence[i - 1] * S * L];
+        T *prev = previous.data();
+        T *cur = current.data();
+
+        V diag = W::shiftIn(W::load(prev + (S - 1) * L), tile.left[i - 1] - bias);
+        V f = W::shiftIn(W::set1(NEG), tile.left[i] - bias - tile.penalty);
+
+        for (int k = 0; k < S; k++)
+        {
+            V up = W::load(prev + k * L);
+            V h = W::add(diag, W::load(rowProfile + k * L));
+            h = W::max(h, W::sub(up, vPenalty));
+            h = W::max(h, f);
+
+            W::store(cur + k * L, h);
+            lowest = W::min(lowest, h);
+            highest = W::max(highest, h);
+
+            f = W::sub(h, vPenalty);
+            diag = up;
+        }
+
+        // carry the left neighbours over the segment boundaries
+        f = W::shiftIn(f, NEG);
+        int k = 0;
+        V h = W::load(cur);
+
+        while (W::anyGreater(f, h))
+        {
+            h = W::max(h, f);
+            W::store(cur + k * L, h);
+            highest = W::max(highest, h);
+            f = W::sub(f, vPenalty);
+
+            if (++k == S)
+            {
+                k = 0;
+                f = W::shiftIn(f, NEG);
+            }
+            h = W::load(cur + k * L);
+        }
+
+        int last = cols - 1;
+        tile.right[i] = cur[(last % S) * L + last / S] + bias;
+
+        previous.swap(current);
+    }
+
+    if (!checkNWExtremes<T>(lowest, highest, tile.penalty)) return false;
+
+    tile.right[0] = tile.top[cols];
+    tile.bottom[0] = tile.left[rows];
+    for (int q = 0; q < cols; q++)
+        tile.bottom[q + 1] = previous[(q % S) * L + q / S] + bias;
+
+    return true;
+}
+
+// ****************************************************************************
+// Function: nwTileAntidiagonal
+//
+// Purpose:
+//   Computes a tile along its anti-diagonals, the cells of which do not
+//   depend on each other. A diagonal is kept by row, so the diagonal,
+//   left and top neighbours are contiguous in the two previous diagonals.
+//   The substitution scores are gathered per diagonal.
+//
+// Arguments:
+//   tile : the tile
+//
+// Returns:  false if a lane could have saturated
+//
+// ****************************************************************************
+template <typename T>
+static bool nwTileAntidiagonal(const NWTile &tile)
+{
+    typedef NWVector<T> W;
+    typedef typename W::V V;
+
+    const int L = W::LANES;
+
+    if (!checkNWBoundaries<T>(tile)) return false;
+
+    int rows = tile.rows;
+    int cols = tile.cols;
+    int bias = tile.top[0];
+    int penalty = tile.penalty;
+
+    vector<T> buffers(3 * (rows + 1));
+    vector<T> substitution(rows + 1);
+
+    // the row residues as offsets into the flat table and the column residues
+    // reversed, so that the gather of a diagonal reads both contiguously
+    const int *table = &blosum62[0][0];
+    vector<int> rowOffsets(rows + 1), reversed(cols);
+    for (int i = 1; i <= rows; i++)
+        rowOffsets[i] = tile.rowSequence[i - 1] * NW_NUM_RESIDUES;
+    for (int j = 0; j < cols; j++)
+        reversed[j] = tile.colSequence[cols - 1 - j];
+
+    T *diagonal2 = &buffers[0];
+    T *diagonal1 = &buffers[rows + 1];
+    T *current = &buffers[2 * (rows + 1)];
+
+    // the diagonals 0 and 1 are boundary cells
+    diagonal2[0] = 0;
+    diagonal1[0] = tile.top[1] - bias;
+    diagonal1[1] = tile.left[1] - bias;
+
+    V vPenalty = W::set1(penalty);
+    V lowest = W::set1(0);
+    V highest = W::set1(0);
+    int lowestTail = 0, highestTail = 0;
+
+    for (int d = 2; d <= rows + cols; d++)
+    {
+        int lo = max(1, d - cols);
+        int hi = min(rows, d - 1);
+
+        // column d-i-1 is reversed column cols-d+i
+        int shift = cols - d;
+        for (int i = lo; i <= hi; i++)
+            substitution[i] = table[rowOffsets[i] + reversed[shift + i]];
+
+        int i = lo;
+
+        for (; i + L - 1 <= hi; i += L)
+        {
+            V h = W::add(W::load(diagonal2 + i - 1), W::load(&substitution[i]));
+            h = W::max(h, W::sub(W::load(diagonal1 + i), vPenalty));
+            h = W::max(h, W::sub(W::load(diagonal1 + i - 1), vPenalty));
+
+            W::store(current + i, h);
+            lowest = W::min(lowest, h);
+            highest = W::max(highest, h);
+        }
+
+        for (; i <= hi; i++)
+        {
+            int h = max(diagonal2[i - 1] + substitution[i],
+                        max(diagonal1[i] - penalty, diagonal1[i - 1] - penalty));
+
+            current[i] = (T)h;
+            lowestTail = min(lowestTail, h);
+            highestTail = max(highestTail, h);
+        }
+
+        if (d <= cols) current[0] = tile.top[d] - bias;
+        if (d <= rows) current[d] = tile.left[d] - bias;
+
+        if (d > rows) tile.bottom[d - rows] = current[rows] + bias;
+        if (d > cols) tile.right[d - cols] = current[d - cols] + bias;
+
+        T *free = diagonal2;
+        diagonal2 = diagonal1;
+        diagonal1 = current;
+        current = free;
+    }
+
+    if (!checkNWExtremes<T>(lowest, highest, penalty) ||
+        !inNWRange<T>(lowestTail, penalty) || !inNWRange<T>(highestTail, penalty))
+        return false;
+
+    tile.right[0] = tile.top[cols];
+    tile.bottom[0] = tile.left[rows];
+
+    return true;
+}
+
+// Computes a tile with 16 bit lanes, again with 32 bit lanes if these could
+// have saturated. Returns whether the tile was widened.
+static bool nwTile(const NWTile &tile, NWEngine engine)
+{
+    if (engine == NW_ENGINE_STRIPED)
+    {
+        if (nwTileStriped<int16_t>(tile)) return false;
+        nwTileStriped<int32_t>(tile);
+    }
+    else
+    {
+        if (nwTileAntidiagonal<int16_t>(tile)) return false;
+        nwTileAntidiagonal<int32_t>(tile);
+    }
+
+    return true;
+}
+
+const char* getNWEngineName(NWEngine engine)
+{
+    return engine == NW_ENGINE_STRIPED ? "striped" : "antidiagonal";
+}
+
+// ****************************************************************************
+// Function: nwScoreRowSIMD
+//
+// Purpose:
+//   Computes the DP row lastRow with a SIMD engine, in tiles of NW_TILE_SIZE
+//   rows and columns. A tile needs the tiles above and left of it, so the
+//   tiles of an anti-diagonal of tiles are spread over the threads.
+//
+// Arguments:
+//   problem : the problem
+//   lastRow : the DP row to compute
+//   row : output - the dim+1 scores of the row
+//   engine : the SIMD engine of the tiles
+//   numThreads : the number of threads, 0 for all cores
+//
+// Returns:  the number of tiles computed with 32 bit lanes
+//
+// ****************************************************************************
+int nwScoreRowSIMD(const NWProblem &problem, int lastRow, int *row,
+                NWEngine engine, int numThreads)
+{
+    int dim = problem.dim;
+    int penalty = problem.penalty;
+
+    for (int j = 0; j <= dim; j++)
+        row[j] = -j * penalty;
+
+    if (lastRow < 1) return 0;
+
+    int tileRows = (lastRow + NW_TILE_SIZE - 1) / NW_TILE_SIZE;
+    int tileCols = (dim + NW_TILE_SIZE - 1) / NW_TILE_SIZE;
+
+    // the right column of the last tile of each tile row, starting with the
+    // first column of the matrix
+    vector<vector<int> > columns(tileRows, vector<int>(NW_TILE_SIZE + 1));
+    for (int t = 0; t < tileRows; t++)
+        for (int i = 0; i <= NW_TILE_SIZE; i++)
+            columns[t][i] = -(t * NW_TILE_SIZE + i) * penalty;
+
+    if (numThreads <= 0) numThreads = max(1u, thread::hardware_concurrency());
+
+    atomic<int> widened(0);
+
+    for (int wave = 0; wave < tileRows + tileCols - 1; wave++)
+    {
+        int first = max(0, wave - tileCols + 1);
+        int last = min(tileRows - 1, wave);
+        int numTiles = last - first + 1;
+
+        atomic<int> next(first);
+        vector<thread> threads;
+
+        for (int t = 0; t < min(numThreads, numTiles); t++)
+        {
+            threads.push_back(thread([&, wave, last]()
+            {
+                vector<int> top(NW_TILE_SIZE + 1), bottom(NW_TILE_SIZE + 1);
+                vector<int> right(NW_TILE_SIZE + 1);
+
+                for (int tr = next++; tr <= last; tr = next++)
+                {
+                    int tc = wave - tr;
+                    int firstRow = tr * NW_TILE_SIZE;
+                    int firstCol = tc * NW_TILE_SIZE;
+
+                    NWTile tile;
+                    tile.rows = min(NW_TILE_SIZE, lastRow - firstRow);
+                    tile.cols = min(NW_TILE_SIZE, dim - firstCol);
+                    tile.rowSequence = &problem.rowSequence[firstRow + 1];
+                    tile.colSequence = &problem.columnSequence[firstCol + 1];
+                    tile.penalty = penalty;
+
+                    // the row buffer holds the bottom row of the tile above,
+                    // the corner comes with the left column
+                    top[0] = columns[tr][0];
+                    copy(row + firstCol + 1, row + firstCol + tile.cols + 1, top.begin() + 1);
+
+                    tile.top = top.data();
+                    tile.left = columns[tr].data();
+                    tile.bottom = bottom.data();
+                    tile.right = right.data();
+
+                    if (nwTile(tile, engine)) widened++;
+
+                    copy(bottom.begin() + 1, bottom.begin() + tile.cols + 1, row + firstCol + 1);
+                    copy(right.begin(), right.begin() + tile.rows + 1, columns[tr].begin());
+                }
+            }));
+        }
+
+        for (thread &t : threads) t.join();
+    }
+
+    row[0] = -lastRow * penalty;
+
+    return widened;
+}
+
+// ****************************************************************************
+// Function: nwScorePairSIMD
+//
+// Purpose:
+//   Computes the global alignment score of two short sequences, e.g. of a
+//   batch, as one tile.
+//
+// Arguments:
+//   rowSequence : the residues of the rows
+//   rowLength : the number of rows
+//   colSequence : the residues of the columns
+//   colLength : the number of columns
+//   penalty : the linear gap penalty
+//   engine : the SIMD engine
+//
+// Returns:  the alignment score
+//
+// ****************************************************************************
+int nwScorePairSIMD(const int *rowSequence, int rowLength, const int *colSequence,
+                int colLength, int penalty, NWEngine engine)
+{
+    vector<int> top(colLength + 1), bottom(colLength + 1);
+    vector<int> left(rowLength + 1), right(rowLength + 1);
+
+    for (int j = 0; j <= colLength; j++) top[j] = -j * penalty;
+    for (int i = 0; i <= rowLength; i++) left[i] = -i * penalty;
+
+    NWTile tile = { rowLength, colLength, rowSequence, colSequence,
+                    top.data(), left.data(), penalty, bottom.data(), right.data() };
+
+    nwTile(tile, engine);
+
+    return bottom[colLength];
+}
@@ -0,0 +1,23 @@
+#ifndef NW_SIMD_H
+#define NW_SIMD_H
+
+#include "nwutility.h"
+
+// The DP matrix is computed in tiles of at most NW_TILE_SIZE x NW_TILE_SIZE
+// cells, the tiles of an anti-diagonal of tiles in parallel.
+#define NW_TILE_SIZE 512
+
+typedef enum {
+    NW_ENGINE_STRIPED,          // Farrar's striped query profile
+    NW_ENGINE_ANTIDIAGONAL      // anti-diagonal wavefront
+} NWEngine;
+
+const char* getNWEngineName(NWEngine engine);
+
+int nwScoreRowSIMD(const NWProblem &problem, int lastRow, int *row, 
+                NWEngine engine, int numThreads);
+
+int nwScorePairSIMD(const int *rowSequence, int rowLength, const int *colSequence, 
+                int colLength, int penalty, NWEngine engine);
+
+#endif
@@ -0,0 +1,257 @@
+#include <stdlib.h>
+#include <stdio.h>
+
+#include <vector>
+#include <algorithm>
+
+#include "nwtraceback.h"
+
+using namespace std;
+
+// The edit operations of an alignment, the codes of CIGAR: a pair of
+// residues, a residue of the row sequence against a gap, a residue of the
+// column sequence against a gap.
+#define NW_OP_MATCH 'M'
+#define NW_OP_DELETE 'D'
+#define NW_OP_INSERT 'I'
+
+// ****************************************************************************
+// Function: nwScoreLastRowCPU
+//
+// Purpose:
+//   Computes the DP rows of the global alignment of two sequences one after
+//   the other in linear space, like nwScoreRowCPU for any two subsequences.
+//
+// Arguments:
+//   rowSeq : the rows residues of the row sequence
+//   rows : the length of the row sequence
+//   colSeq : the cols residues of the column sequence
+//   cols : the length of the column sequence
+//   penalty : the linear gap penalty
+//   row : output - the cols+1 scores of the DP row rows
+//
+// Returns:  nothing
+//
+// ****************************************************************************
+void nwScoreLastRowCPU(const int *rowSeq, int rows, const int *colSeq, int cols,
+                        int penalty, int *row)
+{
+    for (int j = 0; j <= cols; j++)
+        row[j] = -j * penalty;
+
+    for (int i = 1; i <= rows; i++)
+    {
+        const int *scores = blosum62[rowSeq[i - 1]];
+        int diagonal = row[0];
+        row[0] = -i * penalty;
+
+        for (int j = 1; j <= cols; j++)
+        {
+            int score = maximum(diagonal + scores[colSeq[j - 1]],
+                                row[j - 1] - penalty,
+                                row[j] - penalty);
+            diagonal = row[j];
+            row[j] = score;
+        }
+    }
+}
+
+// Aligns a small subproblem with a full traceback matrix and appends its
+// operations. The traceback prefers a pair, then a deletion, then an
+// insertion.
+static void alignFull(const int *rowSeq, int rows, const int *colSeq, int cols,
+                        int penalty, vector<char> &ops)
+{
+    int stride = cols + 1;
+    vector<int> matrix((size_t)(rows + 1) * stride);
+
+    for (int j = 0; j <= cols; j++)
+        matrix[j] = -j * penalty;
+
+    for (int i = 1; i <= rows; i++)
+    {
+        const int *scores = blosum62[rowSeq[i - 1]];
+        matrix[(size_t)i * stride] = -i * penalty;
+
+        for (int j = 1; j <= cols; j++)
+        {
+            matrix[(size_t)i * stride + j] =
+                maximum(matrix[(size_t)(i - 1) * stride + j - 1] + scores[colSeq[j - 1]],
+                        matrix[(size_t)i * stride + j - 1] - penalty,
+                        matrix[(size_t)(i - 1) * stride + j] - penalty);
+        }
+    }
+
+    size_t first = ops.size();
+    int i = rows, j = cols;
+
+    while (i > 0 || j > 0)
+    {
+        int score = matrix[(size_t)i * stride + j];
+
+        if (i > 0 && j > 0 && score == matrix[(size_t)(i - 1) * stride + j - 1]
+                                + blosum62[rowSeq[i - 1]][colSeq[j - 1]])
+        {
+            ops.push_back(NW_OP_MATCH);
+            i--;
+            j--;
+        }
+        else if (i > 0 && score == matrix[(size_t)(i - 1) * stride + j] - penalty)
+        {
+            ops.push_back(NW_OP_DELETE);
+            i--;
+        }
+        else
+        {
+            ops.push_back(NW_OP_INSERT);
+            j--;
+        }
+    }
+
+    reverse(ops.begin() + first, ops.end());
+}
+
+// Aligns rowSeq and colSeq by splitting the row sequence in the middle at
+// the column where the forward and the reverse scores add up to the best
+// score, and appends the operations.
+static void hirschberg(const int *rowSeq, int rows, const int *colSeq, int cols,
+                        int penalty, const NWRowScorer &scorer, vector<char> &ops,
+                        long long &cells)
+{
+    if (rows == 0 || cols == 0)
+    {
+        ops.insert(ops.end(), rows, NW_OP_DELETE);
+        ops.insert(ops.end(), cols, NW_OP_INSERT);
+        return;
+    }
+
+    if (rows == 1 || (long long)rows * cols <= NW_HIRSCHBERG_BASE_CELLS)
+    {
+        alignFull(rowSeq, rows, colSeq, cols, penalty, ops);
+        cells += (long long)rows * cols;
+        return;
+    }
+
+    int mid = rows / 2;
+
+    vector<int> forward(cols + 1), backward(cols + 1);
+    scorer(rowSeq, mid, colSeq, cols, forward.data());
+
+    vector<int> reverseRows(rowSeq + mid, rowSeq + rows);
+    vector<int> reverseCols(colSeq, colSeq + cols);
+    reverse(reverseRows.begin(), reverseRows.end());
+    reverse(reverseCols.begin(), reverseCols.end());
+    scorer(reverseRows.data(), rows - mid, reverseCols.data(), cols, backward.data());
+
+    cells += (long long)rows * cols;
+
+    int split = 0;
+    for (int k = 1; k <= cols; k++)
+    {
+        if (forward[k] + backward[cols - k] > forward[split] + backward[cols - split])
+            split = k;
+    }
+
+    hirschberg(rowSeq, mid, colSeq, split, penalty, scorer, ops, cells);
+    hirschberg(rowSeq + mid, rows - mid, colSeq + split, cols - split, penalty, scorer, ops, cells);
+}
+
+// ****************************************************************************
+// Function: nwHirschbergAlign
+//
+// Purpose:
+//   Computes an optimal global alignment of the sequences of the problem in
+//   linear space (Hirschberg): the rows are split in the middle at the column
+//   where the forward scores of the upper half and the reverse scores of the
+//   lower half add up to the best score, and both halves are aligned the
+//   same way, until the subproblems are small enough for a full traceback.
+//   The score rows are computed by the scorer, on the host or the device.
+//
+// Arguments:
+//   problem : the problem
+//   scorer : computes the last score row of a subproblem
+//   cells : output - the number of cells computed by the scorer and the
+//           full tracebacks
+//
+// Returns:  the alignment as CIGAR, runs of M (residue pairs), D (residues of
+//           the row sequence against gaps) and I (residues of the column
+//           sequence against gaps)
+//
+// ****************************************************************************
+string nwHirschbergAlign(const NWProblem &problem, const NWRowScorer &scorer,
+                        long long &cells)
+{
+    vector<char> ops;
+    cells = 0;
+
+    hirschberg(&problem.rowSequence[1], problem.dim, &problem.columnSequence[1], problem.dim,
+               problem.penalty, scorer, ops, cells);
+
+    string cigar;
+    char run[32];
+
+    for (size_t start = 0, end; start < ops.size(); start = end)
+    {
+        for (end = start; end < ops.size() && ops[end] == ops[start]; end++);
+
+        sprintf(run, "%d%c", (int)(end - start), ops[start]);
+        cigar += run;
+    }
+
+    return cigar;
+}
+
+// ****************************************************************************
+// Function: nwScoreCigar
+//
+// Purpose:
+//   Scores an alignment of the sequences of the problem.
+//
+// Arguments:
+//   problem : the problem
+//   cigar : the alignment
+//   score : output - the score of the alignment
+//
+// Returns:  false if the alignment does not cover both sequences exactly
+//
+// ****************************************************************************
+bool nwScoreCigar(const NWProblem &problem, const string &cigar, int &score)
+{
+    int i = 0, j = 0;
+    score = 0;
+
+    for (size_t p = 0; p < cigar.size(); p++)
+    {
+        char *end;
+        long length = strtol(cigar.c_str() + p, &end, 10);
+        p = end - cigar.c_str();
+
+        if (length < 1 || p >= cigar.size())
+            return false;
+
+        for (long k = 0; k < length; k++)
+        {
+            switch (cigar[p])
+            {
+                case NW_OP_MATCH:
+                    i++;
+                    j++;
+                    if (i > problem.dim || j > problem.dim) return false;
+                    score += blosum62[problem.rowSequence[i]][problem.columnSequence[j]];
+                    break;
+                case NW_OP_DELETE:
+                    i++;
+                    score -= problem.penalty;
+                    break;
+                case NW_OP_INSERT:
+                    j++;
+                    score -= problem.penalty;
+                    break;
+                default:
+                    return false;
+            }
+        }
+    }
+
+    return i == problem.dim && j == problem.dim;
+}
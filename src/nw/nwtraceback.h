@@ -0,0 +1,27 @@
+#ifndef NW_TRACEBACK_H
+#define NW_TRACEBACK_H
+
+#include <string>
+#include <functional>
+
+#include "nwutility.h"
+
+// The subproblems of at most this many cells (or of one row) are aligned on
+// the host with a full traceback matrix, the larger ones are split.
+#define NW_HIRSCHBERG_BASE_CELLS (1 << 16)
+
+// Computes the last row of the global alignment of rowSeq[0, rows) and
+// colSeq[0, cols), the cols+1 scores of the DP row rows, with the linear gap
+// penalty. Hirschberg calls it for the forward and the reverse halves.
+typedef std::function<void(const int *rowSeq, int rows, const int *colSeq, int cols,
+                        int *row)> NWRowScorer;
+
+void nwScoreLastRowCPU(const int *rowSeq, int rows, const int *colSeq, int cols,
+                        int penalty, int *row);
+
+std::string nwHirschbergAlign(const NWProblem &problem, const NWRowScorer &scorer,
+                        long long &cells);
+
+bool nwScoreCigar(const NWProblem &problem, const std::string &cigar, int &score);
+
+#endif
@@ -0,0 +1,246 @@
+/** @file nwtracebackhost.cpp */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <iostream>
+#include <vector>
+#include <algorithm>
+
+#include "../common/utility.h"
+
+#include "nwhost.h"
+
+using namespace std;
+
+#include "CL/cl_ext_intelfpga.h"
+
+#define AOCL_ALIGNMENT 64
+
+// ****************************************************************************
+// Function: initNWRowScorerFPGA
+//
+// Purpose:
+//   Allocates the device and host memory of the row scorer: two reference
+//   strips, one data strip and the first column of the largest subproblem.
+//
+// Arguments:
+//   scorer : output - the row scorer
+//   ctx: the opencl context to use for the benchmark
+//   queue: the opencl command queue to issue commands to
+//   prog: the opencl program containing the nw kernel
+//   maxDim : the largest dim of a subproblem
+//   penalty : the linear gap penalty
+//
+// Returns:  nothing
+//
+// ****************************************************************************
+void initNWRowScorerFPGA(NWRowScorerFPGA &scorer,
+                             cl_context ctx,
+                             cl_command_queue queue,
+                             cl_program prog,
+                             int maxDim,
+                             int penalty)
+{
+    int err;
+    size_t strip_size = (size_t)BSIZE * maxDim * sizeof(int);
+
+    scorer.queue = queue;
+    scorer.maxDim = maxDim;
+    scorer.penalty = penalty;
+    scorer.launches = 0;
+
+    scorer.kernel = clCreateKernel(prog, "nw", &err);
+    CL_CHECK_ERROR(err);
+
+    for (int s = 0; s < 2; s++)
+    {
+        scorer.reference_d[s] = clCreateBuffer(ctx, CL_MEM_READ_ONLY | CL_CHANNEL_1_INTELFPGA, strip_size, NULL, &err);
+        CL_CHECK_ERROR(err);
+
+        void *ptr = NULL;
+        if (posix_memalign(&ptr, AOCL_ALIGNMENT, strip_size))
+        {
+            fprintf(stderr, "Aligned Malloc failed due to insufficient memory.\n");
+            exit(-1);
+        }
+        scorer.strip[s] = (int *)ptr;
+    }
+
+    scorer.data_d = clCreateBuffer(ctx, CL_MEM_READ_WRITE | CL_CHANNEL_2_INTELFPGA, strip_size, NULL, &err);
+    CL_CHECK_ERROR(err);
+
+    // the first column is the same for all subproblems
+    vector<int> input_v(maxDim + 1);
+    for (int i = 0; i <= maxDim; i++)
+    {
+        input_v[i] = -i * penalty;
+    }
+
+    scorer.input_v_d = clCreateBuffer(ctx, CL_MEM_READ_ONLY | CL_CHANNEL_1_INTELFPGA, (maxDim + 1) * sizeof(int), NULL, &err);
+    CL_CHECK_ERROR(err);
+
+    err = clEnqueueWriteBuffer(queue, scorer.input_v_d, 1, 0, (maxDim + 1) * sizeof(int), input_v.data(), 0, NULL, NULL);
+    CL_CHECK_ERROR(err);
+}
+
+// ****************************************************************************
+// Function: scoreNWLastRowFPGA
+//
+// Purpose:
+//   Computes the last score row of a Hirschberg subproblem with the nw
+//   kernel. The subproblem is padded to the square of dim = max(rows + 2,
+//   cols + 1), the kernel computing the rows up to dim - 2 and the columns
+//   up to dim - 1, and only the strips up to the row rows are computed. The
+//   next strip is generated while the kernel computes the current one.
+//
+// Arguments:
+//   scorer : the row scorer
+//   rowSeq : the rows residues of the row sequence
+//   rows : the length of the row sequence, at least 1
+//   colSeq : the cols residues of the column sequence
+//   cols : the length of the column sequence
+//   row : output - the cols+1 scores of the DP row rows
+//
+// Returns:  nothing
+//
+// ****************************************************************************
+void scoreNWLastRowFPGA(NWRowScorerFPGA &scorer, const int *rowSeq, int rows,
+                             const int *colSeq, int cols, int *row)
+{
+    int err;
+    int penalty = scorer.penalty;
+    int dim = max(rows + 2, cols + 1);
+
+    if (dim > scorer.maxDim)
+    {
+        cout << "ERROR: the subproblem of " << rows << " x " << cols
+             << " is larger than the row scorer" << endl;
+        exit(-1);
+    }
+
+    // the padding residues only change the scores beyond the subproblem
+    NWProblem problem;
+    problem.dim = dim;
+    problem.penalty = penalty;
+    problem.rowSequence.assign(dim + 1, 0);
+    problem.columnSequence.assign(dim + 1, 0);
+    copy(rowSeq, rowSeq + rows, problem.rowSequence.begin() + 1);
+    copy(colSeq, colSeq + cols, problem.columnSequence.begin() + 1);
+
+    vector<int> first_row(dim);
+    for (int c = 0; c < dim; c++)
+    {
+        first_row[c] = -(c + 1) * penalty;
+    }
+
+    err = clEnqueueWriteBuffer(scorer.queue, scorer.data_d, 0, 0, dim * sizeof(int), first_row.data(), 0, NULL, NULL);
+    CL_CHECK_ERROR(err);
+
+    int loop_cols = dim - 1 + PAR;
+    int exit_col = (loop_cols % PAR == 0) ? loop_cols : loop_cols + PAR - (loop_cols % PAR);
+    int loop_exit = exit_col * (BSIZE / PAR);
+
+    err = clSetKernelArg(scorer.kernel, 1, sizeof(void *), (void*) &scorer.data_d);
+    CL_CHECK_ERROR(err);
+    err = clSetKernelArg(scorer.kernel, 2, sizeof(void *), (void*) &scorer.input_v_d);
+    CL_CHECK_ERROR(err);
+    err = clSetKernelArg(scorer.kernel, 3, sizeof(cl_int), (void*) &dim);
+    CL_CHECK_ERROR(err);
+    err = clSetKernelArg(scorer.kernel, 4, sizeof(cl_int), (void*) &penalty);
+    CL_CHECK_ERROR(err);
+    err = clSetKernelArg(scorer.kernel, 5, sizeof(cl_int), (void*) &loop_exit);
+    CL_CHECK_ERROR(err);
+
+    int comp_bsize = BSIZE - 1;
+    int last_block = (rows - 1) / comp_bsize;
+    size_t strip_size = (size_t)BSIZE * dim * sizeof(int);
+
+    cl_event upload_event[2] = { NULL, NULL };
+
+    for (int bx = 0; bx <= last_block; bx++)
+    {
+        int block_offset = bx * comp_bsize;
+        int s = bx % 2;
+
+        // the staging strip is free once its last upload is done
+        if (upload_event[s] != NULL)
+        {
+            err = clWaitForEvents(1, &upload_event[s]);
+            CL_CHECK_ERROR(err);
+            clReleaseEvent(upload_event[s]);
+        }
+
+        fillNWReferenceStrip(problem, block_offset, BSIZE, scorer.strip[s]);
+
+        err = clEnqueueWriteBuffer(scorer.queue, scorer.reference_d[s], 0, 0, strip_size, scorer.strip[s], 0, NULL, &upload_event[s]);
+        CL_CHECK_ERROR(err);
+
+        err = clSetKernelArg(scorer.kernel, 0, sizeof(void *), (void*) &scorer.reference_d[s]);
+        CL_CHECK_ERROR(err);
+        err = clSetKernelArg(scorer.kernel, 6, sizeof(cl_int), (void*) &block_offset);
+        CL_CHECK_ERROR(err);
+
+        err = clEnqueueTask(scorer.queue, scorer.kernel, 0, NULL, NULL);
+        CL_CHECK_ERROR(err);
+
+        scorer.launches++;
+
+        if (bx == last_block)
+        {
+            err = clEnqueueReadBuffer(scorer.queue, scorer.data_d, 0, (size_t)(rows - block_offset) * dim * sizeof(int), cols * sizeof(int), row + 1, 0, NULL, NULL);
+            CL_CHECK_ERROR(err);
+        }
+        else
+        {
+            // the last row of this block is the first row of the next one
+            err = clEnqueueCopyBuffer(scorer.queue, scorer.data_d, scorer.data_d, (size_t)comp_bsize * dim * sizeof(int), 0, dim * sizeof(int), 0, NULL, NULL);
+            CL_CHECK_ERROR(err);
+        }
+
+        err = clFlush(scorer.queue);
+        CL_CHECK_ERROR(err);
+    }
+
+    err = clFinish(scorer.queue);
+    CL_CHECK_ERROR(err);
+
+    for (int s = 0; s < 2; s++)
+    {
+        if (upload_event[s] != NULL)
+            clReleaseEvent(upload_event[s]);
+    }
+
+    row[0] = -rows * penalty;
+}
+
+// ****************************************************************************
+// Function: releaseNWRowScorerFPGA
+//
+// Purpose:
+//   Frees the device and host memory of the row scorer.
+//
+// Arguments:
+//   scorer : the row scorer
+//
+// Returns:  nothing
+//
+// ****************************************************************************
+void releaseNWRowScorerFPGA(NWRowScorerFPGA &scorer)
+{
+    int err;
+
+    for (int s = 0; s < 2; s++)
+    {
+        err = clReleaseMemObject(scorer.reference_d[s]);
+        CL_CHECK_ERROR(err);
+        free(scorer.strip[s]);
+    }
+
+    err = clReleaseMemObject(scorer.data_d);
+    CL_CHECK_ERROR(err);
+    err = clReleaseMemObject(scorer.input_v_d);
+    CL_CHECK_ERROR(err);
+    err = clReleaseKernel(scorer.kernel);
+    CL_CHECK_ERROR(err);
+}
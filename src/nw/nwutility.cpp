@@ -0,0 +1,404 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include <iostream>
+#include <vector>
+#include <algorithm>
+
+#include "nwutility.h"
+
+using namespace std;
+
+int blosum62[24][24] = {
+{ 4, -1, -2, -2,  0, -1, -1,  0, -2, -1, -1, -1, -1, -2, -1,  1,  0, -3, -2,  0, -2, -1,  0, -4},
+{-1,  5,  0, -2, -3,  1,  0, -2,  0, -3, -2,  2, -1, -3, -2, -1, -1, -3, -2, -3, -1,  0, -1, -4},
+{-2,  0,  6,  1, -3,  0,  0,  0,  1, -3, -3,  0, -2, -3, -2,  1,  0, -4, -2, -3,  3,  0, -1, -4},
+{-2, -2,  1,  6, -3,  0,  2, -1, -1, -3, -4, -1, -3, -3, -1,  0, -1, -4, -3, -3,  4,  1, -1, -4},
+{ 0, -3, -3, -3,  9, -3, -4, -3, -3, -1, -1, -3, -1, -2, -3, -1, -1, -2, -2, -1, -3, -3, -2, -4},
+{-1,  1,  0,  0, -3,  5,  2, -2,  0, -3, -2,  1,  0, -3, -1,  0, -1, -2, -1, -2,  0,  3, -1, -4},
+{-1,  0,  0,  2, -4,  2,  5, -2,  0, -3, -3,  1, -2, -3, -1,  0, -1, -3, -2, -2,  1,  4, -1, -4},
+{ 0, -2,  0, -1, -3, -2, -2,  6, -2, -4, -4, -2, -3, -3, -2,  0, -2, -2, -3, -3, -1, -2, -1, -4},
+{-2,  0,  1, -1, -3,  0,  0, -2,  8, -3, -3, -1, -2, -1, -2, -1, -2, -2,  2, -3,  0,  0, -1, -4},
+{-1, -3, -3, -3, -1, -3, -3, -4, -3,  4,  2, -3,  1,  0, -3, -2, -1, -3, -1,  3, -3, -3, -1, -4},
+{-1, -2, -3, -4, -1, -2, -3, -4, -3,  2,  4, -2,  2,  0, -3, -2, -1, -2, -1,  1, -4, -3, -1, -4},
+{-1,  2,  0, -1, -3,  1,  1, -2, -1, -3, -2,  5, -1, -3, -1,  0, -1, -3, -2, -2,  0,  1, -1, -4},
+{-1, -1, -2, -3, -1,  0, -2, -3, -2,  1,  2, -1,  5,  0, -2, -1, -1, -1, -1,  1, -3, -1, -1, -4},
+{-2, -3, -3, -3, -2, -3, -3, -3, -1,  0,  0, -3,  0,  6, -4, -2, -2,  1,  3, -1, -3, -3, -1, -4},
+{-1, -2, -2, -1, -3, -1, -1, -2, -2, -3, -3, -1, -2, -4,  7, -1, -1, -4, -3, -2, -2, -1, -2, -4},
+{ 1, -1,  1,  0, -1,  0,  0,  0, -1, -2, -2,  0, -1, -2, -1,  4,  1, -3, -2, -2,  0,  0,  0, -4},
+{ 0, -1,  0, -1, -1, -1, -1, -2, -2, -1, -1, -1, -1, -2, -1,  1,  5, -2, -2,  0, -1, -1,  0, -4},
+{-3, -3, -4, -4, -2, -2, -3, -2, -2, -3, -2, -3, -1,  1, -4, -3, -2, 11,  2, -3, -4, -3, -2, -4},
+{-2, -2, -2, -3, -2, -1, -2, -3,  2, -1, -1, -2, -1,  3, -3, -2, -2,  2,  7, -1, -3, -2, -1, -4},
+{ 0, -3, -3, -3, -1, -2, -2, -3, -3,  3,  1, -2,  1, -1, -2, -2,  0, -3, -1,  4, -3, -2, -1, -4},
+{-2, -1,  3,  4, -3,  0,  1, -1,  0, -3, -4,  0, -3, -3, -2,  0, -1, -4, -3, -3,  4,  1, -1, -4},
+{-1,  0,  0,  1, -3,  3,  4, -2,  0, -3, -3,  1, -1, -3, -1,  0, -1, -3, -2, -2,  1,  4, -1, -4},
+{ 0, -1, -1, -1, -2, -1, -1, -1, -1, -1, -1, -1, -1, -1, -2,  0,  0, -2, -1, -1, -1, -1, -1, -4},
+{-4, -4, -4, -4, -4, -4, -4, -4, -4, -4, -4, -4, -4, -4, -4, -4, -4, -4, -4, -4, -4, -4, -4,  1}
+};
+
+int maximum(int a, int b, int c)
+{
+	int k;
+	if(a <= b)
+		k = b;
+	else
+		k = a;
+
+	if(k <= c)
+		return(c);
+	else
+		return(k);
+}
+
+// ****************************************************************************
+// Function: makeNWProblem
+//
+// Purpose:
+//   Generates the two random sequences of a problem, the row sequence first,
+//   in the order of the original dense initialization (srand(7)).
+//
+// Arguments:
+//   problem : output - the problem
+//   dim : the number of residues per sequence
+//   penalty : the linear gap penalty
+//
+// Returns:  nothing
+//
+// ****************************************************************************
+void makeNWProblem(NWProblem &problem, int dim, int penalty)
+{
+    problem.dim = dim;
+    problem.penalty = penalty;
+    problem.rowSequence.assign(dim + 1, 0);
+    problem.columnSequence.assign(dim + 1, 0);
+
+    srand(7);
+
+    for (int i = 1; i <= dim; i++)
+        problem.rowSequence[i] = rand() % NW_RANDOM_RESIDUES + 1;
+
+    for (int j = 1; j <= dim; j++)
+        problem.columnSequence[j] = rand() % NW_RANDOM_RESIDUES + 1;
+}
+
+// ****************************************************************************
+// Function: fillNWReferenceStrip
+//
+// Purpose:
+//   Generates the substitution scores of the rows [firstRow, firstRow +
+//   numRows) in the device layout: dim scores per row, column c holding the
+//   score of DP column c+1. Row 0 and the rows beyond dim are zero.
+//
+// Arguments:
+//   problem : the problem
+//   firstRow : the first DP row of the strip
+//   numRows : the number of rows of the strip
+//   strip : output - numRows * dim scores
+//
+// Returns:  nothing
+//
+// ****************************************************************************
+void fillNWReferenceStrip(const NWProblem &problem, int firstRow, int numRows, 
+                        int *strip)
+{
+    int dim = problem.dim;
+
+    for (int r = 0; r < numRows; r++)
+    {
+        int i = firstRow + r;
+        int *row = strip + (size_t)r * dim;
+
+        if (i < 1 || i > dim)
+        {
+            memset(row, 0, dim * sizeof(int));
+            continue;
+        }
+
+        const int *scores = blosum62[problem.rowSequence[i]];
+
+        for (int c = 0; c < dim; c++)
+            row[c] = scores[problem.columnSequence[c + 1]];
+    }
+}
+
+// ****************************************************************************
+// Function: nwScoreRowCPU
+//
+// Purpose:
+//   Computes the DP rows 0 to lastRow one after the other, keeping only the
+//   previous row, so that any size is checked in linear space.
+//
+// Arguments:
+//   problem : the problem
+//   lastRow : the DP row to compute
+//   row : output - the dim+1 scores of the row
+//
+// Returns:  nothing
+//
+// ****************************************************************************
+void nwScoreRowCPU(const NWProblem &problem, int lastRow, int *row)
+{
+    int dim = problem.dim;
+    int penalty = problem.penalty;
+
+    vector<int> previous(dim + 1);
+
+    for (int j = 0; j <= dim; j++)
+        row[j] = -j * penalty;
+
+    for (int i = 1; i <= lastRow; i++)
+    {
+        previous.assign(row, row + dim + 1);
+
+        const int *scores = blosum62[problem.rowSequence[i]];
+        row[0] = -i * penalty;
+
+        for (int j = 1; j <= dim; j++)
+        {
+            row[j] = maximum(previous[j - 1] + scores[problem.columnSequence[j]],
+                             row[j - 1] - penalty,
+                             previous[j] - penalty);
+        }
+    }
+}
+
+// ****************************************************************************
+// Function: nwScoreBoundaryCPU
+//
+// Purpose:
+//   Computes the DP rows 1 to lastRow in linear space like nwScoreRowCPU and
+//   keeps the last column and the checksums of the nw_score kernel: the
+//   wrapping sum of the scores of the columns 1 to lastCol of each strip of
+//   stripRows rows, the first strip starting at row 1.
+//
+// Arguments:
+//   problem : the problem
+//   lastRow : the last DP row
+//   lastCol : the last DP column
+//   stripRows : the number of rows per strip
+//   column : output - the lastRow+1 scores of the column lastCol
+//   checksums : output - the (lastRow + stripRows - 1) / stripRows checksums
+//
+// Returns:  nothing
+//
+// ****************************************************************************
+void nwScoreBoundaryCPU(const NWProblem &problem, int lastRow, int lastCol, 
+                        int stripRows, int *column, unsigned int *checksums)
+{
+    int dim = problem.dim;
+    int penalty = problem.penalty;
+
+    vector<int> previous(dim + 1), row(dim + 1);
+
+    for (int j = 0; j <= dim; j++)
+        row[j] = -j * penalty;
+
+    column[0] = row[lastCol];
+
+    for (int s = 0; s < (lastRow + stripRows - 1) / stripRows; s++)
+        checksums[s] = 0;
+
+    for (int i = 1; i <= lastRow; i++)
+    {
+        previous.swap(row);
+
+        const int *scores = blosum62[problem.rowSequence[i]];
+        unsigned int sum = 0;
+        row[0] = -i * penalty;
+
+        for (int j = 1; j <= dim; j++)
+        {
+            row[j] = maximum(previous[j - 1] + scores[problem.columnSequence[j]],
+                             row[j - 1] - penalty,
+                             previous[j] - penalty);
+
+            if (j <= lastCol)
+                sum += row[j];
+        }
+
+        column[i] = row[lastCol];
+        checksums[(i - 1) / stripRows] += sum;
+    }
+}
+
+// ****************************************************************************
+// Function: parseNWOutput
+//
+// Purpose:
+//   Checks the --nw-output option.
+//
+// Arguments:
+//   name : "strip", "score" or "checksum"
+//   output : output - the output
+//
+// Returns:  false (with an error message) if the name is unknown
+//
+// ****************************************************************************
+bool parseNWOutput(const char *name, NWOutput &output)
+{
+    for (int o = NW_OUTPUT_STRIP; o <= NW_OUTPUT_CHECKSUM; o++)
+    {
+        if (strcmp(name, getNWOutputName((NWOutput)o)) == 0)
+        {
+            output = (NWOutput)o;
+            return true;
+        }
+    }
+
+    cout << "ERROR: invalid --nw-output " << name << ", expected strip, score or checksum" << endl;
+    return false;
+}
+
+const char* getNWOutputName(NWOutput output)
+{
+    switch (output)
+    {
+        case NW_OUTPUT_SCORE: return "score";
+        case NW_OUTPUT_CHECKSUM: return "checksum";
+        default: return "strip";
+    }
+}
+
+// ****************************************************************************
+// Function: parseNWScoring
+//
+// Purpose:
+//   Checks the --nw-mode, --gap-open and --gap-extend options and turns them
+//   into the scoring of the affine gap recurrence.
+//
+// Arguments:
+//   mode : "global" or "local"
+//   gapOpen : the cost of the first residue of a gap
+//   gapExtend : the cost of every further residue of a gap
+//   scoring : output - the scoring
+//
+// Returns:  false (with an error message) if the options are invalid
+//
+// ****************************************************************************
+bool parseNWScoring(const char *mode, int gapOpen, int gapExtend, NWScoring &scoring)
+{
+    if (strcmp(mode, NW_MODE_GLOBAL) == 0)
+        scoring.local = false;
+    else if (strcmp(mode, NW_MODE_LOCAL) == 0)
+        scoring.local = true;
+    else
+    {
+        cout << "ERROR: invalid --nw-mode " << mode << ", expected " 
+             << NW_MODE_GLOBAL << " or " << NW_MODE_LOCAL << endl;
+        return false;
+    }
+
+    if (gapOpen < 0 || gapExtend < 0)
+    {
+        cout << "ERROR: invalid gap costs " << gapOpen << "/" << gapExtend 
+             << ", expected --gap-open and --gap-extend >= 0" << endl;
+        return false;
+    }
+
+    scoring.gapOpen = gapOpen;
+    scoring.gapExtend = gapExtend;
+    return true;
+}
+
+// ****************************************************************************
+// Function: isNWLinearScoring
+//
+// Purpose:
+//   Tells whether the scoring is the global alignment with the linear gap
+//   penalty that the nw kernel computes.
+//
+// Arguments:
+//   scoring : the scoring
+//   penalty : the linear gap penalty
+//
+// Returns:  true if the nw kernel computes the scoring
+//
+// ****************************************************************************
+bool isNWLinearScoring(const NWScoring &scoring, int penalty)
+{
+    return !scoring.local && scoring.gapOpen == penalty && scoring.gapExtend == penalty;
+}
+
+// ****************************************************************************
+// Function: getNWGapCost
+//
+// Purpose:
+//   The cost of a gap of length residues.
+//
+// Arguments:
+//   scoring : the scoring
+//   length : the length of the gap
+//
+// Returns:  the cost, 0 for an empty gap
+//
+// ****************************************************************************
+int getNWGapCost(const NWScoring &scoring, int length)
+{
+    return (length > 0) ? scoring.gapOpen + (length - 1) * scoring.gapExtend : 0;
+}
+
+// ****************************************************************************
+// Function: nwAffineRowCPU
+//
+// Purpose:
+//   Computes the affine gap (Gotoh) recurrence over the rows 0 to lastRow in
+//   linear space. H is the best score of a cell, E the best one ending in a
+//   gap in the row sequence (coming from the left) and F the best one ending
+//   in a gap in the column sequence (coming from above):
+//     E[i][j] = max(H[i][j-1] - gapOpen, E[i][j-1] - gapExtend)
+//     F[i][j] = max(H[i-1][j] - gapOpen, F[i-1][j] - gapExtend)
+//     H[i][j] = max(H[i-1][j-1] + s(i, j), E[i][j], F[i][j] [, 0 if local])
+//   The first row and column are the gap costs for a global alignment and 0
+//   for a local one.
+//
+// Arguments:
+//   problem : the problem, its penalty is not used
+//   scoring : the scoring
+//   lastRow : the DP row to compute
+//   lastCol : the last DP column taken into account for the best score
+//   row : output - the dim+1 scores H of the row
+//
+// Returns:  the best score of the rows 1 to lastRow and the columns 1 to
+//           lastCol for a local alignment, row[lastCol] for a global one
+//
+// ****************************************************************************
+int nwAffineRowCPU(const NWProblem &problem, const NWScoring &scoring, 
+                        int lastRow, int lastCol, int *row)
+{
+    int dim = problem.dim;
+    int open = scoring.gapOpen;
+    int extend = scoring.gapExtend;
+    int best = 0;
+
+    vector<int> f(dim + 1, NW_NEG_INF);
+
+    for (int j = 0; j <= dim; j++)
+        row[j] = scoring.local ? 0 : -getNWGapCost(scoring, j);
+
+    for (int i = 1; i <= lastRow; i++)
+    {
+        const int *scores = blosum62[problem.rowSequence[i]];
+
+        int diagonal = row[0];
+        int e = NW_NEG_INF;
+        row[0] = scoring.local ? 0 : -getNWGapCost(scoring, i);
+
+        for (int j = 1; j <= dim; j++)
+        {
+            e = max(row[j - 1] - open, e - extend);
+            f[j] = max(row[j] - open, f[j] - extend);
+
+            int h = maximum(diagonal + scores[problem.columnSequence[j]], e, f[j]);
+            if (scoring.local && h < 0)
+                h = 0;
+
+            diagonal = row[j];
+            row[j] = h;
+
+            if (j <= lastCol && h > best)
+                best = h;
+        }
+    }
+
+    return scoring.local ? best : row[lastCol];
+}
@@ -0,0 +1,68 @@
+#ifndef NW_UTILITY_H
+#define NW_UTILITY_H
+
+#include <vector>
+
+#define NW_DEFAULT_PENALTY 10
+
+// Below any score, far enough from INT_MIN that subtracting a gap cost does not
+// wrap around (the NEG_INF of nw_affine.cl).
+#define NW_NEG_INF (-(1 << 28))
+
+#define NW_MODE_GLOBAL "global"
+#define NW_MODE_LOCAL "local"
+
+// What the nw kernels write: the strips of scores (nw), or the last row and
+// column only (nw_score), checked by their checksums per strip or not.
+enum NWOutput {NW_OUTPUT_STRIP, NW_OUTPUT_SCORE, NW_OUTPUT_CHECKSUM};
+
+// The generated residues are the codes 1 to NW_RANDOM_RESIDUES.
+#define NW_RANDOM_RESIDUES 10
+
+extern int blosum62[24][24];
+
+// A global alignment problem of two sequences of dim residues each. DP row i
+// aligns rowSequence[i] and DP column j columnSequence[j] (1 <= i,j <= dim,
+// index 0 is unused).
+typedef struct {
+    int dim;
+    int penalty;
+    std::vector<int> rowSequence;
+    std::vector<int> columnSequence;
+} NWProblem;
+
+// The scoring of the affine gap (Gotoh) recurrence: a gap of length k costs
+// gapOpen + (k - 1) * gapExtend, so gapOpen == gapExtend is the linear penalty
+// of NWProblem. A local alignment (Smith-Waterman) clamps the scores at 0.
+typedef struct {
+    bool local;
+    int gapOpen;
+    int gapExtend;
+} NWScoring;
+
+int maximum(int a, int b, int c);
+
+void makeNWProblem(NWProblem &problem, int dim, int penalty);
+
+void fillNWReferenceStrip(const NWProblem &problem, int firstRow, int numRows, 
+                        int *strip);
+
+void nwScoreRowCPU(const NWProblem &problem, int lastRow, int *row);
+
+void nwScoreBoundaryCPU(const NWProblem &problem, int lastRow, int lastCol, 
+                        int stripRows, int *column, unsigned int *checksums);
+
+bool parseNWOutput(const char *name, NWOutput &output);
+
+const char* getNWOutputName(NWOutput output);
+
+bool parseNWScoring(const char *mode, int gapOpen, int gapExtend, NWScoring &scoring);
+
+bool isNWLinearScoring(const NWScoring &scoring, int penalty);
+
+int getNWGapCost(const NWScoring &scoring, int length);
+
+int nwAffineRowCPU(const NWProblem &problem, const NWScoring &scoring, 
+                        int lastRow, int lastCol, int *row);
+
+#endif
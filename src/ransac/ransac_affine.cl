@@ -0,0 +1,386 @@
+/** @file ransac_affine.cl
+*/
+
+/*
+ * Copyright (c) 2016 University of Cordoba and University of Illinois
+ * All rights reserved.
+ *
+ * Developed by:    IMPACT Research Group
+ *                  University of Cordoba and University of Illinois
+ *                  http://impact.crhc.illinois.edu/
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * with the Software without restriction, including without limitation the 
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ *      > Redistributions of source code must retain the above copyright notice,
+ *        this list of conditions and the following disclaimers.
+ *      > Redistributions in binary form must reproduce the above copyright
+ *        notice, this list of conditions and the following disclaimers in the
+ *        documentation and/or other materials provided with the distribution.
+ *      > Neither the names of IMPACT Research Group, University of Cordoba, 
+ *        University of Illinois nor the names of its contributors may be used 
+ *        to endorse or promote products derived from this Software without 
+ *        specific prior written permission.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+ * CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS WITH
+ * THE SOFTWARE.
+ *
+ * Modifiers:       Jennifer Faj
+ * Modifications:   + Changed Code to single work-item kernels
+ *                  + Split RANSAC stages into multiple kernels
+ *                  + Optimized the code for FPGA
+ *                  + Added tunable parameters for scalability
+ *
+ * Date:            2020/06/21
+ *
+ */
+
+/*
+ * Affine variant: the model kernel solves the affine transformation
+ * mapping the tails (x, y) of SAMPLES sampled flowvectors to their heads
+ * (vx, vy), a flowvector is an inlier if its head lies within
+ * errorThreshold (Euclidean distance) of its mapped tail.
+ */
+
+#define BR  4       // Burst Read
+
+// The flowvectors sampled per hypothesis
+#define SAMPLES 3
+
+typedef struct {
+    int x;
+    int y;
+    int vx;
+    int vy;
+} flowvector;
+
+typedef struct {
+    flowvector fv[4];
+} flowvector4;
+
+typedef struct {
+    flowvector fv[PO];
+} flowvectorN;
+
+typedef struct {
+    float h[6];
+} m_parameters;
+
+typedef struct {
+    uint eT;    // error Threshold
+    uint nF;    // num Flowvectors
+    uint nI;    // num Iterations
+} constants_in;
+
+typedef struct {
+    int vld;
+    int ol;     // outliers
+} constants_out;
+
+#pragma OPENCL EXTENSION cl_intel_channels : enable
+
+channel flowvector4 ch_flowvectors_init __attribute__((depth(512)));
+channel flowvectorN ch_flowvectors[CU] __attribute__((depth(512)));
+channel m_parameters ch_model_params[CU] __attribute__((depth(1024)));
+channel constants_in ch_constants_in[CU] __attribute__((depth(0)));
+channel constants_out ch_constants_out[CU] __attribute__((depth(512)));
+
+// The affine transformation u = h0 x + h1 y + h2, v = h3 x + h4 y + h5 of
+// the tails to the heads of the samples, by Cramer's rule relative to the
+// first one, as genAffineModel() of ransacutility.cpp. Returns 0 if the
+// tails are collinear.
+inline int gen_model_param(flowvector* fv, m_parameters* model_param) {
+    float x1 = fv[0].x, y1 = fv[0].y, u1 = fv[0].vx, v1 = fv[0].vy;
+    float dx2 = fv[1].x - x1, dy2 = fv[1].y - y1;
+    float dx3 = fv[2].x - x1, dy3 = fv[2].y - y1;
+    float du2 = fv[1].vx - u1, du3 = fv[2].vx - u1;
+    float dv2 = fv[1].vy - v1, dv3 = fv[2].vy - v1;
+
+    float det = dx2 * dy3 - dx3 * dy2;
+    // Check to prevent division by zero, the model count stays balanced
+    int ret = (det != 0);
+    if(det == 0) det = 1;
+
+    float a = (du2 * dy3 - du3 * dy2) / det;
+    float b = (dx2 * du3 - dx3 * du2) / det;
+    float d = (dv2 * dy3 - dv3 * dy2) / det;
+    float e = (dx2 * dv3 - dx3 * dv2) / det;
+
+    model_param->h[0] = a;
+    model_param->h[1] = b;
+    model_param->h[2] = u1 - a * x1 - b * y1;
+    model_param->h[3] = d;
+    model_param->h[4] = e;
+    model_param->h[5] = v1 - d * x1 - e * y1;
+    return ret;
+}
+
+/****************************************************************************
+* <b>Function:</b> ransac_data_handler()
+*
+* <b>Purpose:</b> Store all input data locally and provide it to the CUs
+*
+* @param flowvectors all flowvectors
+* @param errorThreshold threshold for data flowvectors to be inliers
+* @param n_flowvectors number of total flowvectors
+* @param n_iterations number of iterations (random samples to take)
+*
+* @returns Void
+*
+* @author Jennifer Faj 
+*   
+****************************************************************************/
+
+__kernel void ransac_data_handler(global flowvector* restrict flowvectors, const uint errorThreshold, const uint n_flowvectors, const uint n_iterations)
+{
+    local flowvector local_flowvectors[N/PO][PO];
+
+    constants_in c_in;
+    c_in.eT = errorThreshold;
+    c_in.nF = n_flowvectors;
+    c_in.nI = n_iterations;
+
+    write_channel_intel(ch_constants_in[0], c_in);
+
+    for(int i = 0; i < n_flowvectors/PO; i++){
+        for(int j = 0; j < PO; j+=BR){
+            flowvector4 fv4;
+            #pragma unroll
+            for(int k = 0; k < BR; k++){
+                local_flowvectors[i][j + k] = flowvectors[i*PO + j + k];
+                fv4.fv[k] = local_flowvectors[i][j + k];
+            }
+            write_channel_intel(ch_flowvectors_init, fv4);
+        }
+    }
+
+    for(int k = 0; k < n_iterations/CU; k++){
+        for(int i = 0; i < n_flowvectors/PO; i++){
+            flowvectorN fvN;
+            #pragma unroll
+            for(int j = 0; j < PO; j++){
+                fvN.fv[j] = local_flowvectors[i][j];
+            }
+            write_channel_intel(ch_flowvectors[0], fvN);
+        }
+    }
+}
+
+/****************************************************************************
+* <b>Function:</b> ransac_model_gen()
+*
+* <b>Purpose:</b> Take SAMPLES random samples and generate the parameters of
+* the affine transformation
+*
+* @param randomNumbers array of indices for random samples
+* @param n_flowvectors number of total flowvectors
+* @param n_iterations number of iterations (random samples to take)
+*
+* @returns Void
+*
+* @author IMPACT Research Group
+*
+* <b>Modifiers:</b> Jennifer Faj 
+*      
+* <b>Modifications:</b>
+*
+*  + Store data locally
+*  + Send model parameters via channels to outlier count CUs
+*  + Adjustment of computation for "invalid" models, 
+*    so that the amount of computations stays balanced for comparability
+*   
+****************************************************************************/
+
+__kernel void ransac_model_gen(global int* restrict randomNumbers, const uint n_flowvectors, const uint n_iterations)
+{
+    local flowvector local_flowvectors[N];
+
+    for(int i = 0; i < n_flowvectors; i += BR){
+        flowvector4 fv4;
+        fv4 = read_channel_intel(ch_flowvectors_init);
+        #pragma unroll
+        for(int j = 0; j < BR; j++){
+            local_flowvectors[i + j] = fv4.fv[j];
+        }
+    }
+
+    for(int i = 0; i < n_iterations; i++){
+        // select SAMPLES random flow vectors
+        flowvector fv[SAMPLES];
+        #pragma unroll
+        for(int k = 0; k < SAMPLES; k++){
+            fv[k] = local_flowvectors[randomNumbers[i * SAMPLES + k]];
+        }
+
+        m_parameters modelParams;
+        int ret = gen_model_param(fv, &modelParams);
+
+        if(ret == 0){
+            #pragma unroll
+            for(int k = 0; k < 6; k++){
+                modelParams.h[k] = -1;
+            }
+        }
+
+        write_channel_intel(ch_model_params[i % CU], modelParams);
+    }
+}
+
+/****************************************************************************
+* <b>Function:</b> ransac_outlier_count()
+*
+* <b>Purpose:</b> Take model parameters and check the whole data set for outliers 
+* of the affine transformation
+*
+* @returns Void
+*
+* @author IMPACT Research Group
+*
+* <b>Modifiers:</b> Jennifer Faj 
+*      
+* <b>Modifications:</b>
+*
+*  + Separate Autorun kernels (channels to read input data & model params and write outliers)
+*  + Multiple compute units (scalable)
+*  + Multiple outlier computations in parallel (scalable)
+*   
+****************************************************************************/
+
+__attribute__((max_global_work_dim(0)))
+__attribute__((autorun))
+__attribute__((num_compute_units(CU)))
+__kernel void ransac_outlier_count()
+{
+    constants_in c_in;
+
+    int cu_id = get_compute_id(0);
+
+    c_in = read_channel_intel(ch_constants_in[cu_id]);
+    uint errorThreshold = c_in.eT;
+    uint n_flowvectors = c_in.nF;
+    uint n_iterations = c_in.nI;
+    if(cu_id < (CU-1)){
+        write_channel_intel(ch_constants_in[cu_id + 1], c_in);
+    }
+
+    for(int i = 0; i < n_iterations/CU; i++){
+        m_parameters modelParams;
+        modelParams = read_channel_intel(ch_model_params[cu_id]);
+
+        int vld = 0;
+        #pragma unroll
+        for(int k = 0; k < 6; k++){
+            vld |= (modelParams.h[k] != -1);
+        }
+
+        int outlierCount[PO];
+        #pragma unroll PO
+        for(int j = 0; j < PO; j++){
+            outlierCount[j] = 0;
+        }
+
+        float threshold = (float)errorThreshold * (float)errorThreshold;
+
+        // Compute number of outliers
+        for(int j = 0; j < n_flowvectors; j+= PO) {
+            flowvectorN fvN = read_channel_intel(ch_flowvectors[cu_id]);
+
+            #pragma unroll
+            for(int k = 0; k < PO; k++){
+                float x = fvN.fv[k].x;
+                float y = fvN.fv[k].y;
+                float pu = (modelParams.h[0] * x + modelParams.h[1] * y) + modelParams.h[2];
+                float pv = (modelParams.h[3] * x + modelParams.h[4] * y) + modelParams.h[5];
+                float eu = pu - fvN.fv[k].vx;
+                float ev = pv - fvN.fv[k].vy;
+
+                if((vld != 0) && !(eu * eu + ev * ev < threshold)) {
+                    outlierCount[k]++;
+                }
+            }
+
+            if(cu_id < (CU-1)){
+                write_channel_intel(ch_flowvectors[cu_id + 1], fvN);
+            }
+        }
+
+        int outliers = 0;
+        #pragma unroll PO
+        for(int j = 0; j < PO; j++){
+            outliers += outlierCount[j];
+        }
+
+        constants_out c_out;
+        c_out.vld = vld;
+        c_out.ol = outliers;
+
+        write_channel_intel(ch_constants_out[cu_id], c_out);
+    }
+}
+
+/****************************************************************************
+* <b>Function:</b> ransac_model_count()
+*
+* <b>Purpose:</b> Check if a better model was found by comparing outlier counts and 
+* count the number of suitable models. Both accumulate over the launches, so that
+* the host can run the hypotheses in batches and read the best model so far
+*
+* @param convergenceThreshold threshold for a suitable model
+* @param n_flowvectors number of total flowvectors
+* @param n_iterations number of iterations (random samples to take)
+* @param n_bestModelParams in/output - number of models that are above convergence threshold
+* @param n_bestOutliers in/output - outlier count for best model
+*
+* @returns Void
+*
+* @author IMPACT Research Group
+*
+* <b>Modifiers:</b> Jennifer Faj 
+*      
+* <b>Modifications:</b>
+*   + Separate kernel
+*   + Read outlier counts from CUs via channels
+*   
+****************************************************************************/
+
+__kernel void ransac_model_count(const uint n_flowvectors, const uint n_iterations, const float convergenceThreshold, global int* restrict n_bestModelParams, global int* restrict n_bestOutliers){
+    
+    int recvd = 0;
+
+    // continue from the counts of the previous launches
+    int localBestOutliers = *n_bestOutliers;
+    int suitableModelCount = *n_bestModelParams;
+    
+    while(recvd < n_iterations){
+        for(int i = 0; i < CU; i++){
+            bool vld_read;
+            constants_out c_out;
+            c_out = read_channel_nb_intel(ch_constants_out[i], &vld_read);
+
+            int vld = c_out.vld;
+            int outliers = c_out.ol;
+
+            if(vld_read){            
+                if((vld != 0) && (outliers < n_flowvectors * convergenceThreshold)){
+                    suitableModelCount++;
+                    if(outliers < localBestOutliers){
+                        localBestOutliers = outliers;
+                    }
+                }
+                recvd++;
+            }
+        }
+    }
+
+    *n_bestModelParams = suitableModelCount;
+    *n_bestOutliers = localBestOutliers;
+}
\ No newline at end of file
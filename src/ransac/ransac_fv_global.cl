@@ -313,13 +313,14 @@ __kernel void ransac_outlier_count()
 * <b>Function:</b> ransac_model_count()
 *
 * <b>Purpose:</b> Check if a better model was found by comparing outlier counts and 
-* count the number of suitable models
+* count the number of suitable models. Both accumulate over the launches, so that
+* the host can run the hypotheses in batches and read the best model so far
 *
 * @param convergenceThreshold threshold for a suitable model
 * @param n_flowvectors number of total flowvectors
 * @param n_iterations number of iterations (random samples to take)
-* @param n_bestModelParams output - number of models that are above convergence threshold
-* @param n_bestOutliers output - outlier count for best model
+* @param n_bestModelParams in/output - number of models that are above convergence threshold
+* @param n_bestOutliers in/output - outlier count for best model
 *
 * @returns Void
 *
@@ -338,8 +339,9 @@ __kernel void ransac_model_count(const uint n_flowvectors, const uint n_iteratio
     
     int recvd = 0;
 
-    int localBestOutliers = n_flowvectors;
-    int suitableModelCount = 0;
+    // continue from the counts of the previous launches
+    int localBestOutliers = *n_bestOutliers;
+    int suitableModelCount = *n_bestModelParams;
     
     while(recvd < n_iterations){
         for(int i = 0; i < CU; i++){
@@ -0,0 +1,446 @@
+/** @file ransac_fv_preemptive.cl
+*/
+
+/*
+ * Copyright (c) 2016 University of Cordoba and University of Illinois
+ * All rights reserved.
+ *
+ * Developed by:    IMPACT Research Group
+ *                  University of Cordoba and University of Illinois
+ *                  http://impact.crhc.illinois.edu/
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * with the Software without restriction, including without limitation the 
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ *      > Redistributions of source code must retain the above copyright notice,
+ *        this list of conditions and the following disclaimers.
+ *      > Redistributions in binary form must reproduce the above copyright
+ *        notice, this list of conditions and the following disclaimers in the
+ *        documentation and/or other materials provided with the distribution.
+ *      > Neither the names of IMPACT Research Group, University of Cordoba, 
+ *        University of Illinois nor the names of its contributors may be used 
+ *        to endorse or promote products derived from this Software without 
+ *        specific prior written permission.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+ * CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS WITH
+ * THE SOFTWARE.
+ *
+ * Modifiers:       Jennifer Faj
+ * Modifications:   + Changed Code to single work-item kernels
+ *                  + Split RANSAC stages into multiple kernels
+ *                  + Optimized the code for FPGA
+ *                  + Added tunable parameters for scalability
+ *
+ * Date:            2020/06/21
+ *
+ */
+
+/*
+ * Preemptive (breadth-first) variant: all hypotheses are scored on a block
+ * of flowvectors, the better half of them is kept for the next block, until
+ * a single hypothesis is left or the data set is used up. It runs a single
+ * outlier count unit, PO flowvectors in parallel.
+ */
+
+#define BR  4       // Burst Read
+
+// The most hypotheses per launch, must match RANSAC_MAX_HYPOTHESES of ransacutility.h
+#define MAX_HYPOTHESES 4096
+
+typedef struct {
+    int x;
+    int y;
+    int vx;
+    int vy;
+} flowvector;
+
+typedef struct {
+    flowvector fv[4];
+} flowvector4;
+
+typedef struct {
+    flowvector fv[PO];
+} flowvectorN;
+
+typedef struct {
+    float xc;
+    float yc;
+    float D;
+    float R;
+} m_parameters;
+
+typedef struct {
+    m_parameters mp;
+    uint nF;    // flowvectors of the block
+} m_block;
+
+typedef struct {
+    uint eT;    // error Threshold
+    uint nI;    // num hypotheses of all blocks
+} constants_in;
+
+typedef struct {
+    int vld;
+    int ol;     // outliers
+} constants_out;
+
+#pragma OPENCL EXTENSION cl_intel_channels : enable
+
+channel flowvector4 ch_flowvectors_init __attribute__((depth(512)));
+channel flowvectorN ch_flowvectors __attribute__((depth(512)));
+channel m_block ch_model_params __attribute__((depth(1024)));
+channel constants_in ch_constants_in __attribute__((depth(0)));
+channel constants_out ch_constants_out __attribute__((depth(512)));
+channel ushort ch_survivors __attribute__((depth(MAX_HYPOTHESES / 2)));
+
+inline int gen_model_param(int x1, int y1, int vx1, int vy1, int x2, int y2, int vx2, int vy2, m_parameters* model_param) {
+    float temp1;
+    float temp2;
+    int ret = 1;
+    // xc -> model_param[0], yc -> model_param[1], D -> model_param[2], R -> model_param[3]
+    temp1 = (float)((vx1 * (vx1 - (2 * vx2))) + (vx2 * vx2) + (vy1 * vy1) - (vy2 * ((2 * vy1) - vy2)));
+    if(temp1 == 0) { // Check to prevent division by zero
+        ret = 0;
+        model_param->xc = (((vx1 * ((-vx2 * x1) + (vx1 * x2) - (vx2 * x2) + (vy2 * y1) - (vy2 * y2))) +
+                            (vy1 * ((-vy2 * x1) + (vy1 * x2) - (vy2 * x2) - (vx2 * y1) + (vx2 * y2))) +
+                            (x1 * ((vy2 * vy2) + (vx2 * vx2)))) /
+                            1);
+        model_param->yc = (((vx2 * ((vy1 * x1) - (vy1 * x2) - (vx1 * y1) + (vx2 * y1) - (vx1 * y2))) +
+                            (vy2 * ((-vx1 * x1) + (vx1 * x2) - (vy1 * y1) + (vy2 * y1) - (vy1 * y2))) +
+                            (y2 * ((vx1 * vx1) + (vy1 * vy1)))) /
+                            1);
+    } else {
+        model_param->xc = (((vx1 * ((-vx2 * x1) + (vx1 * x2) - (vx2 * x2) + (vy2 * y1) - (vy2 * y2))) +
+                            (vy1 * ((-vy2 * x1) + (vy1 * x2) - (vy2 * x2) - (vx2 * y1) + (vx2 * y2))) +
+                            (x1 * ((vy2 * vy2) + (vx2 * vx2)))) /
+                            temp1);
+        model_param->yc = (((vx2 * ((vy1 * x1) - (vy1 * x2) - (vx1 * y1) + (vx2 * y1) - (vx1 * y2))) +
+                            (vy2 * ((-vx1 * x1) + (vx1 * x2) - (vy1 * y1) + (vy2 * y1) - (vy1 * y2))) +
+                            (y2 * ((vx1 * vx1) + (vy1 * vy1)))) /
+                            temp1);
+    }
+
+    temp2 = (float)((x1 * (x1 - (2 * x2))) + (x2 * x2) + (y1 * (y1 - (2 * y2))) + (y2 * y2));
+    if(temp2 == 0) { // Check to prevent division by zero
+        ret = 0;
+        model_param->D = ((((x1 - x2) * (vx1 - vx2)) + ((y1 - y2) * (vy1 - vy2))) / 1);
+        model_param->R = ((((x1 - x2) * (vy1 - vy2)) + ((y2 - y1) * (vx1 - vx2))) / 1);
+    } else {
+        model_param->D = ((((x1 - x2) * (vx1 - vx2)) + ((y1 - y2) * (vy1 - vy2))) / temp2);
+        model_param->R = ((((x1 - x2) * (vy1 - vy2)) + ((y2 - y1) * (vx1 - vx2))) / temp2);
+    }
+    return ret;
+}
+
+/****************************************************************************
+* <b>Function:</b> ransac_data_handler()
+*
+* <b>Purpose:</b> Store all input data locally and provide each block of it
+* to the outlier count once per hypothesis alive at that block. The number
+* of hypotheses alive halves from block to block, starting with all of them,
+* until a single one is left or the data set is used up.
+*
+* @param flowvectors all flowvectors
+* @param errorThreshold threshold for data flowvectors to be inliers
+* @param n_flowvectors number of total flowvectors
+* @param n_iterations number of hypotheses, at most MAX_HYPOTHESES
+* @param block number of flowvectors per block, a multiple of PO
+*
+* @returns Void
+*
+****************************************************************************/
+
+__kernel void ransac_data_handler(global flowvector* restrict flowvectors, const uint errorThreshold, const uint n_flowvectors, const uint n_iterations, const uint block)
+{
+    local flowvector local_flowvectors[N/PO][PO];
+
+    for(int i = 0; i < n_flowvectors/PO; i++){
+        for(int j = 0; j < PO; j+=BR){
+            flowvector4 fv4;
+            #pragma unroll
+            for(int k = 0; k < BR; k++){
+                local_flowvectors[i][j + k] = flowvectors[i*PO + j + k];
+                fv4.fv[k] = local_flowvectors[i][j + k];
+            }
+            write_channel_intel(ch_flowvectors_init, fv4);
+        }
+    }
+
+    // the hypotheses to score over all blocks
+    uint total = 0;
+    uint alive = n_iterations;
+    for(uint first = 0; ; first += block){
+        total += alive;
+        if(alive == 1 || first + block >= n_flowvectors) break;
+        alive /= 2;
+    }
+
+    constants_in c_in;
+    c_in.eT = errorThreshold;
+    c_in.nI = total;
+
+    write_channel_intel(ch_constants_in, c_in);
+
+    alive = n_iterations;
+    for(uint first = 0; ; first += block){
+        uint last = min(first + block, n_flowvectors);
+
+        for(uint h = 0; h < alive; h++){
+            for(uint i = first/PO; i < last/PO; i++){
+                flowvectorN fvN;
+                #pragma unroll
+                for(int j = 0; j < PO; j++){
+                    fvN.fv[j] = local_flowvectors[i][j];
+                }
+                write_channel_intel(ch_flowvectors, fvN);
+            }
+        }
+
+        if(alive == 1 || last >= n_flowvectors) break;
+        alive /= 2;
+    }
+}
+
+/****************************************************************************
+* <b>Function:</b> ransac_model_gen()
+*
+* <b>Purpose:</b> Generate the model parameters of all hypotheses using the
+* First-order-Flow model, then send those of the hypotheses alive at each
+* block to the outlier count, the survivors of a block being returned by
+* ransac_preempt()
+*
+* @param randomNumbers array of indices for random samples
+* @param n_flowvectors number of total flowvectors
+* @param n_iterations number of hypotheses, at most MAX_HYPOTHESES
+* @param block number of flowvectors per block, a multiple of PO
+*
+* @returns Void
+*
+****************************************************************************/
+
+__kernel void ransac_model_gen(global int* restrict randomNumbers, const uint n_flowvectors, const uint n_iterations, const uint block)
+{
+    local flowvector local_flowvectors[N];
+    local m_parameters models[MAX_HYPOTHESES];
+    local ushort alive_ids[MAX_HYPOTHESES];
+
+    for(int i = 0; i < n_flowvectors; i += BR){
+        flowvector4 fv4;
+        fv4 = read_channel_intel(ch_flowvectors_init);
+        #pragma unroll
+        for(int j = 0; j < BR; j++){
+            local_flowvectors[i + j] = fv4.fv[j];
+        }
+    }
+
+    for(int i = 0; i < n_iterations; i++){
+        // select two random flow vectors
+        int randNum1 = randomNumbers[i * 2 + 0];
+        int randNum2 = randomNumbers[i * 2 + 1];
+
+        flowvector fv[2];
+        fv[0] = local_flowvectors[randNum1];
+        fv[1] = local_flowvectors[randNum2];
+
+        int vx1 = fv[0].vx - fv[0].x;
+        int vy1 = fv[0].vy - fv[0].y;
+        int vx2 = fv[1].vx - fv[1].x;
+        int vy2 = fv[1].vy - fv[1].y;
+
+        m_parameters modelParams;
+        int ret = gen_model_param(fv[0].x, fv[0].y, vx1, vy1, fv[1].x, fv[1].y, vx2, vy2, &modelParams);
+
+        if(ret == 0){
+            modelParams.xc = -1;
+            modelParams.yc = -1;
+            modelParams.D = -1;
+            modelParams.R = -1;
+        }
+
+        models[i] = modelParams;
+        alive_ids[i] = i;
+    }
+
+    uint alive = n_iterations;
+    for(uint first = 0; ; first += block){
+        uint last = min(first + block, n_flowvectors);
+
+        for(uint h = 0; h < alive; h++){
+            m_block mb;
+            mb.mp = models[alive_ids[h]];
+            mb.nF = last - first;
+            write_channel_intel(ch_model_params, mb);
+        }
+
+        if(alive == 1 || last >= n_flowvectors) break;
+        alive /= 2;
+
+        for(uint h = 0; h < alive; h++){
+            alive_ids[h] = read_channel_intel(ch_survivors);
+        }
+    }
+}
+
+/****************************************************************************
+* <b>Function:</b> ransac_outlier_count()
+*
+* <b>Purpose:</b> Take model parameters and count the outliers of a block of
+* flowvectors using the First-order-Flow model
+*
+* @returns Void
+*
+****************************************************************************/
+
+__attribute__((max_global_work_dim(0)))
+__attribute__((autorun))
+__kernel void ransac_outlier_count()
+{
+    constants_in c_in = read_channel_intel(ch_constants_in);
+    uint errorThreshold = c_in.eT;
+    uint n_hypotheses = c_in.nI;
+
+    for(int i = 0; i < n_hypotheses; i++){
+        m_block mb = read_channel_intel(ch_model_params);
+        m_parameters modelParams = mb.mp;
+
+        int vld = 1;
+        if((modelParams.xc == -1) && (modelParams.yc == -1) && (modelParams.D == -1) && (modelParams.R == -1)){
+            vld = 0;
+        }
+
+        int outlierCount[PO];
+        #pragma unroll PO
+        for(int j = 0; j < PO; j++){
+            outlierCount[j] = 0;
+        }
+
+        // Compute number of outliers of the block
+        for(int j = 0; j < mb.nF; j+= PO) {
+            flowvectorN fvN = read_channel_intel(ch_flowvectors);
+
+            #pragma unroll
+            for(int k = 0; k < PO; k++){
+                float vxError, vyError;
+                vxError = fvN.fv[k].x + ((int)((fvN.fv[k].x - modelParams.xc) * modelParams.D) -
+                        (int)((fvN.fv[k].y - modelParams.yc) * modelParams.R)) - fvN.fv[k].vx;
+                vyError = fvN.fv[k].y + ((int)((fvN.fv[k].y - modelParams.yc) * modelParams.D) +
+                        (int)((fvN.fv[k].x - modelParams.xc) * modelParams.R)) - fvN.fv[k].vy;
+
+                if((vld != 0) && ((fabs(vxError) >= errorThreshold) || (fabs(vyError) >= errorThreshold))) {
+                    outlierCount[k]++;
+                }
+            }
+        }
+
+        int outliers = 0;
+        #pragma unroll PO
+        for(int j = 0; j < PO; j++){
+            outliers += outlierCount[j];
+        }
+
+        constants_out c_out;
+        c_out.vld = vld;
+        c_out.ol = outliers;
+
+        write_channel_intel(ch_constants_out, c_out);
+    }
+}
+
+/****************************************************************************
+* <b>Function:</b> ransac_preempt()
+*
+* <b>Purpose:</b> Add the outliers of each block to the scores of the
+* hypotheses alive, a hypothesis without a model scoring all flowvectors of
+* the block as outliers, and return the better half of them to
+* ransac_model_gen(). The half is selected over a histogram of the scores,
+* which are at most the flowvectors scored so far: the hypotheses below the
+* score of the median are kept, and of those at it the first ones. After the
+* last block the hypothesis with the fewest outliers, the first one on a tie,
+* is the model.
+*
+* @param n_flowvectors number of total flowvectors
+* @param n_iterations number of hypotheses, at most MAX_HYPOTHESES
+* @param block number of flowvectors per block, a multiple of PO
+* @param n_bestModel output - the index of the best hypothesis
+* @param n_bestOutliers output - its outliers over the blocks scored
+*
+* @returns Void
+*
+****************************************************************************/
+
+__kernel void ransac_preempt(const uint n_flowvectors, const uint n_iterations, const uint block, global int* restrict n_bestModel, global int* restrict n_bestOutliers){
+
+    local int scores[MAX_HYPOTHESES];
+    local ushort alive_ids[MAX_HYPOTHESES];
+    local int histogram[N + 1];
+
+    for(int i = 0; i < n_iterations; i++){
+        scores[i] = 0;
+        alive_ids[i] = i;
+    }
+
+    uint alive = n_iterations;
+    for(uint first = 0; ; first += block){
+        uint last = min(first + block, n_flowvectors);
+
+        for(uint h = 0; h < alive; h++){
+            constants_out c_out = read_channel_intel(ch_constants_out);
+            scores[alive_ids[h]] += (c_out.vld != 0) ? c_out.ol : (int)(last - first);
+        }
+
+        if(alive == 1 || last >= n_flowvectors) break;
+
+        uint keep = alive / 2;
+
+        for(uint s = 0; s <= last; s++){
+            histogram[s] = 0;
+        }
+        for(uint h = 0; h < alive; h++){
+            histogram[scores[alive_ids[h]]]++;
+        }
+
+        // the score of the keep-th hypothesis and the hypotheses below it
+        int median = 0;
+        uint below = 0;
+        while(below + histogram[median] < keep){
+            below += histogram[median];
+            median++;
+        }
+
+        uint at_median = keep - below;
+        uint kept = 0;
+        for(uint h = 0; h < alive; h++){
+            ushort id = alive_ids[h];
+            int score = scores[id];
+            if(score < median || (score == median && at_median > 0)){
+                if(score == median) at_median--;
+                alive_ids[kept++] = id;
+                write_channel_intel(ch_survivors, id);
+            }
+        }
+
+        alive = keep;
+    }
+
+    int bestModel = alive_ids[0];
+    int bestOutliers = scores[bestModel];
+    for(uint h = 1; h < alive; h++){
+        int id = alive_ids[h];
+        if(scores[id] < bestOutliers){
+            bestOutliers = scores[id];
+            bestModel = id;
+        }
+    }
+
+    *n_bestModel = bestModel;
+    *n_bestOutliers = bestOutliers;
+}
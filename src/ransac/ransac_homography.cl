@@ -0,0 +1,457 @@
+/** @file ransac_homography.cl
+*/
+
+/*
+ * Copyright (c) 2016 University of Cordoba and University of Illinois
+ * All rights reserved.
+ *
+ * Developed by:    IMPACT Research Group
+ *                  University of Cordoba and University of Illinois
+ *                  http://impact.crhc.illinois.edu/
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * with the Software without restriction, including without limitation the 
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ *      > Redistributions of source code must retain the above copyright notice,
+ *        this list of conditions and the following disclaimers.
+ *      > Redistributions in binary form must reproduce the above copyright
+ *        notice, this list of conditions and the following disclaimers in the
+ *        documentation and/or other materials provided with the distribution.
+ *      > Neither the names of IMPACT Research Group, University of Cordoba, 
+ *        University of Illinois nor the names of its contributors may be used 
+ *        to endorse or promote products derived from this Software without 
+ *        specific prior written permission.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+ * CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS WITH
+ * THE SOFTWARE.
+ *
+ * Modifiers:       Jennifer Faj
+ * Modifications:   + Changed Code to single work-item kernels
+ *                  + Split RANSAC stages into multiple kernels
+ *                  + Optimized the code for FPGA
+ *                  + Added tunable parameters for scalability
+ *
+ * Date:            2020/06/21
+ *
+ */
+
+/*
+ * Homography variant: the model kernel solves the homography mapping the
+ * tails (x, y) of SAMPLES sampled flowvectors to their heads (vx, vy), a
+ * flowvector is an inlier if its head lies within errorThreshold (Euclidean
+ * distance) of its mapped tail.
+ */
+
+#define BR  4       // Burst Read
+
+// The flowvectors sampled per hypothesis
+#define SAMPLES 4
+
+typedef struct {
+    int x;
+    int y;
+    int vx;
+    int vy;
+} flowvector;
+
+typedef struct {
+    flowvector fv[4];
+} flowvector4;
+
+typedef struct {
+    flowvector fv[PO];
+} flowvectorN;
+
+typedef struct {
+    float h[8];
+} m_parameters;
+
+typedef struct {
+    uint eT;    // error Threshold
+    uint nF;    // num Flowvectors
+    uint nI;    // num Iterations
+} constants_in;
+
+typedef struct {
+    int vld;
+    int ol;     // outliers
+} constants_out;
+
+#pragma OPENCL EXTENSION cl_intel_channels : enable
+
+channel flowvector4 ch_flowvectors_init __attribute__((depth(512)));
+channel flowvectorN ch_flowvectors[CU] __attribute__((depth(512)));
+channel m_parameters ch_model_params[CU] __attribute__((depth(1024)));
+channel constants_in ch_constants_in[CU] __attribute__((depth(0)));
+channel constants_out ch_constants_out[CU] __attribute__((depth(512)));
+
+// The homography u = (h0 x + h1 y + h2) / w, v = (h3 x + h4 y + h5) / w,
+// w = h6 x + h7 y + 1 of the tails to the heads of the samples by the
+// direct linear transformation, as genHomographyModel() of
+// ransacutility.cpp: the points are centered and scaled to a mean distance
+// (in x plus y) of 2 from their centroid, the 8x8 system solved by Gaussian
+// elimination with partial pivoting. Returns 0 for a degenerate sample.
+inline int gen_model_param(flowvector* fv, m_parameters* model_param) {
+    float cx = 0, cy = 0, cu = 0, cv = 0;
+    #pragma unroll
+    for(int i = 0; i < SAMPLES; i++){
+        cx += fv[i].x;
+        cy += fv[i].y;
+        cu += fv[i].vx;
+        cv += fv[i].vy;
+    }
+    cx /= SAMPLES; cy /= SAMPLES; cu /= SAMPLES; cv /= SAMPLES;
+
+    float ds = 0, dd = 0;
+    #pragma unroll
+    for(int i = 0; i < SAMPLES; i++){
+        ds += fabs(fv[i].x - cx) + fabs(fv[i].y - cy);
+        dd += fabs(fv[i].vx - cu) + fabs(fv[i].vy - cv);
+    }
+    int ret = (ds != 0) && (dd != 0);
+    float ks = 8 / ds, kd = 8 / dd;
+
+    float a[8][9];
+    #pragma unroll
+    for(int i = 0; i < SAMPLES; i++){
+        float x = (fv[i].x - cx) * ks, y = (fv[i].y - cy) * ks;
+        float u = (fv[i].vx - cu) * kd, v = (fv[i].vy - cv) * kd;
+        a[2*i][0] = x;   a[2*i][1] = y;   a[2*i][2] = 1;
+        a[2*i][3] = 0;   a[2*i][4] = 0;   a[2*i][5] = 0;
+        a[2*i][6] = -u * x; a[2*i][7] = -u * y; a[2*i][8] = u;
+        a[2*i+1][0] = 0; a[2*i+1][1] = 0; a[2*i+1][2] = 0;
+        a[2*i+1][3] = x; a[2*i+1][4] = y; a[2*i+1][5] = 1;
+        a[2*i+1][6] = -v * x; a[2*i+1][7] = -v * y; a[2*i+1][8] = v;
+    }
+
+    #pragma unroll
+    for(int c = 0; c < 8; c++){
+        int p = c;
+        #pragma unroll
+        for(int r = c + 1; r < 8; r++){
+            if(fabs(a[r][c]) > fabs(a[p][c])) p = r;
+        }
+        if(fabs(a[p][c]) < 1e-6f) ret = 0;
+        #pragma unroll
+        for(int k = 0; k < 9; k++){
+            float t = a[c][k]; a[c][k] = a[p][k]; a[p][k] = t;
+        }
+        #pragma unroll
+        for(int r = c + 1; r < 8; r++){
+            float f = a[r][c] / a[c][c];
+            #pragma unroll
+            for(int k = c; k < 9; k++){
+                a[r][k] -= f * a[c][k];
+            }
+        }
+    }
+
+    float n[9];
+    n[8] = 1;
+    #pragma unroll
+    for(int c = 7; c >= 0; c--){
+        float sum = a[c][8];
+        #pragma unroll
+        for(int k = c + 1; k < 8; k++){
+            sum -= a[c][k] * n[k];
+        }
+        n[c] = sum / a[c][c];
+    }
+
+    // undo the normalization, H = Td^-1 Hn Ts
+    float m[9];
+    #pragma unroll
+    for(int r = 0; r < 3; r++){
+        m[3*r + 0] = n[3*r + 0] * ks;
+        m[3*r + 1] = n[3*r + 1] * ks;
+        m[3*r + 2] = n[3*r + 2] - n[3*r + 0] * ks * cx - n[3*r + 1] * ks * cy;
+    }
+    float h[9];
+    #pragma unroll
+    for(int j = 0; j < 3; j++){
+        h[j] = m[j] / kd + cu * m[6 + j];
+        h[3 + j] = m[3 + j] / kd + cv * m[6 + j];
+        h[6 + j] = m[6 + j];
+    }
+    if(h[8] == 0) ret = 0;
+
+    #pragma unroll
+    for(int k = 0; k < 8; k++){
+        model_param->h[k] = h[k] / h[8];
+    }
+    return ret;
+}
+
+/****************************************************************************
+* <b>Function:</b> ransac_data_handler()
+*
+* <b>Purpose:</b> Store all input data locally and provide it to the CUs
+*
+* @param flowvectors all flowvectors
+* @param errorThreshold threshold for data flowvectors to be inliers
+* @param n_flowvectors number of total flowvectors
+* @param n_iterations number of iterations (random samples to take)
+*
+* @returns Void
+*
+* @author Jennifer Faj 
+*   
+****************************************************************************/
+
+__kernel void ransac_data_handler(global flowvector* restrict flowvectors, const uint errorThreshold, const uint n_flowvectors, const uint n_iterations)
+{
+    local flowvector local_flowvectors[N/PO][PO];
+
+    constants_in c_in;
+    c_in.eT = errorThreshold;
+    c_in.nF = n_flowvectors;
+    c_in.nI = n_iterations;
+
+    write_channel_intel(ch_constants_in[0], c_in);
+
+    for(int i = 0; i < n_flowvectors/PO; i++){
+        for(int j = 0; j < PO; j+=BR){
+            flowvector4 fv4;
+            #pragma unroll
+            for(int k = 0; k < BR; k++){
+                local_flowvectors[i][j + k] = flowvectors[i*PO + j + k];
+                fv4.fv[k] = local_flowvectors[i][j + k];
+            }
+            write_channel_intel(ch_flowvectors_init, fv4);
+        }
+    }
+
+    for(int k = 0; k < n_iterations/CU; k++){
+        for(int i = 0; i < n_flowvectors/PO; i++){
+            flowvectorN fvN;
+            #pragma unroll
+            for(int j = 0; j < PO; j++){
+                fvN.fv[j] = local_flowvectors[i][j];
+            }
+            write_channel_intel(ch_flowvectors[0], fvN);
+        }
+    }
+}
+
+/****************************************************************************
+* <b>Function:</b> ransac_model_gen()
+*
+* <b>Purpose:</b> Take SAMPLES random samples and generate the parameters of
+* the homography
+*
+* @param randomNumbers array of indices for random samples
+* @param n_flowvectors number of total flowvectors
+* @param n_iterations number of iterations (random samples to take)
+*
+* @returns Void
+*
+* @author IMPACT Research Group
+*
+* <b>Modifiers:</b> Jennifer Faj 
+*      
+* <b>Modifications:</b>
+*
+*  + Store data locally
+*  + Send model parameters via channels to outlier count CUs
+*  + Adjustment of computation for "invalid" models, 
+*    so that the amount of computations stays balanced for comparability
+*   
+****************************************************************************/
+
+__kernel void ransac_model_gen(global int* restrict randomNumbers, const uint n_flowvectors, const uint n_iterations)
+{
+    local flowvector local_flowvectors[N];
+
+    for(int i = 0; i < n_flowvectors; i += BR){
+        flowvector4 fv4;
+        fv4 = read_channel_intel(ch_flowvectors_init);
+        #pragma unroll
+        for(int j = 0; j < BR; j++){
+            local_flowvectors[i + j] = fv4.fv[j];
+        }
+    }
+
+    for(int i = 0; i < n_iterations; i++){
+        // select SAMPLES random flow vectors
+        flowvector fv[SAMPLES];
+        #pragma unroll
+        for(int k = 0; k < SAMPLES; k++){
+            fv[k] = local_flowvectors[randomNumbers[i * SAMPLES + k]];
+        }
+
+        m_parameters modelParams;
+        int ret = gen_model_param(fv, &modelParams);
+
+        if(ret == 0){
+            #pragma unroll
+            for(int k = 0; k < 8; k++){
+                modelParams.h[k] = -1;
+            }
+        }
+
+        write_channel_intel(ch_model_params[i % CU], modelParams);
+    }
+}
+
+/****************************************************************************
+* <b>Function:</b> ransac_outlier_count()
+*
+* <b>Purpose:</b> Take model parameters and check the whole data set for outliers 
+* of the homography
+*
+* @returns Void
+*
+* @author IMPACT Research Group
+*
+* <b>Modifiers:</b> Jennifer Faj 
+*      
+* <b>Modifications:</b>
+*
+*  + Separate Autorun kernels (channels to read input data & model params and write outliers)
+*  + Multiple compute units (scalable)
+*  + Multiple outlier computations in parallel (scalable)
+*   
+****************************************************************************/
+
+__attribute__((max_global_work_dim(0)))
+__attribute__((autorun))
+__attribute__((num_compute_units(CU)))
+__kernel void ransac_outlier_count()
+{
+    constants_in c_in;
+
+    int cu_id = get_compute_id(0);
+
+    c_in = read_channel_intel(ch_constants_in[cu_id]);
+    uint errorThreshold = c_in.eT;
+    uint n_flowvectors = c_in.nF;
+    uint n_iterations = c_in.nI;
+    if(cu_id < (CU-1)){
+        write_channel_intel(ch_constants_in[cu_id + 1], c_in);
+    }
+
+    for(int i = 0; i < n_iterations/CU; i++){
+        m_parameters modelParams;
+        modelParams = read_channel_intel(ch_model_params[cu_id]);
+
+        int vld = 0;
+        #pragma unroll
+        for(int k = 0; k < 8; k++){
+            vld |= (modelParams.h[k] != -1);
+        }
+
+        int outlierCount[PO];
+        #pragma unroll PO
+        for(int j = 0; j < PO; j++){
+            outlierCount[j] = 0;
+        }
+
+        float threshold = (float)errorThreshold * (float)errorThreshold;
+
+        // Compute number of outliers
+        for(int j = 0; j < n_flowvectors; j+= PO) {
+            flowvectorN fvN = read_channel_intel(ch_flowvectors[cu_id]);
+
+            #pragma unroll
+            for(int k = 0; k < PO; k++){
+                float x = fvN.fv[k].x;
+                float y = fvN.fv[k].y;
+                float pu = (modelParams.h[0] * x + modelParams.h[1] * y) + modelParams.h[2];
+                float pv = (modelParams.h[3] * x + modelParams.h[4] * y) + modelParams.h[5];
+                float w = (modelParams.h[6] * x + modelParams.h[7] * y) + 1;
+                pu = pu / w;
+                pv = pv / w;
+                float eu = pu - fvN.fv[k].vx;
+                float ev = pv - fvN.fv[k].vy;
+
+                // a vanishing w gives a NaN distance, an outlier
+                if((vld != 0) && !(eu * eu + ev * ev < threshold)) {
+                    outlierCount[k]++;
+                }
+            }
+
+            if(cu_id < (CU-1)){
+                write_channel_intel(ch_flowvectors[cu_id + 1], fvN);
+            }
+        }
+
+        int outliers = 0;
+        #pragma unroll PO
+        for(int j = 0; j < PO; j++){
+            outliers += outlierCount[j];
+        }
+
+        constants_out c_out;
+        c_out.vld = vld;
+        c_out.ol = outliers;
+
+        write_channel_intel(ch_constants_out[cu_id], c_out);
+    }
+}
+
+/****************************************************************************
+* <b>Function:</b> ransac_model_count()
+*
+* <b>Purpose:</b> Check if a better model was found by comparing outlier counts and 
+* count the number of suitable models. Both accumulate over the launches, so that
+* the host can run the hypotheses in batches and read the best model so far
+*
+* @param convergenceThreshold threshold for a suitable model
+* @param n_flowvectors number of total flowvectors
+* @param n_iterations number of iterations (random samples to take)
+* @param n_bestModelParams in/output - number of models that are above convergence threshold
+* @param n_bestOutliers in/output - outlier count for best model
+*
+* @returns Void
+*
+* @author IMPACT Research Group
+*
+* <b>Modifiers:</b> Jennifer Faj 
+*      
+* <b>Modifications:</b>
+*   + Separate kernel
+*   + Read outlier counts from CUs via channels
+*   
+****************************************************************************/
+
+__kernel void ransac_model_count(const uint n_flowvectors, const uint n_iterations, const float convergenceThreshold, global int* restrict n_bestModelParams, global int* restrict n_bestOutliers){
+    
+    int recvd = 0;
+
+    // continue from the counts of the previous launches
+    int localBestOutliers = *n_bestOutliers;
+    int suitableModelCount = *n_bestModelParams;
+    
+    while(recvd < n_iterations){
+        for(int i = 0; i < CU; i++){
+            bool vld_read;
+            constants_out c_out;
+            c_out = read_channel_nb_intel(ch_constants_out[i], &vld_read);
+
+            int vld = c_out.vld;
+            int outliers = c_out.ol;
+
+            if(vld_read){            
+                if((vld != 0) && (outliers < n_flowvectors * convergenceThreshold)){
+                    suitableModelCount++;
+                    if(outliers < localBestOutliers){
+                        localBestOutliers = outliers;
+                    }
+                }
+                recvd++;
+            }
+        }
+    }
+
+    *n_bestModelParams = suitableModelCount;
+    *n_bestOutliers = localBestOutliers;
+}
\ No newline at end of file
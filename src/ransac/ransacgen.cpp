@@ -0,0 +1,217 @@
+/** @file ransacgen.cpp
+*
+* Generates ransac data sets of flow vectors (first order flow) or points
+* (linear function) from a known model, with inlier noise and a fraction of
+* outliers. The files are written in the csv or the binary (mmap-able)
+* format read by the benchmark. With --check the model is estimated on the
+* host from the data set and compared to the ground truth. With --convert an
+* existing csv or binary data set is written as a binary one instead.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <iostream>
+#include <vector>
+
+#include "../common/optionparser.h"
+
+#include "ransacgenerator.h"
+
+using namespace std;
+
+// Generates, writes and optionally checks the data set of the element type.
+template <class T>
+static int generate(int count, float noise, float outlierRatio, unsigned seed,
+                    bool binary, uint32_t layout, string fileName, bool check, int iterations,
+                    int errorThreshold)
+{
+    RansacGroundTruth truth;
+    initGroundTruth(truth, (const T*)NULL);
+
+    if (noise >= 0) truth.noise = noise;
+    truth.outlierRatio = outlierRatio;
+
+    T *data;
+    if (posix_memalign(reinterpret_cast<void**>(&data), 64, count * sizeof(T)))
+    {
+        cerr << "ERROR: could not allocate " << count << " elements" << endl;
+        return 1;
+    }
+
+    genInputData(data, count, truth, seed);
+
+    bool written = binary ? writeInputBinary(data, count, fileName, layout) :
+                            writeInputData(data, count, fileName);
+
+    if (!written)
+    {
+        cerr << "ERROR: could not write the data set to " << fileName << endl;
+        free(data);
+        return 1;
+    }
+
+    cout << "Written " << count << " elements (" << truth.inliers << " inliers) to "
+         << fileName << endl;
+
+    int result = 0;
+
+    if (check)
+    {
+        vector<int> randNumbers(2 * iterations);
+        srand(seed);
+        genRandNumbers(randNumbers.data(), iterations, count);
+
+        float params[4] = { 0, 0, 0, 0 };
+        RansacResult estimate = estimateModel(data, count, randNumbers.data(), iterations,
+                                              errorThreshold, RANSAC_CONVERGENCE_THRESHOLD, params);
+
+        if (estimate.bestModel < 0)
+        {
+            cout << "No model found in " << iterations << " iterations" << endl;
+            result = 1;
+        }
+        else
+        {
+            float error = modelError(truth, (const T*)NULL, params);
+
+            printf("Ground truth: %g %g %g %g, %d outliers\n", truth.params[0], truth.params[1],
+                   truth.params[2], truth.params[3], count - truth.inliers);
+            printf("Estimated:    %g %g %g %g, %d outliers\n", params[0], params[1],
+                   params[2], params[3], estimate.bestOutliers);
+            printf("Largest model error: %g (threshold %d)\n", error, errorThreshold);
+
+            if (error >= errorThreshold) result = 1;
+        }
+    }
+
+    free(data);
+    return result;
+}
+
+// Writes the data set of the element type in the input file as a binary data
+// set of the layout, named <model>-<count>.bin by default.
+template <class T>
+static int convert(string inputFile, uint32_t layout, string outDir, string fileName, string prefix)
+{
+    RansacDataFile file;
+    if (!readInput(inputFile, inputDataType((const T*)NULL), file))
+    {
+        cerr << "ERROR: could not read the data set " << inputFile << endl;
+        return 1;
+    }
+
+    int count = file.count;
+    if (fileName.empty())
+        fileName = prefix + to_string(count) + ".bin";
+
+    // the elements one after another are written as they are
+    vector<T> interleaved;
+    const T *data = (const T*)file.elements;
+    if (file.layout != RANSAC_DATA_AOS)
+    {
+        interleaved.resize(count);
+        copyInput(file, interleaved.data());
+        data = interleaved.data();
+    }
+
+    bool written = writeInputBinary(data, count, outDir + fileName, layout);
+    releaseInput(file);
+
+    if (!written)
+    {
+        cerr << "ERROR: could not write the data set to " << outDir + fileName << endl;
+        return 1;
+    }
+
+    cout << "Converted " << count << " elements of " << inputFile << " to " << outDir + fileName << endl;
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    OptionParser parser;
+    parser.addOption("outdir", OPT_STRING, "data/", "output directory of the data set");
+    parser.addOption("output", OPT_STRING, "", "file name, default <model>-<count>.<format>", 'o');
+    parser.addOption("model", OPT_STRING, "fv", "fv: flow vectors, p: points of a linear function", 'm');
+    parser.addOption("count", OPT_INT, "1048576", "number of flow vectors or points", 'c');
+    parser.addOption("noise", OPT_FLOAT, "-1", "standard deviation of the inliers, -1 for the model default");
+    parser.addOption("outliers", OPT_FLOAT, "0.3", "fraction of outliers");
+    parser.addOption("seed", OPT_INT, "1", "random seed");
+    parser.addOption("format", OPT_STRING, "bin", "file format, bin or csv", 'f');
+    parser.addOption("layout", OPT_STRING, "aos", "layout of the binary format, aos (elements) or soa (field arrays)");
+    parser.addOption("convert", OPT_STRING, "", "csv or binary data set of the model to write as binary instead of generating one");
+    parser.addOption("check", OPT_BOOL, "false", "estimate the model on the host and compare it to the ground truth");
+    parser.addOption("iterations", OPT_INT, "256", "ransac iterations of the check", 'i');
+
+    if (!parser.parse(argc, argv) || parser.HelpRequested())
+    {
+        parser.usage();
+        return parser.HelpRequested() ? 0 : 1;
+    }
+
+    string outDir = parser.getOptionString("outdir");
+    string fileName = parser.getOptionString("output");
+    string model = parser.getOptionString("model");
+    long long count = parser.getOptionInt("count");
+    float noise = parser.getOptionFloat("noise");
+    float outlierRatio = parser.getOptionFloat("outliers");
+    unsigned seed = parser.getOptionInt("seed");
+    string format = parser.getOptionString("format");
+    bool check = parser.getOptionBool("check");
+    int iterations = parser.getOptionInt("iterations");
+    string layoutName = parser.getOptionString("layout");
+    string inputFile = parser.getOptionString("convert");
+
+    if (count < 2 || count > INT32_MAX / 16)
+    {
+        cerr << "ERROR: the number of elements must be at least 2 and fit the buffers." << endl;
+        return 1;
+    }
+
+    if (outlierRatio < 0 || outlierRatio > 1 || iterations < 1)
+    {
+        cerr << "ERROR: the outlier fraction must be in [0, 1] and the iterations positive." << endl;
+        return 1;
+    }
+
+    if (format != "bin" && format != "csv")
+    {
+        cerr << "ERROR: unknown format: " << format << endl;
+        return 1;
+    }
+
+    if (layoutName != "aos" && layoutName != "soa")
+    {
+        cerr << "ERROR: unknown layout: " << layoutName << endl;
+        return 1;
+    }
+
+    if (model != "fv" && model != "p")
+    {
+        cerr << "ERROR: unknown model: " << model << endl;
+        return 1;
+    }
+
+    bool flowVectors = model == "fv";
+    uint32_t layout = layoutName == "soa" ? RANSAC_DATA_SOA : RANSAC_DATA_AOS;
+
+    if (!outDir.empty() && outDir.back() != '/')
+        outDir += "/";
+
+    if (!inputFile.empty())
+        return flowVectors ?
+            convert<flowvector>(inputFile, layout, outDir, fileName, "flowvector-") :
+            convert<point>(inputFile, layout, outDir, fileName, "point-");
+
+    if (fileName.empty())
+        fileName = string(flowVectors ? "flowvector-" : "point-") + to_string(count) + "." + format;
+
+    bool binary = format == "bin";
+
+    return flowVectors ?
+        generate<flowvector>(count, noise, outlierRatio, seed, binary, layout, outDir + fileName,
+                             check, iterations, RANSAC_FV_ERROR_THRESHOLD) :
+        generate<point>(count, noise, outlierRatio, seed, binary, layout, outDir + fileName,
+                        check, iterations, RANSAC_P_ERROR_THRESHOLD);
+}
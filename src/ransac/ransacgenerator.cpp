@@ -0,0 +1,145 @@
+/** @file ransacgenerator.cpp
+*
+* Generates ransac data sets of any size from a known model: flow vectors
+* of a first order flow (ego-motion) and points of a linear function, with
+* normally distributed inlier noise and a given fraction of uniformly
+* distributed outliers.
+*/
+
+#include <math.h>
+#include <random>
+#include <algorithm>
+
+#include "ransacgenerator.h"
+
+using namespace std;
+
+// Largest displacement of an outlier flow vector in each direction.
+#define OUTLIER_FLOW 32
+
+// The default models, a 1080p frame for the flow vectors.
+void initGroundTruth(RansacGroundTruth &truth, const flowvector *)
+{
+    truth.params[0] = 1000.0f;     // xc
+    truth.params[1] = 500.0f;      // yc
+    truth.params[2] = 0.01f;       // D
+    truth.params[3] = 0.004f;      // R
+    truth.width = 1920;
+    truth.height = 1080;
+    truth.noise = 0.5f;
+    truth.outlierRatio = 0.3f;
+    truth.inliers = 0;
+}
+
+void initGroundTruth(RansacGroundTruth &truth, const point *)
+{
+    truth.params[0] = 0.5f;        // m
+    truth.params[1] = 100.0f;      // b
+    truth.params[2] = 0.0f;
+    truth.params[3] = 0.0f;
+    truth.width = 10000;
+    truth.height = 1000;
+    truth.noise = 10.0f;
+    truth.outlierRatio = 0.3f;
+    truth.inliers = 0;
+}
+
+// The head of the flow vector with the tail (x, y) under the first order
+// flow.
+static void flowHead(const float *params, float x, float y, float &vx, float &vy)
+{
+    vx = x + (x - params[0]) * params[2] - (y - params[1]) * params[3];
+    vy = y + (y - params[1]) * params[2] + (x - params[0]) * params[3];
+}
+
+void genInputData(flowvector *v, int n, RansacGroundTruth &truth, unsigned seed)
+{
+    mt19937 engine(seed);
+    uniform_int_distribution<int> xs(0, truth.width - 1);
+    uniform_int_distribution<int> ys(0, truth.height - 1);
+    uniform_int_distribution<int> flow(-OUTLIER_FLOW, OUTLIER_FLOW);
+    uniform_real_distribution<float> unit(0.0f, 1.0f);
+    normal_distribution<float> noise(0.0f, max(truth.noise, 1e-6f));
+
+    truth.inliers = 0;
+
+    for (int i = 0; i < n; i++)
+    {
+        v[i].x = xs(engine);
+        v[i].y = ys(engine);
+
+        if (unit(engine) < truth.outlierRatio)
+        {
+            v[i].vx = v[i].x + flow(engine);
+            v[i].vy = v[i].y + flow(engine);
+        }
+        else
+        {
+            // the truncations of the outlier count, so that the noise is
+            // the error the kernels see
+            const float *params = truth.params;
+            v[i].vx = v[i].x + ((int)((v[i].x - params[0]) * params[2]) -
+                                (int)((v[i].y - params[1]) * params[3])) + lroundf(noise(engine));
+            v[i].vy = v[i].y + ((int)((v[i].y - params[1]) * params[2]) +
+                                (int)((v[i].x - params[0]) * params[3])) + lroundf(noise(engine));
+            truth.inliers++;
+        }
+    }
+}
+
+void genInputData(point *p, int n, RansacGroundTruth &truth, unsigned seed)
+{
+    mt19937 engine(seed);
+    uniform_real_distribution<float> xs(0.0f, truth.width);
+    uniform_real_distribution<float> spread(-truth.height, truth.height);
+    uniform_real_distribution<float> unit(0.0f, 1.0f);
+    normal_distribution<float> noise(0.0f, max(truth.noise, 1e-6f));
+
+    truth.inliers = 0;
+
+    for (int i = 0; i < n; i++)
+    {
+        p[i].x = xs(engine);
+        p[i].y = truth.params[0] * p[i].x + truth.params[1];
+
+        if (unit(engine) < truth.outlierRatio)
+        {
+            p[i].y += spread(engine);
+        }
+        else
+        {
+            p[i].y += noise(engine);
+            truth.inliers++;
+        }
+    }
+}
+
+// The largest distance between the heads of the flow vectors predicted by
+// the ground truth and by the estimated model over the frame. Both are
+// affine in the tail, so the largest distance is at a corner.
+float modelError(const RansacGroundTruth &truth, const flowvector *, const float *model_param)
+{
+    float error = 0;
+
+    for (int corner = 0; corner < 4; corner++)
+    {
+        float x = (corner & 1) ? truth.width : 0;
+        float y = (corner & 2) ? truth.height : 0;
+        float tx, ty, mx, my;
+        flowHead(truth.params, x, y, tx, ty);
+        flowHead(model_param, x, y, mx, my);
+        error = max(error, hypotf(tx - mx, ty - my));
+    }
+
+    return error;
+}
+
+// The largest vertical distance between the ground truth and the estimated
+// line over the x range of the points.
+float modelError(const RansacGroundTruth &truth, const point *, const float *model_param)
+{
+    float error = fabsf(truth.params[1] - model_param[1]);
+    float x = truth.width;
+
+    return max(error, fabsf((truth.params[0] - model_param[0]) * x + truth.params[1] - model_param[1]));
+}
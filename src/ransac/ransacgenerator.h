@@ -0,0 +1,23 @@
+#ifndef RANSACGENERATOR_H
+#define RANSACGENERATOR_H
+
+#include "ransacutility.h"
+
+// The ground truth of a generated data set.
+typedef struct {
+    float params[4];        // xc, yc, D and R of the first order flow, or m and b of the linear function
+    int width;              // the tails (x, y) lie in [0, width) x [0, height)
+    int height;             // the outliers of the linear function lie within +-height of it
+    float noise;            // standard deviation of the inliers from the model
+    float outlierRatio;     // fraction of the elements that are outliers
+    int inliers;            // number of elements generated from the model
+} RansacGroundTruth;
+
+void initGroundTruth(RansacGroundTruth &truth, const flowvector *);
+void initGroundTruth(RansacGroundTruth &truth, const point *);
+void genInputData(flowvector *v, int n, RansacGroundTruth &truth, unsigned seed);
+void genInputData(point *p, int n, RansacGroundTruth &truth, unsigned seed);
+float modelError(const RansacGroundTruth &truth, const flowvector *, const float *model_param);
+float modelError(const RansacGroundTruth &truth, const point *, const float *model_param);
+
+#endif // RANSACGENERATOR_H
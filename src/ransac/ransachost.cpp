@@ -5,154 +5,409 @@
 #include <stdlib.h>
 #include <math.h>
 #include <string.h>
+#include <time.h>
+
+#include <chrono>
+#include <vector>
+#include <algorithm>
+
+#include <dirent.h>
+#include <sys/stat.h>
 
 #include <CL/cl_ext_intelfpga.h>
 
 #include "../common/utility.h"
 #include "../common/benchmarkoptions.h"
-#include "ransacutility.h"
+#include "ransachost.h"
+#include "ransacgenerator.h"
 using namespace std;
 
+// The distinct frames generated for the stream mode, repeated for longer streams.
+#define RANSAC_STREAM_FRAMES 16
+
 /****************************************************************************
-* Function: runRansac()
+* Function: openRansacData()
+*
+* Purpose: Reads a data set of the model with a single mapping of the file:
+* a binary data set, detected by its magic, stays in the mapping, a csv data
+* set is parsed from it. Exits if the file cannot be read or does not hold
+* the elements of the model.
+*
+* @param inputDataFile file containing the input data, csv or binary
+* @param file output -the data set, to be released by releaseInput()
+*
+* @returns nothing
+*
+*****************************************************************************/
+
+template <class T>
+void openRansacData(string inputDataFile, RansacDataFile &file)
+{
+    if (!readInput(inputDataFile, inputDataType((const T*)NULL), file))
+    {
+        cout << "ERROR: could not read the data set " << inputDataFile << endl;
+        exit(-1);
+    }
+}
+
+/****************************************************************************
+* Function: readRansacData()
+*
+* Purpose: Reads a data set of the model into 64 byte aligned memory, the
+* elements one after another whatever the layout of the file.
+*
+* @param inputDataFile file containing the input data, csv or binary
+* @param n output -the number of elements
+*
+* @returns the elements, to be freed
+*
+*****************************************************************************/
+
+template <class T>
+T *readRansacData(string inputDataFile, int &n)
+{
+    RansacDataFile file;
+    openRansacData<T>(inputDataFile, file);
+
+    T *data;
+    n = file.count;
+    if (posix_memalign(reinterpret_cast<void**>(&data), 64, n * sizeof(T)))
+    {
+        fprintf(stderr, "Aligned Malloc failed due to insufficient memory.\n");
+        exit(-1);
+    }
+
+    copyInput(file, data);
+    releaseInput(file);
+    return data;
+}
+
+/****************************************************************************
+* Function: setRansacIterations()
+*
+* Purpose: Sets the number of hypotheses the three kernels run per launch.
+*
+* @param session the ransac session
+* @param iters number of hypotheses per launch, a multiple of RANSAC_CU
+*
+* @returns nothing
+*
+*****************************************************************************/
+
+template <class T>
+void setRansacIterations(RansacSession<T> &session, int iters)
+{
+    int err;
+
+    // the global model kernel takes its copy of the data set first
+    int modelArg = session.global ? 3 : 2;
+
+    err = clSetKernelArg(session.datakernel, 3, sizeof(int), (void*)&iters);
+    CL_CHECK_ERROR(err);
+    err = clSetKernelArg(session.modelkernel, modelArg, sizeof(int), (void*)&iters);
+    CL_CHECK_ERROR(err);
+    err = clSetKernelArg(session.outkernel, 1, sizeof(int), (void*)&iters);
+    CL_CHECK_ERROR(err);
+}
+
+/****************************************************************************
+* Function: hostRansac(), hostRansacAdaptive()
+*
+* Purpose: Run the host engine on the model of the session, the points only
+* have the line model.
+*
+*****************************************************************************/
+
+RansacResult hostRansac(const RansacSoA<flowvector> &soa, const int *randNumbers, int iters,
+                        int errorThreshold, float convergenceThreshold, int model)
+{
+    return ransacSIMD(soa, randNumbers, iters, errorThreshold, convergenceThreshold, 0, model);
+}
+
+RansacResult hostRansac(const RansacSoA<point> &soa, const int *randNumbers, int iters,
+                        int errorThreshold, float convergenceThreshold, int /*model*/)
+{
+    return ransacSIMD(soa, randNumbers, iters, errorThreshold, convergenceThreshold, 0);
+}
+
+RansacResult hostRansacAdaptive(const RansacSoA<flowvector> &soa, const int *randNumbers, int iters, int batch,
+                                int errorThreshold, float convergenceThreshold, float confidence,
+                                int &evaluated, int model)
+{
+    return ransacAdaptiveSIMD(soa, randNumbers, iters, batch, errorThreshold, convergenceThreshold,
+                              confidence, 0, evaluated, model);
+}
+
+RansacResult hostRansacAdaptive(const RansacSoA<point> &soa, const int *randNumbers, int iters, int batch,
+                                int errorThreshold, float convergenceThreshold, float confidence,
+                                int &evaluated, int /*model*/)
+{
+    return ransacAdaptiveSIMD(soa, randNumbers, iters, batch, errorThreshold, convergenceThreshold,
+                              confidence, 0, evaluated);
+}
+
+/****************************************************************************
+* Function: matchesHost()
+*
+* Purpose: Compares the counts of the kernels to those of the host engine.
+* The first order flow and the line are computed alike on both sides and
+* must match exactly. The fast floating point of the FPGA solves the affine
+* and homography systems a rounding apart, which may move a point across
+* the error threshold, so that the transforms may differ by 1% of the data
+* set in the best outlier count and of the hypotheses in the candidates.
+*
+* @param session the ransac session
+* @param host the result of the host engine
+* @param candidates the suitable models found by the kernels
+* @param bestOutliers the best outlier count found by the kernels
+* @param iters the hypotheses evaluated
+*
+* @returns true, if the counts match
+*
+*****************************************************************************/
+
+template <class T>
+bool matchesHost(const RansacSession<T> &session, const RansacResult &host,
+                 int candidates, int bestOutliers, int iters)
+{
+    if (session.model == RANSAC_MODEL_FLOW)
+        return host.candidates == candidates && host.bestOutliers == bestOutliers;
+
+    return abs(host.candidates - candidates) <= iters / 100 + 1
+        && abs(host.bestOutliers - bestOutliers) <= session.n_idata / 100 + 1;
+}
+
+/****************************************************************************
+* Function: initRansacSession()
 *
-* Purpose: This function will be used, if the kernel operates on local memory 
+* Purpose: Reads the input data set, creates the queues, kernels and device
+* buffers of the ransac kernels, uploads the data set and sets the kernel
+* arguments, all of which stay the same for the passes of the benchmark.
 *
+* @param session output -the ransac session
 * @param dev the opencl device id to use for the benchmark
 * @param ctx the opencl context to use for the benchmark
 * @param queue the opencl command queue to issue commands to
 * @param prog the opencl program containing the kernel
 * @param iters number of iterations (random samples to take)
-* @param ifile file containing the input data
+* @param inputDataFile file containing the input data, csv or binary
 * @param errorThreshold error threshold for the specified model
 * @param convergenceThreshold convergence threshold for the specified model
-* 
-* @returns double runtime in seconds
+* @param global true, if the kernel operates on global memory and the model
+* kernel reads its own copy of the data set from the second memory channel
+* @param block the elements per block of the preemptive kernels, whose last
+* kernel is ransac_preempt instead of ransac_model_count, or 0
+* @param model the model of the flow vectors, RANSAC_MODEL_FLOW for points
 *
-* @author Jennifer Faj
-* @date June 10, 2020
+* @returns nothing
 *
 *****************************************************************************/
 
 template <class T>
-double runRansac(cl_device_id dev,
-                 cl_context ctx,
-                 cl_command_queue queue,
-                 cl_program prog,
-                 int iters,
-                 string ifile,
-                 int errorThreshold,
-                 float convergenceThreshold)
+void initRansacSession(RansacSession<T> &session,
+                       cl_device_id dev,
+                       cl_context ctx,
+                       cl_command_queue queue,
+                       cl_program prog,
+                       int iters,
+                       string inputDataFile,
+                       int errorThreshold,
+                       float convergenceThreshold,
+                       bool global,
+                       int block,
+                       int model)
 {
     int err;
 
-    string inputDataFile = "../../src/ransac/data/" + ifile;
+    session.queue = queue;
 
-    cl_command_queue queue_in = clCreateCommandQueue(ctx, dev, CL_QUEUE_PROFILING_ENABLE, &err);
+    session.queue_in = clCreateCommandQueue(ctx, dev, CL_QUEUE_PROFILING_ENABLE, &err);
     CL_CHECK_ERROR(err);
 
-    cl_command_queue queue_out = clCreateCommandQueue(ctx, dev, CL_QUEUE_PROFILING_ENABLE, &err);
+    session.queue_out = clCreateCommandQueue(ctx, dev, CL_QUEUE_PROFILING_ENABLE, &err);
     CL_CHECK_ERROR(err);
 
     //
     // find the kernels
     //
-    cl_kernel datakernel = clCreateKernel(prog, "ransac_data_handler", &err);
+    session.datakernel = clCreateKernel(prog, "ransac_data_handler", &err);
     CL_CHECK_ERROR(err);
 
-    cl_kernel modelkernel = clCreateKernel(prog, "ransac_model_gen", &err);
+    session.modelkernel = clCreateKernel(prog, "ransac_model_gen", &err);
     CL_CHECK_ERROR(err);
 
-    cl_kernel outkernel = clCreateKernel(prog, "ransac_model_count", &err);
+    session.outkernel = clCreateKernel(prog, block ? "ransac_preempt" : "ransac_model_count", &err);
     CL_CHECK_ERROR(err);
 
     //
     // read input data
     //
-    int n_idata = readInputSize(inputDataFile);
-    T *idata;
-    posix_memalign(reinterpret_cast<void**>(&idata), 64, n_idata * sizeof(T));
-    readInputData(idata, inputDataFile);
+    // the elements of the data set are uploaded from the mapping of a binary
+    // file, those of a structure of arrays file are interleaved first
+    openRansacData<T>(inputDataFile, session.file);
+    int n_idata = session.file.count;
+    session.n_idata = n_idata;
+
+    // all kernels but the global one hold the data set in local memory
+    if (!global && n_idata > RANSAC_N)
+    {
+        cout << "ERROR: the data set has " << n_idata << " elements, the local memory kernels hold at most "
+             << RANSAC_N << " (RANSAC_N), use the global model fvg" << endl;
+        exit(-1);
+    }
 
-    // 
-    // other parameters
-    //
-    int n_iterations = iters;
-    int *randNumbers;
-    posix_memalign(reinterpret_cast<void**>(&randNumbers), 64, 2 * n_iterations * sizeof(int));
-    genRandNumbers(randNumbers, n_iterations, n_idata);
+    if (session.file.layout == RANSAC_DATA_AOS)
+    {
+        session.idata = (const T*)session.file.elements;
+    }
+    else
+    {
+        T *elements;
+        if (posix_memalign(reinterpret_cast<void**>(&elements), 64, n_idata * sizeof(T)))
+        {
+            fprintf(stderr, "Aligned Malloc failed due to insufficient memory.\n");
+            exit(-1);
+        }
+        copyInput(session.file, elements);
+        session.idata = elements;
+    }
+    session.n_iterations = iters;
+    session.errorThreshold = errorThreshold;
+    session.convergenceThreshold = convergenceThreshold;
+    session.global = global;
+    session.block = block;
+    session.model = model;
+    session.samples = ransacSamples(model);
+
+    if (posix_memalign(reinterpret_cast<void**>(&session.randNumbers), 64, session.samples * iters * sizeof(int)))
+    {
+        fprintf(stderr, "Aligned Malloc failed due to insufficient memory.\n");
+        exit(-1);
+    }
 
-    int bestOutliers = n_idata;
-    int bestModelParams = -1; 
+    toSoA(session.file, session.soa);
+
+    // the random numbers of the passes differ, also within the same second
+    srand(time(NULL));
 
     //
     // create device buffers
     //
-    cl_mem d_idata = clCreateBuffer(ctx, CL_MEM_READ_ONLY, n_idata * sizeof(T), NULL, &err);
+    cl_mem_flags in_flags = global ? CL_MEM_READ_ONLY | CL_CHANNEL_1_INTELFPGA : CL_MEM_READ_ONLY;
+    session.d_idata = clCreateBuffer(ctx, in_flags, n_idata * sizeof(T), NULL, &err);
     CL_CHECK_ERROR(err);
-    cl_mem d_randNumbers = clCreateBuffer(ctx, CL_MEM_READ_ONLY, 2 * n_iterations * sizeof(int), NULL, &err);
+
+    session.d_idata_repl = NULL;
+    if (global)
+    {
+        session.d_idata_repl = clCreateBuffer(ctx, CL_MEM_READ_ONLY | CL_CHANNEL_2_INTELFPGA, n_idata * sizeof(T), NULL, &err);
+        CL_CHECK_ERROR(err);
+    }
+
+    session.d_randNumbers = clCreateBuffer(ctx, CL_MEM_READ_ONLY, session.samples * iters * sizeof(int), NULL, &err);
     CL_CHECK_ERROR(err);
 
     //
     // output buffers
-    // 
-    cl_mem n_bestModelParams = clCreateBuffer(ctx, CL_MEM_READ_WRITE, sizeof(int)*1, NULL, &err);
+    //
+    session.n_bestModelParams = clCreateBuffer(ctx, CL_MEM_READ_WRITE, sizeof(int)*1, NULL, &err);
     CL_CHECK_ERROR(err);
-    cl_mem n_bestOutliers = clCreateBuffer(ctx, CL_MEM_READ_WRITE, sizeof(int)*1, NULL, &err);
+    session.n_bestOutliers = clCreateBuffer(ctx, CL_MEM_READ_WRITE, sizeof(int)*1, NULL, &err);
     CL_CHECK_ERROR(err);
 
     //
-    // enqueue data
+    // the data set stays resident on the device
     //
-    err = clEnqueueWriteBuffer(queue_in, d_idata, true, 0, n_idata * sizeof(T), idata, 0, NULL, NULL);
+    err = clEnqueueWriteBuffer(session.queue_in, session.d_idata, true, 0, n_idata * sizeof(T), session.idata, 0, NULL, NULL);
     CL_CHECK_ERROR(err);
 
-    err = clFinish(queue_in);
-    CL_CHECK_ERROR(err);
+    if (global)
+    {
+        err = clEnqueueWriteBuffer(queue, session.d_idata_repl, true, 0, n_idata * sizeof(T), session.idata, 0, NULL, NULL);
+        CL_CHECK_ERROR(err);
+    }
 
-    err = clEnqueueWriteBuffer(queue, d_randNumbers, true, 0, 2 * n_iterations * sizeof(int), randNumbers, 0, NULL, NULL);
+    //
+    // set kernel arguments
+    //
+    err = clSetKernelArg(session.datakernel, 0, sizeof(cl_mem), (void*)&session.d_idata);
     CL_CHECK_ERROR(err);
-
-    err = clFinish(queue);
+    err = clSetKernelArg(session.datakernel, 1, sizeof(int), (void*)&errorThreshold);
+    CL_CHECK_ERROR(err);
+    err = clSetKernelArg(session.datakernel, 2, sizeof(int), (void*)&n_idata);
     CL_CHECK_ERROR(err);
 
-    err = clEnqueueWriteBuffer(queue_out, n_bestModelParams, true, 0, 1 * sizeof(int), &bestModelParams, 0, NULL, NULL);
+    // the global model kernel takes its copy of the data set first
+    int arg = 0;
+    if (global)
+    {
+        err = clSetKernelArg(session.modelkernel, arg++, sizeof(cl_mem), (void*)&session.d_idata_repl);
+        CL_CHECK_ERROR(err);
+    }
+    err = clSetKernelArg(session.modelkernel, arg++, sizeof(cl_mem), (void*)&session.d_randNumbers);
     CL_CHECK_ERROR(err);
-    err = clEnqueueWriteBuffer(queue_out, n_bestOutliers, true, 0, 1 * sizeof(int), &bestOutliers, 0, NULL, NULL);
+    err = clSetKernelArg(session.modelkernel, arg++, sizeof(int), (void*)&n_idata);
     CL_CHECK_ERROR(err);
 
-    err = clFinish(queue_out);
-    CL_CHECK_ERROR(err);
-    
+    // the preemptive kernels take the block size last
+    if (block)
+    {
+        err = clSetKernelArg(session.datakernel, 4, sizeof(int), (void*)&block);
+        CL_CHECK_ERROR(err);
+        err = clSetKernelArg(session.modelkernel, 3, sizeof(int), (void*)&block);
+        CL_CHECK_ERROR(err);
+    }
 
-    //
-    // set kernel arguments
-    //
-    err = clSetKernelArg(datakernel, 0, sizeof(cl_mem), (void*)&d_idata);
+    err = clSetKernelArg(session.outkernel, 0, sizeof(int), (void*)&n_idata);
     CL_CHECK_ERROR(err);
-    err = clSetKernelArg(datakernel, 1, sizeof(int), (void*)&errorThreshold);
+    if (block)
+        err = clSetKernelArg(session.outkernel, 2, sizeof(int), (void*)&block);
+    else
+        err = clSetKernelArg(session.outkernel, 2, sizeof(float), (void*)&convergenceThreshold);
     CL_CHECK_ERROR(err);
-    err = clSetKernelArg(datakernel, 2, sizeof(int), (void*)&n_idata);
+    err = clSetKernelArg(session.outkernel, 3, sizeof(cl_mem), (void*)&session.n_bestModelParams);
     CL_CHECK_ERROR(err);
-    err = clSetKernelArg(datakernel, 3, sizeof(int), (void*)&n_iterations);
+    err = clSetKernelArg(session.outkernel, 4, sizeof(cl_mem), (void*)&session.n_bestOutliers);
     CL_CHECK_ERROR(err);
 
-    err = clSetKernelArg(modelkernel, 0, sizeof(cl_mem), (void*)&d_randNumbers);
-    CL_CHECK_ERROR(err);
-    err = clSetKernelArg(modelkernel, 1, sizeof(int), (void*)&n_idata);
-    CL_CHECK_ERROR(err);
-    err = clSetKernelArg(modelkernel, 2, sizeof(int), (void*)&n_iterations);
-    CL_CHECK_ERROR(err);
+    setRansacIterations(session, iters);
+}
 
-    err = clSetKernelArg(outkernel, 0, sizeof(int), (void*)&n_idata);
-    CL_CHECK_ERROR(err);
-    err = clSetKernelArg(outkernel, 1, sizeof(int), (void*)&n_iterations);
-    CL_CHECK_ERROR(err);
-    err = clSetKernelArg(outkernel, 2, sizeof(float), (void*)&convergenceThreshold);
+/****************************************************************************
+* Function: runRansacPass()
+*
+* Purpose: Runs one pass of ransac on the resident data set: uploads fresh
+* random numbers, resets the best model and outlier count, runs the three
+* kernels and verifies the result against the multithreaded SIMD host
+* engine, which gives the same result as the sequential estimateModel().
+*
+* @param session the ransac session
+* @param hostTime output -the runtime of the host engine in seconds
+*
+* @returns double runtime of the outlier count kernel in seconds
+*
+*****************************************************************************/
+
+template <class T>
+double runRansacPass(RansacSession<T> &session, double &hostTime)
+{
+    int err;
+
+    // the model count kernel continues from these counts
+    int bestOutliers = session.n_idata;
+    int bestModelParams = 0;
+
+    genRandNumbers(session.randNumbers, session.n_iterations, session.n_idata, session.samples);
+
+    //
+    // enqueue data, the in-order queues keep the writes ahead of the kernels
+    //
+    err = clEnqueueWriteBuffer(session.queue, session.d_randNumbers, false, 0, session.samples * session.n_iterations * sizeof(int), session.randNumbers, 0, NULL, NULL);
     CL_CHECK_ERROR(err);
-    err = clSetKernelArg(outkernel, 3, sizeof(cl_mem), (void*)&n_bestModelParams);
+
+    err = clEnqueueWriteBuffer(session.queue_out, session.n_bestModelParams, false, 0, 1 * sizeof(int), &bestModelParams, 0, NULL, NULL);
     CL_CHECK_ERROR(err);
-    err = clSetKernelArg(outkernel, 4, sizeof(cl_mem), (void*)&n_bestOutliers);
+    err = clEnqueueWriteBuffer(session.queue_out, session.n_bestOutliers, false, 0, 1 * sizeof(int), &bestOutliers, 0, NULL, NULL);
     CL_CHECK_ERROR(err);
 
     //
@@ -161,22 +416,24 @@ double runRansac(cl_device_id dev,
     double nanosec = 0;
     cl_event event = NULL;
 
-    err = clEnqueueTask(queue_in, datakernel, 0, NULL, &event);
+    // Uncomment the commented lines below to obtain profiling information from the autorun kernels
+    // when synthesizing with profiling enabled
+    err = clEnqueueTask(session.queue_in, session.datakernel, 0, NULL, NULL);
     CL_CHECK_ERROR(err);
     // clGetProfileDataDeviceIntelFPGA(dev, prog, true, true, NULL, NULL, NULL, NULL, &err);
     // CL_CHECK_ERROR(err);
-    err = clEnqueueTask(queue, modelkernel, 0, NULL, &event);
+    err = clEnqueueTask(session.queue, session.modelkernel, 0, NULL, NULL);
     CL_CHECK_ERROR(err);
     // clGetProfileDataDeviceIntelFPGA(dev, prog, true, true, NULL, NULL, NULL, NULL, &err);
     // CL_CHECK_ERROR(err);
-    err = clEnqueueTask(queue_out, outkernel, 0, NULL, &event);
+    err = clEnqueueTask(session.queue_out, session.outkernel, 0, NULL, &event);
     CL_CHECK_ERROR(err);
 
-    err = clFinish(queue_in);
+    err = clFinish(session.queue_in);
     CL_CHECK_ERROR(err);
-    err = clFinish(queue);
+    err = clFinish(session.queue);
     CL_CHECK_ERROR(err);
-    err = clFinish(queue_out);
+    err = clFinish(session.queue_out);
     CL_CHECK_ERROR (err);
 
     //
@@ -188,46 +445,39 @@ double runRansac(cl_device_id dev,
     err = clGetEventProfilingInfo(event, CL_PROFILING_COMMAND_SUBMIT,
                                     sizeof(cl_ulong), &submitTime, NULL);
     CL_CHECK_ERROR(err);
-    
+
     err = clGetEventProfilingInfo(event, CL_PROFILING_COMMAND_END,
                                     sizeof(cl_ulong), &endTime, NULL);
     CL_CHECK_ERROR(err);
 
     nanosec = endTime - submitTime;
+    clReleaseEvent(event);
 
     //
     // read buffers
     //
-    err = clEnqueueReadBuffer(queue_out, n_bestModelParams, true, 0, 1 * sizeof(int), 
+    err = clEnqueueReadBuffer(session.queue_out, session.n_bestModelParams, true, 0, 1 * sizeof(int),
                                 &bestModelParams, 0, NULL, NULL);
     CL_CHECK_ERROR(err);
-    err = clEnqueueReadBuffer(queue_out, n_bestOutliers, true, 0, 1 * sizeof(int), 
+    err = clEnqueueReadBuffer(session.queue_out, session.n_bestOutliers, true, 0, 1 * sizeof(int),
                                 &bestOutliers, 0, NULL, NULL);
     CL_CHECK_ERROR(err);
 
-    
-    err = clFinish(queue_out);
-    CL_CHECK_ERROR (err);
-
     //
     // verify
     //
-    verify(idata, n_idata, randNumbers, iters, errorThreshold,
-        convergenceThreshold, bestModelParams, bestOutliers);
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
 
-    //
-    // free device memory
-    //
-    err = clReleaseMemObject(d_idata);
-    CL_CHECK_ERROR(err);
-    err = clReleaseMemObject(d_randNumbers);
-    CL_CHECK_ERROR(err);
-    err = clReleaseMemObject(n_bestModelParams);
-    CL_CHECK_ERROR(err);
-    err = clReleaseMemObject(n_bestOutliers);
-    CL_CHECK_ERROR(err);
+    RansacResult host = hostRansac(session.soa, session.randNumbers, session.n_iterations,
+                                   session.errorThreshold, session.convergenceThreshold, session.model);
+
+    hostTime = chrono::duration<double>(chrono::steady_clock::now() - start).count();
 
-    // What metric?
+    if (!matchesHost(session, host, bestModelParams, bestOutliers, session.n_iterations))
+    {
+        printf("Test failed\n");
+        exit(EXIT_FAILURE);
+    }
 
     //
     // return the runtime in seconds
@@ -236,237 +486,822 @@ double runRansac(cl_device_id dev,
 }
 
 /****************************************************************************
-* Function: runRansacGlobal()
+* Function: runRansacPreemptivePass()
 *
-* Purpose: This function will be used, if the kernel operates on global memory 
+* Purpose: Runs one pass of preemptive ransac on the resident data set: uploads
+* fresh random numbers and runs the preemptive kernels, which score all
+* hypotheses on the first block of the data set, keep the better half for
+* the next block and so on. The surviving hypothesis and its score are
+* verified against the host engine.
 *
-* @param dev the opencl device id to use for the benchmark
-* @param ctx the opencl context to use for the benchmark
-* @param queue the opencl command queue to issue commands to
-* @param prog the opencl program containing the kernel
-* @param iters number of iterations (random samples to take)
-* @param ifile file containing the input data
-* @param errorThreshold error threshold for the specified model
-* @param convergenceThreshold convergence threshold for the specified model
-* 
-* @returns double runtime in seconds
+* @param session the ransac session of the preemptive kernels
+* @param result output -the result of the host engine
+* @param hostTime output -the runtime of the host engine in seconds
 *
-* @author Jennifer Faj
-* @date June 10, 2020
+* @returns double runtime of the preempt kernel in seconds
 *
 *****************************************************************************/
 
 template <class T>
-double runRansacGlobal(cl_device_id dev,
-                 cl_context ctx,
-                 cl_command_queue queue,
-                 cl_program prog,
-                 int iters,
-                 string ifile,
-                 int errorThreshold,
-                 float convergenceThreshold)
+double runRansacPreemptivePass(RansacSession<T> &session, RansacPreemptiveResult &result, double &hostTime)
 {
     int err;
 
-    string inputDataFile = "../../src/ransac/data/" + ifile;
+    int bestModel;
+    int bestOutliers;
 
-    cl_command_queue queue_in = clCreateCommandQueue(ctx, dev, CL_QUEUE_PROFILING_ENABLE, &err);
-    CL_CHECK_ERROR(err);
+    genRandNumbers(session.randNumbers, session.n_iterations, session.n_idata, session.samples);
 
-    cl_command_queue queue_out = clCreateCommandQueue(ctx, dev, CL_QUEUE_PROFILING_ENABLE, &err);
+    err = clEnqueueWriteBuffer(session.queue, session.d_randNumbers, false, 0, session.samples * session.n_iterations * sizeof(int), session.randNumbers, 0, NULL, NULL);
     CL_CHECK_ERROR(err);
 
     //
-    // find the kernels
+    // run the kernel
     //
-    cl_kernel datakernel = clCreateKernel(prog, "ransac_data_handler", &err);
+    cl_event event = NULL;
+
+    err = clEnqueueTask(session.queue_in, session.datakernel, 0, NULL, NULL);
+    CL_CHECK_ERROR(err);
+    err = clEnqueueTask(session.queue, session.modelkernel, 0, NULL, NULL);
+    CL_CHECK_ERROR(err);
+    err = clEnqueueTask(session.queue_out, session.outkernel, 0, NULL, &event);
     CL_CHECK_ERROR(err);
 
-    cl_kernel modelkernel = clCreateKernel(prog, "ransac_model_gen", &err);
+    err = clFinish(session.queue_in);
     CL_CHECK_ERROR(err);
+    err = clFinish(session.queue);
+    CL_CHECK_ERROR(err);
+    err = clFinish(session.queue_out);
+    CL_CHECK_ERROR (err);
 
-    cl_kernel outkernel = clCreateKernel(prog, "ransac_model_count", &err);
+    cl_ulong submitTime;
+    cl_ulong endTime;
+
+    err = clGetEventProfilingInfo(event, CL_PROFILING_COMMAND_SUBMIT,
+                                    sizeof(cl_ulong), &submitTime, NULL);
     CL_CHECK_ERROR(err);
 
-    //
-    // read input data
-    //
-    int n_idata = readInputSize(inputDataFile);
-    T *idata;
-    posix_memalign(reinterpret_cast<void**>(&idata), 64, n_idata * sizeof(T));
-    readInputData(idata, inputDataFile);
+    err = clGetEventProfilingInfo(event, CL_PROFILING_COMMAND_END,
+                                    sizeof(cl_ulong), &endTime, NULL);
+    CL_CHECK_ERROR(err);
 
-    // 
-    // other parameters
-    //
-    int n_iterations = iters;
-    int *randNumbers;
-    posix_memalign(reinterpret_cast<void**>(&randNumbers), 64, 2 * n_iterations * sizeof(int));
-    genRandNumbers(randNumbers, n_iterations, n_idata);
+    double nanosec = endTime - submitTime;
+    clReleaseEvent(event);
 
-    int bestOutliers = n_idata;
-    int bestModelParams = -1; 
+    err = clEnqueueReadBuffer(session.queue_out, session.n_bestModelParams, true, 0, 1 * sizeof(int),
+                                &bestModel, 0, NULL, NULL);
+    CL_CHECK_ERROR(err);
+    err = clEnqueueReadBuffer(session.queue_out, session.n_bestOutliers, true, 0, 1 * sizeof(int),
+                                &bestOutliers, 0, NULL, NULL);
+    CL_CHECK_ERROR(err);
 
     //
-    // create device buffers
+    // verify
     //
-    cl_mem d_idata = clCreateBuffer(ctx, CL_MEM_READ_ONLY | CL_CHANNEL_1_INTELFPGA, n_idata * sizeof(T), NULL, &err);
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+
+    result = ransacPreemptiveSIMD(session.soa, session.randNumbers, session.n_iterations,
+                                  session.block, session.errorThreshold);
+
+    hostTime = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    if (result.bestModel != bestModel || result.score != bestOutliers)
+    {
+        printf("Test failed\n");
+        exit(EXIT_FAILURE);
+    }
+
+    return nanosec / 1.e9;
+}
+
+/****************************************************************************
+* Function: runRansacAdaptivePass()
+*
+* Purpose: Runs one pass of adaptive ransac on the resident data set: the
+* kernels run batch hypotheses per launch and the model count kernel keeps
+* the best outlier count across the launches, from which the host derives
+* the hypotheses needed to find an all inlier sample with the probability
+* confidence, N = log(1 - p) / log(1 - w^2). The launches stop once N or the
+* session iterations are reached. The result and the number of hypotheses
+* run are verified against the batched host engine.
+*
+* @param session the ransac session
+* @param batch number of hypotheses per launch, divides the session iterations
+* @param confidence the probability p of an all inlier sample, 0 < p < 1
+* @param evaluated output -the number of hypotheses run
+* @param hostTime output -the runtime of the host engine in seconds
+*
+* @returns double time to the model in seconds, from the first upload of
+* random numbers to the read of the final counts
+*
+*****************************************************************************/
+
+template <class T>
+double runRansacAdaptivePass(RansacSession<T> &session, int batch, float confidence,
+                             int &evaluated, double &hostTime)
+{
+    int err;
+
+    int bestOutliers = session.n_idata;
+    int bestModelParams = 0;
+
+    genRandNumbers(session.randNumbers, session.n_iterations, session.n_idata, session.samples);
+    setRansacIterations(session, batch);
+
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+
+    err = clEnqueueWriteBuffer(session.queue_out, session.n_bestModelParams, false, 0, 1 * sizeof(int), &bestModelParams, 0, NULL, NULL);
     CL_CHECK_ERROR(err);
-    cl_mem d_idata_repl = clCreateBuffer(ctx, CL_MEM_READ_ONLY | CL_CHANNEL_2_INTELFPGA, n_idata * sizeof(T), NULL, &err);
+    err = clEnqueueWriteBuffer(session.queue_out, session.n_bestOutliers, false, 0, 1 * sizeof(int), &bestOutliers, 0, NULL, NULL);
     CL_CHECK_ERROR(err);
-    cl_mem d_randNumbers = clCreateBuffer(ctx, CL_MEM_READ_ONLY, 2 * n_iterations * sizeof(int), NULL, &err);
+
+    for (evaluated = 0; evaluated < session.n_iterations; )
+    {
+        // the model kernel reads the random numbers of the batch from the start
+        err = clEnqueueWriteBuffer(session.queue, session.d_randNumbers, false, 0, session.samples * batch * sizeof(int),
+                                   session.randNumbers + session.samples * evaluated, 0, NULL, NULL);
+        CL_CHECK_ERROR(err);
+
+        err = clEnqueueTask(session.queue_in, session.datakernel, 0, NULL, NULL);
+        CL_CHECK_ERROR(err);
+        err = clEnqueueTask(session.queue, session.modelkernel, 0, NULL, NULL);
+        CL_CHECK_ERROR(err);
+        err = clEnqueueTask(session.queue_out, session.outkernel, 0, NULL, NULL);
+        CL_CHECK_ERROR(err);
+
+        err = clEnqueueReadBuffer(session.queue_out, session.n_bestOutliers, true, 0, 1 * sizeof(int),
+                                  &bestOutliers, 0, NULL, NULL);
+        CL_CHECK_ERROR(err);
+
+        evaluated += batch;
+
+        float inlierRatio = float(session.n_idata - bestOutliers) / session.n_idata;
+        if (evaluated >= ransacIterations(inlierRatio, confidence, session.samples))
+            break;
+    }
+
+    err = clEnqueueReadBuffer(session.queue_out, session.n_bestModelParams, true, 0, 1 * sizeof(int),
+                              &bestModelParams, 0, NULL, NULL);
     CL_CHECK_ERROR(err);
 
-    //
-    // output buffers
-    // 
-    cl_mem n_bestModelParams = clCreateBuffer(ctx, CL_MEM_READ_WRITE, sizeof(int)*1, NULL, &err);
+    double timeToModel = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    err = clFinish(session.queue_in);
     CL_CHECK_ERROR(err);
-    cl_mem n_bestOutliers = clCreateBuffer(ctx, CL_MEM_READ_WRITE, sizeof(int)*1, NULL, &err);
+    err = clFinish(session.queue);
     CL_CHECK_ERROR(err);
 
+    setRansacIterations(session, session.n_iterations);
+
     //
-    // enqueue data
+    // verify
     //
-    err = clEnqueueWriteBuffer(queue_in, d_idata, true, 0, n_idata * sizeof(T), idata, 0, NULL, NULL);
-    CL_CHECK_ERROR(err);
+    start = chrono::steady_clock::now();
 
-    err = clFinish(queue_in);
-    CL_CHECK_ERROR(err);
+    // a near miss may stop the transforms a batch apart, so they are
+    // compared on the hypotheses the kernels evaluated instead
+    int hostEvaluated = evaluated;
+    RansacResult host;
 
-    err = clEnqueueWriteBuffer(queue, d_idata_repl, true, 0, n_idata * sizeof(T), idata, 0, NULL, NULL);
-    CL_CHECK_ERROR(err);
+    if (session.model == RANSAC_MODEL_FLOW)
+    {
+        host = hostRansacAdaptive(session.soa, session.randNumbers, session.n_iterations, batch,
+                                  session.errorThreshold, session.convergenceThreshold,
+                                  confidence, hostEvaluated, session.model);
+    }
+    else
+    {
+        host = hostRansac(session.soa, session.randNumbers, evaluated, session.errorThreshold,
+                          session.convergenceThreshold, session.model);
+    }
 
-    err = clEnqueueWriteBuffer(queue, d_randNumbers, true, 0, 2 * n_iterations * sizeof(int), randNumbers, 0, NULL, NULL);
-    CL_CHECK_ERROR(err);
+    hostTime = chrono::duration<double>(chrono::steady_clock::now() - start).count();
 
-    err = clFinish(queue);
-    CL_CHECK_ERROR(err);
+    if (hostEvaluated != evaluated || !matchesHost(session, host, bestModelParams, bestOutliers, evaluated))
+    {
+        printf("Test failed\n");
+        exit(EXIT_FAILURE);
+    }
 
-    err = clEnqueueWriteBuffer(queue_out, n_bestModelParams, true, 0, 1 * sizeof(int), &bestModelParams, 0, NULL, NULL);
+    return timeToModel;
+}
+
+/****************************************************************************
+* Function: listRansacFrames()
+*
+* Purpose: Lists the files of the frame directory of the stream mode in the
+* order of their names. Exits if the directory cannot be opened or is empty.
+*
+* @param frameDir the directory of the frames, ending in a slash
+*
+* @returns the paths of the frames
+*
+*****************************************************************************/
+
+vector<string> listRansacFrames(string frameDir)
+{
+    vector<string> names;
+    DIR *dir = opendir(frameDir.c_str());
+    if (dir == NULL)
+    {
+        cout << "ERROR: cannot open the frame directory " << frameDir << endl;
+        exit(-1);
+    }
+
+    for (struct dirent *entry = readdir(dir); entry != NULL; entry = readdir(dir))
+    {
+        struct stat info;
+        string name = frameDir + entry->d_name;
+        if (stat(name.c_str(), &info) == 0 && S_ISREG(info.st_mode))
+            names.push_back(name);
+    }
+    closedir(dir);
+
+    if (names.empty())
+    {
+        cout << "ERROR: the frame directory " << frameDir << " has no files" << endl;
+        exit(-1);
+    }
+
+    sort(names.begin(), names.end());
+    return names;
+}
+
+/****************************************************************************
+* Function: readRansacFrames()
+*
+* Purpose: Reads the frames of the stream mode, or generates them with the
+* elements of the session data set, each drawn with its own seed.
+*
+* @param names the paths of the frames, empty to generate them
+* @param n the number of elements of each frame
+* @param frames output -the distinct frames, to be freed
+*
+* @returns nothing
+*
+*****************************************************************************/
+
+template <class T>
+void readRansacFrames(const vector<string> &names, int n, vector<T*> &frames)
+{
+    if (names.empty())
+    {
+        RansacGroundTruth truth;
+        initGroundTruth(truth, (const T*)NULL);
+
+        for (int f = 0; f < RANSAC_STREAM_FRAMES; f++)
+        {
+            T *frame;
+            if (posix_memalign(reinterpret_cast<void**>(&frame), 64, n * sizeof(T)))
+            {
+                fprintf(stderr, "Aligned Malloc failed due to insufficient memory.\n");
+                exit(-1);
+            }
+            genInputData(frame, n, truth, f + 1);
+            frames.push_back(frame);
+        }
+        return;
+    }
+
+    for (const string &name : names)
+    {
+        int count;
+        frames.push_back(readRansacData<T>(name, count));
+
+        if (count != n)
+        {
+            cout << "ERROR: the frame " << name << " has " << count << " elements, not " << n << endl;
+            exit(-1);
+        }
+    }
+}
+
+/****************************************************************************
+* Function: runRansacStream()
+*
+* Purpose: Runs ransac on a stream of frames: the frames alternate between
+* two sets of device buffers, so that the upload of frame i+1 on its own
+* queue overlaps ransac on frame i and the read back of frame i-1 on its
+* own queue, each waiting on the events of the commands it depends on. Each
+* frame gets fresh random numbers and reset counts. The results of all
+* frames are verified against the host engine after the stream.
+*
+* @param session the ransac session, whose kernels and queues are used
+* @param ctx the opencl context to use for the benchmark
+* @param dev the opencl device id to use for the benchmark
+* @param frames the distinct frames, repeated for numFrames frames
+* @param numFrames the number of frames to stream
+*
+* @returns The wall time of the stream and the per frame latencies
+*
+*****************************************************************************/
+
+template <class T>
+RansacStreamResult runRansacStream(RansacSession<T> &session,
+                                   cl_context ctx,
+                                   cl_device_id dev,
+                                   vector<T*> &frames,
+                                   int numFrames)
+{
+    int err;
+    int n = session.n_idata;
+    int iters = session.n_iterations;
+    size_t dataBytes = n * sizeof(T);
+    int samples = session.samples;
+    size_t randBytes = samples * iters * sizeof(int);
+
+    RansacStreamResult result;
+    result.latencies.resize(numFrames);
+
+    cl_command_queue uploadQueue = clCreateCommandQueue(ctx, dev, 0, &err);
     CL_CHECK_ERROR(err);
-    err = clEnqueueWriteBuffer(queue_out, n_bestOutliers, true, 0, 1 * sizeof(int), &bestOutliers, 0, NULL, NULL);
+    cl_command_queue readQueue = clCreateCommandQueue(ctx, dev, 0, &err);
     CL_CHECK_ERROR(err);
 
-    err = clFinish(queue_out);
-    CL_CHECK_ERROR(err);
-    
+    RansacStreamSlot slots[2];
+    for (RansacStreamSlot &slot : slots)
+    {
+        cl_mem_flags in_flags = session.global ? CL_MEM_READ_ONLY | CL_CHANNEL_1_INTELFPGA : CL_MEM_READ_ONLY;
+        slot.d_idata = clCreateBuffer(ctx, in_flags, dataBytes, NULL, &err);
+        CL_CHECK_ERROR(err);
+
+        slot.d_idata_repl = NULL;
+        if (session.global)
+        {
+            slot.d_idata_repl = clCreateBuffer(ctx, CL_MEM_READ_ONLY | CL_CHANNEL_2_INTELFPGA, dataBytes, NULL, &err);
+            CL_CHECK_ERROR(err);
+        }
+
+        slot.d_randNumbers = clCreateBuffer(ctx, CL_MEM_READ_ONLY, randBytes, NULL, &err);
+        CL_CHECK_ERROR(err);
+        slot.n_bestModelParams = clCreateBuffer(ctx, CL_MEM_READ_WRITE, sizeof(int), NULL, &err);
+        CL_CHECK_ERROR(err);
+        slot.n_bestOutliers = clCreateBuffer(ctx, CL_MEM_READ_WRITE, sizeof(int), NULL, &err);
+        CL_CHECK_ERROR(err);
+
+        if (posix_memalign(reinterpret_cast<void**>(&slot.randNumbers), 64, randBytes))
+        {
+            fprintf(stderr, "Aligned Malloc failed due to insufficient memory.\n");
+            exit(-1);
+        }
+    }
+
+    // the model count kernel continues from these counts
+    const int reset[2] = { 0, n };
+
+    vector<int> randNumbers(size_t(samples) * iters * numFrames);
+    vector<int> candidates(numFrames), bestOutliers(numFrames);
+    vector<chrono::steady_clock::time_point> readyTimes(numFrames);
+
+    // Writes the frame, its random numbers and the reset counts into its
+    // slot, once the frame two before is done with the slot.
+    auto uploadFrame = [&](int frame)
+    {
+        RansacStreamSlot &slot = slots[frame % 2];
+        vector<cl_event> waits;
+        if (frame >= 2)
+            waits = { slot.data, slot.model, slot.read };
+
+        genRandNumbers(slot.randNumbers, iters, n, samples);
+        memcpy(&randNumbers[size_t(samples) * iters * frame], slot.randNumbers, randBytes);
+        readyTimes[frame] = chrono::steady_clock::now();
+
+        const T *data = frames[frame % frames.size()];
+        err = clEnqueueWriteBuffer(uploadQueue, slot.d_idata, false, 0, dataBytes, data,
+                                   waits.size(), waits.empty() ? NULL : waits.data(), NULL);
+        CL_CHECK_ERROR(err);
+        if (session.global)
+        {
+            err = clEnqueueWriteBuffer(uploadQueue, slot.d_idata_repl, false, 0, dataBytes, data, 0, NULL, NULL);
+            CL_CHECK_ERROR(err);
+        }
+        err = clEnqueueWriteBuffer(uploadQueue, slot.d_randNumbers, false, 0, randBytes, slot.randNumbers, 0, NULL, NULL);
+        CL_CHECK_ERROR(err);
+        err = clEnqueueWriteBuffer(uploadQueue, slot.n_bestModelParams, false, 0, sizeof(int), &reset[0], 0, NULL, NULL);
+        CL_CHECK_ERROR(err);
+        err = clEnqueueWriteBuffer(uploadQueue, slot.n_bestOutliers, false, 0, sizeof(int), &reset[1], 0, NULL, &slot.upload);
+        CL_CHECK_ERROR(err);
+        err = clFlush(uploadQueue);
+        CL_CHECK_ERROR(err);
+
+        for (cl_event event : waits)
+            clReleaseEvent(event);
+    };
+
+    // Waits for the read back of a frame.
+    auto retireFrame = [&](int frame)
+    {
+        RansacStreamSlot &slot = slots[frame % 2];
+
+        err = clWaitForEvents(1, &slot.read);
+        CL_CHECK_ERROR(err);
+
+        result.latencies[frame] =
+            chrono::duration<double>(chrono::steady_clock::now() - readyTimes[frame]).count();
+
+        candidates[frame] = slot.results[0];
+        bestOutliers[frame] = slot.results[1];
+        clReleaseEvent(slot.out);
+    };
 
     //
-    // set kernel arguments
+    // run the stream
     //
-    err = clSetKernelArg(datakernel, 0, sizeof(cl_mem), (void*)&d_idata);
-    CL_CHECK_ERROR(err);
-    err = clSetKernelArg(datakernel, 1, sizeof(int), (void*)&errorThreshold);
-    CL_CHECK_ERROR(err);
-    err = clSetKernelArg(datakernel, 2, sizeof(int), (void*)&n_idata);
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+
+    uploadFrame(0);
+
+    for (int frame = 0; frame < numFrames; frame++)
+    {
+        RansacStreamSlot &slot = slots[frame % 2];
+
+        err = clSetKernelArg(session.datakernel, 0, sizeof(cl_mem), (void*)&slot.d_idata);
+        CL_CHECK_ERROR(err);
+
+        // the global model kernel takes its copy of the data set first
+        int arg = 0;
+        if (session.global)
+        {
+            err = clSetKernelArg(session.modelkernel, arg++, sizeof(cl_mem), (void*)&slot.d_idata_repl);
+            CL_CHECK_ERROR(err);
+        }
+        err = clSetKernelArg(session.modelkernel, arg, sizeof(cl_mem), (void*)&slot.d_randNumbers);
+        CL_CHECK_ERROR(err);
+
+        err = clSetKernelArg(session.outkernel, 3, sizeof(cl_mem), (void*)&slot.n_bestModelParams);
+        CL_CHECK_ERROR(err);
+        err = clSetKernelArg(session.outkernel, 4, sizeof(cl_mem), (void*)&slot.n_bestOutliers);
+        CL_CHECK_ERROR(err);
+
+        err = clEnqueueTask(session.queue_in, session.datakernel, 1, &slot.upload, &slot.data);
+        CL_CHECK_ERROR(err);
+        err = clEnqueueTask(session.queue, session.modelkernel, 1, &slot.upload, &slot.model);
+        CL_CHECK_ERROR(err);
+        err = clEnqueueTask(session.queue_out, session.outkernel, 1, &slot.upload, &slot.out);
+        CL_CHECK_ERROR(err);
+        clReleaseEvent(slot.upload);
+
+        err = clFlush(session.queue_in);
+        CL_CHECK_ERROR(err);
+        err = clFlush(session.queue);
+        CL_CHECK_ERROR(err);
+        err = clFlush(session.queue_out);
+        CL_CHECK_ERROR(err);
+
+        err = clEnqueueReadBuffer(readQueue, slot.n_bestModelParams, false, 0, sizeof(int),
+                                  &slot.results[0], 1, &slot.out, NULL);
+        CL_CHECK_ERROR(err);
+        err = clEnqueueReadBuffer(readQueue, slot.n_bestOutliers, false, 0, sizeof(int),
+                                  &slot.results[1], 0, NULL, &slot.read);
+        CL_CHECK_ERROR(err);
+        err = clFlush(readQueue);
+        CL_CHECK_ERROR(err);
+
+        // the slot of the next frame is free once the frame before is read back
+        if (frame >= 1)
+            retireFrame(frame - 1);
+
+        if (frame + 1 < numFrames)
+            uploadFrame(frame + 1);
+    }
+
+    retireFrame(numFrames - 1);
+
+    result.seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    for (int frame = max(0, numFrames - 2); frame < numFrames; frame++)
+    {
+        RansacStreamSlot &slot = slots[frame % 2];
+        clReleaseEvent(slot.data);
+        clReleaseEvent(slot.model);
+        clReleaseEvent(slot.read);
+    }
+
+    //
+    // verify
+    //
+    vector<RansacSoA<T>> soas(frames.size());
+    for (size_t f = 0; f < frames.size() && f < size_t(numFrames); f++)
+        toSoA(frames[f], n, soas[f]);
+
+    for (int frame = 0; frame < numFrames; frame++)
+    {
+        RansacResult host = hostRansac(soas[frame % frames.size()], &randNumbers[size_t(samples) * iters * frame],
+                                       iters, session.errorThreshold, session.convergenceThreshold, session.model);
+
+        if (!matchesHost(session, host, candidates[frame], bestOutliers[frame], iters))
+        {
+            printf("Test failed\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    for (RansacStreamSlot &slot : slots)
+    {
+        err = clReleaseMemObject(slot.d_idata);
+        CL_CHECK_ERROR(err);
+        if (slot.d_idata_repl != NULL)
+        {
+            err = clReleaseMemObject(slot.d_idata_repl);
+            CL_CHECK_ERROR(err);
+        }
+        err = clReleaseMemObject(slot.d_randNumbers);
+        CL_CHECK_ERROR(err);
+        err = clReleaseMemObject(slot.n_bestModelParams);
+        CL_CHECK_ERROR(err);
+        err = clReleaseMemObject(slot.n_bestOutliers);
+        CL_CHECK_ERROR(err);
+        free(slot.randNumbers);
+    }
+
+    err = clReleaseCommandQueue(uploadQueue);
     CL_CHECK_ERROR(err);
-    err = clSetKernelArg(datakernel, 3, sizeof(int), (void*)&n_iterations);
+    err = clReleaseCommandQueue(readQueue);
     CL_CHECK_ERROR(err);
 
-    err = clSetKernelArg(modelkernel, 0, sizeof(cl_mem), (void*)&d_idata_repl);
+    return result;
+}
+
+/****************************************************************************
+* Function: releaseRansacSession()
+*
+* Purpose: Frees the queues, kernels, device and host memory of the session.
+*
+* @param session the ransac session
+*
+* @returns nothing
+*
+*****************************************************************************/
+
+template <class T>
+void releaseRansacSession(RansacSession<T> &session)
+{
+    int err;
+
+    err = clReleaseMemObject(session.d_idata);
     CL_CHECK_ERROR(err);
-    err = clSetKernelArg(modelkernel, 1, sizeof(cl_mem), (void*)&d_randNumbers);
+    if (session.d_idata_repl != NULL)
+    {
+        err = clReleaseMemObject(session.d_idata_repl);
+        CL_CHECK_ERROR(err);
+    }
+    err = clReleaseMemObject(session.d_randNumbers);
     CL_CHECK_ERROR(err);
-    err = clSetKernelArg(modelkernel, 2, sizeof(int), (void*)&n_idata);
+    err = clReleaseMemObject(session.n_bestModelParams);
     CL_CHECK_ERROR(err);
-    err = clSetKernelArg(modelkernel, 3, sizeof(int), (void*)&n_iterations);
+    err = clReleaseMemObject(session.n_bestOutliers);
     CL_CHECK_ERROR(err);
 
-    err = clSetKernelArg(outkernel, 0, sizeof(int), (void*)&n_idata);
+    err = clReleaseKernel(session.datakernel);
     CL_CHECK_ERROR(err);
-    err = clSetKernelArg(outkernel, 1, sizeof(int), (void*)&n_iterations);
+    err = clReleaseKernel(session.modelkernel);
     CL_CHECK_ERROR(err);
-    err = clSetKernelArg(outkernel, 2, sizeof(float), (void*)&convergenceThreshold);
+    err = clReleaseKernel(session.outkernel);
     CL_CHECK_ERROR(err);
-    err = clSetKernelArg(outkernel, 3, sizeof(cl_mem), (void*)&n_bestModelParams);
+
+    err = clReleaseCommandQueue(session.queue_in);
     CL_CHECK_ERROR(err);
-    err = clSetKernelArg(outkernel, 4, sizeof(cl_mem), (void*)&n_bestOutliers);
+    err = clReleaseCommandQueue(session.queue_out);
     CL_CHECK_ERROR(err);
 
-    //
-    // run the kernel
-    //
-    double nanosec = 0;
-    cl_event event = NULL;
+    if (session.idata != session.file.elements)
+        free((void*)session.idata);
+    releaseInput(session.file);
+    free(session.randNumbers);
+}
 
-    // Uncomment the commented lines below to obtain profiling information from the autorun kernels
-    // when synthesizing with profiling enabled
-    err = clEnqueueTask(queue_in, datakernel, 0, NULL, &event);
-    CL_CHECK_ERROR(err);
-    // clGetProfileDataDeviceIntelFPGA(dev, prog, true, true, NULL, NULL, NULL, NULL, &err);
-    // CL_CHECK_ERROR(err);
-    err = clEnqueueTask(queue, modelkernel, 0, NULL, &event);
-    CL_CHECK_ERROR(err);
-    // clGetProfileDataDeviceIntelFPGA(dev, prog, true, true, NULL, NULL, NULL, NULL, &err);
-    // CL_CHECK_ERROR(err);
-    err = clEnqueueTask(queue_out, outkernel, 0, NULL, &event);
-    CL_CHECK_ERROR(err);
+/****************************************************************************
+* Function: runRansac()
+*
+* Purpose: Runs the passes of ransac for one model on a single session, the
+* setup of which is reported apart from the passes.
+*
+* @param dev the opencl device id to use for the benchmark
+* @param ctx the opencl context to use for the benchmark
+* @param queue the opencl command queue to issue commands to
+* @param prog the opencl program containing the kernel
+* @param resultDB results from the benchmark are stored in this db
+* @param options the options parser / parameter database
+* @param appOptions the ransac options
+* @param errorThreshold error threshold for the specified model
+* @param convergenceThreshold convergence threshold for the specified model
+* @param global true, if the kernel operates on global memory
+* @param preemptive true, to run the preemptive kernels
+* @param model the model of the flow vectors, RANSAC_MODEL_FLOW for points
+*
+* @returns nothing
+*
+* @author Jennifer Faj
+* @date June 10, 2020
+*
+*****************************************************************************/
 
-    err = clFinish(queue_in);
-    CL_CHECK_ERROR(err);
-    err = clFinish(queue);
-    CL_CHECK_ERROR(err);
-    err = clFinish(queue_out);
-    CL_CHECK_ERROR (err);
+template <class T>
+void runRansac(cl_device_id dev,
+               cl_context ctx,
+               cl_command_queue queue,
+               cl_program prog,
+               BenchmarkDatabase &resultDB,
+               BenchmarkOptions &options,
+               ApplicationOptions &appOptions,
+               int errorThreshold,
+               float convergenceThreshold,
+               bool global,
+               bool preemptive,
+               int model)
+{
+    int iters = appOptions.iterations;
+    string dataDir = appOptions.ransacDataDir;
+    if (!dataDir.empty() && dataDir.back() != '/')
+        dataDir += "/";
+    string inputDataFile = dataDir + appOptions.ifile;
+
+    // the adaptive mode runs the hypotheses in batches up to the iterations
+    float confidence = appOptions.ransacConfidence;
+    int batch = appOptions.ransacBatch;
+    bool adaptive = confidence > 0;
+
+    if (adaptive && (confidence >= 1 || batch <= 0 || iters % batch != 0))
+    {
+        cout << "ERROR: --ransac-confidence must be below 1 and --ransac-batch divide the iterations" << endl;
+        exit(-1);
+    }
 
-    //
-    // get the timing/rate info
-    //
-    cl_ulong submitTime;
-    cl_ulong endTime;
+    // the stream mode runs the frames back to back instead of the passes
+    int numFrames = appOptions.ransacFrames;
+    bool stream = numFrames > 0;
 
-    err = clGetEventProfilingInfo(event, CL_PROFILING_COMMAND_SUBMIT,
-                                    sizeof(cl_ulong), &submitTime, NULL);
-    CL_CHECK_ERROR(err);
-    
-    err = clGetEventProfilingInfo(event, CL_PROFILING_COMMAND_END,
-                                    sizeof(cl_ulong), &endTime, NULL);
-    CL_CHECK_ERROR(err);
+    if (stream && (adaptive || preemptive))
+    {
+        cout << "ERROR: --ransac-frames runs neither the adaptive nor the preemptive ransac" << endl;
+        exit(-1);
+    }
 
-    nanosec = endTime - submitTime;
+    // the frames of a directory, the first of which is read by the session
+    vector<string> frameNames;
+    string frameDir = appOptions.ransacFrameDir;
+    if (stream && !frameDir.empty())
+    {
+        if (frameDir.back() != '/')
+            frameDir += "/";
+        frameNames = listRansacFrames(frameDir);
+        inputDataFile = frameNames[0];
+    }
 
-    //
-    // read buffers
-    //
-    err = clEnqueueReadBuffer(queue_out, n_bestModelParams, true, 0, 1 * sizeof(int), 
-                                &bestModelParams, 0, NULL, NULL);
-    CL_CHECK_ERROR(err);
-    err = clEnqueueReadBuffer(queue_out, n_bestOutliers, true, 0, 1 * sizeof(int), 
-                                &bestOutliers, 0, NULL, NULL);
-    CL_CHECK_ERROR(err);
+    // the preemptive kernels score the hypotheses on blocks of the data set
+    int block = preemptive ? appOptions.ransacBlock : 0;
 
-    
-    err = clFinish(queue_out);
-    CL_CHECK_ERROR (err);
+    if (preemptive && (adaptive || block <= 0 || iters > RANSAC_MAX_HYPOTHESES))
+    {
+        cout << "ERROR: the preemptive ransac needs a positive --ransac-block, at most "
+             << RANSAC_MAX_HYPOTHESES << " iterations and no --ransac-confidence" << endl;
+        exit(-1);
+    }
 
-    //
-    // verify
-    //
-    verify(idata, n_idata, randNumbers, iters, errorThreshold,
-        convergenceThreshold, bestModelParams, bestOutliers);
+    char atts[1024];
+    if (adaptive)
+        sprintf(atts, "%diters_p%g_batch%d", iters, confidence, batch);
+    else if (preemptive)
+        sprintf(atts, "%diters_block%d", iters, block);
+    else if (stream)
+        sprintf(atts, "%diters_%dframes", iters, numFrames);
+    else
+        sprintf(atts, "%diters", iters);
 
-    //
-    // free device memory
-    //
-    err = clReleaseMemObject(d_idata);
-    CL_CHECK_ERROR(err);
-    err = clReleaseMemObject(d_randNumbers);
-    CL_CHECK_ERROR(err);
-    err = clReleaseMemObject(n_bestModelParams);
-    CL_CHECK_ERROR(err);
-    err = clReleaseMemObject(n_bestOutliers);
-    CL_CHECK_ERROR(err);
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
 
-    // What metric?
+    RansacSession<T> session;
+    initRansacSession(session, dev, ctx, queue, prog, iters, inputDataFile,
+                      errorThreshold, convergenceThreshold, global, block, model);
 
-    //
-    // return the runtime in seconds
-    //
-    return nanosec / 1.e9;
+    double setupTime =
+        chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    resultDB.AddResult("ransac", "ransac-setup", atts, "s", setupTime);
+
+    double bytePerIter = double(sizeof(T)) * double(session.n_idata);
+
+    if (stream)
+    {
+        vector<T*> frames;
+        readRansacFrames(frameNames, session.n_idata, frames);
+
+        for (int pass = 0 ; pass < appOptions.passes; ++pass)
+        {
+            if (!options.quiet) cout << "Pass: " << pass << endl;
+
+            RansacStreamResult result = runRansacStream(session, ctx, dev, frames, numFrames);
+
+            resultDB.AddResult("ransac", "ransac-stream", atts, "frames/s", numFrames / result.seconds);
+            resultDB.AddResult("ransac", "ransac-stream-latency-p50", atts, "ms", getPercentile(result.latencies, 50) * 1.e3);
+            resultDB.AddResult("ransac", "ransac-stream-latency-p90", atts, "ms", getPercentile(result.latencies, 90) * 1.e3);
+            resultDB.AddResult("ransac", "ransac-stream-latency-p99", atts, "ms", getPercentile(result.latencies, 99) * 1.e3);
+        }
+
+        for (T *frame : frames)
+            free(frame);
+
+        releaseRansacSession(session);
+        return;
+    }
+
+    for (int pass = 0 ; pass < appOptions.passes; ++pass)
+    {
+        if (!options.quiet) cout << "Pass: " << pass << endl;
+
+        double hostTime;
+
+        if (preemptive)
+        {
+            RansacPreemptiveResult result;
+            double t = runRansacPreemptivePass(session, result, hostTime);
+
+            // exhaustive ransac on the same hypotheses for the quality
+            RansacResult exhaustive = ransacSIMD(session.soa, session.randNumbers, iters,
+                                                 errorThreshold, convergenceThreshold, 0);
+            int exhaustiveInliers = session.n_idata - exhaustive.bestOutliers;
+
+            resultDB.AddResult("ransac", "ransac-preemptive", atts, "hypotheses/s", iters / t);
+            resultDB.AddResult("ransac", "ransac-preemptive-evaluations", atts, "count", double(result.evaluations));
+            resultDB.AddResult("ransac", "ransac-exhaustive-evaluations", atts, "count",
+                               double(iters) * session.n_idata);
+            resultDB.AddResult("ransac", "ransac-preemptive-blocks", atts, "count", result.blocks);
+            resultDB.AddResult("ransac", "ransac-preemptive-outliers", atts, "count", result.outliers);
+            resultDB.AddResult("ransac", "ransac-exhaustive-outliers", atts, "count", exhaustive.bestOutliers);
+            resultDB.AddResult("ransac", "ransac-preemptive-quality", atts, "fraction",
+                               exhaustiveInliers > 0 ? double(session.n_idata - result.outliers) / exhaustiveInliers : 0);
+            resultDB.AddResult("ransac", string("ransac-preemptive-host-") + getRansacSIMDName(), atts, "s", hostTime);
+            continue;
+        }
+
+        if (adaptive)
+        {
+            int evaluated;
+            double t = runRansacAdaptivePass(session, batch, confidence, evaluated, hostTime);
+
+            resultDB.AddResult("ransac", "ransac-adaptive-hypotheses", atts, "count", evaluated);
+            resultDB.AddResult("ransac", "ransac-adaptive-time", atts, "s", t);
+            resultDB.AddResult("ransac", "ransac-adaptive", atts, "hypotheses/s", evaluated / t);
+            resultDB.AddResult("ransac", string("ransac-adaptive-host-") + getRansacSIMDName(), atts, "s", hostTime);
+            continue;
+        }
+
+        double t = runRansacPass(session, hostTime);
+
+        // the transforms are bound by the model generation, not the data
+        if (model != RANSAC_MODEL_FLOW)
+        {
+            string name = model == RANSAC_MODEL_AFFINE ? "ransac-affine" : "ransac-homography";
+            resultDB.AddResult("ransac", name, atts, "hypotheses/s", iters / t);
+            resultDB.AddResult("ransac", name + "-points", atts, "points/s", double(iters) * session.n_idata / t);
+            resultDB.AddResult("ransac", name + "-host-" + getRansacSIMDName(), atts, "hypotheses/s", iters / hostTime);
+            resultDB.AddResult("ransac", "ransac-upload", atts, "B",
+                               double(session.samples * iters + 2) * sizeof(int));
+            continue;
+        }
+
+        double itersPerSec = double(iters) / double(t);
+        double gbPerSec = (itersPerSec * bytePerIter) / 1.e9;
+        resultDB.AddResult("ransac", "ransac", atts, "GB/s", gbPerSec);
+        resultDB.AddResult("ransac", string("ransac-host-") + getRansacSIMDName(), atts, "GB/s",
+                           iters * bytePerIter / hostTime / 1.e9);
+        resultDB.AddResult("ransac", "ransac-upload", atts, "B", 
+                           double(2 * iters + 2) * sizeof(int));
+    }
+
+    releaseRansacSession(session);
 }
 
 
+// The kernels of the --model option: the error threshold of their model, the
+// elements they run on and how.
+typedef struct {
+    const char *name;
+    int errorThreshold;
+    bool points;                    // points of a linear function, else flow vectors
+    bool global;
+    bool preemptive;
+    int model;
+} RansacKernel;
+
+static const RansacKernel ransacKernels[] = {
+    { "fv",  RANSAC_FV_ERROR_THRESHOLD, false, false, false, RANSAC_MODEL_FLOW },
+    { "fvg", RANSAC_FV_ERROR_THRESHOLD, false, true,  false, RANSAC_MODEL_FLOW },
+    { "fvp", RANSAC_FV_ERROR_THRESHOLD, false, false, true,  RANSAC_MODEL_FLOW },
+    { "a",   RANSAC_FV_ERROR_THRESHOLD, false, false, false, RANSAC_MODEL_AFFINE },
+    { "h",   RANSAC_FV_ERROR_THRESHOLD, false, false, false, RANSAC_MODEL_HOMOGRAPHY },
+    { "p",   RANSAC_P_ERROR_THRESHOLD,  true,  false, false, RANSAC_MODEL_FLOW },
+};
+
+static const RansacKernel *findRansacKernel(const string &model)
+{
+    for (const RansacKernel &kernel : ransacKernels)
+    {
+        if (model == kernel.name) return &kernel;
+    }
+
+    return NULL;
+}
+
 /****************************************************************************
 * Function: benchmarkRansac()
 *
@@ -500,11 +1335,7 @@ void benchmarkRansac(cl_device_id dev,
     }
 
     ApplicationOptions appOptions = iter->second;
-    int iters  = appOptions.iterations;
     string model = appOptions.model;
-    string ifile = appOptions.ifile;
-
-    double t;
 
     if (options.verbose)
         cout << "Creating program from ransac bitstream." << endl;
@@ -513,39 +1344,22 @@ void benchmarkRansac(cl_device_id dev,
                                                  appOptions.bitstreamFile, 
                                                  dev);
 
-    for (int pass = 0 ; pass < appOptions.passes; ++pass) 
-    {
-        string inputDataFile = "../../src/ransac/data/" + ifile;
-        int numElements = readInputSize(inputDataFile);
-        double bytePerIter = 0.0;
-        if (!options.quiet) cout << "Pass: " << pass << endl;
-        if (model == "fv"){
-            int errorThreshold = 3;                  // as benchmark option?
-            float convergenceThreshold = 0.75;       // as benchmark option?
-            t = runRansac<flowvector>(dev, ctx, queue, prog, iters, ifile, errorThreshold, convergenceThreshold);
-            bytePerIter = double(sizeof(flowvector)) * double(numElements);
-        } else if (model == "fvg"){
-            int errorThreshold = 3;                  // as benchmark option?
-            float convergenceThreshold = 0.75;       // as benchmark option?
-            t = runRansacGlobal<flowvector>(dev, ctx, queue, prog, iters, ifile, errorThreshold, convergenceThreshold);
-            bytePerIter = double(sizeof(flowvector)) * double(numElements);
-        } else if (model == "p") {
-            int errorThreshold = 50;                 // as benchmark option?
-            float convergenceThreshold = 0.75;       // as benchmark option?
-            t = runRansac<point>(dev, ctx, queue, prog, iters, ifile, errorThreshold, convergenceThreshold);
-            bytePerIter = double(sizeof(point)) * double(numElements);
-        } else {
-            cout << "Unknown Model " << model << endl;
-            break;
-        }
+    const RansacKernel *kernel = findRansacKernel(model);
 
-        
-        double itersPerSec = double(iters) / double(t);
-        double gbPerSec = (itersPerSec * bytePerIter) / 1.e9;
-        char atts[1024];
-        sprintf(atts, "%diters", iters);
-        resultDB.AddResult("ransac", "ransac", atts, "GB/s", gbPerSec);
+    if (kernel == NULL)
+    {
+        cout << "Unknown Model " << model << endl;
+    }
+    else if (kernel->points)
+    {
+        runRansac<point>(dev, ctx, queue, prog, resultDB, options, appOptions, kernel->errorThreshold,
+                         RANSAC_CONVERGENCE_THRESHOLD, kernel->global, kernel->preemptive, kernel->model);
+    }
+    else
+    {
+        runRansac<flowvector>(dev, ctx, queue, prog, resultDB, options, appOptions, kernel->errorThreshold,
+                              RANSAC_CONVERGENCE_THRESHOLD, kernel->global, kernel->preemptive, kernel->model);
     }
 
-
-}
\ No newline at end of file
+    clReleaseProgram(prog);
+}
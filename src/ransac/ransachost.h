@@ -0,0 +1,74 @@
+/** @file ransachost.h
+*/
+
+#ifndef RANSAC_HOST_H
+#define RANSAC_HOST_H
+
+#include "../common/utility.h"
+
+#include "ransacutility.h"
+#include "ransacsimd.h"
+
+/****************************************************************************
+* The state of a ransac benchmark that lives across the passes: the input
+* data set is read and uploaded once, the queues and kernels are created
+* and their arguments set once, so that a pass only uploads fresh random
+* numbers and resets the two result values, or runs the hypotheses in
+* batches until the confidence bound is met. The preemptive kernels score
+* the hypotheses block by block instead. The host engine checks the
+* result on a structure of arrays copy of the data set. The affine and
+* homography models of the flow vectors draw 3 and 4 samples per hypothesis.
+*****************************************************************************/
+template <class T>
+struct RansacSession {
+    cl_command_queue queue;         // the model generation queue (not owned)
+    cl_command_queue queue_in;      // the data handler queue
+    cl_command_queue queue_out;     // the outlier count queue
+    cl_kernel datakernel;
+    cl_kernel modelkernel;
+    cl_kernel outkernel;
+    cl_mem d_idata;
+    cl_mem d_idata_repl;            // the copy of the model kernel, or NULL
+    cl_mem d_randNumbers;
+    cl_mem n_bestModelParams;
+    cl_mem n_bestOutliers;
+    RansacDataFile file;            // the data set, binary ones mapped
+    const T *idata;                 // the uploaded elements, in place unless the file is a SoA one
+    RansacSoA<T> soa;
+    int *randNumbers;
+    int n_idata;
+    int n_iterations;
+    int errorThreshold;
+    float convergenceThreshold;
+    bool global;                    // the model kernel takes a copy of the data set
+    int block;                      // the elements per block of the preemptive kernels, or 0
+    int model;                      // RANSAC_MODEL_FLOW, _AFFINE or _HOMOGRAPHY of the flow vectors
+    int samples;                    // the random numbers per hypothesis
+};
+
+/****************************************************************************
+* The device buffers of a frame in the stream mode, two of which alternate
+* between consecutive frames, and the events of the frame using them.
+*****************************************************************************/
+typedef struct {
+    cl_mem d_idata;
+    cl_mem d_idata_repl;            // the copy of the model kernel, or NULL
+    cl_mem d_randNumbers;
+    cl_mem n_bestModelParams;
+    cl_mem n_bestOutliers;
+    int *randNumbers;
+    int results[2];                 // the candidates and best outlier count read back
+    cl_event upload;                // the last write of the frame
+    cl_event data;
+    cl_event model;
+    cl_event out;
+    cl_event read;                  // the last read of the frame
+} RansacStreamSlot;
+
+// The result of the stream mode.
+typedef struct {
+    double seconds;                 // wall time of the whole stream
+    std::vector<double> latencies;  // per frame, upload enqueued to results read
+} RansacStreamResult;
+
+#endif
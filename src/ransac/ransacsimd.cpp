@@ -0,0 +1,622 @@
+/** @file ransacsimd.cpp
+*
+* Multithreaded SIMD host engine of ransac. The hypotheses are spread over
+* the threads, the outliers of a hypothesis counted over the structure of
+* arrays of the data set, 16 (AVX-512) or 8 (AVX2) elements at a time, with
+* the same single precision operations in the same order as the sequential
+* estimateModel(), so that the candidates and the best outlier count are
+* the same. It is also the reference of the affine and homography kernels,
+* which have no sequential estimate.
+*/
+
+#include <stdint.h>
+#include <math.h>
+
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <algorithm>
+
+#if defined(__AVX2__) || defined(__AVX512F__)
+#include <immintrin.h>
+#endif
+
+#include "ransacsimd.h"
+
+using namespace std;
+
+// Hypotheses handed to a thread at a time.
+#define RANSAC_SIMD_CHUNK 16
+
+// One lane, for the remainder of the elements.
+struct RansacScalar
+{
+    typedef int32_t VI;
+    typedef float VF;
+    static const int LANES = 1;
+    static VI loadi(const int32_t *p) { return *p; }
+    static VF loadf(const float *p) { return *p; }
+    static VI set1i(int32_t x) { return x; }
+    static VF set1f(float x) { return x; }
+    static VF tofloat(VI a) { return (float)a; }
+    static VI truncate(VF a) { return (int32_t)a; }
+    static VI addi(VI a, VI b) { return (int32_t)((uint32_t)a + (uint32_t)b); }
+    static VI subi(VI a, VI b) { return (int32_t)((uint32_t)a - (uint32_t)b); }
+    static VF addf(VF a, VF b) { return a + b; }
+    static VF subf(VF a, VF b) { return a - b; }
+    static VF mulf(VF a, VF b) { return a * b; }
+    static VF divf(VF a, VF b) { return a / b; }
+    static VF sqrtf(VF a) { return ::sqrtf(a); }
+    static int countWithin(VI a, VI b, int32_t th) { return a < th && a > -th && b < th && b > -th; }
+    static int countAtLeast(VF a, float th) { return a >= th; }
+    static int countBelow(VF a, float th) { return a < th; }
+};
+
+// The lanes of the engine: 32 bit integers and floats.
+#if defined(__AVX512F__)
+
+struct RansacVector
+{
+    typedef __m512i VI;
+    typedef __m512 VF;
+    static const int LANES = 16;
+    static VI loadi(const int32_t *p) { return _mm512_loadu_si512(p); }
+    static VF loadf(const float *p) { return _mm512_loadu_ps(p); }
+    static VI set1i(int32_t x) { return _mm512_set1_epi32(x); }
+    static VF set1f(float x) { return _mm512_set1_ps(x); }
+    static VF tofloat(VI a) { return _mm512_cvtepi32_ps(a); }
+    static VI truncate(VF a) { return _mm512_cvttps_epi32(a); }
+    static VI addi(VI a, VI b) { return _mm512_add_epi32(a, b); }
+    static VI subi(VI a, VI b) { return _mm512_sub_epi32(a, b); }
+    static VF addf(VF a, VF b) { return _mm512_add_ps(a, b); }
+    static VF subf(VF a, VF b) { return _mm512_sub_ps(a, b); }
+    static VF mulf(VF a, VF b) { return _mm512_mul_ps(a, b); }
+    static VF divf(VF a, VF b) { return _mm512_div_ps(a, b); }
+    static VF sqrtf(VF a) { return _mm512_sqrt_ps(a); }
+    // lanes with -th < a < th and -th < b < th
+    static int countWithin(VI a, VI b, int32_t th)
+    {
+        VI hi = _mm512_set1_epi32(th), lo = _mm512_set1_epi32(-th);
+        __mmask16 m = _mm512_cmplt_epi32_mask(a, hi) & _mm512_cmpgt_epi32_mask(a, lo) &
+                      _mm512_cmplt_epi32_mask(b, hi) & _mm512_cmpgt_epi32_mask(b, lo);
+        return __builtin_popcount(m);
+    }
+    // lanes with a >= th, false for NaN
+    static int countAtLeast(VF a, float th)
+    {
+        return __builtin_popcount(_mm512_cmp_ps_mask(a, _mm512_set1_ps(th), _CMP_GE_OQ));
+    }
+    // lanes with a < th, false for NaN
+    static int countBelow(VF a, float th)
+    {
+        return __builtin_popcount(_mm512_cmp_ps_mask(a, _mm512_set1_ps(th), _CMP_LT_OQ));
+    }
+};
+
+#elif defined(__AVX2__)
+
+struct RansacVector
+{
+    typedef __m256i VI;
+    typedef __m256 VF;
+    static const int LANES = 8;
+    static VI loadi(const int32_t *p) { return _mm256_loadu_si256((const __m256i*)p); }
+    static VF loadf(const float *p) { return _mm256_loadu_ps(p); }
+    static VI set1i(int32_t x) { return _mm256_set1_epi32(x); }
+    static VF set1f(float x) { return _mm256_set1_ps(x); }
+    static VF tofloat(VI a) { return _mm256_cvtepi32_ps(a); }
+    static VI truncate(VF a) { return _mm256_cvttps_epi32(a); }
+    static VI addi(VI a, VI b) { return _mm256_add_epi32(a, b); }
+    static VI subi(VI a, VI b) { return _mm256_sub_epi32(a, b); }
+    static VF addf(VF a, VF b) { return _mm256_add_ps(a, b); }
+    static VF subf(VF a, VF b) { return _mm256_sub_ps(a, b); }
+    static VF mulf(VF a, VF b) { return _mm256_mul_ps(a, b); }
+    static VF divf(VF a, VF b) { return _mm256_div_ps(a, b); }
+    static VF sqrtf(VF a) { return _mm256_sqrt_ps(a); }
+    static int countWithin(VI a, VI b, int32_t th)
+    {
+        VI hi = _mm256_set1_epi32(th), lo = _mm256_set1_epi32(-th);
+        VI m = _mm256_and_si256(_mm256_and_si256(_mm256_cmpgt_epi32(hi, a), _mm256_cmpgt_epi32(a, lo)),
+                                _mm256_and_si256(_mm256_cmpgt_epi32(hi, b), _mm256_cmpgt_epi32(b, lo)));
+        return __builtin_popcount(_mm256_movemask_ps(_mm256_castsi256_ps(m)));
+    }
+    static int countAtLeast(VF a, float th)
+    {
+        return __builtin_popcount(_mm256_movemask_ps(_mm256_cmp_ps(a, _mm256_set1_ps(th), _CMP_GE_OQ)));
+    }
+    static int countBelow(VF a, float th)
+    {
+        return __builtin_popcount(_mm256_movemask_ps(_mm256_cmp_ps(a, _mm256_set1_ps(th), _CMP_LT_OQ)));
+    }
+};
+
+#else
+
+struct RansacVector : RansacScalar {};
+
+#endif
+
+const char* getRansacSIMDName()
+{
+#if defined(__AVX512F__)
+    return "avx512";
+#elif defined(__AVX2__)
+    return "avx2";
+#else
+    return "scalar";
+#endif
+}
+
+void toSoA(const flowvector *v, int n, RansacSoA<flowvector> &soa)
+{
+    soa.n = n;
+    soa.x.resize(n);
+    soa.y.resize(n);
+    soa.vx.resize(n);
+    soa.vy.resize(n);
+
+    for (int i = 0; i < n; i++)
+    {
+        soa.x[i] = v[i].x;
+        soa.y[i] = v[i].y;
+        soa.vx[i] = v[i].vx;
+        soa.vy[i] = v[i].vy;
+    }
+}
+
+void toSoA(const point *p, int n, RansacSoA<point> &soa)
+{
+    soa.n = n;
+    soa.x.resize(n);
+    soa.y.resize(n);
+
+    for (int i = 0; i < n; i++)
+    {
+        soa.x[i] = p[i].x;
+        soa.y[i] = p[i].y;
+    }
+}
+
+// A data set in the structure of arrays layout is taken field by field.
+void toSoA(const RansacDataFile &file, RansacSoA<flowvector> &soa)
+{
+    if (file.layout == RANSAC_DATA_AOS)
+    {
+        toSoA((const flowvector *)file.elements, file.count, soa);
+        return;
+    }
+
+    const int32_t *fields[4];
+    for (int f = 0; f < 4; f++)
+        fields[f] = (const int32_t *)inputField(file, f);
+
+    soa.n = file.count;
+    soa.x.assign(fields[0], fields[0] + file.count);
+    soa.y.assign(fields[1], fields[1] + file.count);
+    soa.vx.assign(fields[2], fields[2] + file.count);
+    soa.vy.assign(fields[3], fields[3] + file.count);
+}
+
+void toSoA(const RansacDataFile &file, RansacSoA<point> &soa)
+{
+    if (file.layout == RANSAC_DATA_AOS)
+    {
+        toSoA((const point *)file.elements, file.count, soa);
+        return;
+    }
+
+    const float *x = (const float *)inputField(file, 0);
+    const float *y = (const float *)inputField(file, 1);
+
+    soa.n = file.count;
+    soa.x.assign(x, x + file.count);
+    soa.y.assign(y, y + file.count);
+}
+
+// The elements within the error threshold of the first order flow of the
+// elements [begin, end), a multiple of the lanes.
+template <class V>
+static int countFlowInliers(const RansacSoA<flowvector> &soa, int begin, int end,
+                            const float *model_param, int error_threshold)
+{
+    typename V::VF xc = V::set1f(model_param[0]), yc = V::set1f(model_param[1]);
+    typename V::VF d = V::set1f(model_param[2]), r = V::set1f(model_param[3]);
+    int inliers = 0;
+
+    for (int i = begin; i < end; i += V::LANES)
+    {
+        typename V::VI x = V::loadi(&soa.x[i]), y = V::loadi(&soa.y[i]);
+        typename V::VF tx = V::subf(V::tofloat(x), xc);
+        typename V::VF ty = V::subf(V::tofloat(y), yc);
+
+        typename V::VI ex = V::subi(V::addi(x, V::subi(V::truncate(V::mulf(tx, d)),
+                                                       V::truncate(V::mulf(ty, r)))), V::loadi(&soa.vx[i]));
+        typename V::VI ey = V::subi(V::addi(y, V::addi(V::truncate(V::mulf(ty, d)),
+                                                       V::truncate(V::mulf(tx, r)))), V::loadi(&soa.vy[i]));
+
+        inliers += V::countWithin(ex, ey, error_threshold);
+    }
+
+    return inliers;
+}
+
+// The elements at least the error threshold away from the line of the
+// elements [begin, end), a multiple of the lanes.
+template <class V>
+static int countLineOutliers(const RansacSoA<point> &soa, int begin, int end,
+                             const float *model_param, int error_threshold)
+{
+    float m1 = model_param[0], b1 = model_param[1];
+    float m2 = (-1) / m1;
+    typename V::VF vm1 = V::set1f(m1), vb1 = V::set1f(b1), vm2 = V::set1f(m2);
+    typename V::VF dm = V::set1f(m2 - m1);
+    int outliers = 0;
+
+    for (int i = begin; i < end; i += V::LANES)
+    {
+        typename V::VF px = V::loadf(&soa.x[i]), py = V::loadf(&soa.y[i]);
+        typename V::VF b2 = V::subf(py, V::mulf(vm2, px));
+        typename V::VF qx = V::divf(V::subf(vb1, b2), dm);
+        typename V::VF qy = V::addf(V::mulf(vm1, qx), vb1);
+        typename V::VF ey = V::subf(qy, py), ex = V::subf(qx, px);
+        typename V::VF dist = V::sqrtf(V::addf(V::mulf(ey, ey), V::mulf(ex, ex)));
+
+        outliers += V::countAtLeast(dist, (float)error_threshold);
+    }
+
+    return outliers;
+}
+
+// The outliers of the elements [begin, end).
+static int countOutliers(const RansacSoA<flowvector> &soa, int begin, int end,
+                         const float *model_param, int error_threshold)
+{
+    int simd_end = end - (end - begin) % RansacVector::LANES;
+    int inliers = countFlowInliers<RansacVector>(soa, begin, simd_end, model_param, error_threshold) +
+                  countFlowInliers<RansacScalar>(soa, simd_end, end, model_param, error_threshold);
+    return end - begin - inliers;
+}
+
+static int countOutliers(const RansacSoA<point> &soa, int begin, int end,
+                         const float *model_param, int error_threshold)
+{
+    int simd_end = end - (end - begin) % RansacVector::LANES;
+    return countLineOutliers<RansacVector>(soa, begin, simd_end, model_param, error_threshold) +
+           countLineOutliers<RansacScalar>(soa, simd_end, end, model_param, error_threshold);
+}
+
+// The elements whose heads lie within the error threshold of the affine
+// transformation or homography of their tails, of the elements [begin,
+// end), a multiple of the lanes.
+template <class V, bool PROJECTIVE>
+static int countTransformInliers(const RansacSoA<flowvector> &soa, int begin, int end,
+                                 const float *model_param, int error_threshold)
+{
+    typename V::VF a = V::set1f(model_param[0]), b = V::set1f(model_param[1]), c = V::set1f(model_param[2]);
+    typename V::VF d = V::set1f(model_param[3]), e = V::set1f(model_param[4]), f = V::set1f(model_param[5]);
+    typename V::VF g = V::set1f(PROJECTIVE ? model_param[6] : 0), h = V::set1f(PROJECTIVE ? model_param[7] : 0);
+    typename V::VF one = V::set1f(1);
+    float threshold = float(error_threshold) * float(error_threshold);
+    int inliers = 0;
+
+    for (int i = begin; i < end; i += V::LANES)
+    {
+        typename V::VF x = V::tofloat(V::loadi(&soa.x[i])), y = V::tofloat(V::loadi(&soa.y[i]));
+        typename V::VF pu = V::addf(V::addf(V::mulf(a, x), V::mulf(b, y)), c);
+        typename V::VF pv = V::addf(V::addf(V::mulf(d, x), V::mulf(e, y)), f);
+
+        if (PROJECTIVE)
+        {
+            typename V::VF w = V::addf(V::addf(V::mulf(g, x), V::mulf(h, y)), one);
+            pu = V::divf(pu, w);
+            pv = V::divf(pv, w);
+        }
+
+        typename V::VF eu = V::subf(pu, V::tofloat(V::loadi(&soa.vx[i])));
+        typename V::VF ev = V::subf(pv, V::tofloat(V::loadi(&soa.vy[i])));
+
+        inliers += V::countBelow(V::addf(V::mulf(eu, eu), V::mulf(ev, ev)), threshold);
+    }
+
+    return inliers;
+}
+
+template <bool PROJECTIVE>
+static int countTransformOutliers(const RansacSoA<flowvector> &soa, int begin, int end,
+                                  const float *model_param, int error_threshold)
+{
+    int simd_end = end - (end - begin) % RansacVector::LANES;
+    int inliers = countTransformInliers<RansacVector, PROJECTIVE>(soa, begin, simd_end, model_param, error_threshold) +
+                  countTransformInliers<RansacScalar, PROJECTIVE>(soa, simd_end, end, model_param, error_threshold);
+    return end - begin - inliers;
+}
+
+// The sampled elements of the iteration.
+static void getSamples(const RansacSoA<flowvector> &soa, const int *random_numbers, int iter, int count,
+                       flowvector *samples)
+{
+    for (int s = 0; s < count; s++)
+    {
+        int i = random_numbers[count * iter + s];
+        samples[s].x = soa.x[i];
+        samples[s].y = soa.y[i];
+        samples[s].vx = soa.vx[i];
+        samples[s].vy = soa.vy[i];
+    }
+}
+
+static void getSamples(const RansacSoA<point> &soa, const int *random_numbers, int iter, int count,
+                       point *samples)
+{
+    for (int s = 0; s < count; s++)
+    {
+        int i = random_numbers[count * iter + s];
+        samples[s].x = soa.x[i];
+        samples[s].y = soa.y[i];
+    }
+}
+
+// The models of the engine: the elements, the samples and parameters of a
+// hypothesis, the generation of its parameters from the samples and the
+// outliers of the elements [begin, end).
+struct FlowModel
+{
+    typedef flowvector T;
+    static const int SAMPLES = 2;
+    static const int PARAMS = 4;
+    static int gen(const T *samples, float *model_param)
+    {
+        const int pair[2] = { 0, 1 };
+        return genModel(samples, pair, 0, model_param);
+    }
+    static int count(const RansacSoA<T> &soa, int begin, int end, const float *model_param, int error_threshold)
+    {
+        return countOutliers(soa, begin, end, model_param, error_threshold);
+    }
+};
+
+struct LineModel
+{
+    typedef point T;
+    static const int SAMPLES = 2;
+    static const int PARAMS = 2;
+    static int gen(const T *samples, float *model_param)
+    {
+        const int pair[2] = { 0, 1 };
+        return genModel(samples, pair, 0, model_param);
+    }
+    static int count(const RansacSoA<T> &soa, int begin, int end, const float *model_param, int error_threshold)
+    {
+        return countOutliers(soa, begin, end, model_param, error_threshold);
+    }
+};
+
+struct AffineModel
+{
+    typedef flowvector T;
+    static const int SAMPLES = 3;
+    static const int PARAMS = 6;
+    static int gen(const T *samples, float *model_param) { return genAffineModel(samples, model_param); }
+    static int count(const RansacSoA<T> &soa, int begin, int end, const float *model_param, int error_threshold)
+    {
+        return countTransformOutliers<false>(soa, begin, end, model_param, error_threshold);
+    }
+};
+
+struct HomographyModel
+{
+    typedef flowvector T;
+    static const int SAMPLES = 4;
+    static const int PARAMS = 8;
+    static int gen(const T *samples, float *model_param) { return genHomographyModel(samples, model_param); }
+    static int count(const RansacSoA<T> &soa, int begin, int end, const float *model_param, int error_threshold)
+    {
+        return countTransformOutliers<true>(soa, begin, end, model_param, error_threshold);
+    }
+};
+
+// Counts the outliers of all hypotheses on the threads, then picks the
+// candidates and the best one in the order of the iterations like
+// estimateModel().
+template <class M>
+static RansacResult runRansacSIMD(const RansacSoA<typename M::T> &soa, const int *random_numbers, int max_iter,
+    int error_threshold, float convergence_threshold, int numThreads)
+{
+    RansacResult result = { 0, soa.n, -1 };
+
+    if (soa.n == 0)
+        return result;
+
+    if (numThreads <= 0) numThreads = max(1u, thread::hardware_concurrency());
+
+    // -1 for the iterations without a model
+    vector<int> outliers(max_iter, -1);
+    atomic<int> next(0);
+    vector<thread> threads;
+
+    for (int t = 0; t < numThreads; t++)
+    {
+        threads.push_back(thread([&]()
+        {
+            int first;
+
+            while ((first = next.fetch_add(RANSAC_SIMD_CHUNK)) < max_iter)
+            {
+                int last = min(max_iter, first + RANSAC_SIMD_CHUNK);
+
+                for (int iter = first; iter < last; iter++)
+                {
+                    typename M::T samples[M::SAMPLES];
+                    float model_param[M::PARAMS];
+                    getSamples(soa, random_numbers, iter, M::SAMPLES, samples);
+
+                    if (M::gen(samples, model_param))
+                        outliers[iter] = M::count(soa, 0, soa.n, model_param, error_threshold);
+                }
+            }
+        }));
+    }
+
+    for (thread &t : threads) t.join();
+
+    for (int iter = 0; iter < max_iter; iter++)
+    {
+        int outlier_count = outliers[iter];
+
+        if (outlier_count >= 0 && outlier_count < soa.n * convergence_threshold)
+        {
+            result.candidates++;
+            if (outlier_count < result.bestOutliers)
+            {
+                result.bestOutliers = outlier_count;
+                result.bestModel = iter;
+            }
+        }
+    }
+
+    return result;
+}
+
+RansacResult ransacSIMD(const RansacSoA<flowvector> &soa, const int *random_numbers, int max_iter,
+    int error_threshold, float convergence_threshold, int numThreads, int model)
+{
+    if (model == RANSAC_MODEL_AFFINE)
+        return runRansacSIMD<AffineModel>(soa, random_numbers, max_iter, error_threshold, convergence_threshold, numThreads);
+    if (model == RANSAC_MODEL_HOMOGRAPHY)
+        return runRansacSIMD<HomographyModel>(soa, random_numbers, max_iter, error_threshold, convergence_threshold, numThreads);
+    return runRansacSIMD<FlowModel>(soa, random_numbers, max_iter, error_threshold, convergence_threshold, numThreads);
+}
+
+RansacResult ransacSIMD(const RansacSoA<point> &soa, const int *random_numbers, int max_iter,
+    int error_threshold, float convergence_threshold, int numThreads)
+{
+    return runRansacSIMD<LineModel>(soa, random_numbers, max_iter, error_threshold, convergence_threshold, numThreads);
+}
+
+// Runs the hypotheses in batches like the adaptive mode of the device, until
+// the hypotheses run reach ransacIterations() of the best inlier ratio so
+// far or max_iter.
+template <class M>
+static RansacResult runRansacAdaptiveSIMD(const RansacSoA<typename M::T> &soa, const int *random_numbers, int max_iter,
+    int batch, int error_threshold, float convergence_threshold, float confidence, int numThreads, int &evaluated)
+{
+    RansacResult result = { 0, soa.n, -1 };
+
+    for (evaluated = 0; evaluated < max_iter; )
+    {
+        int count = min(batch, max_iter - evaluated);
+        RansacResult part = runRansacSIMD<M>(soa, random_numbers + M::SAMPLES * evaluated, count,
+                                             error_threshold, convergence_threshold, numThreads);
+
+        result.candidates += part.candidates;
+        if (part.bestOutliers < result.bestOutliers)
+        {
+            result.bestOutliers = part.bestOutliers;
+            result.bestModel = evaluated + part.bestModel;
+        }
+
+        evaluated += count;
+
+        float inlier_ratio = float(soa.n - result.bestOutliers) / soa.n;
+        if (evaluated >= ransacIterations(inlier_ratio, confidence, M::SAMPLES))
+            break;
+    }
+
+    return result;
+}
+
+RansacResult ransacAdaptiveSIMD(const RansacSoA<flowvector> &soa, const int *random_numbers, int max_iter,
+    int batch, int error_threshold, float convergence_threshold, float confidence, int numThreads, int &evaluated,
+    int model)
+{
+    if (model == RANSAC_MODEL_AFFINE)
+        return runRansacAdaptiveSIMD<AffineModel>(soa, random_numbers, max_iter, batch, error_threshold,
+                                                  convergence_threshold, confidence, numThreads, evaluated);
+    if (model == RANSAC_MODEL_HOMOGRAPHY)
+        return runRansacAdaptiveSIMD<HomographyModel>(soa, random_numbers, max_iter, batch, error_threshold,
+                                                      convergence_threshold, confidence, numThreads, evaluated);
+    return runRansacAdaptiveSIMD<FlowModel>(soa, random_numbers, max_iter, batch, error_threshold,
+                                            convergence_threshold, confidence, numThreads, evaluated);
+}
+
+RansacResult ransacAdaptiveSIMD(const RansacSoA<point> &soa, const int *random_numbers, int max_iter,
+    int batch, int error_threshold, float convergence_threshold, float confidence, int numThreads, int &evaluated)
+{
+    return runRansacAdaptiveSIMD<LineModel>(soa, random_numbers, max_iter, batch, error_threshold,
+                                            convergence_threshold, confidence, numThreads, evaluated);
+}
+
+// Scores all hypotheses on the first block of elements, keeps the better
+// half of them, the first ones on a tie, for the next block and so on, like
+// the preemptive kernels, until one hypothesis is left or the elements are
+// used up. A hypothesis without a model scores all elements of a block as
+// outliers.
+template <class M>
+static RansacPreemptiveResult runRansacPreemptiveSIMD(const RansacSoA<typename M::T> &soa, const int *random_numbers,
+    int max_iter, int block, int error_threshold)
+{
+    RansacPreemptiveResult result = { -1, 0, soa.n, 0, 0 };
+
+    if (max_iter <= 0 || soa.n == 0)
+        return result;
+
+    vector<float> models(M::PARAMS * max_iter);
+    vector<char> valid(max_iter);
+    vector<int> scores(max_iter, 0);
+    vector<int> alive(max_iter);
+
+    for (int iter = 0; iter < max_iter; iter++)
+    {
+        typename M::T samples[M::SAMPLES];
+        getSamples(soa, random_numbers, iter, M::SAMPLES, samples);
+        valid[iter] = M::gen(samples, &models[M::PARAMS * iter]);
+        alive[iter] = iter;
+    }
+
+    for (int first = 0; ; first += block)
+    {
+        int last = min(first + block, soa.n);
+
+        for (int id : alive)
+        {
+            scores[id] += valid[id] ? M::count(soa, first, last, &models[M::PARAMS * id], error_threshold)
+                                    : last - first;
+        }
+
+        result.blocks++;
+        result.evaluations += (long long)alive.size() * (last - first);
+
+        if (alive.size() == 1 || last >= soa.n)
+            break;
+
+        // the alive hypotheses are in the order of the iterations
+        stable_sort(alive.begin(), alive.end(), [&](int a, int b) { return scores[a] < scores[b]; });
+        alive.resize(alive.size() / 2);
+        sort(alive.begin(), alive.end());
+    }
+
+    result.bestModel = alive[0];
+    for (int id : alive)
+    {
+        if (scores[id] < scores[result.bestModel])
+            result.bestModel = id;
+    }
+
+    result.score = scores[result.bestModel];
+    if (valid[result.bestModel])
+        result.outliers = M::count(soa, 0, soa.n, &models[M::PARAMS * result.bestModel], error_threshold);
+
+    return result;
+}
+
+RansacPreemptiveResult ransacPreemptiveSIMD(const RansacSoA<flowvector> &soa, const int *random_numbers,
+    int max_iter, int block, int error_threshold)
+{
+    return runRansacPreemptiveSIMD<FlowModel>(soa, random_numbers, max_iter, block, error_threshold);
+}
+
+RansacPreemptiveResult ransacPreemptiveSIMD(const RansacSoA<point> &soa, const int *random_numbers,
+    int max_iter, int block, int error_threshold)
+{
+    return runRansacPreemptiveSIMD<LineModel>(soa, random_numbers, max_iter, block, error_threshold);
+}
@@ -0,0 +1,59 @@
+#ifndef RANSACSIMD_H
+#define RANSACSIMD_H
+
+#include <vector>
+
+#include "ransacutility.h"
+
+// The data set as a structure of arrays, so that the outliers of a
+// hypothesis are counted for as many elements per instruction as the SIMD
+// registers hold.
+template <class T> struct RansacSoA;
+
+template <> struct RansacSoA<flowvector>
+{
+    int n;
+    std::vector<int32_t> x, y, vx, vy;
+};
+
+template <> struct RansacSoA<point>
+{
+    int n;
+    std::vector<float> x, y;
+};
+
+// The result of preemptive ransac: the surviving hypothesis, its outliers
+// over the blocks it was scored on and over the whole data set, the blocks
+// scored and the elements evaluated against a hypothesis over all blocks.
+typedef struct {
+    int bestModel;
+    int score;
+    int outliers;
+    int blocks;
+    long long evaluations;
+} RansacPreemptiveResult;
+
+const char* getRansacSIMDName();
+
+void toSoA(const flowvector *v, int n, RansacSoA<flowvector> &soa);
+void toSoA(const point *p, int n, RansacSoA<point> &soa);
+void toSoA(const RansacDataFile &file, RansacSoA<flowvector> &soa);
+void toSoA(const RansacDataFile &file, RansacSoA<point> &soa);
+
+RansacResult ransacSIMD(const RansacSoA<flowvector> &soa, const int *random_numbers, int max_iter,
+    int error_threshold, float convergence_threshold, int numThreads, int model = RANSAC_MODEL_FLOW);
+RansacResult ransacSIMD(const RansacSoA<point> &soa, const int *random_numbers, int max_iter,
+    int error_threshold, float convergence_threshold, int numThreads);
+
+RansacResult ransacAdaptiveSIMD(const RansacSoA<flowvector> &soa, const int *random_numbers, int max_iter,
+    int batch, int error_threshold, float convergence_threshold, float confidence, int numThreads, int &evaluated,
+    int model = RANSAC_MODEL_FLOW);
+RansacResult ransacAdaptiveSIMD(const RansacSoA<point> &soa, const int *random_numbers, int max_iter,
+    int batch, int error_threshold, float convergence_threshold, float confidence, int numThreads, int &evaluated);
+
+RansacPreemptiveResult ransacPreemptiveSIMD(const RansacSoA<flowvector> &soa, const int *random_numbers,
+    int max_iter, int block, int error_threshold);
+RansacPreemptiveResult ransacPreemptiveSIMD(const RansacSoA<point> &soa, const int *random_numbers,
+    int max_iter, int block, int error_threshold);
+
+#endif // RANSACSIMD_H
@@ -43,101 +43,328 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <math.h>
+#include <limits.h>
 #include <iostream>
+#include <vector>
 
+#include "../common/mappedfile.h"
 #include "ransacutility.h"
 
 using namespace std;
 
-int readInputSize(string fileName) {
-    FILE *File = NULL;
-    File       = fopen(fileName.c_str(), "r");
-
-    if(File == NULL) {
-        puts("Error opening the file");
-        exit(-1);
+void genRandNumbers(int *r, int maxIter, int n, int samples){
+    for(int i = 0; i < samples * maxIter; i++) {
+        r[i] = ((int)rand()) % n;
     }
+}
 
-    int n;
-    fscanf(File, "%d", &n);
-    fclose(File);
+static bool hasDataMagic(const void *start, size_t size) {
+    return size >= sizeof(RansacDataHeader) &&
+        memcmp(start, RANSAC_DATA_MAGIC, strlen(RANSAC_DATA_MAGIC)) == 0;
+}
 
-    return n;
+// The bytes from one field array of the structure of arrays layout to the next.
+static size_t fieldStride(int64_t count) {
+    size_t bytes = count * sizeof(int32_t);
+    return (bytes + RANSAC_DATA_ALIGNMENT - 1) / RANSAC_DATA_ALIGNMENT * RANSAC_DATA_ALIGNMENT;
 }
 
-void readInputData(flowvector *v, string fileName) {
+// Checks the header of a mapped binary data set and sets the elements.
+static bool parseInputBinary(string fileName, RansacDataFile &file) {
+    if(!hasDataMagic(file.mapping, file.mappingSize)) {
+        cout << "Not a ransac data file (version " << RANSAC_DATA_VERSION << "): " << fileName << endl;
+        return false;
+    }
+
+    const RansacDataHeader *header = (const RansacDataHeader *)file.mapping;
+    size_t elementSize = header->type == RANSAC_DATA_FLOWVECTOR ? sizeof(flowvector) : sizeof(point);
 
-    int ic = 0;
+    if(header->version != RANSAC_DATA_VERSION ||
+        (header->type != RANSAC_DATA_FLOWVECTOR && header->type != RANSAC_DATA_POINT) ||
+        (header->layout != RANSAC_DATA_AOS && header->layout != RANSAC_DATA_SOA) ||
+        header->elementSize != elementSize) {
+        cout << "Not a ransac data file (version " << RANSAC_DATA_VERSION << "): " << fileName << endl;
+        return false;
+    }
 
-    // Open input file
-    FILE *File = NULL;
-    File       = fopen(fileName.c_str(), "r");
-    if(File == NULL) {
-        puts("Error opening file!");
-        exit(-1);
+    if(header->count < 1 || header->count > INT32_MAX) {
+        cout << "Failed reading the element(s) in the file: " << fileName << endl;
+        return false;
     }
 
+    // the last field array ends with the last element
+    size_t fields = elementSize / sizeof(int32_t);
+    size_t stride = fieldStride(header->count);
+    size_t dataSize = header->layout == RANSAC_DATA_SOA ?
+        (fields - 1) * stride + header->count * sizeof(int32_t) : header->count * elementSize;
+
+    if(header->dataOffset % RANSAC_DATA_ALIGNMENT != 0 ||
+        header->dataOffset + dataSize > file.mappingSize) {
+        cout << "Failed reading the element(s) in the file: " << fileName << endl;
+        return false;
+    }
+
+    file.type = header->type;
+    file.layout = header->layout;
+    file.count = header->count;
+    file.fieldStride = stride;
+    file.elements = (const char *)file.mapping + header->dataOffset;
+    return true;
+}
+
+// Reads the next number of a csv data set into token, skipping the
+// separators before it. The mapping is not terminated, so the number is
+// copied before it is converted.
+static bool nextToken(const char *&p, const char *end, char *token, size_t size) {
+    while(p < end && (*p == ',' || *p == ' ' || *p == '\t' || *p == '\r' || *p == '\n'))
+        p++;
+
+    size_t length = 0;
+    while(p < end && *p != ',' && *p != ' ' && *p != '\t' && *p != '\r' && *p != '\n') {
+        if(length + 1 == size)
+            return false;
+        token[length++] = *p++;
+    }
+    token[length] = '\0';
+    return length > 0;
+}
+
+static bool parseValue(const char *&p, const char *end, int &value) {
+    char token[32], *last;
+    if(!nextToken(p, end, token, sizeof(token)))
+        return false;
+    long parsed = strtol(token, &last, 10);
+    value = (int)parsed;
+    return *last == '\0' && parsed >= INT_MIN && parsed <= INT_MAX;
+}
+
+static bool parseValue(const char *&p, const char *end, float &value) {
+    char token[64], *last;
+    if(!nextToken(p, end, token, sizeof(token)))
+        return false;
+    value = strtof(token, &last);
+    return *last == '\0';
+}
+
+static bool parseElement(const char *&p, const char *end, flowvector &v) {
+    return parseValue(p, end, v.x) && parseValue(p, end, v.y) &&
+        parseValue(p, end, v.vx) && parseValue(p, end, v.vy);
+}
+
+static bool parseElement(const char *&p, const char *end, point &e) {
+    return parseValue(p, end, e.x) && parseValue(p, end, e.y);
+}
+
+// Parses the csv data set (the number of elements, then one element per
+// line) in the mapping into 64 byte aligned memory.
+template <class T>
+static bool parseInputCsv(string fileName, RansacDataFile &file) {
+    const char *p = (const char *)file.mapping, *end = p + file.mappingSize;
     int n;
-    fscanf(File, "%d", &n);
 
-    while(fscanf(File, "%d,%d,%d,%d", &v[ic].x, &v[ic].y, &v[ic].vx, &v[ic].vy) == 4) {
-        ic++;
-        if(ic > n) {
-            puts("Error: inconsistent file data!");
-            exit(-1);
-        }
+    if(!parseValue(p, end, n) || n < 1) {
+        cout << "Failed reading the number of elements in the file: " << fileName << endl;
+        return false;
     }
-    if(ic < n) {
-        puts("Error: inconsistent file data!");
-        exit(-1);
+
+    T *elements;
+    if(posix_memalign(reinterpret_cast<void**>(&elements), 64, size_t(n) * sizeof(T))) {
+        cout << "Failed allocating " << n << " elements of the file: " << fileName << endl;
+        return false;
+    }
+    file.buffer = elements;
+
+    int i = 0;
+    while(i < n && parseElement(p, end, elements[i]))
+        i++;
+
+    // as many elements as announced, and nothing after them
+    char token[2];
+    if(i < n || nextToken(p, end, token, sizeof(token)) || p < end) {
+        cout << "Error: inconsistent file data: " << fileName << endl;
+        return false;
     }
+
+    file.layout = RANSAC_DATA_AOS;
+    file.count = n;
+    file.fieldStride = 0;
+    file.elements = elements;
+    return true;
 }
 
-void readInputData(point *p, string fileName) {
+// Reads a data set of the element type from a single mapping of the file.
+// A binary data set, detected by its magic, is used in place in the
+// mapping, in either layout. A csv data set is parsed into memory owned by
+// the file and the mapping released.
+bool readInput(string fileName, uint32_t type, RansacDataFile &file) {
+    file.mapping = NULL;
+    file.mappingSize = 0;
+    file.buffer = NULL;
+    file.elements = NULL;
+    file.type = type;
+    file.count = 0;
+
+    if(!mapFile(fileName, file.mapping, file.mappingSize)) {
+        file.mapping = NULL;
+        return false;
+    }
 
-    int ic = 0;
+    if(!hasDataMagic(file.mapping, file.mappingSize)) {
+        bool parsed = type == RANSAC_DATA_FLOWVECTOR ? parseInputCsv<flowvector>(fileName, file) :
+                                                       parseInputCsv<point>(fileName, file);
+        unmapFile(file.mapping, file.mappingSize);
+        file.mapping = NULL;
+        file.mappingSize = 0;
 
-    // Open input file
-    FILE *File = NULL;
-    File       = fopen(fileName.c_str(), "r");
-    if(File == NULL) {
-        puts("Error opening file!");
-        exit(-1);
+        if(!parsed)
+            releaseInput(file);
+        return parsed;
     }
 
-    int n;
-    fscanf(File, "%d", &n);
+    if(!parseInputBinary(fileName, file)) {
+        releaseInput(file);
+        return false;
+    }
+
+    if(file.type != type) {
+        cout << "The data set does not hold the elements of the model: " << fileName << endl;
+        releaseInput(file);
+        return false;
+    }
+    return true;
+}
+
+void releaseInput(RansacDataFile &file) {
+    if(file.mapping != NULL)
+        unmapFile(file.mapping, file.mappingSize);
+    free(file.buffer);
 
-    while(fscanf(File, "%f,%f", &p[ic].x, &p[ic].y) == 2) {
-        ic++;
-        if(ic > n) {
-            puts("Error: inconsistent file data!");
-            exit(-1);
+    file.mapping = NULL;
+    file.mappingSize = 0;
+    file.buffer = NULL;
+    file.elements = NULL;
+}
+
+// Copies the elements of a data set in either layout one after another.
+void copyInput(const RansacDataFile &file, void *elements) {
+    size_t elementSize = file.type == RANSAC_DATA_FLOWVECTOR ? sizeof(flowvector) : sizeof(point);
+
+    if(file.layout == RANSAC_DATA_AOS) {
+        memcpy(elements, file.elements, file.count * elementSize);
+        return;
+    }
+
+    // the fields are 32 bit ints or floats alike, copied bitwise
+    size_t fields = elementSize / sizeof(int32_t);
+    uint32_t *out = (uint32_t *)elements;
+    for(size_t f = 0; f < fields; f++) {
+        const uint32_t *in = (const uint32_t *)inputField(file, f);
+        for(int i = 0; i < file.count; i++) {
+            out[i * fields + f] = in[i];
         }
     }
-    if(ic < n) {
-        puts("Error: inconsistent file data!");
-        exit(-1);
+}
+
+// Writes a csv data set as read by readInput().
+bool writeInputData(const flowvector *v, int n, string fileName) {
+    FILE *File = fopen(fileName.c_str(), "w");
+    if(File == NULL) {
+        cout << "Failed opening: " << fileName << " for writing" << endl;
+        return false;
+    }
+
+    fprintf(File, "%d\n", n);
+    for(int i = 0; i < n; i++) {
+        fprintf(File, "%d,%d,%d,%d\n", v[i].x, v[i].y, v[i].vx, v[i].vy);
     }
+
+    bool written = !ferror(File);
+    return fclose(File) == 0 && written;
 }
 
-void genRandNumbers(int *r, int maxIter, int n){
-    srand(time(NULL));
-    for(int i = 0; i < 2 * maxIter; i++) {
-        r[i] = ((int)rand()) % n;
+bool writeInputData(const point *p, int n, string fileName) {
+    FILE *File = fopen(fileName.c_str(), "w");
+    if(File == NULL) {
+        cout << "Failed opening: " << fileName << " for writing" << endl;
+        return false;
     }
+
+    // enough digits to read back the same floats
+    fprintf(File, "%d\n", n);
+    for(int i = 0; i < n; i++) {
+        fprintf(File, "%.9g,%.9g\n", p[i].x, p[i].y);
+    }
+
+    bool written = !ferror(File);
+    return fclose(File) == 0 && written;
 }
 
-inline int compare_output(int count1, int count2, int outliers1, int outliers2) {
-    if(count1 != count2) {
-        printf("Test failed\n");
-        exit(EXIT_FAILURE);
+// Writes a binary data set as read by readInput(), in the structure
+// of arrays layout the fields of the elements are gathered into arrays.
+static bool writeBinary(const void *elements, int n, uint32_t type, size_t elementSize, uint32_t layout,
+                        string fileName) {
+    FILE *File = fopen(fileName.c_str(), "wb");
+    if(File == NULL) {
+        cout << "Failed opening: " << fileName << " for writing" << endl;
+        return false;
     }
-    if(outliers1 != outliers2) {
-        printf("Test failed\n");
-        exit(EXIT_FAILURE);
+
+    RansacDataHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, RANSAC_DATA_MAGIC, sizeof(header.magic));
+    header.version = RANSAC_DATA_VERSION;
+    header.type = type;
+    header.count = n;
+    header.elementSize = elementSize;
+    header.layout = layout;
+    header.dataOffset = sizeof(RansacDataHeader);
+
+    bool written = fwrite(&header, sizeof(header), 1, File) == 1;
+
+    if(layout == RANSAC_DATA_AOS) {
+        written = written && fwrite(elements, elementSize, n, File) == size_t(n);
+    } else {
+        size_t fields = elementSize / sizeof(int32_t);
+        size_t stride = fieldStride(n);
+        const uint32_t *in = (const uint32_t *)elements;
+        vector<uint32_t> field(stride / sizeof(uint32_t), 0);
+
+        for(size_t f = 0; f < fields && written; f++) {
+            for(int i = 0; i < n; i++) {
+                field[i] = in[i * fields + f];
+            }
+            // the last array is not padded
+            size_t count = f + 1 < fields ? field.size() : size_t(n);
+            written = fwrite(field.data(), sizeof(uint32_t), count, File) == count;
+        }
     }
-    return 0;
+
+    return fclose(File) == 0 && written;
+}
+
+bool writeInputBinary(const flowvector *v, int n, string fileName, uint32_t layout) {
+    return writeBinary(v, n, RANSAC_DATA_FLOWVECTOR, sizeof(flowvector), layout, fileName);
+}
+
+bool writeInputBinary(const point *p, int n, string fileName, uint32_t layout) {
+    return writeBinary(p, n, RANSAC_DATA_POINT, sizeof(point), layout, fileName);
+}
+
+// The hypotheses after which, with the probability confidence, one of them
+// sampled only inliers: N = log(1 - p) / log(1 - w^s). INT_MAX while no
+// inlier ratio is known.
+int ransacIterations(float inlier_ratio, float confidence, int samples) {
+    double all_inliers = pow((double)inlier_ratio, samples);
+
+    if(all_inliers <= 0 || confidence >= 1) {
+        return INT_MAX;
+    }
+    if(all_inliers >= 1) {
+        return 0;
+    }
+
+    double n = ceil(log(1.0 - confidence) / log(1.0 - all_inliers));
+    return n < INT_MAX ? (int)n : INT_MAX;
 }
 
 // Sequential implementation for comparison purposes
@@ -253,8 +480,8 @@ inline int estimate_ego_motion_first_order_flow(flowvector *flow_vector_array, i
         return (0);
     }
 
-    // Allocate memory to store newly generated vectors
-    flowvector ego_vector_array[size_flow_vector_array];
+    // Allocate memory to store newly generated vectors (too large for the stack)
+    flowvector *ego_vector_array = (flowvector *)malloc(size_flow_vector_array * sizeof(flowvector));
     *count_candidates = 0;
 
     for(iter = 0; iter < max_iter; iter++) {
@@ -272,11 +499,21 @@ inline int estimate_ego_motion_first_order_flow(flowvector *flow_vector_array, i
             model_candidate, outliers_candidate, count_candidates, error_threshold, convergence_threshold, iter);
     }
 
+    free(ego_vector_array);
     return (1);
 }
 
-void verify(flowvector *flow_vector_array, int size_flow_vector_array, int *random_numbers, int max_iter,
-    int error_threshold, float convergence_threshold, int candidates, int b_outliers) {
+// Generates the first order flow model of the iteration (xc, yc, D and R),
+// returns 0 if the two sampled vectors do not define one.
+int genModel(const flowvector *flow_vector_array, const int *random_numbers, int iter, float *model_param) {
+    return gen_firstOrderFlow_model(0, (flowvector *)flow_vector_array, model_param, (int *)random_numbers, iter);
+}
+
+// Estimates the first order flow model sequentially, the reference of the
+// kernels and the host engine, with the parameters of the best model if
+// there is one.
+RansacResult estimateModel(flowvector *flow_vector_array, int size_flow_vector_array, int *random_numbers, int max_iter,
+    int error_threshold, float convergence_threshold, float *model_param) {
 
     int *model_candidate    = (int *)malloc(max_iter * sizeof(int));
     int *outliers_candidate = (int *)malloc(max_iter * sizeof(int));
@@ -292,9 +529,13 @@ void verify(flowvector *flow_vector_array, int size_flow_vector_array, int *rand
             best_model    = model_candidate[i];
         }
     }
-    compare_output(candidates, count_candidates, best_outliers, b_outliers);
+    if(best_model >= 0) {
+        gen_firstOrderFlow_model(size_flow_vector_array, flow_vector_array, model_param, random_numbers, best_model);
+    }
     free(model_candidate);
     free(outliers_candidate);
+    RansacResult result = { count_candidates, best_outliers, best_model };
+    return result;
 }
 
 inline void linear_function_oultier_count(point *point_array, int point_count,
@@ -380,8 +621,137 @@ inline int estimate_linear_function(point *point_array, int size_point_array, in
     return (1);
 }
 
-void verify(point *point_array, int size_point_array, int *random_numbers, int max_iter,
-    int error_threshold, float convergence_threshold, int candidates, int b_outliers) {
+// Generates the linear function of the iteration (m and b), returns 0 if
+// the two sampled points do not define one.
+int genModel(const point *point_array, const int *random_numbers, int iter, float *model_param) {
+    return gen_linear_function_params((point *)point_array, model_param, (int *)random_numbers, iter);
+}
+
+// The elements sampled per hypothesis of a flow vector model.
+int ransacSamples(int model) {
+    return model == RANSAC_MODEL_HOMOGRAPHY ? 4 : (model == RANSAC_MODEL_AFFINE ? 3 : 2);
+}
+
+// The affine transformation u = a x + b y + c, v = d x + e y + f of the
+// tails (x, y) to the heads (u, v) of three flow vectors, by Cramer's rule
+// relative to the first one. Returns 0 if the tails are collinear.
+int genAffineModel(const flowvector *samples, float *model_param) {
+    float x1 = samples[0].x, y1 = samples[0].y, u1 = samples[0].vx, v1 = samples[0].vy;
+    float dx2 = samples[1].x - x1, dy2 = samples[1].y - y1;
+    float dx3 = samples[2].x - x1, dy3 = samples[2].y - y1;
+    float du2 = samples[1].vx - u1, du3 = samples[2].vx - u1;
+    float dv2 = samples[1].vy - v1, dv3 = samples[2].vy - v1;
+
+    float det = dx2 * dy3 - dx3 * dy2;
+    if(det == 0) {
+        return 0;
+    }
+
+    float a = (du2 * dy3 - du3 * dy2) / det;
+    float b = (dx2 * du3 - dx3 * du2) / det;
+    float d = (dv2 * dy3 - dv3 * dy2) / det;
+    float e = (dx2 * dv3 - dx3 * dv2) / det;
+
+    model_param[0] = a;
+    model_param[1] = b;
+    model_param[2] = u1 - a * x1 - b * y1;
+    model_param[3] = d;
+    model_param[4] = e;
+    model_param[5] = v1 - d * x1 - e * y1;
+    return 1;
+}
+
+// The homography of the tails (x, y) to the heads (u, v) of four flow
+// vectors by the direct linear transformation, u = (h0 x + h1 y + h2) / w,
+// v = (h3 x + h4 y + h5) / w, w = h6 x + h7 y + 1. The points are centered
+// and scaled to a mean distance (in x plus y) of 2 from their centroid,
+// the 8x8 system solved by Gaussian elimination with partial pivoting.
+// Returns 0 for a degenerate sample.
+int genHomographyModel(const flowvector *samples, float *model_param) {
+    float cx = 0, cy = 0, cu = 0, cv = 0;
+    for(int i = 0; i < 4; i++) {
+        cx += samples[i].x;
+        cy += samples[i].y;
+        cu += samples[i].vx;
+        cv += samples[i].vy;
+    }
+    cx /= 4; cy /= 4; cu /= 4; cv /= 4;
+
+    float ds = 0, dd = 0;
+    for(int i = 0; i < 4; i++) {
+        ds += fabsf(samples[i].x - cx) + fabsf(samples[i].y - cy);
+        dd += fabsf(samples[i].vx - cu) + fabsf(samples[i].vy - cv);
+    }
+    if(ds == 0 || dd == 0) {
+        return 0;
+    }
+    float ks = 8 / ds, kd = 8 / dd;
+
+    float a[8][9];
+    for(int i = 0; i < 4; i++) {
+        float x = (samples[i].x - cx) * ks, y = (samples[i].y - cy) * ks;
+        float u = (samples[i].vx - cu) * kd, v = (samples[i].vy - cv) * kd;
+        float r0[9] = { x, y, 1, 0, 0, 0, -u * x, -u * y, u };
+        float r1[9] = { 0, 0, 0, x, y, 1, -v * x, -v * y, v };
+        memcpy(a[2 * i], r0, sizeof(r0));
+        memcpy(a[2 * i + 1], r1, sizeof(r1));
+    }
+
+    for(int c = 0; c < 8; c++) {
+        int p = c;
+        for(int r = c + 1; r < 8; r++) {
+            if(fabsf(a[r][c]) > fabsf(a[p][c])) p = r;
+        }
+        if(fabsf(a[p][c]) < 1e-6f) {
+            return 0;
+        }
+        for(int k = 0; k < 9; k++) {
+            float t = a[c][k]; a[c][k] = a[p][k]; a[p][k] = t;
+        }
+        for(int r = c + 1; r < 8; r++) {
+            float f = a[r][c] / a[c][c];
+            for(int k = c; k < 9; k++) {
+                a[r][k] -= f * a[c][k];
+            }
+        }
+    }
+
+    float n[9];
+    n[8] = 1;
+    for(int c = 7; c >= 0; c--) {
+        float sum = a[c][8];
+        for(int k = c + 1; k < 8; k++) {
+            sum -= a[c][k] * n[k];
+        }
+        n[c] = sum / a[c][c];
+    }
+
+    // undo the normalization, H = Td^-1 Hn Ts
+    float m[9];
+    for(int r = 0; r < 3; r++) {
+        m[3 * r + 0] = n[3 * r + 0] * ks;
+        m[3 * r + 1] = n[3 * r + 1] * ks;
+        m[3 * r + 2] = n[3 * r + 2] - n[3 * r + 0] * ks * cx - n[3 * r + 1] * ks * cy;
+    }
+    float h[9];
+    for(int j = 0; j < 3; j++) {
+        h[j] = m[j] / kd + cu * m[6 + j];
+        h[3 + j] = m[3 + j] / kd + cv * m[6 + j];
+        h[6 + j] = m[6 + j];
+    }
+    if(h[8] == 0) {
+        return 0;
+    }
+    for(int k = 0; k < 8; k++) {
+        model_param[k] = h[k] / h[8];
+    }
+    return 1;
+}
+
+// Estimates the linear function sequentially, the reference of the kernels
+// and the host engine, with the parameters of the best model if there is one.
+RansacResult estimateModel(point *point_array, int size_point_array, int *random_numbers, int max_iter,
+    int error_threshold, float convergence_threshold, float *model_param) {
 
     int *model_candidate    = (int *)malloc(max_iter * sizeof(int));
     int *outliers_candidate = (int *)malloc(max_iter * sizeof(int));
@@ -397,8 +767,11 @@ void verify(point *point_array, int size_point_array, int *random_numbers, int m
             best_model    = model_candidate[i];
         }
     }
-    
-    compare_output(candidates, count_candidates, best_outliers, b_outliers);
+    if(best_model >= 0) {
+        gen_linear_function_params(point_array, model_param, random_numbers, best_model);
+    }
     free(model_candidate);
     free(outliers_candidate);
-}
\ No newline at end of file
+    RansacResult result = { count_candidates, best_outliers, best_model };
+    return result;
+}
@@ -4,9 +4,52 @@
 #include <string.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <stdint.h>
+#include <string>
 
 using namespace std;
 
+// The thresholds of the models (flow vectors, linear function).
+#define RANSAC_FV_ERROR_THRESHOLD 3
+#define RANSAC_P_ERROR_THRESHOLD 50
+#define RANSAC_CONVERGENCE_THRESHOLD 0.75f
+
+// Elements sampled per hypothesis by the first order flow and the linear
+// function models, the affine and homography models draw 3 and 4
+// (ransacSamples()).
+#define RANSAC_SAMPLES 2
+
+// The models of the flow vectors: the first order flow, and the affine
+// transformation and homography mapping the tails (x, y) to the heads
+// (vx, vy), from 2, 3 and 4 samples.
+#define RANSAC_MODEL_FLOW 0
+#define RANSAC_MODEL_AFFINE 1
+#define RANSAC_MODEL_HOMOGRAPHY 2
+
+// The most hypotheses of the preemptive kernels.
+#define RANSAC_MAX_HYPOTHESES 4096
+
+// The most elements of the local memory kernels (set by CMake).
+#ifndef RANSAC_N
+#define RANSAC_N 5888
+#endif
+
+// Binary data sets, read instead of the csv files if they start with the
+// magic.
+#define RANSAC_DATA_MAGIC "FBRANDAT"
+#define RANSAC_DATA_VERSION 1
+#define RANSAC_DATA_ALIGNMENT 64
+
+// Element types of the binary data sets.
+#define RANSAC_DATA_FLOWVECTOR 1
+#define RANSAC_DATA_POINT 2
+
+// Layouts of the binary data sets: the elements one after another, or the
+// fields (x, y, vx, vy or x, y) in arrays of count 32 bit values one after
+// another, each starting at a multiple of RANSAC_DATA_ALIGNMENT.
+#define RANSAC_DATA_AOS 0
+#define RANSAC_DATA_SOA 1
+
 typedef struct {
     int x;  // tail
     int y;  // tail
@@ -19,13 +62,67 @@ typedef struct {
     float y;  
 } point;
 
-int readInputSize(string fileName);
-void readInputData(flowvector *v, string fileName);
-void readInputData(point *p, string fileName);
-void genRandNumbers(int *r, int maxIter, int n);
-void verify(flowvector *flow_vector_array, int size_flow_vector_array, int *random_numbers, int max_iter,
-    int error_threshold, float convergence_threshold, int candidates, int b_outliers);
-void verify(point *point_array, int size_point_array, int *random_numbers, int max_iter,
-    int error_threshold, float convergence_threshold, int candidates, int b_outliers);
+// Header of the binary data sets, the raw elements follow at dataOffset
+// (a multiple of RANSAC_DATA_ALIGNMENT).
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t type;
+    int64_t count;
+    uint32_t elementSize;
+    uint32_t layout;
+    uint64_t dataOffset;
+    uint8_t reserved[24];
+} RansacDataHeader;
+
+// A data set as read by readInput(): the elements point into the mapping of
+// a binary data set, or into the buffer a csv data set is parsed into. The
+// fields of the structure of arrays layout are fieldStride bytes apart.
+typedef struct {
+    void *mapping;
+    size_t mappingSize;
+    void *buffer;
+    uint32_t type;
+    uint32_t layout;
+    int count;
+    size_t fieldStride;
+    const void *elements;
+} RansacDataFile;
+
+// The result of ransac: the number of hypotheses with fewer outliers than
+// the convergence threshold, the fewest outliers (the number of elements if
+// there is no candidate) and the iteration of that hypothesis (-1 if none).
+typedef struct {
+    int candidates;
+    int bestOutliers;
+    int bestModel;
+} RansacResult;
+
+inline uint32_t inputDataType(const flowvector *) { return RANSAC_DATA_FLOWVECTOR; }
+inline uint32_t inputDataType(const point *) { return RANSAC_DATA_POINT; }
+
+// The array of field f of a data set in the structure of arrays layout.
+inline const void *inputField(const RansacDataFile &file, int f) {
+    return (const char *)file.elements + f * file.fieldStride;
+}
+
+bool readInput(string fileName, uint32_t type, RansacDataFile &file);
+void releaseInput(RansacDataFile &file);
+void copyInput(const RansacDataFile &file, void *elements);
+void genRandNumbers(int *r, int maxIter, int n, int samples = RANSAC_SAMPLES);
+bool writeInputData(const flowvector *v, int n, string fileName);
+bool writeInputData(const point *p, int n, string fileName);
+bool writeInputBinary(const flowvector *v, int n, string fileName, uint32_t layout = RANSAC_DATA_AOS);
+bool writeInputBinary(const point *p, int n, string fileName, uint32_t layout = RANSAC_DATA_AOS);
+int ransacIterations(float inlier_ratio, float confidence, int samples);
+int genModel(const flowvector *flow_vector_array, const int *random_numbers, int iter, float *model_param);
+int genModel(const point *point_array, const int *random_numbers, int iter, float *model_param);
+int ransacSamples(int model);
+int genAffineModel(const flowvector *samples, float *model_param);
+int genHomographyModel(const flowvector *samples, float *model_param);
+RansacResult estimateModel(flowvector *flow_vector_array, int size_flow_vector_array, int *random_numbers, int max_iter,
+    int error_threshold, float convergence_threshold, float *model_param);
+RansacResult estimateModel(point *point_array, int size_point_array, int *random_numbers, int max_iter,
+    int error_threshold, float convergence_threshold, float *model_param);
 
 #endif // RANSACUTILITY_H
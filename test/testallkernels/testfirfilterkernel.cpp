@@ -6,10 +6,17 @@
 
 #include <gtest/gtest.h>
 #include <time.h>
+#include <math.h>
+#include <vector>
 #include "../../src/common/benchmarkoptionsparser.h"
 #include "../../src/common/utility.h"
 
 #include "../../src/firfilter/firfilterutility.h"
+#include "../../src/firfilter/firfilterfft.h"
+#include "../../src/firfilter/firfilterpolyphase.h"
+#include "../../src/firfilter/firfilterbank.h"
+#include "../../src/firfilter/firfilterfixed.h"
+#include "../../src/firfilter/firfilterlms.h"
 
 #include "../common/basetest.h"
 
@@ -26,7 +33,29 @@ extern cl_device_id t_dev;
 // firfilter specific Implementation from BaseFixtureTest
 class FirFilterKernelsTestFixture : public BaseTestFixture
 {
-
+protected:
+    vector<FLOATING_POINT> samples, coefficients;
+    BenchmarkData benchmarkData;
+
+    // The test signal of the host engines: a slow sine on a pseudo random
+    // staircase, filtered by a cosine, set up as the benchmark data.
+    void makeFirTestSignal(int numSamples, int numCoefficients)
+    {
+        samples.resize(numSamples);
+        coefficients.resize(numCoefficients);
+
+        for (int i=0; i<numSamples; i++)
+            samples[i] = sin(i * 0.01) + 0.3 * ((i * 7919) % 13 - 6);
+
+        for (int i=0; i<numCoefficients; i++)
+            coefficients[i] = 0.01 * cos(i * 0.1);
+
+        benchmarkData = BenchmarkData();
+        benchmarkData.samples.elements = samples.data();
+        benchmarkData.samples.size = numSamples;
+        benchmarkData.coefficients.elements = coefficients.data();
+        benchmarkData.coefficients.size = numCoefficients;
+    }
 };
 
 // Parameterized Tests implementation of Unit Testing firfilter with Test Fixtures
@@ -160,3 +189,354 @@ TEST_F(FirFilterKernelsTestFixture, DISABLED_TestFirFilter)
     delete results;
 
 }; // Testfirfilter
+
+// Filtering a stream block by block with the carried history must give the
+// same samples as filtering it at once.
+TEST_F(FirFilterKernelsTestFixture, TestFirFilterStreamHistory)
+{
+    int numSamples = 1000;
+    int numCoefficients = 37;
+    int blockSizes[] = {5, 100, 3, 400, 492};
+
+    vector<FLOATING_POINT> samples(numSamples), coefficients(numCoefficients);
+    vector<FLOATING_POINT> wholeResults(numSamples), blockResults(numSamples);
+    vector<FLOATING_POINT> wholeHistory(numCoefficients-1, 0);
+    vector<FLOATING_POINT> blockHistory(numCoefficients-1, 0);
+
+    for (int i=0; i<numSamples; i++)
+        samples[i] = sin(i * 0.1);
+
+    for (int i=0; i<numCoefficients; i++)
+        coefficients[i] = 1.0 / (i+1);
+
+    filterSamplesCPU(samples.data(), numSamples, coefficients.data(), 
+                    numCoefficients, wholeHistory.data(), wholeResults.data());
+
+    int offset = 0;
+    for (int blockSize : blockSizes)
+    {
+        filterSamplesCPU(samples.data()+offset, blockSize, coefficients.data(),
+                numCoefficients, blockHistory.data(), blockResults.data()+offset);
+        offset += blockSize;
+    }
+
+    ASSERT_EQ(numSamples, offset);
+
+    for (int i=0; i<numSamples; i++)
+        ASSERT_FLOAT_EQ(wholeResults[i], blockResults[i]);
+
+    for (int i=0; i<numCoefficients-1; i++)
+        ASSERT_FLOAT_EQ(wholeHistory[i], blockHistory[i]);
+}; // TestFirFilterStreamHistory
+
+// The overlap-add fft filter must match the direct filter for fft sizes 
+// with one, a few and a partial segment pair.
+TEST_F(FirFilterKernelsTestFixture, TestFirFilterFft)
+{
+    int numSamples = 5000;
+    int numCoefficients = 256;
+    int fftSizes[] = {512, 1024, 2048, 16384};
+
+    vector<FLOATING_POINT> directResults(numSamples), fftResults(numSamples);
+    vector<FLOATING_POINT> history(numCoefficients-1, 0);
+
+    makeFirTestSignal(numSamples, numCoefficients);
+
+    filterSamplesCPU(samples.data(), numSamples, coefficients.data(), 
+                    numCoefficients, history.data(), directResults.data());
+
+    double tolerance = getHostEspsilon(numCoefficients);
+
+    for (int fftSize : fftSizes)
+    {
+        FftFilter filter;
+        initFftFilter(filter, coefficients.data(), numCoefficients, fftSize);
+        filterSamplesFFT(filter, samples.data(), numSamples, fftResults.data());
+
+        for (int i=0; i<numSamples; i++)
+            ASSERT_TRUE(floatingPointEquals(directResults[i], fftResults[i], tolerance))
+                << "fft size " << fftSize << ", index " << i;
+    }
+}; // TestFirFilterFft
+
+TEST_F(FirFilterKernelsTestFixture, TestFirFilterBinaryFiles)
+{
+    int group = 9;
+    int numSamples = 1000;
+    string dirName = ::testing::TempDir();
+
+    vector<FLOATING_POINT> samples(numSamples);
+    for (int i=0; i<numSamples; i++)
+        samples[i] = sin(i * 0.01);
+
+    string binaryName = dirName + to_string(group) + INPUTS_BINARY_FILE;
+    ASSERT_TRUE(writeBinaryFile(binaryName, group, samples.data(), numSamples));
+
+    FileData fileData;
+    ASSERT_TRUE(readBinaryFile(binaryName, fileData));
+    ASSERT_EQ(group, fileData.group);
+    ASSERT_EQ(numSamples, fileData.size);
+    ASSERT_EQ(0, (uintptr_t)fileData.elements % FIR_DATA_ALIGNMENT);
+
+    for (int i=0; i<numSamples; i++)
+        ASSERT_EQ(samples[i], fileData.elements[i]) << "index " << i;
+
+    releaseFile(fileData);
+
+    // a data offset into the header, beyond the file or leaving too few
+    // elements behind it is rejected instead of read out of bounds
+    uint64_t offsets[] = { 0, ~uint64_t(FIR_DATA_ALIGNMENT - 1), 
+                           FIR_DATA_ALIGNMENT * uint64_t(numSamples / FIR_DATA_ALIGNMENT + 2) };
+    for (uint64_t offset : offsets)
+    {
+        FILE *file = fopen(binaryName.c_str(), "r+b");
+        ASSERT_TRUE(file != NULL);
+        fseek(file, offsetof(FirDataHeader, dataOffset), SEEK_SET);
+        ASSERT_EQ(1, fwrite(&offset, sizeof(offset), 1, file));
+        fclose(file);
+
+        ASSERT_FALSE(readBinaryFile(binaryName, fileData)) << "offset " << offset;
+        ASSERT_TRUE(fileData.mapping == NULL);
+    }
+
+    remove(binaryName.c_str());
+}; // TestFirFilterBinaryFiles
+
+TEST_F(FirFilterKernelsTestFixture, TestFirFilterSelectVariants)
+{
+    vector<FirVariant> variants;
+
+    ASSERT_TRUE(selectFirVariants(FIR_VARIANTS_ALL, variants));
+    ASSERT_EQ(8, variants.size());
+
+    ASSERT_TRUE(selectFirVariants("single_man_mac,firfilter_double", variants));
+    ASSERT_EQ(2, variants.size());
+    ASSERT_EQ("firfilter_single_man_mac", variants[0].name);
+    ASSERT_EQ(FIR_KERNEL_DIRECT, variants[0].type);
+    ASSERT_FALSE(variants[0].doublePrecision);
+    ASSERT_TRUE(variants[1].doublePrecision);
+
+    ASSERT_TRUE(selectFirVariants("single_channel_man_mac_non_align", variants));
+    ASSERT_EQ(FIR_KERNEL_CHANNELED, variants[0].type);
+
+    ASSERT_FALSE(selectFirVariants("single,quadruple", variants));
+
+    // the bitstreams of all variants tell their precision, the double ones
+    // included, whose kernel arguments are of the FLOATING_POINT typedef
+    ASSERT_TRUE(selectFirVariants(FIR_VARIANTS_ALL, variants));
+    for (FirVariant &variant : variants)
+    {
+        FirVariant detected = getFirVariant("../bin/" + variant.name + ".aocx", variant.type);
+        ASSERT_EQ(variant.name, detected.name);
+        ASSERT_EQ(variant.doublePrecision, detected.doublePrecision) << variant.name;
+    }
+
+    FirVariant detected = getFirVariant("firfilter_double_unroll_mac.aocx", FIR_KERNEL_DIRECT);
+    ASSERT_TRUE(detected.doublePrecision);
+    detected = getFirVariant("firfilter_single", FIR_KERNEL_DIRECT);
+    ASSERT_FALSE(detected.doublePrecision);
+}; // TestFirFilterSelectVariants
+
+// The polyphase engines must give the decimated respectively zero stuffed
+// outputs of the full rate filter.
+TEST_F(FirFilterKernelsTestFixture, TestFirFilterPolyphase)
+{
+    int numSamples = 3001;
+    int numCoefficients = 100;
+    int factors[] = {2, 3, 4, 5};
+
+    makeFirTestSignal(numSamples, numCoefficients);
+
+    double tolerance = getHostEspsilon(numCoefficients);
+
+    for (int factor : factors)
+    {
+        PolyphaseFilter filter;
+        initPolyphaseFilter(filter, coefficients.data(), numCoefficients, factor);
+
+        // Decimated: every factor-th output of the full rate filter.
+        vector<FLOATING_POINT> stuffed(numSamples * factor, 0);
+        vector<FLOATING_POINT> fullRate(numSamples * factor);
+        vector<FLOATING_POINT> history(numCoefficients-1, 0);
+        vector<FLOATING_POINT> results(numSamples * factor);
+
+        filterSamplesCPU(samples.data(), numSamples, coefficients.data(), 
+                        numCoefficients, history.data(), fullRate.data());
+        decimateSamplesCPU(filter, samples.data(), numSamples, results.data());
+
+        for (int m=0; m<getDecimatedSize(numSamples, factor); m++)
+            ASSERT_TRUE(floatingPointEquals(fullRate[m*factor], results[m], tolerance))
+                << "decimation by " << factor << ", index " << m;
+
+        // Interpolated: the full rate filter of the zero stuffed samples.
+        for (int j=0; j<numSamples; j++)
+            stuffed[j*factor] = samples[j];
+
+        history.assign(numCoefficients-1, 0);
+        filterSamplesCPU(stuffed.data(), numSamples * factor, coefficients.data(), 
+                        numCoefficients, history.data(), fullRate.data());
+        interpolateSamplesCPU(filter, samples.data(), numSamples, results.data());
+
+        for (int n=0; n<numSamples * factor; n++)
+            ASSERT_TRUE(floatingPointEquals(fullRate[n], results[n], tolerance))
+                << "interpolation by " << factor << ", index " << n;
+    }
+}; // TestFirFilterPolyphase
+
+// Every channel of the filter bank must be filtered like a single signal
+// by its own coefficients.
+TEST_F(FirFilterKernelsTestFixture, TestFirFilterBank)
+{
+    int fileSamples = 2000;
+    int numCoefficients = 64;
+    int numChannels = 70;
+    int numSamples = 300;
+
+    makeFirTestSignal(fileSamples, numCoefficients);
+
+    FilterBank bank;
+    makeFilterBank(bank, benchmarkData, numChannels, numSamples);
+
+    vector<FLOATING_POINT> results(bank.samples.size());
+    filterBankCPU(bank, results.data(), 3);
+
+    double tolerance = getHostEspsilon(numCoefficients);
+
+    for (int c=0; c<numChannels; c++)
+    {
+        vector<FLOATING_POINT> channelSamples(numSamples), channelCoefficients(numCoefficients);
+        vector<FLOATING_POINT> channelResults(numSamples);
+        vector<FLOATING_POINT> history(numCoefficients-1, 0);
+
+        for (int n=0; n<numSamples; n++)
+            channelSamples[n] = bank.samples[n*numChannels + c];
+
+        for (int k=0; k<numCoefficients; k++)
+            channelCoefficients[k] = bank.coefficients[k*numChannels + c];
+
+        filterSamplesCPU(channelSamples.data(), numSamples, channelCoefficients.data(),
+                        numCoefficients, history.data(), channelResults.data());
+
+        for (int n=0; n<numSamples; n++)
+            ASSERT_TRUE(floatingPointEquals(channelResults[n], results[n*numChannels + c], 
+                        tolerance)) << "channel " << c << ", sample " << n;
+    }
+
+    vector<int> channelCounts;
+    ASSERT_TRUE(parseChannelCounts("64,256,1024", channelCounts));
+    ASSERT_EQ(3, channelCounts.size());
+    ASSERT_EQ(1024, channelCounts[2]);
+    ASSERT_FALSE(parseChannelCounts("64,x", channelCounts));
+    ASSERT_FALSE(parseChannelCounts("0", channelCounts));
+}; // TestFirFilterBank
+
+// Checks the fixed point host engine of type T bit for bit against the exact
+// sums, and the dequantized results against the float filter.
+template <typename T>
+static void checkFixedPointFilter(BenchmarkData &benchmarkData, double &bound)
+{
+    const int fracBits = FixedPointTraits<T>::fracBits;
+    const long maxValue = (1L << fracBits) - 1, minValue = -(1L << fracBits);
+
+    FixedPointFilter<T> filter;
+    initFixedPointFilter(filter, benchmarkData);
+
+    int numSamples = filter.numSamples;
+    int numCoefficients = filter.numCoefficients;
+
+    vector<T> results(numSamples);
+    filterSamplesFixedCPU(filter, results.data());
+
+    vector<long> sums(numSamples);
+    for (int n=0; n<numSamples; n++)
+    {
+        sums[n] = 0;
+        for (int k=0; k<numCoefficients && k<=n; k++)
+            sums[n] += long(filter.samples[n-k]) * filter.coefficients[k];
+
+        long expected = filter.shift > 0 ? 
+            (sums[n] + (1L << (filter.shift-1))) >> filter.shift : sums[n];
+        ASSERT_EQ(expected, results[n]) << FixedPointTraits<T>::name() << ", index " << n;
+    }
+
+    double maxError;
+    bound = getFixedPointErrorBound(filter, benchmarkData);
+    ASSERT_TRUE(verifyFixedPoint(filter, benchmarkData, results.data(), maxError));
+    ASSERT_LE(maxError, bound);
+
+    // Without the result shift the large sums saturate.
+    filter.shift = 0;
+    filterSamplesFixedCPU(filter, results.data());
+
+    for (int n=0; n<numSamples; n++)
+        ASSERT_EQ(max(minValue, min(maxValue, sums[n])), results[n]);
+}
+
+// The fixed point filters must be exact to their integer sums and within
+// the quantization error bound of the float filter.
+TEST_F(FirFilterKernelsTestFixture, TestFirFilterFixedPoint)
+{
+    int numSamples = 3001;
+    int numCoefficients = 100;
+
+    makeFirTestSignal(numSamples, numCoefficients);
+
+    double q15Bound, q7Bound;
+    checkFixedPointFilter<int16_t>(benchmarkData, q15Bound);
+    checkFixedPointFilter<int8_t>(benchmarkData, q7Bound);
+
+    ASSERT_LT(q15Bound, q7Bound);
+}; // TestFirFilterFixedPoint
+
+// LMS and NLMS must identify the filter that made the desired samples.
+TEST_F(FirFilterKernelsTestFixture, TestFirFilterLms)
+{
+    int numSamples = 40000;
+    int numCoefficients = 24;
+    int numTaps = 32;
+
+    vector<FLOATING_POINT> desired(numSamples);
+
+    // white noise through an unknown filter instead of the test signal
+    makeFirTestSignal(numSamples, numCoefficients);
+
+    unsigned int seed = 12345;
+    for (int i=0; i<numSamples; i++)
+    {
+        seed = seed * 1103515245 + 12345;
+        samples[i] = ((seed >> 8) & 0xffff) / 32768.0 - 1;
+    }
+
+    for (int k=0; k<numCoefficients; k++)
+        coefficients[k] = 0.3 * sin(0.4 * k + 0.2) / (1 + 0.1 * k);
+
+    vector<FLOATING_POINT> history(numCoefficients-1, 0);
+    filterSamplesCPU(samples.data(), numSamples, coefficients.data(), numCoefficients,
+                    history.data(), desired.data());
+
+    benchmarkData.results.elements = desired.data();
+    benchmarkData.results.size = numSamples;
+
+    vector<FLOATING_POINT> weights(numTaps), errors(numSamples);
+
+    for (bool normalized : {false, true})
+    {
+        FLOATING_POINT step = getLmsStep(benchmarkData, numTaps, normalized, 0);
+        adaptSamplesCPU(samples.data(), desired.data(), numSamples, numTaps, step,
+                        normalized, weights.data(), errors.data());
+
+        LmsConvergence convergence = getLmsConvergence(benchmarkData, errors.data(),
+                                                    weights.data(), numTaps);
+
+        ASSERT_TRUE(convergence.converged);
+        ASSERT_LT(convergence.finalMse, 1.e-6 * convergence.desiredPower);
+        ASSERT_GT(convergence.initialMse, 100 * convergence.finalMse);
+        ASSERT_LT(convergence.misalignment, 1.e-5);
+    }
+
+    // A step far beyond the stable range diverges.
+    adaptSamplesCPU(samples.data(), desired.data(), numSamples, numTaps, 1.0, false,
+                    weights.data(), errors.data());
+    ASSERT_FALSE(getLmsConvergence(benchmarkData, errors.data(), weights.data(), 
+                                    numTaps).converged);
+}; // TestFirFilterLms
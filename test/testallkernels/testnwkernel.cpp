@@ -6,9 +6,17 @@
 
 #include <gtest/gtest.h>
 #include <time.h>
+#include <algorithm>
+#include <limits>
 #include "../../src/common/benchmarkoptionsparser.h"
 #include "../../src/common/utility.h"
 #include "../common/basetest.h"
+#include "../../src/nw/nwutility.h"
+#include "../../src/nw/nwbatch.h"
+#include "../../src/nw/nwsimd.h"
+#include "../../src/nw/nwtraceback.h"
+#include "../../src/nw/nwbanded.h"
+#include "../../src/nw/nwsequence.h"
 #include "CL/cl_ext_intelfpga.h"
 
 using namespace std;
@@ -43,20 +51,6 @@ inline static void* alignedMalloc(size_t size)
 #endif	
 }
 
-inline int maximum(int a, int b, int c)
-{
-	int k;
-	if(a <= b)
-		k = b;
-	else
-		k = a;
-
-	if(k <= c)
-		return(c);
-	else
-		return(k);
-}
-
 // scan specific Implementation from BaseFixtureTest
 class NWKernelsTestFixture : public BaseTestFixture
 {
@@ -149,25 +143,22 @@ TEST_P(NWKernelsTestFixtureWithParam, TestNW)
         buffer_h[j - 1] = -j * penalty;
     }
 
-    // Allocate host memory for reference data (reference)
-    cl_mem reference_d = clCreateBuffer(t_ctx, CL_MEM_READ_ONLY | CL_CHANNEL_1_INTELFPGA, ref_size * sizeof(int), NULL, &err);
+    // the kernel reads and writes one strip of BSIZE rows of the reference
+    // and data matrices per block, as in benchmarkNW
+    size_t strip_size = (size_t)BSIZE * num_cols;
+    int *reference_strip = (int *)alignedMalloc(strip_size * sizeof(int));
+    int *output_strip = (int *)alignedMalloc(strip_size * sizeof(int));
+
+    cl_mem reference_d = clCreateBuffer(t_ctx, CL_MEM_READ_ONLY | CL_CHANNEL_1_INTELFPGA, strip_size * sizeof(int), NULL, &err);
     ASSERT_EQ(CL_SUCCESS, err);
 
-    // Allocate host memory for input data (input_itemsets)
-    int device_buff_size = ref_size;
-    cl_mem input_itemsets_d = clCreateBuffer(t_ctx, CL_MEM_READ_WRITE | CL_CHANNEL_2_INTELFPGA, device_buff_size * sizeof(int), NULL, &err);
+    cl_mem input_itemsets_d = clCreateBuffer(t_ctx, CL_MEM_READ_WRITE | CL_CHANNEL_2_INTELFPGA, strip_size * sizeof(int), NULL, &err);
     ASSERT_EQ(CL_SUCCESS, err);
 
     // Allocate
     cl_mem buffer_v_d = clCreateBuffer(t_ctx, CL_MEM_READ_ONLY | CL_CHANNEL_1_INTELFPGA, num_rows * sizeof(int), NULL, &err);
     ASSERT_EQ(CL_SUCCESS, err);
 
-    err = clEnqueueWriteBuffer(t_queue, reference_d, 1, 0, ref_size * sizeof(int), reference, 0, 0, 0);
-    ASSERT_EQ(CL_SUCCESS, err);
-
-    err = clFinish(t_queue);
-    ASSERT_EQ(CL_SUCCESS, err);
-
     err = clEnqueueWriteBuffer(t_queue, input_itemsets_d, 1, 0, num_cols * sizeof(int), buffer_h, 0, 0, 0);
     ASSERT_EQ(CL_SUCCESS, err);
 
@@ -209,26 +200,47 @@ TEST_P(NWKernelsTestFixtureWithParam, TestNW)
     int last_diag  = (num_diags % comp_bsize == 0) ? num_diags : num_diags + comp_bsize - (num_diags % comp_bsize);
     int num_blocks = last_diag / comp_bsize;
         
+    // the first row is not written by the kernel
+    std::copy(buffer_h, buffer_h + num_cols, output_itemsets);
+
     for (int bx = 0; bx < num_blocks; bx++)
     {
         int block_offset = bx * comp_bsize;
 
+        // the rows block_offset to block_offset + BSIZE - 1 of the reference
+        for (int r = 0; r < BSIZE; r++)
+        {
+            int row = block_offset + r;
+            for (int c = 0; c < num_cols; c++)
+                reference_strip[r * num_cols + c] = (row < num_rows) ? reference[row * num_cols + c] : 0;
+        }
+
+        err = clEnqueueWriteBuffer(t_queue, reference_d, 1, 0, strip_size * sizeof(int), reference_strip, 0, 0, 0);
+        CL_CHECK_ERROR(err);
+
         err = clSetKernelArg(nwkernel, 6, sizeof(cl_int), (void*) &block_offset);
         CL_CHECK_ERROR(err);
             
         err = clEnqueueTask(t_queue, nwkernel, 0, NULL, NULL);
         CL_CHECK_ERROR(err);
 
+        err = clEnqueueReadBuffer(t_queue, input_itemsets_d, 1, 0, strip_size * sizeof(int), output_strip, 0, 0, 0);
+        CL_CHECK_ERROR(err);
+
+        // the rows after the carried one are this block's
+        for (int r = 1; r < BSIZE && block_offset + r < num_rows; r++)
+            std::copy(output_strip + r * num_cols, output_strip + (r + 1) * num_cols,
+                      output_itemsets + (block_offset + r) * num_cols);
+
+        // the last row of this block is the first row of the next one
+        err = clEnqueueCopyBuffer(t_queue, input_itemsets_d, input_itemsets_d, (size_t)comp_bsize * num_cols * sizeof(int),
+                                  0, num_cols * sizeof(int), 0, NULL, NULL);
+        CL_CHECK_ERROR(err);
+
         err = clFinish(t_queue);
         CL_CHECK_ERROR(err);
     }
     
-    err = clEnqueueReadBuffer(t_queue, input_itemsets_d, 1, 0, ref_size * sizeof(int), output_itemsets, 0, 0, 0);
-    CL_CHECK_ERROR(err);
-
-    err = clFinish(t_queue);
-    CL_CHECK_ERROR(err);
-    
 	for (int i=0 ; i < max_rows - 2 ; ++i)
 	{
 		for (int j = 0 ; j < max_cols - 2 ; ++j)
@@ -244,6 +256,8 @@ TEST_P(NWKernelsTestFixtureWithParam, TestNW)
     ASSERT_EQ(CL_SUCCESS, err);
 
     // Clean up other host memory
+    free(reference_strip);
+    free(output_strip);
 
     err = clReleaseProgram(fbenchProgram);
     ASSERT_EQ(CL_SUCCESS, err);
@@ -253,6 +267,352 @@ TEST_P(NWKernelsTestFixtureWithParam, TestNW)
 
 };
 
+// The reference strips generated on the fly and the linear-space rows must
+// match the full matrices of the kernel test
+TEST_P(NWKernelsTestFixtureWithParam, TestNWLinearSpace)
+{
+    auto param = GetParam();
+    int dim = param.dim;
+
+    NWProblem problem;
+    makeNWProblem(problem, dim, NW_DEFAULT_PENALTY);
+
+    vector<int> strip(BSIZE * dim);
+
+    for (int block_offset = 0; block_offset < dim + 1; block_offset += BSIZE - 1)
+    {
+        fillNWReferenceStrip(problem, block_offset, BSIZE, strip.data());
+
+        for (int r = 0; r < BSIZE && block_offset + r < dim + 1; r++)
+        {
+            for (int c = 0; c < dim; c++)
+            {
+                ASSERT_EQ(param.reference[(block_offset + r) * dim + c], strip[r * dim + c]);
+            }
+        }
+    }
+
+    vector<int> row(dim + 1);
+
+    for (int i = 0; i < dim - 1; i++)
+    {
+        nwScoreRowCPU(problem, i, row.data());
+
+        for (int j = 0; j < dim - 1; j++)
+        {
+            ASSERT_EQ(param.output_itemsets[i * (dim - 1) + j], row[j + 1]);
+        }
+    }
+}
+
+// The batched host routine and the scalar linear space reference must match
+// a full matrix alignment of each pair, whichever thread computes it
+TEST_F(NWKernelsTestFixture, TestNWBatch)
+{
+    vector<NWLengthRange> ranges;
+    ASSERT_TRUE(parseNWLengthRanges("7,1-40", ranges));
+    ASSERT_EQ(2, (int)ranges.size());
+    ASSERT_EQ(7, ranges[0].max);
+    ASSERT_EQ(1, ranges[1].min);
+    ASSERT_EQ(40, ranges[1].max);
+    ASSERT_EQ("1-40", getNWLengthRangeName(ranges[1]));
+    ASSERT_FALSE(parseNWLengthRanges("40-1", ranges));
+    ASSERT_FALSE(parseNWLengthRanges("0", ranges));
+    ASSERT_FALSE(parseNWLengthRanges("10000", ranges));
+
+    NWBatch batch;
+    makeNWBatch(batch, 300, NWLengthRange{1, 40}, NW_DEFAULT_PENALTY);
+
+    vector<int> scores(300);
+    nwBatchCPU(batch, scores.data(), 3);
+
+    long long cells = 0;
+    vector<int> scratch(NW_BATCH_MAX_LENGTH + 1);
+
+    for (int p = 0; p < 300; p++)
+    {
+        const NWPair &pair = batch.pairs[p];
+        int rows = pair.rowLength + 1;
+        int cols = pair.colLength + 1;
+        vector<int> matrix(rows * cols);
+
+        for (int i = 0; i < rows; i++)
+            matrix[i * cols] = -i * NW_DEFAULT_PENALTY;
+        for (int j = 0; j < cols; j++)
+            matrix[j] = -j * NW_DEFAULT_PENALTY;
+
+        for (int i = 1; i < rows; i++)
+        {
+            for (int j = 1; j < cols; j++)
+            {
+                int score = blosum62[(int)batch.residues[pair.rowOffset + i - 1]]
+                                    [(int)batch.residues[pair.colOffset + j - 1]];
+                matrix[i * cols + j] = maximum(matrix[(i - 1) * cols + j - 1] + score,
+                                               matrix[i * cols + j - 1] - NW_DEFAULT_PENALTY,
+                                               matrix[(i - 1) * cols + j] - NW_DEFAULT_PENALTY);
+            }
+        }
+
+        ASSERT_EQ(matrix[rows * cols - 1], nwScorePairCPU(batch, p, scratch.data())) << "pair " << p;
+        ASSERT_EQ(matrix[rows * cols - 1], scores[p]) << "pair " << p;
+        cells += (long long)pair.rowLength * pair.colLength;
+    }
+
+    ASSERT_EQ(cells, batch.cells);
+}
+
+// Both SIMD engines must match the scalar row over several tiles. A penalty
+// of half the range of the 16 bit lanes drives the gap costs of the boundary
+// of every tile out of it, so all tiles are widened
+TEST_F(NWKernelsTestFixture, TestNWSimdEngines)
+{
+    int dim = NW_TILE_SIZE * 2 + 77;
+    int lastRow = dim - 2;
+    int tiles = ((lastRow + NW_TILE_SIZE - 1) / NW_TILE_SIZE) * ((dim + NW_TILE_SIZE - 1) / NW_TILE_SIZE);
+    int widePenalty = numeric_limits<int16_t>::max() / 2 + 1;
+    NWEngine engines[2] = { NW_ENGINE_STRIPED, NW_ENGINE_ANTIDIAGONAL };
+
+    for (int penalty : { NW_DEFAULT_PENALTY, widePenalty })
+    {
+        NWProblem problem;
+        makeNWProblem(problem, dim, penalty);
+
+        vector<int> expected(dim + 1), row(dim + 1);
+        nwScoreRowCPU(problem, lastRow, expected.data());
+
+        for (NWEngine engine : engines)
+        {
+            int widened = nwScoreRowSIMD(problem, lastRow, row.data(), engine, 3);
+
+            ASSERT_EQ(expected, row) << getNWEngineName(engine) << ", penalty " << penalty;
+
+            if (penalty == NW_DEFAULT_PENALTY)
+                ASSERT_EQ(0, widened);
+            else
+                ASSERT_EQ(tiles, widened);
+        }
+    }
+}
+
+// The linear space affine gap reference must match a full matrix Gotoh
+// alignment in the global and the local mode, and the linear penalty
+// reference when opening and extending a gap cost the same
+TEST_F(NWKernelsTestFixture, TestNWAffine)
+{
+    int dim = 70;
+    NWScoring scoring;
+
+    ASSERT_FALSE(parseNWScoring("semiglobal", 10, 10, scoring));
+    ASSERT_FALSE(parseNWScoring(NW_MODE_LOCAL, -1, 1, scoring));
+    ASSERT_TRUE(parseNWScoring(NW_MODE_GLOBAL, NW_DEFAULT_PENALTY, NW_DEFAULT_PENALTY, scoring));
+    ASSERT_TRUE(isNWLinearScoring(scoring, NW_DEFAULT_PENALTY));
+    ASSERT_EQ(NW_DEFAULT_PENALTY * 3, getNWGapCost(scoring, 3));
+
+    NWProblem problem;
+    makeNWProblem(problem, dim, NW_DEFAULT_PENALTY);
+
+    vector<int> expected(dim + 1), row(dim + 1);
+    nwScoreRowCPU(problem, dim - 2, expected.data());
+    nwAffineRowCPU(problem, scoring, dim - 2, dim - 1, row.data());
+    ASSERT_EQ(expected, row);
+
+    for (const char *mode : { NW_MODE_GLOBAL, NW_MODE_LOCAL })
+    {
+        ASSERT_TRUE(parseNWScoring(mode, 11, 1, scoring));
+        ASSERT_FALSE(isNWLinearScoring(scoring, NW_DEFAULT_PENALTY));
+
+        int cols = dim + 1;
+        vector<int> h(cols * cols), e(cols * cols, NW_NEG_INF), f(cols * cols, NW_NEG_INF);
+        int best = 0;
+
+        for (int k = 0; k < cols; k++)
+        {
+            h[k * cols] = scoring.local ? 0 : -getNWGapCost(scoring, k);
+            h[k] = scoring.local ? 0 : -getNWGapCost(scoring, k);
+        }
+
+        for (int i = 1; i < cols; i++)
+        {
+            for (int j = 1; j < cols; j++)
+            {
+                int score = blosum62[problem.rowSequence[i]][problem.columnSequence[j]];
+                e[i * cols + j] = max(h[i * cols + j - 1] - 11, e[i * cols + j - 1] - 1);
+                f[i * cols + j] = max(h[(i - 1) * cols + j] - 11, f[(i - 1) * cols + j] - 1);
+                h[i * cols + j] = maximum(h[(i - 1) * cols + j - 1] + score, 
+                                          e[i * cols + j], f[i * cols + j]);
+
+                if (scoring.local)
+                    h[i * cols + j] = max(h[i * cols + j], 0);
+                if (i <= dim - 2 && j <= dim - 1)
+                    best = max(best, h[i * cols + j]);
+            }
+        }
+
+        int score = nwAffineRowCPU(problem, scoring, dim - 2, dim - 1, row.data());
+
+        ASSERT_TRUE(equal(row.begin(), row.end(), h.begin() + (dim - 2) * cols)) << mode;
+        ASSERT_EQ(scoring.local ? best : h[(dim - 2) * cols + dim - 1], score) << mode;
+    }
+}
+
+// The last column and the strip checksums of the score-only outputs must
+// match the rows of the linear space reference
+TEST_F(NWKernelsTestFixture, TestNWScoreBoundary)
+{
+    int dim = 100;
+    int strip_rows = BSIZE - 1;
+    int last_row = dim - 2;
+    int num_strips = (last_row + strip_rows - 1) / strip_rows;
+
+    NWOutput output;
+    ASSERT_TRUE(parseNWOutput("checksum", output));
+    ASSERT_EQ(NW_OUTPUT_CHECKSUM, output);
+    ASSERT_FALSE(parseNWOutput("matrix", output));
+
+    NWProblem problem;
+    makeNWProblem(problem, dim, NW_DEFAULT_PENALTY);
+
+    vector<int> column(last_row + 1);
+    vector<unsigned int> checksums(num_strips);
+    nwScoreBoundaryCPU(problem, last_row, dim - 1, strip_rows, column.data(), checksums.data());
+
+    vector<unsigned int> expected(num_strips, 0);
+    vector<int> row(dim + 1);
+
+    for (int i = 0; i <= last_row; i++)
+    {
+        nwScoreRowCPU(problem, i, row.data());
+        ASSERT_EQ(row[dim - 1], column[i]) << "row " << i;
+
+        for (int j = 1; i > 0 && j <= dim - 1; j++)
+            expected[(i - 1) / strip_rows] += row[j];
+    }
+
+    ASSERT_EQ(expected, checksums);
+}
+
+// The Hirschberg alignment must cover both sequences and score the best
+// score of the linear space reference, with subproblems split several times
+TEST_F(NWKernelsTestFixture, TestNWHirschberg)
+{
+    int dim = 700;
+
+    NWProblem problem;
+    makeNWProblem(problem, dim, NW_DEFAULT_PENALTY);
+
+    vector<int> expected(dim + 1), row(dim + 1);
+    nwScoreRowCPU(problem, dim, expected.data());
+    nwScoreLastRowCPU(&problem.rowSequence[1], dim, &problem.columnSequence[1], dim, 
+                      NW_DEFAULT_PENALTY, row.data());
+    ASSERT_EQ(expected, row);
+
+    long long cells;
+    string cigar = nwHirschbergAlign(problem, 
+        [](const int *rowSeq, int rows, const int *colSeq, int cols, int *row)
+        {
+            nwScoreLastRowCPU(rowSeq, rows, colSeq, cols, NW_DEFAULT_PENALTY, row);
+        }, cells);
+
+    int score;
+    ASSERT_TRUE(nwScoreCigar(problem, cigar, score));
+    ASSERT_EQ(expected[dim], score);
+    ASSERT_GT(cells, (long long)dim * dim);
+    ASSERT_LT(cells, 2LL * dim * dim);
+
+    ASSERT_FALSE(nwScoreCigar(problem, "1M", score));
+    ASSERT_FALSE(nwScoreCigar(problem, cigar + "1I", score));
+}
+
+// The banded score of similar sequences must be the best score without a
+// band overflow, and a band too narrow for random sequences must overflow
+TEST_F(NWKernelsTestFixture, TestNWBanded)
+{
+    int dim = 500;
+    int band = 16;
+
+    NWProblem problem;
+    makeNWSimilarProblem(problem, dim, NW_DEFAULT_PENALTY, NW_SIMILAR_DIVERGENCE);
+
+    vector<int> row(dim + 1);
+    nwScoreRowCPU(problem, dim, row.data());
+
+    int score;
+    ASSERT_FALSE(nwBandedCPU(problem, band, score));
+    ASSERT_EQ(row[dim], score);
+
+    // a band covering the whole matrix is the full alignment
+    makeNWProblem(problem, 40, NW_DEFAULT_PENALTY);
+    nwScoreRowCPU(problem, 40, row.data());
+    ASSERT_FALSE(nwBandedCPU(problem, 40, score));
+    ASSERT_EQ(row[40], score);
+    ASSERT_TRUE(nwBandedCPU(problem, 1, score));
+    ASSERT_LE(score, row[40]);
+
+    ASSERT_EQ(40LL * 40, getNWBandCells(40, 40));
+    ASSERT_EQ(3LL * 40 - 2, getNWBandCells(40, 1));
+}
+
+// The records of a FASTA file must be read as the codes of blosum62, and the
+// packed residues must look up the same scores in the packed table
+TEST_F(NWKernelsTestFixture, TestNWFasta)
+{
+    string fileName = "/tmp/nwtest.fa";
+
+    FILE *file = fopen(fileName.c_str(), "w");
+    ASSERT_TRUE(file != NULL);
+    fputs(">first\nacgtAC\nGTTG\n;comment\n>second record\r\nCGTAAC\r\nG\n>third\nMKVL\n", file);
+    fclose(file);
+
+    NWProblem problem;
+    int bits;
+    ASSERT_TRUE(makeNWFastaProblem(problem, fileName.c_str(), NW_DEFAULT_PENALTY, bits));
+    ASSERT_EQ(NW_DNA_BITS, bits);
+    ASSERT_EQ(7, problem.dim);
+
+    string first = "ACGTACG", second = "CGTAACG";
+    for (int p = 0; p < problem.dim; p++)
+    {
+        ASSERT_EQ(NW_PROTEIN_RESIDUES[problem.rowSequence[p + 1]], first[p]);
+        ASSERT_EQ(NW_PROTEIN_RESIDUES[problem.columnSequence[p + 1]], second[p]);
+    }
+
+    vector<string> sequences;
+    ASSERT_TRUE(readNWFasta(fileName.c_str(), sequences));
+    ASSERT_EQ(3, (int)sequences.size());
+    ASSERT_EQ("MKVL", sequences[2]);
+    remove(fileName.c_str());
+
+    // the random sequences packed as proteins, the FASTA pair as DNA
+    NWProblem random;
+    makeNWProblem(random, 300, NW_DEFAULT_PENALTY);
+    NWProblem *problems[2] = { &random, &problem };
+    int problemBits[2] = { NW_PROTEIN_BITS, NW_DNA_BITS };
+
+    for (int k = 0; k < 2; k++)
+    {
+        NWProblem &packedProblem = *problems[k];
+        NWPackedSequence rows, columns;
+        packNWSequence(packedProblem.rowSequence, problemBits[k], rows);
+        packNWSequence(packedProblem.columnSequence, problemBits[k], columns);
+
+        vector<int> table(NW_TABLE_SIDE * NW_TABLE_SIDE);
+        fillNWPackedTable(problemBits[k], table.data());
+
+        for (int i = 1; i <= packedProblem.dim; i++)
+        {
+            for (int j = 1; j <= packedProblem.dim; j++)
+            {
+                int row = unpackNWResidue(rows.words.data(), i, problemBits[k]);
+                int column = unpackNWResidue(columns.words.data(), j, problemBits[k]);
+                ASSERT_EQ(blosum62[packedProblem.rowSequence[i]][packedProblem.columnSequence[j]], 
+                          table[row * NW_TABLE_SIDE + column]) << i << ", " << j;
+            }
+        }
+    }
+
+    ASSERT_FALSE(makeNWFastaProblem(problem, "/tmp/nwtest-missing.fa", NW_DEFAULT_PENALTY, bits));
+}
+
 INSTANTIATE_TEST_CASE_P(TestBaseInstantiation, NWKernelsTestFixtureWithParam,
                         Values(
                             NWTestItem{16,
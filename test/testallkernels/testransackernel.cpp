@@ -9,11 +9,14 @@
 
 #include <gtest/gtest.h>
 #include <time.h>
+#include <limits.h>
 #include "../../src/common/benchmarkoptionsparser.h"
 #include "../../src/common/utility.h"
 #include "../common/basetest.h"
 
 #include "../../src/ransac/ransacutility.h"
+#include "../../src/ransac/ransacgenerator.h"
+#include "../../src/ransac/ransacsimd.h"
 
 #define NUM_IDATA 2
 
@@ -267,6 +270,273 @@ TEST_P(RansacKernelsTestFixtureWithParam, TestRansac)
 
 }; 
 
+// A generated data set must read back the same from the csv and the binary
+// file, and the host ransac must recover the ground truth model from it
+TEST_F(RansacKernelsTestFixture, TestRansacGenerator)
+{
+    const int n = 4099, iters = 256;
+    vector<flowvector> v(n);
+    vector<point> p(n);
+    RansacGroundTruth truth;
+
+    initGroundTruth(truth, v.data());
+    genInputData(v.data(), n, truth, 1);
+    ASSERT_GT(truth.inliers, n / 2);
+
+    // the binary data sets are detected by their magic, not their name
+    string csvName = "/tmp/ransactest.csv", binName = "/tmp/ransactest.dat", soaName = "/tmp/ransactest.soa";
+    ASSERT_TRUE(writeInputData(v.data(), n, csvName));
+    ASSERT_TRUE(writeInputBinary(v.data(), n, binName));
+    ASSERT_TRUE(writeInputBinary(v.data(), n, soaName, RANSAC_DATA_SOA));
+
+    RansacSoA<flowvector> expected;
+    toSoA(v.data(), n, expected);
+
+    // the binary files are used in place in their mapping, the csv one is
+    // parsed; all read back the same elements and structure of arrays
+    uint32_t layouts[3] = { RANSAC_DATA_AOS, RANSAC_DATA_AOS, RANSAC_DATA_SOA };
+    string names[3] = { csvName, binName, soaName };
+    for (int f = 0; f < 3; f++)
+    {
+        RansacDataFile file;
+        ASSERT_TRUE(readInput(names[f], RANSAC_DATA_FLOWVECTOR, file));
+        ASSERT_EQ(RANSAC_DATA_FLOWVECTOR, (int)file.type);
+        ASSERT_EQ(layouts[f], file.layout);
+        ASSERT_EQ(n, file.count);
+        ASSERT_EQ(f == 0, file.mapping == NULL);
+        ASSERT_EQ(0, (size_t)file.elements % RANSAC_DATA_ALIGNMENT);
+
+        if (f > 0)
+        {
+            const char *begin = (const char *)file.mapping;
+            ASSERT_TRUE((const char *)file.elements > begin);
+            ASSERT_TRUE((const char *)file.elements < begin + file.mappingSize);
+        }
+        if (file.layout == RANSAC_DATA_SOA)
+        {
+            ASSERT_EQ(0, file.fieldStride % RANSAC_DATA_ALIGNMENT);
+            ASSERT_EQ(v[n - 1].vy, ((const int *)inputField(file, 3))[n - 1]);
+        }
+
+        vector<flowvector> read(n);
+        copyInput(file, read.data());
+        ASSERT_EQ(0, memcmp(read.data(), v.data(), n * sizeof(flowvector)));
+
+        RansacSoA<flowvector> soa;
+        toSoA(file, soa);
+        ASSERT_EQ(n, soa.n);
+        ASSERT_TRUE(soa.x == expected.x && soa.y == expected.y);
+        ASSERT_TRUE(soa.vx == expected.vx && soa.vy == expected.vy);
+        releaseInput(file);
+    }
+
+    // a binary data set of flow vectors is not read as points
+    RansacDataFile file;
+    ASSERT_FALSE(readInput(soaName, RANSAC_DATA_POINT, file));
+    remove(csvName.c_str());
+    remove(binName.c_str());
+    remove(soaName.c_str());
+
+    vector<int> randNumbers(2 * iters);
+    srand(1);
+    genRandNumbers(randNumbers.data(), iters, n);
+
+    float params[4];
+    RansacResult result = estimateModel(v.data(), n, randNumbers.data(), iters, RANSAC_FV_ERROR_THRESHOLD,
+                                        RANSAC_CONVERGENCE_THRESHOLD, params);
+    ASSERT_GE(result.bestModel, 0);
+    ASSERT_LT(modelError(truth, v.data(), params), RANSAC_FV_ERROR_THRESHOLD);
+
+    initGroundTruth(truth, p.data());
+    genInputData(p.data(), n, truth, 1);
+    result = estimateModel(p.data(), n, randNumbers.data(), iters, RANSAC_P_ERROR_THRESHOLD,
+                           RANSAC_CONVERGENCE_THRESHOLD, params);
+    ASSERT_GE(result.bestModel, 0);
+    ASSERT_LT(modelError(truth, p.data(), params), RANSAC_P_ERROR_THRESHOLD);
+}
+
+// The SIMD host engine must find the same candidates and best outlier count
+// as the reference, also for the remainder of the lanes, points with x = 0
+// and horizontal lines
+TEST_F(RansacKernelsTestFixture, TestRansacSIMD)
+{
+    const int iters = 300;
+    vector<int> randNumbers(2 * iters);
+    float params[4];
+
+    for (int n : { 5, 1000, 4099 })
+    {
+        srand(n);
+        genRandNumbers(randNumbers.data(), iters, n);
+
+        vector<flowvector> v(n);
+        RansacGroundTruth truth;
+        initGroundTruth(truth, v.data());
+        genInputData(v.data(), n, truth, n);
+
+        RansacResult reference = estimateModel(v.data(), n, randNumbers.data(), iters, RANSAC_FV_ERROR_THRESHOLD,
+                                               RANSAC_CONVERGENCE_THRESHOLD, params);
+        RansacSoA<flowvector> flows;
+        toSoA(v.data(), n, flows);
+
+        for (int threads : { 1, 3 })
+        {
+            RansacResult result = ransacSIMD(flows, randNumbers.data(), iters, RANSAC_FV_ERROR_THRESHOLD,
+                                             RANSAC_CONVERGENCE_THRESHOLD, threads);
+            ASSERT_EQ(reference.candidates, result.candidates);
+            ASSERT_EQ(reference.bestOutliers, result.bestOutliers);
+            ASSERT_EQ(reference.bestModel, result.bestModel);
+        }
+
+        vector<point> p(n);
+        initGroundTruth(truth, p.data());
+        genInputData(p.data(), n, truth, n);
+        for (int i = 0; i < n; i += 7) p[i].x = 0;
+        for (int i = 3; i < n; i += 11) p[i].y = p[0].y;
+
+        reference = estimateModel(p.data(), n, randNumbers.data(), iters, RANSAC_P_ERROR_THRESHOLD,
+                                  RANSAC_CONVERGENCE_THRESHOLD, params);
+        RansacSoA<point> points;
+        toSoA(p.data(), n, points);
+
+        RansacResult result = ransacSIMD(points, randNumbers.data(), iters, RANSAC_P_ERROR_THRESHOLD,
+                                         RANSAC_CONVERGENCE_THRESHOLD, 2);
+        ASSERT_EQ(reference.candidates, result.candidates);
+        ASSERT_EQ(reference.bestOutliers, result.bestOutliers);
+        ASSERT_EQ(reference.bestModel, result.bestModel);
+    }
+}
+
+TEST_F(RansacKernelsTestFixture, TestRansacAdaptive)
+{
+    ASSERT_EQ(INT_MAX, ransacIterations(0, 0.99, RANSAC_SAMPLES));
+    ASSERT_EQ(0, ransacIterations(1, 0.99, RANSAC_SAMPLES));
+    // 1 - 0.5^2 = 0.75, log(0.01) / log(0.75) = 16.0078
+    ASSERT_EQ(17, ransacIterations(0.5, 0.99, RANSAC_SAMPLES));
+
+    const int n = 4096, iters = 1024, batch = 32;
+    vector<int> randNumbers(2 * iters);
+    float params[4];
+
+    srand(n);
+    genRandNumbers(randNumbers.data(), iters, n);
+
+    vector<flowvector> v(n);
+    RansacGroundTruth truth;
+    initGroundTruth(truth, v.data());
+    genInputData(v.data(), n, truth, n);
+
+    RansacSoA<flowvector> flows;
+    toSoA(v.data(), n, flows);
+
+    // 30% outliers stop after the first batches, which match the full run
+    int evaluated;
+    RansacResult result = ransacAdaptiveSIMD(flows, randNumbers.data(), iters, batch, RANSAC_FV_ERROR_THRESHOLD,
+                                             RANSAC_CONVERGENCE_THRESHOLD, 0.99, 2, evaluated);
+    ASSERT_LT(evaluated, iters);
+    ASSERT_EQ(0, evaluated % batch);
+
+    RansacResult reference = estimateModel(v.data(), n, randNumbers.data(), evaluated, RANSAC_FV_ERROR_THRESHOLD,
+                                           RANSAC_CONVERGENCE_THRESHOLD, params);
+    ASSERT_EQ(reference.candidates, result.candidates);
+    ASSERT_EQ(reference.bestOutliers, result.bestOutliers);
+    ASSERT_EQ(reference.bestModel, result.bestModel);
+
+    float ratio = float(n - result.bestOutliers) / n;
+    ASSERT_GE(evaluated, ransacIterations(ratio, 0.99, RANSAC_SAMPLES));
+
+    // a confidence of 1 is never met
+    result = ransacAdaptiveSIMD(flows, randNumbers.data(), iters, batch, RANSAC_FV_ERROR_THRESHOLD,
+                                RANSAC_CONVERGENCE_THRESHOLD, 1, 2, evaluated);
+    ASSERT_EQ(iters, evaluated);
+}
+
+TEST_F(RansacKernelsTestFixture, TestRansacPreemptive)
+{
+    const int n = 4096, iters = 256, block = 128;
+    vector<int> randNumbers(2 * iters);
+
+    srand(n);
+    genRandNumbers(randNumbers.data(), iters, n);
+
+    vector<flowvector> v(n);
+    RansacGroundTruth truth;
+    initGroundTruth(truth, v.data());
+    genInputData(v.data(), n, truth, n);
+
+    RansacSoA<flowvector> flows;
+    toSoA(v.data(), n, flows);
+
+    // 256, 128, ..., 1 hypotheses on the first 9 blocks
+    RansacPreemptiveResult result = ransacPreemptiveSIMD(flows, randNumbers.data(), iters, block,
+                                                         RANSAC_FV_ERROR_THRESHOLD);
+    ASSERT_EQ(9, result.blocks);
+    ASSERT_EQ(511LL * block, result.evaluations);
+    ASSERT_LE(result.score, 9 * block);
+
+    RansacResult exhaustive = ransacSIMD(flows, randNumbers.data(), iters, RANSAC_FV_ERROR_THRESHOLD,
+                                         RANSAC_CONVERGENCE_THRESHOLD, 2);
+    ASSERT_GE(result.outliers, exhaustive.bestOutliers);
+    ASSERT_GT(n - result.outliers, 0.9 * (n - exhaustive.bestOutliers));
+
+    // the data set is used up after two blocks, scored on all elements
+    result = ransacPreemptiveSIMD(flows, randNumbers.data(), iters, n / 2, RANSAC_FV_ERROR_THRESHOLD);
+    ASSERT_EQ(2, result.blocks);
+    ASSERT_EQ(384LL * n / 2, result.evaluations);
+    ASSERT_EQ(result.outliers, result.score);
+}
+
+// The affine and homography solves must reproduce exact correspondences,
+// and on a generated data set, whose first order flow is an affine map of
+// the tails to the heads, find about the inliers of the flow model
+TEST_F(RansacKernelsTestFixture, TestRansacTransforms)
+{
+    // u = 2x + y + 3, v = x - y + 1
+    flowvector s[4] = { {0, 0, 3, 1}, {10, 0, 23, 11}, {0, 10, 13, -9}, {10, 10, 33, 1} };
+    float expected[8] = { 2, 1, 3, 1, -1, 1, 0, 0 };
+    float params[8];
+
+    ASSERT_EQ(1, genAffineModel(s, params));
+    for (int k = 0; k < 6; k++) ASSERT_NEAR(expected[k], params[k], 1e-4);
+    ASSERT_EQ(1, genHomographyModel(s, params));
+    for (int k = 0; k < 8; k++) ASSERT_NEAR(expected[k], params[k], 1e-3);
+
+    // collinear tails and a repeated sample are degenerate
+    flowvector line[3] = { {0, 0, 3, 1}, {5, 5, 18, 1}, {10, 10, 33, 1} };
+    ASSERT_EQ(0, genAffineModel(line, params));
+    flowvector repeated[4] = { s[0], s[0], s[0], s[0] };
+    ASSERT_EQ(0, genHomographyModel(repeated, params));
+
+    const int n = 4096, iters = 300;
+    vector<flowvector> v(n);
+    RansacGroundTruth truth;
+    initGroundTruth(truth, v.data());
+    genInputData(v.data(), n, truth, n);
+
+    RansacSoA<flowvector> flows;
+    toSoA(v.data(), n, flows);
+
+    vector<int> randNumbers(4 * iters);
+    srand(n);
+    genRandNumbers(randNumbers.data(), iters, n, 4);
+
+    RansacResult flow = ransacSIMD(flows, randNumbers.data(), iters, RANSAC_FV_ERROR_THRESHOLD,
+                                   RANSAC_CONVERGENCE_THRESHOLD, 2);
+
+    for (int model : { RANSAC_MODEL_AFFINE, RANSAC_MODEL_HOMOGRAPHY })
+    {
+        RansacResult single = ransacSIMD(flows, randNumbers.data(), iters, RANSAC_FV_ERROR_THRESHOLD,
+                                         RANSAC_CONVERGENCE_THRESHOLD, 1, model);
+        RansacResult result = ransacSIMD(flows, randNumbers.data(), iters, RANSAC_FV_ERROR_THRESHOLD,
+                                         RANSAC_CONVERGENCE_THRESHOLD, 3, model);
+        ASSERT_EQ(single.candidates, result.candidates);
+        ASSERT_EQ(single.bestOutliers, result.bestOutliers);
+        ASSERT_EQ(single.bestModel, result.bestModel);
+        ASSERT_GT(result.candidates, 0);
+        ASSERT_GT(n - result.bestOutliers, 0.9 * (n - flow.bestOutliers));
+    }
+}
+
 // In order to run value-parameterized tests, we need to instantiate them,
 // or bind them to a list of values which will be used as test parameters.
 // We can instantiate them in a different translation module, or even